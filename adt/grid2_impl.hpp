@@ -8,6 +8,7 @@
 #include <cxx/cassert.hpp>
 #include <cxx/cstdlib.hpp>
 #include <cxx/invoke.hpp>
+#include <cxx/serialize.hpp>
 #include <fun/fun_decl.hpp>
 
 #include <fun/fun_impl.hpp>
@@ -44,10 +45,30 @@ private:
   space_type space;
   container_type data;
 
+  // Only the active region is sent, stored contiguously. (A boundary
+  // shares the storage of its grid, which would otherwise be sent as a
+  // whole.)
   friend class cereal::access;
-  template <typename Archive> void serialize(Archive &ar) {
-    // TODO: Serialize only the accessible part of data
-    ar(space, data);
+  template <typename Archive> void save(Archive &ar) const {
+    ar(active());
+    if (space.allocated() == active()) {
+      cxx::save_container(ar, data);
+      return;
+    }
+    space_type dense(active());
+    fun::accumulator<container_type> acc(size());
+    active().loop([&](const index_type &ipos) {
+      acc[dense.linear(ipos)] = fun::getIndex(data, space.linear(ipos));
+    });
+    container_type xs = acc.finalize();
+    cxx::save_container(ar, xs);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    range_type act;
+    ar(act);
+    cxx::load_container(ar, data);
+    space = space_type(act);
+    cxx_assert(invariant());
   }
 
 public:
@@ -6,10 +6,14 @@
 
 #include <adt/grid2_impl.hpp>
 
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
 #include <gtest/gtest.h>
 
 #include <array>
 #include <cmath>
+#include <sstream>
+#include <string>
 #include <tuple>
 
 namespace {
@@ -152,6 +156,54 @@ TEST(adt_grid2, boundary) {
   test_boundary<10>();
 }
 
+namespace {
+template <typename T> std::string serialize(const T &x) {
+  std::stringstream buf;
+  { (cereal::BinaryOutputArchive(buf))(x); }
+  return buf.str();
+}
+
+template <typename T> T deserialize(const std::string &str) {
+  std::stringstream buf(str);
+  T x;
+  { (cereal::BinaryInputArchive(buf))(x); }
+  return x;
+}
+
+template <std::size_t D> void test_serialize() {
+  std::ptrdiff_t s = std::lrint(std::fmax(2.0, std::pow(1000.0, 1.0 / D)));
+  auto g = vgrid<double, D>(typename vgrid<double, D>::iotaMap(),
+                            [](auto i) { return double(adt::sum(i)); },
+                            adt::set<adt::index_t<D>>(s));
+  auto g1 = deserialize<vgrid<double, D>>(serialize(g));
+  EXPECT_EQ(g.size(), g1.size());
+  EXPECT_EQ(g.last(), g1.last());
+  // Boundaries send only their active region
+  for (int f = 0; f < 2; ++f) {
+    for (int d = 0; d < int(D); ++d) {
+      auto bs =
+          vgrid<double, D>(typename vgrid<double, D>::boundary(), g, f, d);
+      auto str = serialize(bs);
+      EXPECT_LT(str.size(), bs.size() * sizeof(double) + 1000);
+      auto bs1 = deserialize<vgrid<double, D>>(str);
+      EXPECT_EQ(bs.active(), bs1.active());
+      EXPECT_EQ(bs.head(), bs1.head());
+      EXPECT_EQ(bs.last(), bs1.last());
+      EXPECT_EQ(bs.foldMap([](auto x) { return x; },
+                           [](auto x, auto y) { return x + y; }, 0.0),
+                bs1.foldMap([](auto x) { return x; },
+                            [](auto x, auto y) { return x + y; }, 0.0));
+    }
+  }
+}
+}
+
+TEST(adt_grid2, serialize) {
+  test_serialize<1>();
+  test_serialize<2>();
+  test_serialize<3>();
+}
+
 namespace {
 template <std::size_t D> void test_fmapStencil() {
   std::ptrdiff_t s = std::lrint(std::fmax(2.0, std::pow(1000.0, 1.0 / D)));
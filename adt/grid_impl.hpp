@@ -6,14 +6,23 @@
 #include <adt/index.hpp>
 #include <cxx/cassert.hpp>
 #include <cxx/cstdlib.hpp>
+#include <cxx/execution.hpp>
 #include <cxx/invoke.hpp>
+#include <cxx/memory.hpp>
+#include <cxx/serialize.hpp>
+#include <cxx/utility.hpp>
+#include <fun/fold.hpp>
 #include <fun/fun_decl.hpp>
+#include <qthread/parallel.hpp>
 
 #include <cereal/access.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace adt {
 
@@ -76,6 +85,29 @@ private:
     return adt::prod(shape);
   }
 
+  // Pad the allocated shape: Dimension 0 is rounded up to a multiple
+  // of pad0 points, so that all rows start aligned. Strides that are a
+  // multiple of the page size are avoided, since neighbouring rows or
+  // planes would then compete for the same cache sets.
+  static index_type make_padded(const index_type &shape, std::ptrdiff_t pad0,
+                                std::ptrdiff_t elem_size) {
+    cxx_assert(pad0 > 0 && elem_size > 0);
+    index_type alloc = shape;
+    if (adt::prod(shape) == 0)
+      return alloc;
+    std::ptrdiff_t str = elem_size;
+    for (std::ptrdiff_t d = 0; d < std::ptrdiff_t(D); ++d) {
+      if (d == 0)
+        alloc[d] = cxx::align_ceil(alloc[d], pad0);
+      // The stride of the last dimension is irrelevant
+      if (d < std::ptrdiff_t(D) - 1 &&
+          str * alloc[d] % std::ptrdiff_t(cxx::page_size) == 0)
+        alloc[d] += d == 0 ? pad0 : 1;
+      str *= alloc[d];
+    }
+    return alloc;
+  }
+
 public:
   bool invariant() const noexcept {
     if (adt::any(adt::lt(m_shape, 0)))
@@ -108,8 +140,11 @@ public:
   }
 
   index_space() : index_space(origin()) {}
-  // TODO: Add padding if desired
   index_space(const index_type &shape) : index_space(shape, origin(), shape) {}
+  struct padded {};
+  index_space(padded, const index_type &shape, std::ptrdiff_t pad0,
+              std::ptrdiff_t elem_size)
+      : index_space(shape, origin(), make_padded(shape, pad0, elem_size)) {}
   index_space(const index_type &shape, const index_type &offset,
               const index_type &allocated)
       : m_shape(shape), m_offset(make_offset(make_stride(allocated), offset)),
@@ -154,6 +189,22 @@ public:
   }
   std::ptrdiff_t allocated_size() const { return m_allocated; }
 
+  // Whether the points are stored contiguously and in order, without
+  // padding
+  bool contiguous() const {
+    if (empty())
+      return m_allocated == 0;
+    if (m_offset != 0)
+      return false;
+    std::ptrdiff_t str = 1;
+    for (std::ptrdiff_t d = 0; d < std::ptrdiff_t(D); ++d) {
+      if (m_shape[d] != 1 && stride(d) != str)
+        return false;
+      str *= m_shape[d];
+    }
+    return str == m_allocated;
+  }
+
   // Convert a position to a linear index
   std::ptrdiff_t linear(const index_type &i) const {
     std::ptrdiff_t lin = m_offset;
@@ -205,6 +256,125 @@ public:
     loop_impl<D>(std::forward<F>(f), origin(), std::forward<Args>(args)...);
   }
 
+  // Parallel loop: The index space is split into tiles, which are
+  // executed as separate threads. The tile size is chosen by grain.
+  template <typename F, typename... Args>
+  void parallel_loop(qthread::grain_size &grain, F &&f,
+                     Args &&... args) const {
+    static_assert(std::is_void<cxx::invoke_of_t<F, index_type, Args...>>::value,
+                  "");
+    if (std::ptrdiff_t(size()) <= grain.get(size())) {
+      loop(std::forward<F>(f), std::forward<Args>(args)...);
+      return;
+    }
+    auto fs = qthread::parallel_for(
+        grain, adt::steprange_t<D>(m_shape),
+        [&](const index_type &i) { cxx::invoke(f, i, args...); });
+    for (const auto &fut : fs)
+      fut.wait();
+  }
+
+  // Multi-dimensional loop over linear indices
+private:
+  index_type strides() const {
+    index_type r;
+    for (std::size_t d = 0; d < D; ++d)
+      r[d] = stride(d);
+    return r;
+  }
+
+  // The linear indices are updated incrementally instead of being
+  // recalculated for each point. In the innermost dimension all
+  // strides are usually 1, and the loop can then be vectorized.
+  template <std::ptrdiff_t d, typename F, std::size_t N, std::size_t... Is,
+            std::enable_if_t<(d == 0)> * = nullptr>
+  static void loop_linear_impl(const index_type &imin, const index_type &imax,
+                               F &&f, const std::array<index_type, N> &strs,
+                               std::array<std::ptrdiff_t, N> lins,
+                               std::index_sequence<Is...>) {
+    cxx::invoke(std::forward<F>(f), std::get<Is>(lins)...);
+  }
+  template <std::ptrdiff_t d, typename F, std::size_t N, std::size_t... Is,
+            std::enable_if_t<(d == 1)> * = nullptr>
+  static void loop_linear_impl(const index_type &imin, const index_type &imax,
+                               F &&f, const std::array<index_type, N> &strs,
+                               std::array<std::ptrdiff_t, N> lins,
+                               std::index_sequence<Is...>) {
+    bool unit_stride = true;
+    for (std::size_t n = 0; n < N; ++n) {
+      lins[n] += imin[0] * strs[n][0];
+      unit_stride &= strs[n][0] == 1;
+    }
+    const std::ptrdiff_t len = imax[0] - imin[0];
+    if (unit_stride) {
+#pragma omp simd
+      for (std::ptrdiff_t i = 0; i < len; ++i)
+        cxx::invoke(f, (std::get<Is>(lins) + i)...);
+    } else {
+      for (std::ptrdiff_t i = 0; i < len; ++i)
+        cxx::invoke(f, (std::get<Is>(lins) + i * std::get<Is>(strs)[0])...);
+    }
+  }
+  template <std::ptrdiff_t d, typename F, std::size_t N, std::size_t... Is,
+            std::enable_if_t<(d > 1)> * = nullptr>
+  static void loop_linear_impl(const index_type &imin, const index_type &imax,
+                               F &&f, const std::array<index_type, N> &strs,
+                               std::array<std::ptrdiff_t, N> lins,
+                               std::index_sequence<Is...> is) {
+    for (std::size_t n = 0; n < N; ++n)
+      lins[n] += imin[d - 1] * strs[n][d - 1];
+    for (std::ptrdiff_t i = imin[d - 1]; i < imax[d - 1]; ++i) {
+      loop_linear_impl<d - 1>(imin, imax, f, strs, lins, is);
+      for (std::size_t n = 0; n < N; ++n)
+        lins[n] += strs[n][d - 1];
+    }
+  }
+
+public:
+  // Loop over the box [imin, imax), calling f(lin, lins...) with the
+  // linear index of each point in this and in the other index spaces
+  // (which need to have the same shape)
+  template <typename F, typename... ISs>
+  void loop_linear_box(const index_type &imin, const index_type &imax, F &&f,
+                       const ISs &... iss) const {
+    static_assert(
+        cxx::all_of_type<std::is_same<ISs, index_space>::value...>::value, "");
+    constexpr std::size_t N = 1 + sizeof...(ISs);
+    for (bool same_shape : std::array<bool, N>{{true, iss.shape() == shape()...}})
+      cxx_assert(same_shape);
+    cxx_assert(adt::all(adt::le(origin(), imin)) &&
+               adt::all(adt::le(imax, m_shape)));
+    if (adt::any(adt::le(imax, imin)))
+      return;
+    std::array<index_type, N> strs{{strides(), iss.strides()...}};
+    std::array<std::ptrdiff_t, N> lins{{m_offset, iss.m_offset...}};
+    loop_linear_impl<D>(imin, imax, std::forward<F>(f), strs, lins,
+                        std::make_index_sequence<N>());
+  }
+
+  template <typename F, typename... ISs>
+  void loop_linear(F &&f, const ISs &... iss) const {
+    loop_linear_box(origin(), m_shape, std::forward<F>(f), iss...);
+  }
+
+  // Parallel loop over linear indices, split into tiles as for
+  // parallel_loop
+  template <typename F, typename... ISs>
+  void parallel_loop_linear(qthread::grain_size &grain, F &&f,
+                            const ISs &... iss) const {
+    if (std::ptrdiff_t(size()) <= grain.get(size())) {
+      loop_linear(std::forward<F>(f), iss...);
+      return;
+    }
+    auto fs = qthread::parallel_for_chunks(
+        grain, adt::steprange_t<D>(m_shape),
+        [&](const adt::steprange_t<D> &tile) {
+          loop_linear_box(tile.imin(), tile.imax(), f, iss...);
+        });
+    for (const auto &fut : fs)
+      fut.wait();
+  }
+
   friend std::ostream &operator<<(std::ostream &os, const index_space &is) {
     adt::index_t<D + 1> strides;
     for (std::ptrdiff_t d = 0; d <= std::ptrdiff_t(D); ++d)
@@ -220,6 +390,16 @@ public:
 template <std::size_t D> void swap(index_space<D> &x, index_space<D> &y) {
   x.swap(y);
 }
+
+// The alignment of the storage of an accumulator, if it declares one
+template <typename Acc, typename T>
+constexpr std::size_t storage_alignment(decltype(Acc::alignment) *) {
+  return Acc::alignment;
+}
+template <typename Acc, typename T>
+constexpr std::size_t storage_alignment(...) {
+  return alignof(T);
+}
 }
 
 template <typename C, typename T, std::size_t D> class grid {
@@ -244,10 +424,48 @@ private:
   index_space indexing;
   container_constructor<T> data;
 
+  // Only the points of the grid are sent, stored contiguously. (A
+  // boundary shares the storage of its grid, which would otherwise be
+  // sent as a whole.)
   friend class cereal::access;
-  template <typename Archive> void serialize(Archive &ar) {
-    // TODO: Serialize only the accessible part of data
-    ar(indexing, data);
+  template <typename Archive> void save(Archive &ar) const {
+    ar(indexing.shape());
+    if (indexing.contiguous()) {
+      cxx::save_container(ar, data);
+      return;
+    }
+    index_space dense(indexing.shape());
+    fun::accumulator<container_constructor<T>> acc(dense.allocated_size());
+    dense.loop_linear(
+        [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+          acc[lin] = fun::getIndex(data, xlin);
+        },
+        indexing);
+    container_constructor<T> xs = acc.finalize();
+    cxx::save_container(ar, xs);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    index_type shape;
+    ar(shape);
+    indexing = make_indexing(shape);
+    if (indexing.contiguous()) {
+      // Load in place, so that a grid that is loaded repeatedly (e.g. a
+      // halo buffer) keeps its storage if its size does not change
+      cxx::load_container(ar, data);
+    } else {
+      container_constructor<T> xs;
+      cxx::load_container(ar, xs);
+      index_space dense(shape);
+      fun::accumulator<container_constructor<T>> acc(
+          indexing.allocated_size());
+      indexing.loop_linear(
+          [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+            acc[lin] = fun::getIndex(xs, xlin);
+          },
+          dense);
+      data = acc.finalize();
+    }
+    cxx_assert(invariant());
   }
 
 public:
@@ -260,6 +478,22 @@ private:
     return indexing.allocated_size() == std::ptrdiff_t(fun::msize(data));
   }
 
+  // Grids with over-aligned storage (e.g. a std::vector with a
+  // cxx::aligned_allocator) pad their rows to the alignment, up to a
+  // cache line; other grids are stored contiguously
+  static index_space make_indexing(const index_type &shape) {
+    constexpr std::size_t alignment = detail::storage_alignment<
+        fun::accumulator<container_constructor<T>>, T>(nullptr);
+    if (alignment <= alignof(T))
+      return index_space(shape);
+    constexpr std::size_t row_alignment =
+        std::min(alignment, cxx::cache_line_size);
+    constexpr std::ptrdiff_t pad0 =
+        row_alignment % sizeof(T) == 0 ? row_alignment / sizeof(T) : 1;
+    return index_space(typename index_space::padded(), shape, pad0,
+                       sizeof(T));
+  }
+
 public:
   bool invariant() const {
     auto inv = invariant0();
@@ -295,14 +529,51 @@ public:
     swap(data, other.data);
   }
 
-  const T &head() const {
+  decltype(auto) head() const {
     return fun::getIndex(data, indexing.linear(adt::set<index_type>(0)));
   }
-  const T &last() const {
+  decltype(auto) last() const {
     return fun::getIndex(
         data, indexing.linear(indexing.shape() - adt::set<index_type>(1)));
   }
 
+private:
+  // Tiles of parallel loops should fit into the L1 cache
+  static constexpr std::size_t tile_bytes = 32 * 1024;
+
+  // Loop over all points, using the given execution policy
+  template <typename F>
+  void loop(const cxx::execution::sequenced_policy &, F &&f) const {
+    indexing.loop(std::forward<F>(f));
+  }
+  template <typename Policy, typename F,
+            std::enable_if_t<cxx::is_parallel_execution_policy<Policy>::value>
+                * = nullptr>
+  void loop(const Policy &, F &&f) const {
+    static qthread::grain_size grain(
+        qthread::grain_size::default_target_time,
+        std::max(std::size_t(1), tile_bytes / sizeof(T)));
+    indexing.parallel_loop(grain, std::forward<F>(f));
+  }
+
+  // Loop over all points, passing linear indices into this grid's and
+  // the other index spaces
+  template <typename F, typename... ISs>
+  void loop_linear(const cxx::execution::sequenced_policy &, F &&f,
+                   const ISs &... iss) const {
+    indexing.loop_linear(std::forward<F>(f), iss...);
+  }
+  template <typename Policy, typename F, typename... ISs,
+            std::enable_if_t<cxx::is_parallel_execution_policy<Policy>::value>
+                * = nullptr>
+  void loop_linear(const Policy &, F &&f, const ISs &... iss) const {
+    static qthread::grain_size grain(
+        qthread::grain_size::default_target_time,
+        std::max(std::size_t(1), tile_bytes / sizeof(T)));
+    indexing.parallel_loop_linear(grain, std::forward<F>(f), iss...);
+  }
+
+public:
   // iotaMap
 
   struct iotaMap {};
@@ -335,12 +606,23 @@ public:
 
   template <typename F, typename... Args>
   grid(iotaMapMulti, F &&f, const adt::steprange_t<D> &inds, Args &&... args)
-      : indexing(inds.shape()) {
+      : grid(iotaMapMulti(), cxx::execution::seq, std::forward<F>(f), inds,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(iotaMapMulti, const Policy &policy, F &&f,
+       const adt::steprange_t<D> &inds, Args &&... args)
+      : indexing(make_indexing(inds.shape())) {
     static_assert(
         std::is_same<cxx::invoke_of_t<F, index_type, Args...>, T>::value, "");
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    indexing.loop([&](const index_type &i) {
-      acc[indexing.linear(i)] = cxx::invoke(f, i, args...);
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    // f receives the indices of inds, not the grid-local ones
+    const index_type imin = inds.imin(), istep = inds.istep();
+    loop(policy, [&](const index_type &i) {
+      acc[indexing.linear(i)] = cxx::invoke(f, imin + i * istep, args...);
     });
     data = acc.finalize();
     cxx_assert(invariant());
@@ -352,12 +634,56 @@ public:
 
   template <typename F, typename T1, typename... Args>
   grid(fmap, F &&f, const grid<C, T1, D> &xs, Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmap(), cxx::execution::seq, std::forward<F>(f), xs,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename T1, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmap, const Policy &policy, F &&f, const grid<C, T1, D> &xs,
+       Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(std::is_same<cxx::invoke_of_t<F, T1, Args...>, T>::value, "");
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    indexing.loop([&](const index_type &i) {
-      acc[indexing.linear(i)] = cxx::invoke(
-          f, fun::getIndex(xs.data, xs.indexing.linear(i)), args...);
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop_linear(policy,
+                [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+                  acc[lin] =
+                      cxx::invoke(f, fun::getIndex(xs.data, xlin), args...);
+                },
+                xs.indexing);
+    data = acc.finalize();
+    cxx_assert(invariant());
+  }
+
+private:
+  // Whether the storage of a grid<C, T1, D> can hold the result
+  template <typename T1>
+  using can_reuse =
+      std::integral_constant<bool,
+                             std::is_same<T1, T>::value &&
+                                 std::is_constructible<
+                                     fun::accumulator<container_constructor<T>>,
+                                     container_constructor<T> &&>::value>;
+
+public:
+  // These reuse the storage of xs if possible
+
+  template <typename F, typename T1, typename... Args>
+  grid(fmap, F &&f, grid<C, T1, D> &&xs, Args &&... args)
+      : grid(fmap(), cxx::execution::seq, std::forward<F>(f), std::move(xs),
+             std::forward<Args>(args)...) {}
+
+  template <typename Policy, typename F, typename T1, typename... Args,
+            std::enable_if_t<cxx::is_execution_policy<Policy>::value &&
+                             can_reuse<T1>::value> * = nullptr>
+  grid(fmap, const Policy &policy, F &&f, grid<C, T1, D> &&xs,
+       Args &&... args)
+      : indexing(xs.indexing) {
+    static_assert(std::is_same<cxx::invoke_of_t<F, T1, Args...>, T>::value, "");
+    fun::accumulator<container_constructor<T>> acc(std::move(xs.data));
+    loop_linear(policy, [&](std::ptrdiff_t lin) {
+      acc[lin] = cxx::invoke(f, std::move(acc[lin]), args...);
     });
     data = acc.finalize();
     cxx_assert(invariant());
@@ -368,16 +694,55 @@ public:
   template <typename F, typename T1, typename T2, typename... Args>
   grid(fmap2, F &&f, const grid<C, T1, D> &xs, const grid<C, T2, D> &ys,
        Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmap2(), cxx::execution::seq, std::forward<F>(f), xs, ys,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename T1, typename T2, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmap2, const Policy &policy, F &&f, const grid<C, T1, D> &xs,
+       const grid<C, T2, D> &ys, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(std::is_same<cxx::invoke_of_t<F, T1, T2, Args...>, T>::value,
                   "");
     cxx_assert(ys.shape() == xs.shape());
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    indexing.loop([&](const index_type &i) {
-      acc[indexing.linear(i)] =
-          cxx::invoke(f, fun::getIndex(xs.data, xs.indexing.linear(i)),
-                      fun::getIndex(ys.data, ys.indexing.linear(i)), args...);
-    });
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop_linear(policy,
+                [&](std::ptrdiff_t lin, std::ptrdiff_t xlin,
+                    std::ptrdiff_t ylin) {
+                  acc[lin] = cxx::invoke(f, fun::getIndex(xs.data, xlin),
+                                         fun::getIndex(ys.data, ylin), args...);
+                },
+                xs.indexing, ys.indexing);
+    data = acc.finalize();
+    cxx_assert(invariant());
+  }
+
+  template <typename F, typename T1, typename T2, typename... Args>
+  grid(fmap2, F &&f, grid<C, T1, D> &&xs, const grid<C, T2, D> &ys,
+       Args &&... args)
+      : grid(fmap2(), cxx::execution::seq, std::forward<F>(f), std::move(xs),
+             ys, std::forward<Args>(args)...) {}
+
+  template <typename Policy, typename F, typename T1, typename T2,
+            typename... Args,
+            std::enable_if_t<cxx::is_execution_policy<Policy>::value &&
+                             can_reuse<T1>::value> * = nullptr>
+  grid(fmap2, const Policy &policy, F &&f, grid<C, T1, D> &&xs,
+       const grid<C, T2, D> &ys, Args &&... args)
+      : indexing(xs.indexing) {
+    static_assert(std::is_same<cxx::invoke_of_t<F, T1, T2, Args...>, T>::value,
+                  "");
+    cxx_assert(ys.shape() == xs.shape());
+    cxx_assert(static_cast<const void *>(&ys) != &xs);
+    fun::accumulator<container_constructor<T>> acc(std::move(xs.data));
+    loop_linear(policy,
+                [&](std::ptrdiff_t lin, std::ptrdiff_t ylin) {
+                  acc[lin] = cxx::invoke(f, std::move(acc[lin]),
+                                         fun::getIndex(ys.data, ylin), args...);
+                },
+                ys.indexing);
     data = acc.finalize();
     cxx_assert(invariant());
   }
@@ -387,18 +752,30 @@ public:
   template <typename F, typename T1, typename T2, typename T3, typename... Args>
   grid(fmap3, F &&f, const grid<C, T1, D> &xs, const grid<C, T2, D> &ys,
        const grid<C, T3, D> &zs, Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmap3(), cxx::execution::seq, std::forward<F>(f), xs, ys, zs,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename T1, typename T2, typename T3,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmap3, const Policy &policy, F &&f, const grid<C, T1, D> &xs,
+       const grid<C, T2, D> &ys, const grid<C, T3, D> &zs, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(
         std::is_same<cxx::invoke_of_t<F, T1, T2, T3, Args...>, T>::value, "");
     cxx_assert(ys.shape() == xs.shape());
     cxx_assert(zs.shape() == xs.shape());
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    indexing.loop([&](const index_type &i) {
-      acc[indexing.linear(i)] =
-          cxx::invoke(f, fun::getIndex(xs.data, xs.indexing.linear(i)),
-                      fun::getIndex(ys.data, ys.indexing.linear(i)),
-                      fun::getIndex(zs.data, zs.indexing.linear(i)), args...);
-    });
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop_linear(policy,
+                [&](std::ptrdiff_t lin, std::ptrdiff_t xlin,
+                    std::ptrdiff_t ylin, std::ptrdiff_t zlin) {
+                  acc[lin] = cxx::invoke(f, fun::getIndex(xs.data, xlin),
+                                         fun::getIndex(ys.data, ylin),
+                                         fun::getIndex(zs.data, zlin), args...);
+                },
+                xs.indexing, ys.indexing, zs.indexing);
     data = acc.finalize();
     cxx_assert(invariant());
   }
@@ -413,142 +790,857 @@ public:
     cxx_assert(invariant());
   }
 
+  // boundaryMap
+
+  // Unlike boundary, these do not copy the data of the source grids
+
+  struct boundaryMap {};
+
+  template <typename F, typename T1, typename... Args>
+  grid(boundaryMap, F &&f, const grid<C, T1, D + 1> &xs, std::ptrdiff_t i,
+       Args &&... args)
+      : indexing(make_indexing(
+            index_space(typename index_space::boundary(), xs.indexing, i)
+                .shape())) {
+    static_assert(std::is_same<cxx::invoke_of_t<F, T1, Args...>, T>::value, "");
+    index_space xbnd(typename index_space::boundary(), xs.indexing, i);
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    indexing.loop_linear(
+        [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+          acc[lin] = cxx::invoke(f, fun::getIndex(xs.data, xlin), args...);
+        },
+        xbnd);
+    data = acc.finalize();
+    cxx_assert(invariant());
+  }
+
+  struct boundaryMap2 {};
+
+  template <typename F, typename T1, typename T2, typename... Args>
+  grid(boundaryMap2, F &&f, const grid<C, T1, D + 1> &xs,
+       const grid<C, T2, D + 1> &ys, std::ptrdiff_t i, Args &&... args)
+      : indexing(make_indexing(
+            index_space(typename index_space::boundary(), xs.indexing, i)
+                .shape())) {
+    static_assert(std::is_same<cxx::invoke_of_t<F, T1, T2, Args...>, T>::value,
+                  "");
+    cxx_assert(ys.shape() == xs.shape());
+    index_space xbnd(typename index_space::boundary(), xs.indexing, i);
+    index_space ybnd(typename index_space::boundary(), ys.indexing, i);
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    indexing.loop_linear(
+        [&](std::ptrdiff_t lin, std::ptrdiff_t xlin, std::ptrdiff_t ylin) {
+          acc[lin] = cxx::invoke(f, fun::getIndex(xs.data, xlin),
+                                 fun::getIndex(ys.data, ylin), args...);
+        },
+        xbnd, ybnd);
+    data = acc.finalize();
+    cxx_assert(invariant());
+  }
+
+  // boundaryMapWide: each element holds the K outermost layers of the
+  // boundary, starting at the boundary and going inwards
+
+  template <std::size_t K> struct boundaryMapWide {};
+
+  template <std::size_t K, typename F, typename T1, typename... Args>
+  grid(boundaryMapWide<K>, F &&f, const grid<C, T1, D + 1> &xs,
+       std::ptrdiff_t i, Args &&... args)
+      : indexing(make_indexing(
+            index_space(typename index_space::boundary(), xs.indexing, i)
+                .shape())) {
+    typedef cxx::invoke_of_t<F, T1, Args...> R;
+    static_assert(std::is_same<std::array<R, K>, T>::value, "");
+    std::ptrdiff_t d = i / 2, f0 = i % 2;
+    cxx_assert(xs.shape()[d] >= std::ptrdiff_t(K));
+    index_space xbnd(typename index_space::boundary(), xs.indexing, i);
+    std::ptrdiff_t step = f0 ? -xs.indexing.stride(d) : xs.indexing.stride(d);
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    indexing.loop_linear(
+        [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+          T layers;
+          for (std::size_t k = 0; k < K; ++k)
+            layers[k] = cxx::invoke(
+                f, fun::getIndex(xs.data, xlin + std::ptrdiff_t(k) * step),
+                args...);
+          acc[lin] = std::move(layers);
+        },
+        xbnd);
+    data = acc.finalize();
+    cxx_assert(invariant());
+  }
+
   // fmapStencilMulti
 
+private:
+  // Evaluate a stencil on all points of the input index spaces iss:
+  // fi(lins, bdirs, bs...) evaluates the point at the linear indices
+  // lins, given the boundary mask and the neighbouring faces, and
+  // gi(lins, dir) evaluates the face of the point at lins that faces
+  // in direction dir
+  template <typename Policy, std::size_t N, typename FI, typename GI,
+            std::size_t D2 = D, std::enable_if_t<D2 == 0> * = nullptr>
+  void stencil(const Policy &policy,
+               const std::array<const index_space *, N> &iss,
+               std::size_t bmask, const FI &fi, const GI &gi) {
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop(policy, [&](const index_type &i) {
+      std::array<std::ptrdiff_t, N> lins;
+      for (std::size_t n = 0; n < N; ++n)
+        lins[n] = iss[n]->linear(i);
+      std::size_t bdirs = 0;
+      acc[indexing.linear(i)] = fi(lins, bdirs);
+    });
+    data = acc.finalize();
+  }
+
+  template <typename Policy, std::size_t N, typename FI, typename GI,
+            typename BCB, std::size_t D2 = D,
+            std::enable_if_t<D2 == 1> * = nullptr>
+  void stencil(const Policy &policy,
+               const std::array<const index_space *, N> &iss,
+               std::size_t bmask, const FI &fi, const GI &gi, const BCB &bm0,
+               const BCB &bp0) {
+    typedef typename BCB::value_type B;
+    std::array<std::ptrdiff_t, N> di0;
+    for (std::size_t n = 0; n < N; ++n) {
+      cxx_assert(iss[n]->shape() == indexing.shape());
+      di0[n] = iss[n]->stride(0);
+    }
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop(policy, [&](const index_type &i) {
+      std::array<std::ptrdiff_t, N> lins, lm0, lp0;
+      for (std::size_t n = 0; n < N; ++n) {
+        lins[n] = iss[n]->linear(i);
+        lm0[n] = lins[n] - di0[n];
+        lp0[n] = lins[n] + di0[n];
+      }
+      bool isbm0 = i[0] == 0;
+      bool isbp0 = i[0] == indexing.shape()[0] - 1;
+      std::size_t bdirs = bmask & ((isbm0 << 0) | (isbp0 << 1));
+      const B &cm0 =
+          isbm0 ? fun::getIndex(bm0.data, bm0.indexing.linear(rmdir<0>(i)))
+                : gi(lm0, 1);
+      const B &cp0 =
+          isbp0 ? fun::getIndex(bp0.data, bp0.indexing.linear(rmdir<0>(i)))
+                : gi(lp0, 0);
+      acc[indexing.linear(i)] = fi(lins, bdirs, cm0, cp0);
+    });
+    data = acc.finalize();
+  }
+
+  template <typename Policy, std::size_t N, typename FI, typename GI,
+            typename BCB, std::size_t D2 = D,
+            std::enable_if_t<D2 == 2> * = nullptr>
+  void stencil(const Policy &policy,
+               const std::array<const index_space *, N> &iss,
+               std::size_t bmask, const FI &fi, const GI &gi, const BCB &bm0,
+               const BCB &bm1, const BCB &bp0, const BCB &bp1) {
+    typedef typename BCB::value_type B;
+    std::array<std::ptrdiff_t, N> di0, di1;
+    for (std::size_t n = 0; n < N; ++n) {
+      cxx_assert(iss[n]->shape() == indexing.shape());
+      di0[n] = iss[n]->stride(0);
+      di1[n] = iss[n]->stride(1);
+    }
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop(policy, [&](const index_type &i) {
+      std::array<std::ptrdiff_t, N> lins, lm0, lm1, lp0, lp1;
+      for (std::size_t n = 0; n < N; ++n) {
+        lins[n] = iss[n]->linear(i);
+        lm0[n] = lins[n] - di0[n];
+        lm1[n] = lins[n] - di1[n];
+        lp0[n] = lins[n] + di0[n];
+        lp1[n] = lins[n] + di1[n];
+      }
+      bool isbm0 = i[0] == 0;
+      bool isbm1 = i[1] == 0;
+      bool isbp0 = i[0] == indexing.shape()[0] - 1;
+      bool isbp1 = i[1] == indexing.shape()[1] - 1;
+      std::size_t bdirs =
+          bmask & ((isbm0 << 0) | (isbm1 << 2) | (isbp0 << 1) | (isbp1 << 3));
+      const B &cm0 =
+          isbm0 ? fun::getIndex(bm0.data, bm0.indexing.linear(rmdir<0>(i)))
+                : gi(lm0, 1);
+      const B &cm1 =
+          isbm1 ? fun::getIndex(bm1.data, bm1.indexing.linear(rmdir<1>(i)))
+                : gi(lm1, 3);
+      const B &cp0 =
+          isbp0 ? fun::getIndex(bp0.data, bp0.indexing.linear(rmdir<0>(i)))
+                : gi(lp0, 0);
+      const B &cp1 =
+          isbp1 ? fun::getIndex(bp1.data, bp1.indexing.linear(rmdir<1>(i)))
+                : gi(lp1, 2);
+      acc[indexing.linear(i)] = fi(lins, bdirs, cm0, cm1, cp0, cp1);
+    });
+    data = acc.finalize();
+  }
+
+  // Evaluate a stencil of radius K on all points of the index space
+  // is: fi(lin, bdirs, nbs) evaluates the point at the linear index
+  // lin, where nbs[2 * d + f] holds the K nearest neighbours in
+  // direction d (f = 0: downwards, f = 1: upwards), nearest first.
+  // Inside the grid, neighbours are evaluated via gi(lin, dir);
+  // outside, they are taken from the K boundary layers in bs.
+  template <std::size_t K, typename Policy, typename FI, typename GI,
+            typename BCB>
+  void stencil_wide(const Policy &policy, const index_space &is,
+                    std::size_t bmask, const FI &fi, const GI &gi,
+                    const std::array<const BCB *, 2 * D> &bs) {
+    typedef typename BCB::value_type BK;
+    static_assert(std::tuple_size<BK>::value == K, "");
+    cxx_assert(is.shape() == indexing.shape());
+    const std::ptrdiff_t k0 = K;
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop(policy, [&](const index_type &i) {
+      std::ptrdiff_t lin = is.linear(i);
+      std::size_t bdirs = 0;
+      std::array<BK, 2 * D> nbs;
+      for (std::size_t d = 0; d < D; ++d) {
+        std::ptrdiff_t n = indexing.shape()[d];
+        std::ptrdiff_t di = is.stride(d);
+        bool isbm = i[d] < k0;
+        bool isbp = i[d] >= n - k0;
+        bdirs |= (std::size_t(isbm) << (2 * d)) |
+                 (std::size_t(isbp) << (2 * d + 1));
+        const BK *bm = nullptr, *bp = nullptr;
+        if (isbm || isbp) {
+          auto bi = rmdir(i, d);
+          if (isbm)
+            bm = &fun::getIndex(bs[2 * d]->data,
+                                bs[2 * d]->indexing.linear(bi));
+          if (isbp)
+            bp = &fun::getIndex(bs[2 * d + 1]->data,
+                                bs[2 * d + 1]->indexing.linear(bi));
+        }
+        for (std::ptrdiff_t k = 0; k < k0; ++k) {
+          std::ptrdiff_t jm = i[d] - 1 - k, jp = i[d] + 1 + k;
+          nbs[2 * d][k] =
+              jm >= 0 ? gi(lin - (k + 1) * di, 2 * d + 1) : (*bm)[-1 - jm];
+          nbs[2 * d + 1][k] =
+              jp < n ? gi(lin + (k + 1) * di, 2 * d) : (*bp)[jp - n];
+        }
+      }
+      acc[indexing.linear(i)] = fi(lin, bmask & bdirs, nbs);
+    });
+    data = acc.finalize();
+  }
+
+  // Set all points of the grid to the points of xs, advanced by ns
+  // steps of a stencil, where fi(x, bdirs, nbs) evaluates a point from
+  // the point x and its neighbours nbs[2 * d + f]. Neighbours inside
+  // the grid are evaluated via gi(x, dir), the ones outside via hi(x,
+  // dir) from the point on the boundary itself. The grid is split into
+  // tiles that fit into the cache. Each tile is extended by ns ghost
+  // points on each side and advanced on its own, its valid region
+  // shrinking by one point per step. The ghost points are thus
+  // computed several times, but the grid is read and written only once
+  // for all ns steps.
+  template <typename Policy, typename FI, typename GI, typename HI>
+  void stencil_tiles(const Policy &policy, const grid &xs, std::ptrdiff_t ns,
+                     std::size_t bmask, const FI &fi, const GI &gi,
+                     const HI &hi) {
+    typedef std::decay_t<cxx::invoke_of_t<GI, T, std::ptrdiff_t>> B;
+    cxx_assert(ns > 0);
+    cxx_assert(xs.shape() == indexing.shape());
+    const index_type shape = indexing.shape();
+    const index_type tshape = iterate_tile_shape(ns);
+    index_type ntiles;
+    for (std::size_t d = 0; d < D; ++d)
+      ntiles[d] = (shape[d] + tshape[d] - 1) / tshape[d];
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    loop_tiles(policy, ntiles, [&](const index_type &ti) {
+      const index_type tmin = ti * tshape;
+      const index_type tmax = adt::min(tmin + tshape, shape);
+      const index_type bmin = adt::max(adt::set<index_type>(0), tmin - ns);
+      const index_type bmax = adt::min(tmax + ns, shape);
+      index_type strs;
+      std::ptrdiff_t str = 1;
+      for (std::size_t d = 0; d < D; ++d) {
+        strs[d] = str;
+        str *= bmax[d] - bmin[d];
+      }
+      auto lin = [&](const index_type &i) {
+        std::ptrdiff_t l = 0;
+        for (std::size_t d = 0; d < D; ++d)
+          l += strs[d] * (i[d] - bmin[d]);
+        return l;
+      };
+      std::vector<T> xs0;
+      xs0.reserve(str);
+      adt::range_t<D>(bmin, bmax).loop([&](const index_type &i) {
+        xs0.push_back(fun::getIndex(xs.data, xs.indexing.linear(i)));
+      });
+      std::vector<T> xs1(xs0);
+      index_type vmin = bmin, vmax = bmax;
+      for (std::ptrdiff_t s = 0; s < ns; ++s) {
+        // Ghost points are valid for one step less
+        for (std::size_t d = 0; d < D; ++d) {
+          vmin[d] += bmin[d] > 0;
+          vmax[d] -= bmax[d] < shape[d];
+        }
+        adt::range_t<D>(vmin, vmax).loop([&](const index_type &i) {
+          std::ptrdiff_t l = lin(i);
+          const T &x = xs0[l];
+          std::size_t bdirs = 0;
+          std::array<B, 2 * D> nbs;
+          for (std::size_t d = 0; d < D; ++d) {
+            bool isbm = i[d] == 0;
+            bool isbp = i[d] == shape[d] - 1;
+            bdirs |= (std::size_t(isbm) << (2 * d)) |
+                     (std::size_t(isbp) << (2 * d + 1));
+            nbs[2 * d] = isbm ? hi(x, 2 * d) : gi(xs0[l - strs[d]], 2 * d + 1);
+            nbs[2 * d + 1] =
+                isbp ? hi(x, 2 * d + 1) : gi(xs0[l + strs[d]], 2 * d);
+          }
+          xs1[l] = fi(x, bmask & bdirs, nbs);
+        });
+        std::swap(xs0, xs1);
+      }
+      adt::range_t<D>(tmin, tmax).loop([&](const index_type &i) {
+        acc[indexing.linear(i)] = std::move(xs0[lin(i)]);
+      });
+    });
+    data = acc.finalize();
+  }
+
+  // Tiles of iterated stencils, including their ghost points and a
+  // second copy, should fit into the L2 cache
+  static constexpr std::size_t iterate_tile_bytes = 256 * 1024;
+  // Number of steps taken at once; the redundant work on the ghost
+  // points grows with this number
+  static constexpr std::ptrdiff_t iterate_max_steps = 4;
+
+  static index_type iterate_tile_shape(std::ptrdiff_t ns) {
+    std::ptrdiff_t npoints =
+        std::max(std::size_t(1), iterate_tile_bytes / (2 * sizeof(T)));
+    std::ptrdiff_t extent = std::pow(double(npoints), 1.0 / D);
+    return adt::set<index_type>(std::max(extent - 2 * ns, ns));
+  }
+
+  template <typename F>
+  static void loop_tiles(const cxx::execution::sequenced_policy &,
+                         const index_type &ntiles, F &&f) {
+    adt::range_t<D>(ntiles).loop(std::forward<F>(f));
+  }
+  template <typename Policy, typename F,
+            std::enable_if_t<cxx::is_parallel_execution_policy<Policy>::value>
+                * = nullptr>
+  static void loop_tiles(const Policy &, const index_type &ntiles, F &&f) {
+    static qthread::grain_size grain(qthread::grain_size::default_target_time,
+                                     1);
+    auto fs = qthread::parallel_for(grain, adt::steprange_t<D>(ntiles),
+                                    std::forward<F>(f));
+    for (const auto &fut : fs)
+      fut.wait();
+  }
+
+public:
   struct fmapStencilMulti {};
 
   template <typename F, typename G, typename T1, typename... Args>
   grid(fmapStencilMulti, F &&f, G &&g, const grid<C, T1, 0> &xs,
        std::size_t bmask, Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmapStencilMulti(), cxx::execution::seq, std::forward<F>(f),
+             std::forward<G>(g), xs, bmask, std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmapStencilMulti, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 0> &xs, std::size_t bmask, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(D == 0, "");
-    typedef cxx::invoke_of_t<G, T1, std::ptrdiff_t> B
-        __attribute__((__unused__));
     static_assert(
         std::is_same<cxx::invoke_of_t<F, T1, std::size_t, Args...>, T>::value,
         "");
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    indexing.loop([&](const index_type &i) {
-      std::size_t bdirs = 0;
-      acc[indexing.linear(i)] = cxx::invoke(
-          f, fun::getIndex(xs.data, xs.indexing.linear(i)), bdirs, args...);
-    });
-    data = acc.finalize();
+    std::array<const index_space *, 1> iss{{&xs.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::size_t bdirs) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]), bdirs,
+                                 args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]), dir);
+            });
     cxx_assert(invariant());
   }
 
   template <
       typename F, typename G, typename T1, typename... Args,
       typename BC = grid<C, adt::dummy, 0>,
-      typename B = cxx::invoke_of_t<G, T, std::ptrdiff_t>,
+      typename B = cxx::invoke_of_t<G, T1, std::ptrdiff_t>,
       typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
   grid(fmapStencilMulti, F &&f, G &&g, const grid<C, T1, 1> &xs,
        std::size_t bmask, const BCB &bm0, const BCB &bp0, Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmapStencilMulti(), cxx::execution::seq, std::forward<F>(f),
+             std::forward<G>(g), xs, bmask, bm0, bp0,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 0>,
+      typename B = cxx::invoke_of_t<G, T1, std::ptrdiff_t>,
+      typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
+  grid(fmapStencilMulti, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 1> &xs, std::size_t bmask, const BCB &bm0,
+       const BCB &bp0, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(D == 1, "");
     typedef cxx::invoke_of_t<F, T1, std::size_t, B, B, Args...> R;
     static_assert(std::is_same<R, T>::value, "");
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    auto di = xs.indexing.linear(array_dir<std::ptrdiff_t, D, 0>());
-    indexing.loop([&](const index_type &i) {
-      bool isbm0 = i[0] == 0;
-      bool isbp0 = i[0] == xs.indexing.shape()[0] - 1;
-      std::size_t bdirs = bmask & ((isbm0 << 0) | (isbp0 << 1));
-      const B &cm0 =
-          isbm0 ? fun::getIndex(bm0.data, bm0.indexing.linear(rmdir<0>(i)))
-                : cxx::invoke(
-                      g, fun::getIndex(xs.data, xs.indexing.linear(i - di)), 1);
-      const B &cp0 =
-          isbp0 ? fun::getIndex(bp0.data, bp0.indexing.linear(rmdir<0>(i)))
-                : cxx::invoke(
-                      g, fun::getIndex(xs.data, xs.indexing.linear(i + di)), 0);
-      acc[indexing.linear(i)] =
-          cxx::invoke(f, fun::getIndex(xs.data, xs.indexing.linear(i)), bdirs,
-                      cm0, cp0, args...);
-    });
-    data = acc.finalize();
+    std::array<const index_space *, 1> iss{{&xs.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::size_t bdirs,
+                const B &cm0, const B &cp0) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]), bdirs, cm0,
+                                 cp0, args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]), dir);
+            },
+            bm0, bp0);
     cxx_assert(invariant());
   }
 
   template <
       typename F, typename G, typename T1, typename... Args,
       typename BC = grid<C, adt::dummy, 1>,
-      typename B = cxx::invoke_of_t<G, T, std::ptrdiff_t>,
+      typename B = cxx::invoke_of_t<G, T1, std::ptrdiff_t>,
       typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
   grid(fmapStencilMulti, F &&f, G &&g, const grid<C, T1, 2> &xs,
        std::size_t bmask, const BCB &bm0, const BCB &bm1, const BCB &bp0,
        const BCB &bp1, Args &&... args)
-      : indexing(xs.shape()) {
+      : grid(fmapStencilMulti(), cxx::execution::seq, std::forward<F>(f),
+             std::forward<G>(g), xs, bmask, bm0, bm1, bp0, bp1,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 1>,
+      typename B = cxx::invoke_of_t<G, T1, std::ptrdiff_t>,
+      typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
+  grid(fmapStencilMulti, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 2> &xs, std::size_t bmask, const BCB &bm0,
+       const BCB &bm1, const BCB &bp0, const BCB &bp1, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
     static_assert(D == 2, "");
     typedef cxx::invoke_of_t<F, T1, std::size_t, B, B, B, B, Args...> R;
     static_assert(std::is_same<R, T>::value, "");
-    fun::accumulator<container_constructor<T>> acc(indexing.size());
-    auto di0 = array_dir<std::ptrdiff_t, D, 0>();
-    auto di1 = array_dir<std::ptrdiff_t, D, 1>();
-    indexing.loop([&](const index_type &i) {
-      bool isbm0 = i[0] == 0;
-      bool isbm1 = i[1] == 0;
-      bool isbp0 = i[0] == xs.indexing.shape()[0] - 1;
-      bool isbp1 = i[1] == xs.indexing.shape()[1] - 1;
-      std::size_t bdirs =
-          bmask & ((isbm0 << 0) | (isbm1 << 2) | (isbp0 << 1) | (isbp1 << 3));
-      const B &cm0 =
-          isbm0
-              ? fun::getIndex(bm0.data, bm0.indexing.linear(rmdir<0>(i)))
-              : cxx::invoke(
-                    g, fun::getIndex(xs.data, xs.indexing.linear(i - di0)), 1);
-      const B &cm1 =
-          isbm1
-              ? fun::getIndex(bm1.data, bm1.indexing.linear(rmdir<1>(i)))
-              : cxx::invoke(
-                    g, fun::getIndex(xs.data, xs.indexing.linear(i - di1)), 3);
-      const B &cp0 =
-          isbp0
-              ? fun::getIndex(bp0.data, bp0.indexing.linear(rmdir<0>(i)))
-              : cxx::invoke(
-                    g, fun::getIndex(xs.data, xs.indexing.linear(i + di0)), 0);
-      const B &cp1 =
-          isbp1
-              ? fun::getIndex(bp1.data, bp1.indexing.linear(rmdir<1>(i)))
-              : cxx::invoke(
-                    g, fun::getIndex(xs.data, xs.indexing.linear(i + di1)), 2);
-      acc[indexing.linear(i)] =
-          cxx::invoke(f, fun::getIndex(xs.data, xs.indexing.linear(i)), bdirs,
-                      cm0, cm1, cp0, cp1, args...);
-    });
-    data = acc.finalize();
+    std::array<const index_space *, 1> iss{{&xs.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::size_t bdirs,
+                const B &cm0, const B &cm1, const B &cp0, const B &cp1) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]), bdirs, cm0,
+                                 cm1, cp0, cp1, args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 1> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]), dir);
+            },
+            bm0, bm1, bp0, bp1);
+    cxx_assert(invariant());
+  }
+
+  // fmapStencilMultiWide: a stencil of radius K, where f receives the
+  // K nearest neighbours in each direction, and the boundaries hold K
+  // layers (see boundaryMapWide)
+
+  template <std::size_t K> struct fmapStencilMultiWide {};
+
+  template <
+      std::size_t K, typename F, typename G, typename T1, typename... Args,
+      typename BC = grid<C, adt::dummy, 0>,
+      typename B = std::decay_t<cxx::invoke_of_t<G, T1, std::ptrdiff_t>>,
+      typename BCB =
+          typename fun::fun_traits<BC>::template constructor<std::array<B, K>>>
+  grid(fmapStencilMultiWide<K>, F &&f, G &&g, const grid<C, T1, 1> &xs,
+       std::size_t bmask, const BCB &bm0, const BCB &bp0, Args &&... args)
+      : grid(fmapStencilMultiWide<K>(), cxx::execution::seq,
+             std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bp0,
+             std::forward<Args>(args)...) {}
+
+  template <
+      std::size_t K, typename Policy, typename F, typename G, typename T1,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 0>,
+      typename B = std::decay_t<cxx::invoke_of_t<G, T1, std::ptrdiff_t>>,
+      typename BCB =
+          typename fun::fun_traits<BC>::template constructor<std::array<B, K>>>
+  grid(fmapStencilMultiWide<K>, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 1> &xs, std::size_t bmask, const BCB &bm0,
+       const BCB &bp0, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D == 1, "");
+    typedef std::array<B, K> BK;
+    typedef cxx::invoke_of_t<F, T1, std::size_t, BK, BK, Args...> R;
+    static_assert(std::is_same<R, T>::value, "");
+    stencil_wide<K>(policy, xs.indexing, bmask,
+                    [&](std::ptrdiff_t lin, std::size_t bdirs,
+                        const std::array<BK, 2> &nbs) {
+                      return cxx::invoke(f, fun::getIndex(xs.data, lin),
+                                         bdirs, nbs[0], nbs[1], args...);
+                    },
+                    [&](std::ptrdiff_t lin, std::ptrdiff_t dir) {
+                      return cxx::invoke(g, fun::getIndex(xs.data, lin), dir);
+                    },
+                    std::array<const BCB *, 2>{{&bm0, &bp0}});
+    cxx_assert(invariant());
+  }
+
+  template <
+      std::size_t K, typename F, typename G, typename T1, typename... Args,
+      typename BC = grid<C, adt::dummy, 1>,
+      typename B = std::decay_t<cxx::invoke_of_t<G, T1, std::ptrdiff_t>>,
+      typename BCB =
+          typename fun::fun_traits<BC>::template constructor<std::array<B, K>>>
+  grid(fmapStencilMultiWide<K>, F &&f, G &&g, const grid<C, T1, 2> &xs,
+       std::size_t bmask, const BCB &bm0, const BCB &bm1, const BCB &bp0,
+       const BCB &bp1, Args &&... args)
+      : grid(fmapStencilMultiWide<K>(), cxx::execution::seq,
+             std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bm1, bp0,
+             bp1, std::forward<Args>(args)...) {}
+
+  template <
+      std::size_t K, typename Policy, typename F, typename G, typename T1,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 1>,
+      typename B = std::decay_t<cxx::invoke_of_t<G, T1, std::ptrdiff_t>>,
+      typename BCB =
+          typename fun::fun_traits<BC>::template constructor<std::array<B, K>>>
+  grid(fmapStencilMultiWide<K>, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 2> &xs, std::size_t bmask, const BCB &bm0,
+       const BCB &bm1, const BCB &bp0, const BCB &bp1, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D == 2, "");
+    typedef std::array<B, K> BK;
+    typedef cxx::invoke_of_t<F, T1, std::size_t, BK, BK, BK, BK, Args...> R;
+    static_assert(std::is_same<R, T>::value, "");
+    stencil_wide<K>(policy, xs.indexing, bmask,
+                    [&](std::ptrdiff_t lin, std::size_t bdirs,
+                        const std::array<BK, 4> &nbs) {
+                      return cxx::invoke(f, fun::getIndex(xs.data, lin),
+                                         bdirs, nbs[0], nbs[2], nbs[1], nbs[3],
+                                         args...);
+                    },
+                    [&](std::ptrdiff_t lin, std::ptrdiff_t dir) {
+                      return cxx::invoke(g, fun::getIndex(xs.data, lin), dir);
+                    },
+                    std::array<const BCB *, 4>{{&bm0, &bp0, &bm1, &bp1}});
+    cxx_assert(invariant());
+  }
+
+  // iterateStencil: nsteps steps of a stencil, where the boundaries of
+  // each step are obtained from the grid itself via h (see
+  // stencil_tiles)
+
+  struct iterateStencil {};
+
+  template <typename F, typename G, typename H, typename... Args>
+  grid(iterateStencil, F &&f, G &&g, H &&h, const grid &xs,
+       std::size_t bmask, std::ptrdiff_t nsteps, Args &&... args)
+      : grid(iterateStencil(), cxx::execution::seq, std::forward<F>(f),
+             std::forward<G>(g), std::forward<H>(h), xs, bmask, nsteps,
+             std::forward<Args>(args)...) {}
+
+  template <
+      typename Policy, typename F, typename G, typename H, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(iterateStencil, const Policy &policy, F &&f, G &&g, H &&h,
+       const grid &xs, std::size_t bmask, std::ptrdiff_t nsteps,
+       Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D > 0, "");
+    typedef std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>> B;
+    static_assert(
+        std::is_same<std::decay_t<cxx::invoke_of_t<H, T, std::ptrdiff_t>>,
+                     B>::value,
+        "");
+    cxx_assert(nsteps >= 0);
+    if (nsteps == 0 || xs.size() == 0) {
+      *this = xs;
+      return;
+    }
+    for (std::ptrdiff_t n = 0; n < nsteps; n += iterate_max_steps) {
+      std::ptrdiff_t ns =
+          std::min(nsteps - n, std::ptrdiff_t(iterate_max_steps));
+      // The first pass reads xs, later ones the result of the previous
+      // pass
+      stencil_tiles(
+          policy, n == 0 ? xs : *this, ns, bmask,
+          [&](const T &x, std::size_t bdirs, const std::array<B, 2 * D> &nbs) {
+            return iterate_invoke(f, x, bdirs, nbs,
+                                  std::make_index_sequence<2 * D>(), args...);
+          },
+          [&](const T &x, std::ptrdiff_t dir) {
+            return cxx::invoke(g, x, dir);
+          },
+          [&](const T &x, std::ptrdiff_t dir) {
+            return cxx::invoke(h, x, dir);
+          });
+    }
+    cxx_assert(invariant());
+  }
+
+private:
+  // f expects the neighbours ordered as bm0, ..., bm(D-1), bp0, ...,
+  // bp(D-1)
+  template <typename F, typename B, std::size_t... Is, typename... Args>
+  static T iterate_invoke(const F &f, const T &x, std::size_t bdirs,
+                          const std::array<B, 2 * D> &nbs,
+                          std::index_sequence<Is...>, const Args &... args) {
+    return cxx::invoke(f, x, bdirs,
+                       nbs[Is < D ? 2 * Is : 2 * (Is - D) + 1]..., args...);
+  }
+
+public:
+
+  // fmapStencilMulti2: a stencil over two grids, where f and g receive
+  // the elements of both grids
+
+  struct fmapStencilMulti2 {};
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename T2,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmapStencilMulti2, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 0> &xs, const grid<C, T2, 0> &ys, std::size_t bmask,
+       Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D == 0, "");
+    static_assert(
+        std::is_same<cxx::invoke_of_t<F, T1, T2, std::size_t, Args...>,
+                     T>::value,
+        "");
+    std::array<const index_space *, 2> iss{{&xs.indexing, &ys.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::size_t bdirs) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), bdirs,
+                                 args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), dir);
+            });
+    cxx_assert(invariant());
+  }
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename T2,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 0>,
+      typename B = cxx::invoke_of_t<G, T1, T2, std::ptrdiff_t>,
+      typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
+  grid(fmapStencilMulti2, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 1> &xs, const grid<C, T2, 1> &ys, std::size_t bmask,
+       const BCB &bm0, const BCB &bp0, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D == 1, "");
+    typedef cxx::invoke_of_t<F, T1, T2, std::size_t, B, B, Args...> R;
+    static_assert(std::is_same<R, T>::value, "");
+    cxx_assert(ys.shape() == xs.shape());
+    std::array<const index_space *, 2> iss{{&xs.indexing, &ys.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::size_t bdirs,
+                const B &cm0, const B &cp0) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), bdirs, cm0,
+                                 cp0, args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), dir);
+            },
+            bm0, bp0);
+    cxx_assert(invariant());
+  }
+
+  template <
+      typename Policy, typename F, typename G, typename T1, typename T2,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename BC = grid<C, adt::dummy, 1>,
+      typename B = cxx::invoke_of_t<G, T1, T2, std::ptrdiff_t>,
+      typename BCB = typename fun::fun_traits<BC>::template constructor<B>>
+  grid(fmapStencilMulti2, const Policy &policy, F &&f, G &&g,
+       const grid<C, T1, 2> &xs, const grid<C, T2, 2> &ys, std::size_t bmask,
+       const BCB &bm0, const BCB &bm1, const BCB &bp0, const BCB &bp1,
+       Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    static_assert(D == 2, "");
+    typedef cxx::invoke_of_t<F, T1, T2, std::size_t, B, B, B, B, Args...> R;
+    static_assert(std::is_same<R, T>::value, "");
+    cxx_assert(ys.shape() == xs.shape());
+    std::array<const index_space *, 2> iss{{&xs.indexing, &ys.indexing}};
+    stencil(policy, iss, bmask,
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::size_t bdirs,
+                const B &cm0, const B &cm1, const B &cp0, const B &cp1) {
+              return cxx::invoke(f, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), bdirs, cm0,
+                                 cm1, cp0, cp1, args...);
+            },
+            [&](const std::array<std::ptrdiff_t, 2> &lins, std::ptrdiff_t dir) {
+              return cxx::invoke(g, fun::getIndex(xs.data, lins[0]),
+                                 fun::getIndex(ys.data, lins[1]), dir);
+            },
+            bm0, bm1, bp0, bp1);
     cxx_assert(invariant());
   }
 
   // foldMap
 
+private:
+  // Fold g(lin, lins...) over the box [imin, imax) onto r, where lin
+  // and lins are the linear indices into this and the other index
+  // spaces. Each row (along dimension 0) is folded as a range.
+  template <typename Op, typename R, typename G, typename... ISs,
+            std::size_t D2 = D, std::enable_if_t<D2 == 0> * = nullptr>
+  R fold_box(const index_type &imin, const index_type &imax, const Op &op,
+             R r, const G &g, const ISs &... iss) const {
+    indexing.loop_linear_box(imin, imax,
+                             [&](std::ptrdiff_t lin, auto... lins) {
+                               r = cxx::invoke(op, std::move(r),
+                                               g(lin, lins...));
+                             },
+                             iss...);
+    return r;
+  }
+  template <typename Op, typename R, typename G, typename... ISs,
+            std::size_t D2 = D, std::enable_if_t<(D2 > 0)> * = nullptr>
+  R fold_box(const index_type &imin, const index_type &imax, const Op &op,
+             R r, const G &g, const ISs &... iss) const {
+    const std::ptrdiff_t len = imax[0] - imin[0];
+    const std::ptrdiff_t str = indexing.stride(0);
+    index_type rmax = imax;
+    rmax[0] = std::min(imax[0], imin[0] + 1);
+    indexing.loop_linear_box(
+        imin, rmax,
+        [&](std::ptrdiff_t lin, auto... lins) {
+          r = fun::detail::fold_range(op, std::move(r), len,
+                                      [&](std::ptrdiff_t i) {
+                                        return g(lin + i * str,
+                                                 (lins + i * iss.stride(0))...);
+                                      });
+        },
+        iss...);
+    return r;
+  }
+
+  // Fold all points; in parallel only if op is associative, and then z
+  // needs to be an identity of op. To keep the order of the operands,
+  // the grid is split into slabs along its last dimension.
+  template <typename Op, typename R, typename G, typename... ISs>
+  R fold(const cxx::execution::sequenced_policy &, const Op &op, const R &z,
+         const G &g, const ISs &... iss) const {
+    return fold_box(adt::set<index_type>(0), shape(), op, z, g, iss...);
+  }
+  template <typename Policy, typename Op, typename R, typename G,
+            typename... ISs,
+            std::enable_if_t<cxx::is_parallel_execution_policy<Policy>::value>
+                * = nullptr>
+  R fold(const Policy &, const Op &op, const R &z, const G &g,
+         const ISs &... iss) const {
+    if (D == 0 || !fun::is_associative<Op>::value)
+      return fold(cxx::execution::seq, op, z, g, iss...);
+    static qthread::grain_size grain;
+    return qthread::parallel_reduce_chunks(
+               grain, adt::irange_t(shape()[D - 1]),
+               [&](const adt::irange_t &slabs) {
+                 index_type imin = adt::set<index_type>(0), imax = shape();
+                 imin[D - 1] = slabs.imin();
+                 imax[D - 1] = slabs.imax();
+                 return fold_box(imin, imax, op, z, g, iss...);
+               },
+               op, z)
+        .get();
+  }
+
+public:
   template <typename F, typename Op, typename Z, typename... Args,
+            std::enable_if_t<!cxx::is_execution_policy<std::decay_t<F>>::value>
+                * = nullptr,
             typename R = cxx::invoke_of_t<F, T, Args...>>
   R foldMap(F &&f, Op &&op, const Z &z, Args &&... args) const {
+    return foldMap(cxx::execution::seq, std::forward<F>(f),
+                   std::forward<Op>(op), z, std::forward<Args>(args)...);
+  }
+
+  template <
+      typename Policy, typename F, typename Op, typename Z, typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename R = cxx::invoke_of_t<F, T, Args...>>
+  R foldMap(const Policy &policy, F &&f, Op &&op, const Z &z,
+            Args &&... args) const {
     static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
-    R r(z);
-    indexing.loop([&](const index_type &i) {
-      r = cxx::invoke(
-          op, std::move(r),
-          cxx::invoke(f, fun::getIndex(data, indexing.linear(i)), args...));
+    return fold(policy, op, R(z), [&](std::ptrdiff_t lin) {
+      return cxx::invoke(f, fun::getIndex(data, lin), args...);
     });
-    return r;
   }
 
   template <typename F, typename Op, typename Z, typename T2, typename... Args,
+            std::enable_if_t<!cxx::is_execution_policy<std::decay_t<F>>::value>
+                * = nullptr,
             typename R = cxx::invoke_of_t<F, T, T2, Args...>>
   R foldMap2(F &&f, Op &&op, const Z &z, const grid<C, T2, D> &ys,
              Args &&... args) const {
+    return foldMap2(cxx::execution::seq, std::forward<F>(f),
+                    std::forward<Op>(op), z, ys, std::forward<Args>(args)...);
+  }
+
+  template <
+      typename Policy, typename F, typename Op, typename Z, typename T2,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+      typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+  R foldMap2(const Policy &policy, F &&f, Op &&op, const Z &z,
+             const grid<C, T2, D> &ys, Args &&... args) const {
     static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
     cxx_assert(ys.shape() == shape());
-    R r(z);
-    indexing.loop([&](const index_type &i) {
-      r = cxx::invoke(op, std::move(r),
-                      cxx::invoke(f, fun::getIndex(data, indexing.linear(i)),
-                                  fun::getIndex(ys.data, ys.indexing.linear(i)),
-                                  args...));
-    });
-    return r;
+    return fold(policy, op, R(z),
+                [&](std::ptrdiff_t lin, std::ptrdiff_t ylin) {
+                  return cxx::invoke(f, fun::getIndex(data, lin),
+                                     fun::getIndex(ys.data, ylin), args...);
+                },
+                ys.indexing);
+  }
+
+  // fmapFold: f returns pairs; their first elements form this grid, and
+  // their second elements are folded onto r
+
+  struct fmapFold {};
+
+  template <
+      typename Policy, typename F, typename Op, typename S, typename T1,
+      typename... Args,
+      std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+  grid(fmapFold, const Policy &policy, F &&f, const Op &op, S &r,
+       const grid<C, T1, D> &xs, Args &&... args)
+      : indexing(make_indexing(xs.shape())) {
+    fun::accumulator<container_constructor<T>> acc(
+        indexing.allocated_size());
+    r = fold(policy, op, r,
+             [&](std::ptrdiff_t lin, std::ptrdiff_t xlin) {
+               auto ys = cxx::invoke(f, fun::getIndex(xs.data, xlin), args...);
+               acc[lin] = std::move(ys.first);
+               return std::move(ys.second);
+             },
+             xs.indexing);
+    data = acc.finalize();
+    cxx_assert(invariant());
   }
 
   // dump
@@ -286,3 +286,55 @@ TEST(adt_grid, foldMap) {
   EXPECT_TRUE((std::is_same<decltype(r10), double>::value));
   EXPECT_EQ(5120.0, r10);
 }
+
+TEST(adt_grid, loop_linear) {
+  typedef adt::detail::index_space<3> is3_t;
+  typedef adt::detail::index_space<2> is2_t;
+  is3_t is3(adt::index_t<3>{{3, 4, 5}});
+  std::vector<std::ptrdiff_t> lins, lins1;
+  is3.loop([&](const auto &i) { lins.push_back(is3.linear(i)); });
+  is3.loop_linear([&](std::ptrdiff_t lin) { lins1.push_back(lin); });
+  EXPECT_EQ(lins, lins1);
+
+  // Boundaries have non-unit strides
+  for (std::ptrdiff_t f = 0; f < 6; ++f) {
+    is2_t is2(typename is2_t::boundary(), is3, f);
+    is2_t is2c(is2.shape());
+    std::vector<std::ptrdiff_t> blins, blins1;
+    is2.loop([&](const auto &i) { blins.push_back(is2.linear(i)); });
+    is2c.loop_linear(
+        [&](std::ptrdiff_t lin, std::ptrdiff_t blin) {
+          EXPECT_EQ(std::ptrdiff_t(blins1.size()), lin);
+          blins1.push_back(blin);
+        },
+        is2);
+    EXPECT_EQ(blins, blins1);
+  }
+
+  std::vector<std::ptrdiff_t> boxlins;
+  is3.loop_linear_box(adt::index_t<3>{{1, 1, 1}}, adt::index_t<3>{{2, 3, 2}},
+                      [&](std::ptrdiff_t lin) { boxlins.push_back(lin); });
+  EXPECT_EQ((std::vector<std::ptrdiff_t>{
+                is3.linear(adt::index_t<3>{{1, 1, 1}}),
+                is3.linear(adt::index_t<3>{{1, 2, 1}})}),
+            boxlins);
+}
+
+TEST(adt_grid, index_space_padded) {
+  typedef adt::detail::index_space<3> is3_t;
+  // Rows are padded to 8 elements of 8 bytes
+  is3_t is1(typename is3_t::padded(), adt::index_t<3>{{3, 4, 5}}, 8, 8);
+  EXPECT_TRUE(is1.invariant());
+  EXPECT_EQ((adt::index_t<3>{{8, 4, 5}}), is1.allocated());
+  EXPECT_EQ(8 * 4 * 5, is1.allocated_size());
+  std::vector<std::ptrdiff_t> lins, lins1;
+  is1.loop([&](const auto &i) { lins.push_back(is1.linear(i)); });
+  is1.loop_linear([&](std::ptrdiff_t lin) { lins1.push_back(lin); });
+  EXPECT_EQ(lins, lins1);
+
+  // Strides that are multiples of 4096 bytes are avoided
+  is3_t is2(typename is3_t::padded(), adt::index_t<3>{{512, 8, 3}}, 8, 8);
+  EXPECT_EQ((adt::index_t<3>{{520, 8, 3}}), is2.allocated());
+  is3_t is3(typename is3_t::padded(), adt::index_t<3>{{64, 64, 3}}, 8, 8);
+  EXPECT_EQ((adt::index_t<3>{{64, 65, 3}}), is3.allocated());
+}
@@ -8,6 +8,8 @@
 
 #include <cereal/types/array.hpp>
 
+#include <cstdint>
+
 namespace adt {
 
 // Integer range
@@ -267,7 +269,92 @@ public:
     return os << "steprange_t(" << inds.imin_ << ":" << inds.imax_ << ":"
               << inds.istep_ << ")";
   }
+
+private:
+  template <std::ptrdiff_t I, typename F, typename... Args>
+  std::enable_if_t<(I < 0), void> loop_impl(F &&f, const index_t<D> &ipos,
+                                            Args &&... args) const {
+    cxx::invoke(std::forward<F>(f), ipos, std::forward<Args>(args)...);
+  }
+  template <std::ptrdiff_t I, typename F, typename... Args>
+  std::enable_if_t<(I >= 0), void> loop_impl(F &&f, index_t<D> ipos,
+                                             Args &&... args) const {
+    std::ptrdiff_t imin1 = imin()[I];
+    std::ptrdiff_t imax1 = imax()[I];
+    std::ptrdiff_t istep1 = istep()[I];
+    for (std::ptrdiff_t ipos1 = imin1; ipos1 < imax1; ipos1 += istep1) {
+      ipos[I] = ipos1;
+      loop_impl<I - 1>(std::forward<F>(f), ipos, std::forward<Args>(args)...);
+    }
+  }
+
+public:
+  template <typename F, typename... Args>
+  void loop(F &&f, Args &&... args) const {
+    loop_impl<std::ptrdiff_t(D) - 1>(std::forward<F>(f), index_t<D>{},
+                                     std::forward<Args>(args)...);
+  }
 };
+
+// Space-filling curves
+
+// The keys order the points of the cube [0, 2^bits)^D along the curve.
+// As for the layout of grids, direction 0 varies fastest.
+
+namespace detail {
+// Interleave the bits of the coordinates, starting with the most
+// significant bit of direction D-1
+template <std::size_t D>
+std::uint64_t interleave_bits(const index_t<D> &i, int bits) {
+  cxx_assert(D * bits <= 64);
+  std::uint64_t key = 0;
+  for (int b = bits - 1; b >= 0; --b)
+    for (std::ptrdiff_t d = D - 1; d >= 0; --d)
+      key = (key << 1) | ((std::uint64_t(i[d]) >> b) & 1);
+  return key;
+}
+}
+
+// Morton (Z-order) curve
+template <std::size_t D>
+std::uint64_t morton_key(const index_t<D> &i, int bits) {
+  cxx_assert(all(ge(i, 0)) && all(lt(i, std::ptrdiff_t(1) << bits)));
+  return detail::interleave_bits(i, bits);
+}
+
+// Hilbert curve, using Skilling's transposition ("Programming the
+// Hilbert curve", AIP Conf. Proc. 707, 2004)
+template <std::size_t D>
+std::uint64_t hilbert_key(index_t<D> x, int bits) {
+  cxx_assert(all(ge(x, 0)) && all(lt(x, std::ptrdiff_t(1) << bits)));
+  if (bits == 0)
+    return 0;
+  // Skilling treats x[0] as most significant; we reverse the directions
+  // so that direction 0 varies fastest
+  const std::ptrdiff_t top = std::ptrdiff_t(1) << (bits - 1);
+  for (std::ptrdiff_t q = top; q > 1; q >>= 1) {
+    std::ptrdiff_t p = q - 1;
+    for (std::ptrdiff_t d = D - 1; d >= 0; --d) {
+      if (x[d] & q) {
+        x[D - 1] ^= p;
+      } else {
+        std::ptrdiff_t t = (x[D - 1] ^ x[d]) & p;
+        x[D - 1] ^= t;
+        x[d] ^= t;
+      }
+    }
+  }
+  // Gray encode
+  for (std::ptrdiff_t d = D - 2; d >= 0; --d)
+    x[d] ^= x[d + 1];
+  std::ptrdiff_t t = 0;
+  for (std::ptrdiff_t q = top; q > 1; q >>= 1)
+    if (x[0] & q)
+      t ^= q - 1;
+  for (std::size_t d = 0; d < D; ++d)
+    x[d] ^= t;
+  return detail::interleave_bits(x, bits);
+}
 }
 
 #define ADT_INDEX_HPP_DONE
@@ -2,8 +2,33 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 TEST(adt_index, types) {
   adt::irange_t{};
   adt::index_t<2>{};
   adt::range_t<2>{};
 }
+
+TEST(adt_index, space_filling_curves) {
+  const int bits = 3;
+  const std::ptrdiff_t n = std::ptrdiff_t(1) << bits;
+  std::vector<adt::index_t<3>> morton(n * n * n), hilbert(n * n * n);
+  adt::steprange_t<3>(adt::set<adt::index_t<3>>(n)).loop([&](const auto &i) {
+    morton.at(adt::morton_key(i, bits)) = i;
+    hilbert.at(adt::hilbert_key(i, bits)) = i;
+  });
+  // Both curves are bijections that start at the origin; direction 0
+  // varies fastest
+  EXPECT_EQ((adt::index_t<3>{{0, 0, 0}}), morton[0]);
+  EXPECT_EQ((adt::index_t<3>{{1, 0, 0}}), morton[1]);
+  EXPECT_EQ((adt::index_t<3>{{0, 1, 0}}), morton[2]);
+  EXPECT_EQ((adt::index_t<3>{{0, 0, 1}}), morton[4]);
+  EXPECT_EQ((adt::index_t<3>{{0, 0, 0}}), hilbert[0]);
+  // Consecutive points of a Hilbert curve are neighbours
+  for (std::size_t k = 1; k < hilbert.size(); ++k)
+    EXPECT_EQ(1, adt::sum(adt::abs(hilbert[k] - hilbert[k - 1])));
+  // Morton keys are ordered by octant
+  EXPECT_LT(adt::morton_key(adt::index_t<3>{{n / 2 - 1, n / 2 - 1, 0}}, bits),
+            adt::morton_key(adt::index_t<3>{{n / 2, 0, 0}}, bits));
+}
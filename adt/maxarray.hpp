@@ -2,41 +2,95 @@
 #define ADT_MAXARRAY_HPP
 
 #include <cxx/cassert.hpp>
+#include <cxx/serialize.hpp>
 
 #include <cereal/access.hpp>
 
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace adt {
 
 template <typename T, std::size_t N> struct maxarray {
-  std::array<T, N> elts;
+  // Only the first used elements are constructed; the remaining
+  // storage is left uninitialized
+  typedef std::aligned_storage_t<sizeof(T), alignof(T)> storage_t;
+  std::array<storage_t, N> elts;
   std::size_t used;
 
   friend class cereal::access;
-  template <typename Archive> void serialize(Archive &ar) { ar(elts, used); }
+  // Only the used elements are serialized
+  template <typename Archive> void save(Archive &ar) const {
+    ar(used);
+    cxx::serialize_range(ar, data(), used);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    std::size_t n;
+    ar(n);
+    cxx_assert(n <= N);
+    reset();
+    resize(n);
+    cxx::serialize_range(ar, data(), used);
+  }
 
 public:
   typedef T element_type;
 
-  maxarray() : used(0) {}
-  explicit maxarray(std::size_t n) : used(n) { cxx_assert(n <= N); }
+  maxarray() noexcept : used(0) {}
+  // This requires T to be default-constructible
+  explicit maxarray(std::size_t n) : used(0) { resize(n); }
+  maxarray(const maxarray &other) : used(0) {
+    std::uninitialized_copy(other.begin(), other.end(), begin());
+    used = other.used;
+  }
+  maxarray(maxarray &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+      : used(0) {
+    std::uninitialized_copy(std::make_move_iterator(other.begin()),
+                            std::make_move_iterator(other.end()), begin());
+    used = other.used;
+  }
+  maxarray &operator=(const maxarray &other) {
+    if (this != &other) {
+      reset();
+      std::uninitialized_copy(other.begin(), other.end(), begin());
+      used = other.used;
+    }
+    return *this;
+  }
+  maxarray &operator=(maxarray &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    if (this != &other) {
+      reset();
+      std::uninitialized_copy(std::make_move_iterator(other.begin()),
+                              std::make_move_iterator(other.end()), begin());
+      used = other.used;
+    }
+    return *this;
+  }
+  ~maxarray() { reset(); }
   void swap(maxarray &other) {
-    using std::swap;
-    swap(used, other.used);
-    swap(elts, other.elts);
+    maxarray tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
   }
 
   bool invariant() const noexcept { return used <= N; }
 
+  // This requires T to be default-constructible
   void resize(std::size_t n) {
     cxx_assert(n <= N);
-    used = n;
+    for (; used < n; ++used)
+      new (&elts[used]) T();
+    destroy(n);
   }
-  void reset() noexcept { used = 0; }
+  void reset() noexcept { destroy(0); }
 
   constexpr bool empty() const noexcept { return used == 0; }
   constexpr std::size_t size() const noexcept { return used; }
@@ -44,33 +98,43 @@ public:
 
   void push_back(const T &value) {
     cxx_assert(used < N);
-    *end() = value;
+    new (&elts[used]) T(value);
     ++used;
   }
   void push_back(T &&value) {
     cxx_assert(used < N);
-    *end() = std::move(value);
+    new (&elts[used]) T(std::move(value));
     ++used;
   }
 
-  T *data() noexcept { return elts.data(); }
-  const T *data() const noexcept { return elts.data(); }
+private:
+  // Destroy the elements starting at n
+  void destroy(std::size_t n) noexcept {
+    for (; used > n; --used)
+      data()[used - 1].~T();
+  }
+
+public:
+  T *data() noexcept { return reinterpret_cast<T *>(elts.data()); }
+  const T *data() const noexcept {
+    return reinterpret_cast<const T *>(elts.data());
+  }
 
   const T &operator[](std::size_t i) const {
-    cxx_assert(i < N);
+    cxx_assert(i < used);
     cxx_assert(std::ptrdiff_t(i) >= 0);
-    return elts[i];
+    return data()[i];
   }
-  constexpr T &operator[](std::size_t i) {
-    cxx_assert(i < N);
+  T &operator[](std::size_t i) {
+    cxx_assert(i < used);
     cxx_assert(std::ptrdiff_t(i) >= 0);
-    return elts[i];
+    return data()[i];
   }
 
-  constexpr T *begin() noexcept { return data(); }
-  constexpr const T *begin() const noexcept { return data(); }
-  constexpr T *end() noexcept { return data() + size(); }
-  constexpr const T *end() const noexcept { return data() + size(); }
+  T *begin() noexcept { return data(); }
+  const T *begin() const noexcept { return data(); }
+  T *end() noexcept { return data() + size(); }
+  const T *end() const noexcept { return data() + size(); }
 
   template <std::size_t N2>
   bool operator==(const maxarray<T, N2> &other) const {
@@ -98,7 +162,7 @@ public:
   }
 };
 template <typename T, std::size_t N>
-void swap(maxarray<T, N> &x, maxarray<T, N> &y) noexcept {
+void swap(maxarray<T, N> &x, maxarray<T, N> &y) {
   x.swap(y);
 }
 }
@@ -1 +1,105 @@
 #include <adt/maxarray.hpp>
+
+#include <cereal/archives/binary.hpp>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+template <typename T> std::string serialize(const T &x) {
+  std::stringstream buf;
+  { (cereal::BinaryOutputArchive(buf))(x); }
+  return buf.str();
+}
+
+template <typename T> T deserialize(const std::string &str) {
+  std::stringstream buf(str);
+  T x;
+  { (cereal::BinaryInputArchive(buf))(x); }
+  return x;
+}
+
+// A type without default constructor
+struct nodefault {
+  int x;
+  explicit nodefault(int x) : x(x) {}
+};
+}
+
+TEST(adt_maxarray, basic) {
+  adt::maxarray<nodefault, 4> xs;
+  EXPECT_TRUE(xs.empty());
+  xs.push_back(nodefault(1));
+  xs.push_back(nodefault(2));
+  EXPECT_EQ(2, xs.size());
+  auto ys = xs;
+  ys.push_back(nodefault(3));
+  EXPECT_EQ(2, xs.size());
+  EXPECT_EQ(3, ys.size());
+  EXPECT_EQ(3, ys[2].x);
+  xs.swap(ys);
+  EXPECT_EQ(3, xs.size());
+  EXPECT_EQ(2, ys.size());
+  EXPECT_EQ(1, ys[0].x);
+  ys.reset();
+  EXPECT_TRUE(ys.empty());
+
+  // Elements are destroyed when they are removed
+  auto p = std::make_shared<int>(0);
+  {
+    adt::maxarray<std::shared_ptr<int>, 4> ps;
+    ps.push_back(p);
+    ps.push_back(p);
+    EXPECT_EQ(3, p.use_count());
+    ps.resize(1);
+    EXPECT_EQ(2, p.use_count());
+    auto qs = std::move(ps);
+    EXPECT_EQ(2, p.use_count());
+  }
+  EXPECT_EQ(1, p.use_count());
+}
+
+TEST(adt_maxarray, serialize) {
+  adt::maxarray<double, 16> xs;
+  for (int i = 0; i < 3; ++i)
+    xs.push_back(i);
+  auto str = serialize(xs);
+  // Only the used elements are sent
+  EXPECT_LE(str.size(), sizeof(std::size_t) + 3 * sizeof(double));
+  auto ys = deserialize<adt::maxarray<double, 16>>(str);
+  EXPECT_EQ(xs, ys);
+  auto zs = deserialize<adt::maxarray<double, 16>>(
+      serialize(adt::maxarray<double, 16>()));
+  EXPECT_TRUE(zs.empty());
+}
+
+namespace {
+// A type that counts how often it is copied
+struct counted {
+  static int copies;
+  counted() = default;
+  counted(const counted &) { ++copies; }
+  counted(counted &&) noexcept = default;
+  counted &operator=(const counted &) {
+    ++copies;
+    return *this;
+  }
+  counted &operator=(counted &&) noexcept = default;
+};
+int counted::copies = 0;
+}
+
+TEST(adt_maxarray, nothrow_move) {
+  typedef adt::maxarray<counted, 4> arr;
+  static_assert(std::is_nothrow_move_constructible<arr>::value, "");
+  static_assert(std::is_nothrow_move_assignable<arr>::value, "");
+  // std::vector moves (instead of copies) its elements when it grows
+  std::vector<arr> xss(1, arr(3));
+  counted::copies = 0;
+  xss.resize(xss.capacity() + 1);
+  EXPECT_EQ(0, counted::copies);
+}
@@ -0,0 +1,256 @@
+#ifndef ADT_SMALL_VECTOR_HPP
+#define ADT_SMALL_VECTOR_HPP
+
+#include <cxx/cassert.hpp>
+#include <cxx/serialize.hpp>
+
+#include <cereal/access.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace adt {
+
+// A vector that keeps up to N elements in inline storage, and moves
+// them to the heap when it grows beyond that
+template <typename T, std::size_t N> class small_vector {
+  // Only the first used elements are constructed; the remaining
+  // storage is left uninitialized
+  typedef std::aligned_storage_t<sizeof(T), alignof(T)> storage_t;
+  std::array<storage_t, N> elts;
+  T *heap; // nullptr if the elements are stored inline
+  std::size_t used, cap;
+
+  friend class cereal::access;
+  // Only the used elements are serialized
+  template <typename Archive> void save(Archive &ar) const {
+    ar(used);
+    cxx::serialize_range(ar, data(), used);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    std::size_t n;
+    ar(n);
+    clear();
+    resize(n);
+    cxx::serialize_range(ar, data(), used);
+  }
+
+public:
+  typedef T element_type;
+  typedef T value_type;
+  static constexpr std::size_t inline_size = N;
+
+  small_vector() noexcept : heap(nullptr), used(0), cap(N) {}
+  // This requires T to be default-constructible
+  explicit small_vector(std::size_t n) : small_vector() { resize(n); }
+  small_vector(std::initializer_list<T> xs) : small_vector() {
+    reserve(xs.size());
+    std::uninitialized_copy(xs.begin(), xs.end(), begin());
+    used = xs.size();
+  }
+  small_vector(const small_vector &other) : small_vector() {
+    reserve(other.used);
+    std::uninitialized_copy(other.begin(), other.end(), begin());
+    used = other.used;
+  }
+  small_vector(small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value)
+      : small_vector() {
+    take(other);
+  }
+  small_vector &operator=(const small_vector &other) {
+    if (this != &other) {
+      clear();
+      reserve(other.used);
+      std::uninitialized_copy(other.begin(), other.end(), begin());
+      used = other.used;
+    }
+    return *this;
+  }
+  small_vector &operator=(small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+  ~small_vector() { reset(); }
+  void swap(small_vector &other) {
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  bool invariant() const noexcept {
+    return used <= cap && (heap ? cap > N : cap == N);
+  }
+
+  // This requires T to be default-constructible
+  void resize(std::size_t n) {
+    reserve(n);
+    for (; used < n; ++used)
+      new (&data()[used]) T();
+    destroy(n);
+  }
+  void reserve(std::size_t n) {
+    if (n <= cap)
+      return;
+    std::size_t newcap = std::max(n, 2 * cap);
+    // Free the new storage if moving the elements throws
+    auto free_newheap = [newcap](T *p) {
+      std::allocator<T>().deallocate(p, newcap);
+    };
+    std::unique_ptr<T, decltype(free_newheap)> newheap(
+        std::allocator<T>().allocate(newcap), free_newheap);
+    std::uninitialized_copy(std::make_move_iterator(begin()),
+                            std::make_move_iterator(end()), newheap.get());
+    std::size_t n0 = used;
+    destroy(0);
+    deallocate();
+    heap = newheap.release();
+    used = n0;
+    cap = newcap;
+  }
+  // Destroy all elements, keeping the storage
+  void clear() noexcept { destroy(0); }
+  // Destroy all elements, and return to the inline storage
+  void reset() noexcept {
+    destroy(0);
+    deallocate();
+  }
+
+  bool empty() const noexcept { return used == 0; }
+  std::size_t size() const noexcept { return used; }
+  std::size_t capacity() const noexcept { return cap; }
+  // Whether the elements are stored inline (i.e. not on the heap)
+  bool is_inline() const noexcept { return !heap; }
+
+  void push_back(const T &value) {
+    if (used == cap) {
+      // value may be an element of this vector
+      T tmp(value);
+      reserve(used + 1);
+      new (&data()[used]) T(std::move(tmp));
+    } else {
+      new (&data()[used]) T(value);
+    }
+    ++used;
+  }
+  void push_back(T &&value) {
+    if (used == cap) {
+      T tmp(std::move(value));
+      reserve(used + 1);
+      new (&data()[used]) T(std::move(tmp));
+    } else {
+      new (&data()[used]) T(std::move(value));
+    }
+    ++used;
+  }
+
+private:
+  // Destroy the elements starting at n
+  void destroy(std::size_t n) noexcept {
+    for (; used > n; --used)
+      data()[used - 1].~T();
+  }
+  // Release the heap storage; there must not be any elements
+  void deallocate() noexcept {
+    cxx_assert(used == 0);
+    if (heap)
+      std::allocator<T>().deallocate(heap, cap);
+    heap = nullptr;
+    cap = N;
+  }
+  // Take over the elements of other, which must be empty and inline;
+  // heap storage is stolen, inline elements are moved
+  void take(small_vector &other) noexcept(
+      std::is_nothrow_move_constructible<T>::value) {
+    cxx_assert(used == 0 && !heap);
+    if (other.heap) {
+      heap = other.heap;
+      used = other.used;
+      cap = other.cap;
+      other.heap = nullptr;
+      other.used = 0;
+      other.cap = N;
+    } else {
+      std::uninitialized_copy(std::make_move_iterator(other.begin()),
+                              std::make_move_iterator(other.end()), begin());
+      used = other.used;
+      other.clear();
+    }
+  }
+
+public:
+  T *data() noexcept {
+    return heap ? heap : reinterpret_cast<T *>(elts.data());
+  }
+  const T *data() const noexcept {
+    return heap ? heap : reinterpret_cast<const T *>(elts.data());
+  }
+
+  const T &operator[](std::size_t i) const {
+    cxx_assert(i < used);
+    cxx_assert(std::ptrdiff_t(i) >= 0);
+    return data()[i];
+  }
+  T &operator[](std::size_t i) {
+    cxx_assert(i < used);
+    cxx_assert(std::ptrdiff_t(i) >= 0);
+    return data()[i];
+  }
+
+  T *begin() noexcept { return data(); }
+  const T *begin() const noexcept { return data(); }
+  T *end() noexcept { return data() + size(); }
+  const T *end() const noexcept { return data() + size(); }
+
+  template <std::size_t N2>
+  bool operator==(const small_vector<T, N2> &other) const {
+    return size() == other.size() &&
+           std::equal(begin(), end(), other.begin(), other.end());
+  }
+  template <std::size_t N2>
+  bool operator!=(const small_vector<T, N2> &other) const {
+    return !(*this == other);
+  }
+  template <std::size_t N2>
+  bool operator<(const small_vector<T, N2> &other) const {
+    return std::lexicographical_compare(begin(), end(), other.begin(),
+                                        other.end());
+  }
+  template <std::size_t N2>
+  bool operator>(const small_vector<T, N2> &other) const {
+    return other < *this;
+  }
+  template <std::size_t N2>
+  bool operator<=(const small_vector<T, N2> &other) const {
+    return !(*this > other);
+  }
+  template <std::size_t N2>
+  bool operator>=(const small_vector<T, N2> &other) const {
+    return !(*this < other);
+  }
+};
+template <typename T, std::size_t N>
+constexpr std::size_t small_vector<T, N>::inline_size;
+
+template <typename T, std::size_t N>
+void swap(small_vector<T, N> &x, small_vector<T, N> &y) {
+  x.swap(y);
+}
+}
+
+#define ADT_SMALL_VECTOR_HPP_DONE
+#endif // #ifdef ADT_SMALL_VECTOR_HPP
+#ifndef ADT_SMALL_VECTOR_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,106 @@
+#include <adt/small_vector.hpp>
+
+#include <cereal/archives/binary.hpp>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+template <typename T> std::string serialize(const T &x) {
+  std::stringstream buf;
+  { (cereal::BinaryOutputArchive(buf))(x); }
+  return buf.str();
+}
+
+template <typename T> T deserialize(const std::string &str) {
+  std::stringstream buf(str);
+  T x;
+  { (cereal::BinaryInputArchive(buf))(x); }
+  return x;
+}
+
+// A type without default constructor
+struct nodefault {
+  int x;
+  explicit nodefault(int x) : x(x) {}
+};
+}
+
+TEST(adt_small_vector, basic) {
+  adt::small_vector<nodefault, 2> xs;
+  EXPECT_TRUE(xs.empty());
+  EXPECT_TRUE(xs.is_inline());
+  xs.push_back(nodefault(1));
+  xs.push_back(nodefault(2));
+  EXPECT_EQ(2, xs.size());
+  EXPECT_TRUE(xs.is_inline());
+  auto ys = xs;
+  ys.push_back(nodefault(3));
+  EXPECT_TRUE(xs.is_inline());
+  EXPECT_FALSE(ys.is_inline());
+  EXPECT_TRUE(ys.invariant());
+  EXPECT_EQ(3, ys.size());
+  EXPECT_EQ(1, ys[0].x);
+  EXPECT_EQ(3, ys[2].x);
+  xs.swap(ys);
+  EXPECT_EQ(3, xs.size());
+  EXPECT_EQ(2, ys.size());
+  EXPECT_EQ(2, ys[1].x);
+  // Moving heap storage takes over the pointer
+  const nodefault *p = xs.data();
+  auto zs = std::move(xs);
+  EXPECT_EQ(p, zs.data());
+  EXPECT_EQ(3, zs[2].x);
+  zs.reset();
+  EXPECT_TRUE(zs.empty());
+  EXPECT_TRUE(zs.is_inline());
+
+  // Elements are destroyed when they are removed
+  auto q = std::make_shared<int>(0);
+  {
+    adt::small_vector<std::shared_ptr<int>, 2> qs;
+    for (int i = 0; i < 5; ++i)
+      qs.push_back(q);
+    EXPECT_EQ(6, q.use_count());
+    qs.resize(1);
+    EXPECT_EQ(2, q.use_count());
+    auto rs = std::move(qs);
+    EXPECT_EQ(2, q.use_count());
+    // Pushing back an element of the vector itself
+    for (int i = 0; i < 4; ++i)
+      rs.push_back(rs[0]);
+    EXPECT_EQ(6, q.use_count());
+  }
+  EXPECT_EQ(1, q.use_count());
+}
+
+TEST(adt_small_vector, nothrow_move) {
+  typedef adt::small_vector<int, 2> vec;
+  static_assert(std::is_nothrow_move_constructible<vec>::value, "");
+  static_assert(std::is_nothrow_move_assignable<vec>::value, "");
+  // std::vector moves (instead of copies) its elements when it grows
+  std::vector<vec> xss(1);
+  for (int i = 0; i < 3; ++i)
+    xss[0].push_back(i);
+  const int *p = xss[0].data();
+  xss.resize(xss.capacity() + 1);
+  EXPECT_EQ(p, xss[0].data());
+}
+
+TEST(adt_small_vector, serialize) {
+  for (std::size_t n : {0, 3, 100}) {
+    adt::small_vector<double, 4> xs;
+    for (std::size_t i = 0; i < n; ++i)
+      xs.push_back(i);
+    auto str = serialize(xs);
+    // Only the used elements are sent
+    EXPECT_LE(str.size(), sizeof(std::size_t) + n * sizeof(double));
+    auto ys = deserialize<adt::small_vector<double, 4>>(str);
+    EXPECT_EQ(xs, ys);
+    EXPECT_EQ(n <= 4, ys.is_inline());
+  }
+}
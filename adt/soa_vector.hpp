@@ -0,0 +1,185 @@
+#ifndef ADT_SOA_VECTOR_HPP
+#define ADT_SOA_VECTOR_HPP
+
+#include <cxx/cassert.hpp>
+
+#include <cereal/access.hpp>
+#include <cereal/types/tuple.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace adt {
+
+// The fields of a type that soa_vector stores in separate arrays.
+// Specialize this for aggregates, listing all their fields:
+//
+//   template <> struct soa_traits<cell_t> {
+//     static constexpr auto fields() {
+//       return std::make_tuple(&cell_t::x, &cell_t::u, &cell_t::rho);
+//     }
+//   };
+//
+// Types without specialization are stored as a single array.
+
+struct soa_whole {};
+
+template <typename T> struct soa_traits {
+  static constexpr auto fields() { return std::make_tuple(soa_whole()); }
+};
+
+namespace detail {
+template <typename T> constexpr T &soa_field(T &x, soa_whole) { return x; }
+template <typename T> constexpr const T &soa_field(const T &x, soa_whole) {
+  return x;
+}
+template <typename T, typename F, typename U>
+constexpr F &soa_field(T &x, F U::*field) {
+  return x.*field;
+}
+template <typename T, typename F, typename U>
+constexpr const F &soa_field(const T &x, F U::*field) {
+  return x.*field;
+}
+
+template <typename T> using soa_fields_t = decltype(soa_traits<T>::fields());
+template <typename T, typename Field>
+using soa_field_t = std::decay_t<decltype(
+    soa_field(std::declval<T &>(), std::declval<Field>()))>;
+
+template <typename T, typename Fields> struct soa_arrays;
+template <typename T, typename... Fields>
+struct soa_arrays<T, std::tuple<Fields...>> {
+  typedef std::tuple<std::vector<soa_field_t<T, Fields>>...> type;
+};
+}
+
+// A vector that stores each field of its elements in a separate
+// array (structure of arrays). Elements are returned by value, and
+// are assigned via proxy references.
+template <typename T> class soa_vector {
+  static_assert(std::is_default_constructible<T>::value, "");
+
+  typedef detail::soa_fields_t<T> fields_t;
+  static constexpr std::size_t nfields = std::tuple_size<fields_t>::value;
+  typedef std::make_index_sequence<nfields> field_indices;
+  typedef typename detail::soa_arrays<T, fields_t>::type arrays_t;
+
+  arrays_t arrays;
+  std::size_t used;
+
+  friend class cereal::access;
+  template <typename Archive> void serialize(Archive &ar) { ar(arrays, used); }
+
+  template <std::size_t... Is>
+  void get_impl(T &x, std::size_t i, std::index_sequence<Is...>) const {
+    constexpr fields_t fields = soa_traits<T>::fields();
+    (void)std::initializer_list<int>{
+        (detail::soa_field(x, std::get<Is>(fields)) = std::get<Is>(arrays)[i],
+         0)...};
+  }
+  template <std::size_t... Is>
+  void set_impl(std::size_t i, const T &x, std::index_sequence<Is...>) {
+    constexpr fields_t fields = soa_traits<T>::fields();
+    (void)std::initializer_list<int>{
+        (std::get<Is>(arrays)[i] = detail::soa_field(x, std::get<Is>(fields)),
+         0)...};
+  }
+  template <std::size_t... Is>
+  void resize_impl(std::size_t n, std::index_sequence<Is...>) {
+    (void)std::initializer_list<int>{(std::get<Is>(arrays).resize(n), 0)...};
+  }
+
+  T get(std::size_t i) const {
+    T x;
+    get_impl(x, i, field_indices());
+    return x;
+  }
+  void set(std::size_t i, const T &x) { set_impl(i, x, field_indices()); }
+
+public:
+  typedef T element_type;
+
+  class reference {
+    soa_vector *self;
+    std::size_t i;
+
+  public:
+    reference(soa_vector *self, std::size_t i) : self(self), i(i) {}
+    reference(const reference &) = default;
+    operator T() const { return self->get(i); }
+    reference &operator=(const T &x) {
+      self->set(i, x);
+      return *this;
+    }
+    reference &operator=(const reference &x) { return *this = T(x); }
+  };
+
+  bool invariant() const noexcept { return std::get<0>(arrays).size() == used; }
+
+  soa_vector() : used(0) {}
+  explicit soa_vector(std::size_t n) : used(0) { resize(n); }
+  soa_vector(std::size_t n, const T &x) : soa_vector(n) {
+    for (std::size_t i = 0; i < n; ++i)
+      set(i, x);
+  }
+  soa_vector(std::initializer_list<T> xs) : soa_vector(xs.size()) {
+    std::size_t i = 0;
+    for (const auto &x : xs)
+      set(i++, x);
+  }
+  void swap(soa_vector &other) {
+    using std::swap;
+    swap(arrays, other.arrays);
+    swap(used, other.used);
+  }
+
+  void resize(std::size_t n) {
+    resize_impl(n, field_indices());
+    used = n;
+  }
+  void reset() { resize(0); }
+
+  bool empty() const noexcept { return used == 0; }
+  std::size_t size() const noexcept { return used; }
+
+  void push_back(const T &x) {
+    resize(used + 1);
+    set(used - 1, x);
+  }
+
+  T operator[](std::size_t i) const {
+    cxx_assert(i < used);
+    return get(i);
+  }
+  reference operator[](std::size_t i) {
+    cxx_assert(i < used);
+    return reference(this, i);
+  }
+
+  // The array holding field I
+  template <std::size_t I> const auto &field() const {
+    return std::get<I>(arrays);
+  }
+  template <std::size_t I> auto &field() { return std::get<I>(arrays); }
+
+  bool operator==(const soa_vector &other) const {
+    return used == other.used && arrays == other.arrays;
+  }
+  bool operator!=(const soa_vector &other) const { return !(*this == other); }
+};
+template <typename T> void swap(soa_vector<T> &x, soa_vector<T> &y) {
+  x.swap(y);
+}
+}
+
+#define ADT_SOA_VECTOR_HPP_DONE
+#endif // #ifdef ADT_SOA_VECTOR_HPP
+#ifndef ADT_SOA_VECTOR_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,49 @@
+#include <adt/soa_vector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <tuple>
+
+namespace {
+struct point_t {
+  double x, y;
+  int tag;
+};
+}
+
+namespace adt {
+template <> struct soa_traits<point_t> {
+  static constexpr auto fields() {
+    return std::make_tuple(&point_t::x, &point_t::y, &point_t::tag);
+  }
+};
+}
+
+TEST(adt_soa_vector, basic) {
+  adt::soa_vector<point_t> ps(3);
+  EXPECT_EQ(3, ps.size());
+  for (std::size_t i = 0; i < ps.size(); ++i)
+    ps[i] = point_t{double(i), 2.0 * i, int(i) + 1};
+  ps.push_back(point_t{-1.0, -2.0, -3});
+  EXPECT_EQ(4, ps.size());
+  EXPECT_TRUE(ps.invariant());
+
+  // Each field is stored contiguously
+  EXPECT_EQ((std::vector<double>{0.0, 1.0, 2.0, -1.0}), ps.field<0>());
+  EXPECT_EQ((std::vector<double>{0.0, 2.0, 4.0, -2.0}), ps.field<1>());
+  EXPECT_EQ((std::vector<int>{1, 2, 3, -3}), ps.field<2>());
+
+  const auto &cps = ps;
+  point_t p = cps[1];
+  EXPECT_EQ(1.0, p.x);
+  EXPECT_EQ(2.0, p.y);
+  EXPECT_EQ(2, p.tag);
+
+  ps[0] = ps[3];
+  EXPECT_EQ(-3, cps[0].tag);
+
+  adt::soa_vector<int> is{1, 2, 3};
+  EXPECT_EQ(3, is.size());
+  EXPECT_EQ(2, is[1]);
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), is.field<0>());
+}
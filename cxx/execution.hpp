@@ -0,0 +1,43 @@
+#ifndef CXX_EXECUTION_HPP
+#define CXX_EXECUTION_HPP
+
+#include <type_traits>
+
+namespace cxx {
+
+// Execution policies, modelled after C++17's <execution>
+
+namespace execution {
+class sequenced_policy {};
+class parallel_policy {};
+class parallel_unsequenced_policy {};
+
+constexpr sequenced_policy seq{};
+constexpr parallel_policy par{};
+constexpr parallel_unsequenced_policy par_unseq{};
+}
+
+template <typename T> struct is_execution_policy : std::false_type {};
+template <>
+struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+template <>
+struct is_execution_policy<execution::parallel_policy> : std::true_type {};
+template <>
+struct is_execution_policy<execution::parallel_unsequenced_policy>
+    : std::true_type {};
+
+// Whether a policy allows executing iterations in different threads
+template <typename T> struct is_parallel_execution_policy : std::false_type {};
+template <>
+struct is_parallel_execution_policy<execution::parallel_policy>
+    : std::true_type {};
+template <>
+struct is_parallel_execution_policy<execution::parallel_unsequenced_policy>
+    : std::true_type {};
+}
+
+#define CXX_EXECUTION_HPP_DONE
+#endif // #ifndef CXX_EXECUTION_HPP
+#ifndef CXX_EXECUTION_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,87 @@
+#ifndef CXX_MEMORY_HPP
+#define CXX_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include <stdlib.h>
+
+namespace cxx {
+
+// An allocator returning storage aligned to Alignment bytes (e.g. a
+// cache line or a page), which needs to be a power of two
+template <typename T, std::size_t Alignment> class aligned_allocator {
+  static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two");
+
+public:
+  typedef T value_type;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type is_always_equal;
+
+  static constexpr std::size_t alignment =
+      Alignment > alignof(T) ? Alignment : alignof(T);
+
+  template <typename U> struct rebind {
+    typedef aligned_allocator<U, Alignment> other;
+  };
+
+  aligned_allocator() noexcept {}
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    if (n == 0)
+      return nullptr;
+    // posix_memalign requires a multiple of sizeof(void *)
+    constexpr std::size_t align =
+        alignment > sizeof(void *) ? alignment : sizeof(void *);
+    void *ptr;
+    if (posix_memalign(&ptr, align, n * sizeof(T)) != 0)
+      throw std::bad_alloc();
+    return static_cast<T *>(ptr);
+  }
+  void deallocate(T *ptr, std::size_t n) noexcept { std::free(ptr); }
+};
+
+template <typename T, std::size_t Alignment>
+constexpr std::size_t aligned_allocator<T, Alignment>::alignment;
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment> &,
+                const aligned_allocator<U, Alignment> &) noexcept {
+  return true;
+}
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment> &,
+                const aligned_allocator<U, Alignment> &) noexcept {
+  return false;
+}
+
+// The alignment of the storage returned by an allocator
+template <typename Allocator>
+struct allocator_alignment
+    : std::integral_constant<std::size_t,
+                             alignof(typename Allocator::value_type)> {};
+template <typename T, std::size_t Alignment>
+struct allocator_alignment<aligned_allocator<T, Alignment>>
+    : std::integral_constant<std::size_t,
+                             aligned_allocator<T, Alignment>::alignment> {};
+
+// Common alignments
+constexpr std::size_t cache_line_size = 64;
+constexpr std::size_t page_size = 4096;
+}
+
+#define CXX_MEMORY_HPP_DONE
+#endif // #ifdef CXX_MEMORY_HPP
+#ifndef CXX_MEMORY_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,27 @@
+#include <cxx/memory.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+TEST(cxx_memory, aligned_allocator) {
+  typedef cxx::aligned_allocator<double, cxx::cache_line_size> alloc_t;
+  EXPECT_EQ(64, alloc_t::alignment);
+  EXPECT_EQ(64, cxx::allocator_alignment<alloc_t>::value);
+  EXPECT_EQ(alignof(int), cxx::allocator_alignment<std::allocator<int>>::value);
+  typedef alloc_t::rebind<char>::other char_alloc_t;
+  EXPECT_EQ(64, char_alloc_t::alignment);
+  EXPECT_TRUE(alloc_t() == char_alloc_t());
+
+  for (std::size_t n : {1, 3, 100, 1000}) {
+    std::vector<double, alloc_t> xs(n, 1.0);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(xs.data()) % 64);
+    xs.push_back(2.0);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(xs.data()) % 64);
+    EXPECT_EQ(2.0, xs.back());
+  }
+  std::vector<char, cxx::aligned_allocator<char, cxx::page_size>> ys(10);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(ys.data()) % cxx::page_size);
+}
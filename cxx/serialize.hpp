@@ -5,9 +5,11 @@
 
 #include <cereal/archives/binary.hpp>
 
+#include <array>
 #include <cstddef>
 #include <cstring>
 #include <type_traits>
+#include <vector>
 
 namespace cereal {
 
@@ -129,6 +131,84 @@ void load(Archive &ar, T &m) {
 }
 }
 
+namespace cxx {
+
+// Bitwise serialization
+
+// Types whose values can be serialized as their bytes, so that a
+// contiguous range of them is written as a single binary blob. This
+// holds for arithmetic and enum types. Other trivially copyable types
+// (e.g. structs of numbers) need to opt in by specializing this trait;
+// this is not automatic, since such types may contain pointers, which
+// cannot be sent to another process.
+template <typename T>
+struct is_bitwise_serializable
+    : std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                       std::is_enum<T>::value> {};
+template <typename T, std::size_t N>
+struct is_bitwise_serializable<std::array<T, N>>
+    : is_bitwise_serializable<T> {};
+
+namespace detail {
+template <typename Archive, typename T>
+using can_serialize_bitwise = std::integral_constant<
+    bool, is_bitwise_serializable<std::remove_const_t<T>>::value &&
+              (cereal::traits::is_output_serializable<
+                   cereal::BinaryData<std::remove_const_t<T>>,
+                   Archive>::value ||
+               cereal::traits::is_input_serializable<
+                   cereal::BinaryData<std::remove_const_t<T>>,
+                   Archive>::value)>;
+}
+
+// Serialize the n elements starting at ptr (which points to const
+// elements when saving)
+template <
+    typename Archive, typename T,
+    std::enable_if_t<detail::can_serialize_bitwise<Archive, T>::value> * =
+        nullptr>
+void serialize_range(Archive &ar, T *ptr, std::size_t n) {
+  static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value,
+                "Only trivially copyable types can be serialized bitwise");
+  ar(cereal::binary_data(ptr, n * sizeof(T)));
+}
+template <
+    typename Archive, typename T,
+    std::enable_if_t<!detail::can_serialize_bitwise<Archive, T>::value> * =
+        nullptr>
+void serialize_range(Archive &ar, T *ptr, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i)
+    ar(ptr[i]);
+}
+
+// Save or load a container. Vectors are stored as for cereal, with
+// their elements serialized via serialize_range.
+template <typename Archive, typename C>
+void save_container(Archive &ar, const C &xs) {
+  ar(xs);
+}
+template <typename Archive, typename C>
+void load_container(Archive &ar, C &xs) {
+  ar(xs);
+}
+
+template <typename Archive, typename T, typename Allocator,
+          std::enable_if_t<!std::is_same<T, bool>::value> * = nullptr>
+void save_container(Archive &ar, const std::vector<T, Allocator> &xs) {
+  cereal::size_type n = xs.size();
+  ar(cereal::make_size_tag(n));
+  serialize_range(ar, xs.data(), n);
+}
+template <typename Archive, typename T, typename Allocator,
+          std::enable_if_t<!std::is_same<T, bool>::value> * = nullptr>
+void load_container(Archive &ar, std::vector<T, Allocator> &xs) {
+  cereal::size_type n;
+  ar(cereal::make_size_tag(n));
+  xs.resize(n);
+  serialize_range(ar, xs.data(), n);
+}
+}
+
 #if 0
 namespace cxx {
 // captureless lambdas
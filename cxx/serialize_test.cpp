@@ -2,10 +2,12 @@
 #include <cxx/serialize.hpp>
 
 #include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
 #include <gtest/gtest.h>
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
 template <typename T> std::string serialize(T &&obj) {
@@ -81,6 +83,77 @@ TEST(cxx_serialize, member_object) {
   EXPECT_EQ(cxx::invoke(orig, obj()), cxx::invoke(copy, obj()));
 }
 
+namespace {
+// Points that count how often they are serialized element-wise
+struct bpoint {
+  double x, y;
+  static int count;
+  template <typename Archive> void serialize(Archive &ar) {
+    ++count;
+    ar(x, y);
+  }
+};
+int bpoint::count = 0;
+struct fpoint {
+  double x, y;
+  static int count;
+  template <typename Archive> void serialize(Archive &ar) {
+    ++count;
+    ar(x, y);
+  }
+};
+int fpoint::count = 0;
+
+template <typename C> struct container {
+  C xs;
+  template <typename Archive> void save(Archive &ar) const {
+    cxx::save_container(ar, xs);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    cxx::load_container(ar, xs);
+  }
+};
+}
+
+namespace cxx {
+template <> struct is_bitwise_serializable<bpoint> : std::true_type {};
+}
+
+TEST(cxx_serialize, bitwise) {
+  EXPECT_TRUE(cxx::is_bitwise_serializable<double>::value);
+  EXPECT_TRUE((cxx::is_bitwise_serializable<std::array<int, 3>>::value));
+  EXPECT_FALSE(cxx::is_bitwise_serializable<fpoint>::value);
+  EXPECT_TRUE(cxx::is_bitwise_serializable<bpoint>::value);
+
+  std::size_t n = 100;
+  container<std::vector<bpoint>> bs;
+  container<std::vector<fpoint>> fs;
+  for (std::size_t i = 0; i < n; ++i) {
+    bs.xs.push_back(bpoint{double(i), -double(i)});
+    fs.xs.push_back(fpoint{double(i), -double(i)});
+  }
+  auto bbuf = serialize(bs);
+  auto fbuf = serialize(fs);
+  // Both are stored in the same format
+  EXPECT_EQ(fbuf, bbuf);
+  auto bs1 = deserialize<container<std::vector<bpoint>>>(fbuf);
+  auto fs1 = deserialize<container<std::vector<fpoint>>>(bbuf);
+  ASSERT_EQ(n, bs1.xs.size());
+  ASSERT_EQ(n, fs1.xs.size());
+  for (std::size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(bs.xs[i].x, bs1.xs[i].x);
+    EXPECT_EQ(bs.xs[i].y, bs1.xs[i].y);
+    EXPECT_EQ(fs.xs[i].x, fs1.xs[i].x);
+    EXPECT_EQ(fs.xs[i].y, fs1.xs[i].y);
+  }
+  // Only the element-wise path serializes individual points
+  EXPECT_EQ(0, bpoint::count);
+  EXPECT_EQ(2 * int(n), fpoint::count);
+
+  container<std::vector<bool>> vs{{true, false, true}};
+  EXPECT_EQ(vs.xs, deserialize<decltype(vs)>(serialize(vs)).xs);
+}
+
 #if 0
 TEST(cxx_serialize, lambda) {
   auto orig0 = [](int x) { return x; };
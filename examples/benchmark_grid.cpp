@@ -0,0 +1,319 @@
+#include <adt/dummy.hpp>
+#include <adt/index.hpp>
+#include <cxx/execution.hpp>
+#include <cxx/memory.hpp>
+#include <fun/grid_decl.hpp>
+#include <fun/soa_vector.hpp>
+#include <fun/vector.hpp>
+
+#include <fun/lazy.hpp>
+#include <funhpc/main.hpp>
+#include <qthread/parallel.hpp>
+
+#include <fun/grid_impl.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+#include <utility>
+#include <vector>
+
+// Memory bandwidth of grid operations, compared to raw loops. The
+// kernel is the axpy operation of the wave examples, which is memory
+// bound: it reads two cells and writes one.
+
+template <typename T> T clamp(T x, T minval, T maxval) {
+  return std::min(std::max(x, minval), maxval);
+}
+
+double gettime() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec + tv.tv_usec / 1.0e+6;
+}
+
+struct cell_t {
+  double x, u, rho, v;
+};
+
+namespace adt {
+template <> struct soa_traits<cell_t> {
+  static constexpr auto fields() {
+    return std::make_tuple(&cell_t::x, &cell_t::u, &cell_t::rho, &cell_t::v);
+  }
+};
+}
+
+inline cell_t cell_axpy(const cell_t &y, const cell_t &x, double alpha) {
+  return cell_t{y.x, alpha * x.u + y.u, alpha * x.rho + y.rho,
+                alpha * x.v + y.v};
+}
+
+// A kernel that accesses only a single field
+inline double cell_energy(const cell_t &c) { return 0.5 * c.rho * c.rho; }
+
+constexpr std::size_t dim = 3;
+typedef adt::grid<std::vector<adt::dummy>, cell_t, dim> grid_t;
+typedef adt::grid<adt::soa_vector<adt::dummy>, cell_t, dim> soa_grid_t;
+
+const std::ptrdiff_t npoints = 100;
+const adt::index_t<dim> shape{{npoints, npoints, npoints}};
+
+template <typename G = grid_t> auto make_grid() {
+  return fun::iotaMapMulti<G>(
+      [](const adt::index_t<dim> &i) {
+        return cell_t{double(i[0]), double(i[1]), double(i[2]), 1.0};
+      },
+      adt::steprange_t<dim>(shape));
+}
+
+// Raw loop over a std::vector, writing into preallocated memory
+double raw_serial(std::int64_t iters) {
+  std::ptrdiff_t n = adt::prod(shape);
+  std::vector<cell_t> xs(n, cell_t{0, 1, 2, 3}), ys(n, cell_t{0, 1, 2, 3}),
+      rs(n);
+  const cell_t *restrict xp = xs.data();
+  const cell_t *restrict yp = ys.data();
+  cell_t *restrict rp = rs.data();
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+#pragma omp simd
+    for (std::ptrdiff_t i = 0; i < n; ++i)
+      rp[i] = cell_axpy(yp[i], xp[i], 0.5);
+  }
+  return rs[n - 1].u;
+}
+
+// Raw loop parallelized via qthread::parallel_for
+double raw_parallel(std::int64_t iters) {
+  std::ptrdiff_t n = adt::prod(shape);
+  std::vector<cell_t> xs(n, cell_t{0, 1, 2, 3}), ys(n, cell_t{0, 1, 2, 3}),
+      rs(n);
+  const cell_t *restrict xp = xs.data();
+  const cell_t *restrict yp = ys.data();
+  cell_t *restrict rp = rs.data();
+  qthread::grain_size grain(qthread::grain_size::default_target_time,
+                            32 * 1024 / sizeof(cell_t));
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    auto fs = qthread::parallel_for_chunks(
+        grain, adt::irange_t(n), [=](const adt::irange_t &chunk) {
+          std::ptrdiff_t imin = chunk.imin(), imax = chunk.imax();
+#pragma omp simd
+          for (std::ptrdiff_t i = imin; i < imax; ++i)
+            rp[i] = cell_axpy(yp[i], xp[i], 0.5);
+        });
+    for (const auto &f : fs)
+      f.wait();
+  }
+  return rs[n - 1].u;
+}
+
+template <typename Policy> double grid_fmap2(std::int64_t iters) {
+  auto xs = make_grid();
+  auto ys = make_grid();
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    auto rs = fun::fmap2(Policy(), cell_axpy, ys, xs, 0.5);
+    r += rs.last().u;
+  }
+  return r;
+}
+
+template <typename G> double grid_fmap_field(std::int64_t iters) {
+  auto xs = make_grid<G>();
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    auto rs = fun::fmap(cell_energy, xs);
+    r += rs.last();
+  }
+  return r;
+}
+
+// An RK2 substep of the wave examples: a stencil applied to s0 + dt/2
+// r0, where the argument of the stencil is either stored (eager) or
+// evaluated on the fly (lazy). The 2d grid has the same number of
+// points as the 3d grid above.
+
+typedef adt::grid<std::vector<adt::dummy>, cell_t, 2> grid2_t;
+const adt::index_t<2> shape2{{npoints * 10, npoints * npoints / 10}};
+
+inline cell_t cell_rhs(const cell_t &c, std::size_t bdirs, const cell_t &bm0,
+                       const cell_t &bm1, const cell_t &bp0,
+                       const cell_t &bp1) {
+  return cell_t{1.0, c.rho,
+                (bm0.u - 2 * c.u + bp0.u) + (bm1.u - 2 * c.u + bp1.u), 0.0};
+}
+inline cell_t cell_face(const cell_t &c, std::ptrdiff_t i) { return c; }
+
+template <bool lazy> double grid_rk2_substep(std::int64_t iters) {
+  auto s0 = fun::iotaMapMulti<grid2_t>(
+      [](const adt::index_t<2> &i) {
+        return cell_t{double(i[0]), double(i[1]), 0.0, 1.0};
+      },
+      adt::steprange_t<2>(shape2));
+  auto r0 = s0;
+  std::array<adt::grid<std::vector<adt::dummy>, cell_t, 1>, 4> bs;
+  for (std::ptrdiff_t f = 0; f < 4; ++f)
+    bs[f] = fun::boundaryMap(cell_face, s0, f);
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    if (lazy) {
+      auto s1 = fun::fmap2(cell_axpy, fun::lazy(s0), fun::lazy(r0), 0.25);
+      auto r1 = fun::fmapStencilMulti<2>(cell_rhs, cell_face, s1, ~0, bs[0],
+                                         bs[2], bs[1], bs[3]);
+      r += r1.last().rho;
+    } else {
+      auto s1 = fun::fmap2(cell_axpy, s0, r0, 0.25);
+      auto r1 = fun::fmapStencilMulti<2>(cell_rhs, cell_face, s1, ~0, bs[0],
+                                         bs[2], bs[1], bs[3]);
+      r += r1.last().rho;
+    }
+  }
+  return r;
+}
+
+// A 2d Laplace stencil for various grid sizes. When the rows of a
+// contiguous grid are a multiple of the page size long, neighbouring
+// rows compete for the same cache sets. Grids with aligned storage pad
+// their rows to avoid this.
+
+typedef std::vector<adt::dummy,
+                    cxx::aligned_allocator<adt::dummy, cxx::cache_line_size>>
+    aligned_vector_t;
+
+inline double laplace(double x, std::size_t bdirs, double bm0, double bm1,
+                      double bp0, double bp1) {
+  return (bm0 - 2 * x + bp0) + (bm1 - 2 * x + bp1);
+}
+inline double face(double x, std::ptrdiff_t i) { return x; }
+
+template <typename C>
+double grid_laplace(std::ptrdiff_t n, std::int64_t iters) {
+  auto xs = fun::iotaMapMulti<adt::grid<C, double, 2>>(
+      [](const adt::index_t<2> &i) { return double(i[0] * i[1]); },
+      adt::steprange_t<2>(adt::index_t<2>{{n, n}}));
+  std::array<adt::grid<C, double, 1>, 4> bs;
+  for (std::ptrdiff_t f = 0; f < 4; ++f)
+    bs[f] = fun::boundaryMap(face, xs, f);
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    auto rs = fun::fmapStencilMulti<2>(laplace, face, xs, ~0, bs[0], bs[2],
+                                       bs[1], bs[3]);
+    r += rs.last();
+  }
+  return r;
+}
+
+// Several steps of a 2d diffusion stencil, either one at a time or
+// blocked in time via iterateStencil, which streams the grid through
+// memory once for several steps
+
+inline double diffuse(double x, std::size_t bdirs, double bm0, double bm1,
+                      double bp0, double bp1) {
+  return x + 0.125 * laplace(x, bdirs, bm0, bm1, bp0, bp1);
+}
+
+const std::ptrdiff_t iterate_steps = 8;
+
+template <bool blocked>
+double grid_iterate(std::ptrdiff_t n, std::int64_t iters) {
+  auto xs = fun::iotaMapMulti<adt::grid<std::vector<adt::dummy>, double, 2>>(
+      [](const adt::index_t<2> &i) { return double(i[0] * i[1]); },
+      adt::steprange_t<2>(adt::index_t<2>{{n, n}}));
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    if (blocked) {
+      xs = fun::iterateStencil<2>(cxx::execution::par, diffuse, face, face, xs,
+                                  ~0, iterate_steps);
+    } else {
+      for (std::ptrdiff_t step = 0; step < iterate_steps; ++step)
+        xs = fun::fmapStencilMulti<2>(
+            cxx::execution::par, diffuse, face, xs, ~0,
+            fun::boundaryMap(face, xs, 0), fun::boundaryMap(face, xs, 2),
+            fun::boundaryMap(face, xs, 1), fun::boundaryMap(face, xs, 3));
+    }
+    r += xs.last();
+  }
+  return r;
+}
+
+template <typename F>
+void runbench(const std::string &name, F &&f,
+              double bytes_per_point = 3.0 * sizeof(cell_t),
+              std::ptrdiff_t points = adt::prod(shape)) {
+  std::int64_t inititers = 1;
+  double mintime = 1.0;
+
+  std::cout << "   " << std::left << std::setw(32) << name << std::flush;
+  auto iters = inititers;
+  auto time = mintime;
+  for (;;) {
+    auto t0 = gettime();
+    volatile double r = cxx::invoke(f, iters);
+    (void)r;
+    auto t1 = gettime();
+    time = t1 - t0;
+    if (time >= mintime)
+      break;
+    iters = clamp(std::int64_t(llrint(1.1 * iters * mintime / time)),
+                  2 * iters, 10 * iters);
+  }
+  double bytes = bytes_per_point * points;
+  std::cout << "   " << time / iters * 1.0e+3 << " msec/iter, "
+            << bytes * iters / time / 1.0e+9 << " GByte/sec   (" << iters
+            << " iters, " << time << " sec)\n";
+}
+
+int funhpc_main(int argc, char **argv) {
+  std::cout << "Grid Bandwidth Benchmark\n"
+            << "\n";
+
+  runbench("raw loop, serial", raw_serial);
+  runbench("raw loop, parallel", raw_parallel);
+  runbench("grid fmap2, seq", grid_fmap2<cxx::execution::sequenced_policy>);
+  runbench("grid fmap2, par", grid_fmap2<cxx::execution::parallel_policy>);
+  // The structure-of-arrays layout reads only the accessed field
+  runbench("grid fmap field, AoS", grid_fmap_field<grid_t>,
+           sizeof(cell_t) + sizeof(double));
+  runbench("grid fmap field, SoA", grid_fmap_field<soa_grid_t>,
+           sizeof(cell_t) + sizeof(double));
+  // The lazy version neither writes nor re-reads the intermediate grid
+  runbench("grid rk2 substep, eager", grid_rk2_substep<false>,
+           5.0 * sizeof(cell_t));
+  runbench("grid rk2 substep, lazy", grid_rk2_substep<true>,
+           3.0 * sizeof(cell_t));
+
+  for (std::ptrdiff_t n : {500, 512, 1000, 1024, 2000, 2048}) {
+    std::string size = std::to_string(n) + "^2";
+    runbench("grid laplace " + size + ", contiguous",
+             [n](std::int64_t iters) {
+               return grid_laplace<std::vector<adt::dummy>>(n, iters);
+             },
+             2.0 * sizeof(double), n * n);
+    runbench("grid laplace " + size + ", aligned",
+             [n](std::int64_t iters) {
+               return grid_laplace<aligned_vector_t>(n, iters);
+             },
+             2.0 * sizeof(double), n * n);
+  }
+
+  // Bandwidth per step; the blocked version reads and writes the grid
+  // only once for all steps
+  for (std::ptrdiff_t n : {1000, 2000}) {
+    std::string size = std::to_string(n) + "^2";
+    runbench("grid iterate " + size + ", stepwise",
+             [n](std::int64_t iters) { return grid_iterate<false>(n, iters); },
+             2.0 * sizeof(double) * iterate_steps, n * n);
+    runbench("grid iterate " + size + ", blocked",
+             [n](std::int64_t iters) { return grid_iterate<true>(n, iters); },
+             2.0 * sizeof(double) * iterate_steps, n * n);
+  }
+
+  std::cout << "\n"
+            << "Done.\n";
+  return 0;
+}
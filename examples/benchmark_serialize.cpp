@@ -0,0 +1,127 @@
+#include <adt/dummy.hpp>
+#include <adt/index.hpp>
+#include <cxx/invoke.hpp>
+#include <cxx/serialize.hpp>
+#include <fun/grid_decl.hpp>
+#include <fun/vector.hpp>
+
+#include <funhpc/main.hpp>
+
+#include <fun/grid_impl.hpp>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+// Serialization throughput of grids, as used when sending leaf grids
+// to another process. Cells are serialized either field by field, or
+// as their bytes.
+
+template <typename T> T clamp(T x, T minval, T maxval) {
+  return std::min(std::max(x, minval), maxval);
+}
+
+double gettime() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec + tv.tv_usec / 1.0e+6;
+}
+
+template <bool bitwise> struct cell_t {
+  double x, u, rho, v;
+  template <typename Archive> void serialize(Archive &ar) { ar(x, u, rho, v); }
+};
+
+namespace cxx {
+template <> struct is_bitwise_serializable<cell_t<true>> : std::true_type {};
+}
+
+constexpr std::size_t dim = 3;
+template <bool bitwise>
+using grid_t = adt::grid<std::vector<adt::dummy>, cell_t<bitwise>, dim>;
+
+const std::ptrdiff_t npoints = 100;
+const adt::index_t<dim> shape{{npoints, npoints, npoints}};
+
+template <bool bitwise> auto make_grid() {
+  return fun::iotaMapMulti<grid_t<bitwise>>(
+      [](const adt::index_t<dim> &i) {
+        return cell_t<bitwise>{double(i[0]), double(i[1]), double(i[2]), 1.0};
+      },
+      adt::steprange_t<dim>(shape));
+}
+
+template <bool bitwise> double grid_save(std::int64_t iters) {
+  auto xs = make_grid<bitwise>();
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    std::ostringstream buf;
+    { (cereal::BinaryOutputArchive(buf))(xs); }
+    r += buf.tellp();
+  }
+  return r;
+}
+
+template <bool bitwise> double grid_load(std::int64_t iters) {
+  std::string str;
+  {
+    std::ostringstream buf;
+    { (cereal::BinaryOutputArchive(buf))(make_grid<bitwise>()); }
+    str = buf.str();
+  }
+  double r = 0;
+  for (std::int64_t iter = 0; iter < iters; ++iter) {
+    std::istringstream buf(str);
+    grid_t<bitwise> xs;
+    { (cereal::BinaryInputArchive(buf))(xs); }
+    r += xs.last().u;
+  }
+  return r;
+}
+
+template <typename F> void runbench(const std::string &name, F &&f) {
+  std::int64_t inititers = 1;
+  double mintime = 1.0;
+
+  std::cout << "   " << std::left << std::setw(32) << name << std::flush;
+  auto iters = inititers;
+  auto time = mintime;
+  for (;;) {
+    auto t0 = gettime();
+    volatile double r = cxx::invoke(f, iters);
+    (void)r;
+    auto t1 = gettime();
+    time = t1 - t0;
+    if (time >= mintime)
+      break;
+    iters = clamp(std::int64_t(llrint(1.1 * iters * mintime / time)),
+                  2 * iters, 10 * iters);
+  }
+  double bytes = 4.0 * sizeof(double) * adt::prod(shape);
+  std::cout << "   " << time / iters * 1.0e+3 << " msec/iter, "
+            << bytes * iters / time / 1.0e+9 << " GByte/sec   (" << iters
+            << " iters, " << time << " sec)\n";
+}
+
+int funhpc_main(int argc, char **argv) {
+  std::cout << "Grid Serialization Benchmark\n"
+            << "\n";
+
+  runbench("grid save, field by field", grid_save<false>);
+  runbench("grid save, bitwise", grid_save<true>);
+  runbench("grid load, field by field", grid_load<false>);
+  runbench("grid load, bitwise", grid_load<true>);
+
+  std::cout << "\n"
+            << "Done.\n";
+  return 0;
+}
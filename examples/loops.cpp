@@ -1,5 +1,6 @@
 #include <funhpc/async.hpp>
 #include <funhpc/main.hpp>
+#include <qthread/parallel.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -79,11 +80,34 @@ void vdiff_funhpc(double *y, const double *x, int n) {
     f.wait();
 }
 
+// The same loop, using qthread::parallel_for. The block size is not
+// fixed, but is adapted at run time: the execution time of each block
+// is measured, and blocks are made large enough to amortize the
+// thread overhead, but small enough to keep all cores busy. The
+// futures are returned in index order, so that the boundary blocks
+// can again be awaited first.
+void vdiff_parallel_for(double *y, const double *x, int n) {
+  auto fs = qthread::parallel_for(adt::irange_t(1, n - 1), [=](int i) {
+    y[i] = (x[i + 1] - x[i - 1]) / 2;
+  });
+
+  // synchronize as soon as the boundary results are available
+  assert(!fs.empty());
+  fs.front().wait();
+  fs.back().wait();
+  sync(y, n);
+
+  // wait for all threads to finish
+  for (const auto &f : fs)
+    f.wait();
+}
+
 int funhpc_main(int argc, char **argv) {
   const int n = 1000000;
   std::vector<double> x(n), y(n);
   vdiff(&y[0], &x[0], n);
   vdiff_openmp(&y[0], &x[0], n);
   vdiff_funhpc(&y[0], &x[0], n);
+  vdiff_parallel_for(&y[0], &x[0], n);
   return 0;
 }
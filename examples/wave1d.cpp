@@ -1,5 +1,6 @@
 #include <adt/dummy.hpp>
 #include <cxx/funobj.hpp>
+#include <cxx/serialize.hpp>
 #include <fun/fun_decl.hpp>
 #include <fun/maxarray.hpp>
 #include <fun/nested_decl.hpp>
@@ -9,6 +10,7 @@
 #include <fun/tree_decl.hpp>
 #include <fun/vector.hpp>
 #include <funhpc/main.hpp>
+#include <funhpc/placement.hpp>
 #include <funhpc/rexec.hpp>
 
 #include <fun/fun_impl.hpp>
@@ -26,6 +28,8 @@
 #include <limits>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 // Types
@@ -58,7 +62,20 @@ struct parameters_t {
   }
 };
 
-parameters_t parameters;
+// The parameters are set up during startup, so that they are also
+// available on the other processes
+parameters_t make_parameters() {
+  parameters_t parameters;
+  parameters.ncells = 100;
+  parameters.nsteps = parameters.ncells * parameters.icfl;
+  parameters.outinfo_every = parameters.nsteps / 10;
+  parameters.outfile_every = parameters.nsteps / 20;
+  parameters.outfile_name = "wave1d.tsv";
+  parameters.setup();
+  return parameters;
+}
+
+const parameters_t parameters = make_parameters();
 
 // Norm
 
@@ -105,6 +122,10 @@ struct cell_t {
   real_t u, rho, v;
   template <typename Archive> void serialize(Archive &ar) { ar(x, u, rho, v); }
 };
+// Cells contain only numbers, and are sent as their bytes
+namespace cxx {
+template <> struct is_bitwise_serializable<cell_t> : std::true_type {};
+}
 
 std::ostream &operator<<(std::ostream &os, const cell_t &c) {
   return os << "cell_t{x=" << c.x << " u=" << c.u << " rho=" << c.rho
@@ -215,26 +236,52 @@ auto grid_axpy(const grid_t &y, const grid_t &x, real_t alpha) {
                 fun::fmap2(cell_axpy, y.cells, x.cells, alpha)};
 }
 
+// Function objects that are sent to other processes cannot be lambdas
+struct cell_init_at {
+  real_t t;
+  template <typename Archive> void serialize(Archive &ar) { ar(t); }
+  auto operator()(int_t i) const {
+    real_t x = parameters.xmin + parameters.dx * (real_t(i) + 0.5);
+    return cell_init(t, x);
+  }
+};
+
+// Proxy-based storage types spread their leaves over all processes
+template <typename C, typename F,
+          std::enable_if_t<fun::detail::is_placeable<C>::value> * = nullptr>
+auto storage_iotaMap(F &&f, int_t n) {
+  return fun::iotaMap<C>(funhpc::placement<1>(funhpc::placement_kind::block),
+                         std::forward<F>(f), n);
+}
+template <typename C, typename F,
+          std::enable_if_t<!fun::detail::is_placeable<C>::value> * = nullptr>
+auto storage_iotaMap(F &&f, int_t n) {
+  return fun::iotaMap<C>(std::forward<F>(f), n);
+}
+
 auto grid_init(real_t t) {
-  return grid_t{t, fun::iotaMap<storage_t<adt::dummy>>(
-                       [t](int_t i) {
-                         real_t x = parameters.xmin +
-                                    parameters.dx * (real_t(i) + 0.5);
-                         return cell_init(t, x);
-                       },
-                       parameters.ncells)};
+  return grid_t{t, storage_iotaMap<storage_t<adt::dummy>>(cell_init_at{t},
+                                                          parameters.ncells)};
 }
 
 auto grid_error(const grid_t &g) {
   return grid_t{g.time, fun::fmap(cell_error, g.cells, g.time)};
 }
 
-auto grid_norm(const grid_t &g) {
-  return fun::foldMap(cell_norm, norm_add, norm_zero(), g.cells);
-}
+struct cell_error_norm {
+  real_t t;
+  template <typename Archive> void serialize(Archive &ar) { ar(t); }
+  auto operator()(const cell_t &c) const {
+    return cell_norm(cell_error(c, t));
+  }
+};
 
-auto grid_energy(const grid_t &g) {
-  return fun::foldMap(cell_energy, std::plus<real_t>(), 0.0, g.cells);
+// Calculate the error norm and the energy in a single traversal
+auto grid_norm_energy(const grid_t &g) {
+  return fun::foldMapTuple(
+      std::make_tuple(cell_error_norm{g.time}, cell_energy),
+      std::make_tuple(norm_add, std::plus<real_t>()),
+      std::make_tuple(norm_zero(), 0.0), g.cells);
 }
 
 auto grid_boundary(const grid_t &g, int_t i) {
@@ -256,14 +303,12 @@ auto grid_rhs(const grid_t &g) {
 struct schedule_t {
   int_t iter;
   grid_t state;
-  grid_t error;
-  qthread::shared_future<norm_t> fnorm;
-  qthread::shared_future<real_t> fenergy;
+  qthread::shared_future<std::tuple<norm_t, real_t>> fnorm_energy;
   grid_t rhs;
   schedule_t(int_t iter, const grid_t &state)
-      : iter(iter), state(state), error(grid_error(state)),
-        fnorm(qthread::async(grid_norm, error)),
-        fenergy(qthread::async(grid_energy, state)), rhs(grid_rhs(state)) {}
+      : iter(iter), state(state),
+        fnorm_energy(qthread::async(grid_norm_energy, state)),
+        rhs(grid_rhs(state)) {}
 };
 
 auto euler(const schedule_t &s) {
@@ -285,7 +330,8 @@ auto rk2(const schedule_t &s) {
 int info_output(int token, const schedule_t &s) {
   if (s.iter % parameters.outinfo_every == 0 || s.iter == parameters.nsteps) {
     std::cout << "[" << s.iter << "] " << s.state.time << ": "
-              << s.fnorm.get().norm2() << " " << s.fenergy.get() << "\n";
+              << std::get<0>(s.fnorm_energy.get()).norm2() << " "
+              << std::get<1>(s.fnorm_energy.get()) << "\n";
   }
   return token;
 }
@@ -310,7 +356,7 @@ int file_output(int token, const schedule_t &s) {
     fs.open(parameters.outfile_name, mode);
     fs << fun::foldMap2(cell_to_ostreamer{s.state.time},
                         fun::combine_ostreamers(), fun::ostreamer(),
-                        s.state.cells, s.error.cells)
+                        s.state.cells, grid_error(s.state).cells)
        << "\n";
     fs.close();
   }
@@ -321,12 +367,6 @@ int file_output(int token, const schedule_t &s) {
 
 int funhpc_main(int argc, char **argv) {
   std::cout << "Wave1d\n";
-  parameters.ncells = 100;
-  parameters.nsteps = parameters.ncells * parameters.icfl;
-  parameters.outinfo_every = parameters.nsteps / 10;
-  parameters.outfile_every = parameters.nsteps / 20;
-  parameters.outfile_name = "wave1d.tsv";
-  parameters.setup();
   qthread::shared_future<int> info_token = qthread::make_ready_future(0);
   qthread::shared_future<int> file_token = qthread::make_ready_future(0);
   schedule_t s(0, grid_init(parameters.tmin));
@@ -1,12 +1,17 @@
 #include <adt/dummy.hpp>
 #include <adt/index.hpp>
 #include <cxx/apply.hpp>
+#include <cxx/execution.hpp>
 #include <cxx/funobj.hpp>
+#include <cxx/serialize.hpp>
 #include <cxx/tuple.hpp>
 #include <cxx/utility.hpp>
 #include <fun/array.hpp>
+#include <fun/dist_grid.hpp>
+#include <fun/fold.hpp>
 #include <fun/fun_decl.hpp>
 #include <fun/grid_decl.hpp>
+#include <fun/lazy.hpp>
 #include <fun/maxarray.hpp>
 #include <fun/nested_decl.hpp>
 #include <fun/proxy.hpp>
@@ -15,6 +20,7 @@
 #include <fun/tree_decl.hpp>
 #include <fun/vector.hpp>
 #include <funhpc/main.hpp>
+#include <funhpc/placement.hpp>
 #include <funhpc/rexec.hpp>
 
 #include <fun/fun_impl.hpp>
@@ -35,6 +41,7 @@
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 // Types
@@ -74,6 +81,13 @@ struct parameters_t {
   int_t outfile_every;
   std::string outfile_name;
 
+  // Evaluate the intermediate RK2 state lazily inside the stencil
+  // instead of storing it (see fun/lazy.hpp). This saves memory
+  // traffic only once the stencil is memory-bound; on small grids the
+  // repeated evaluation for each neighbour makes it slower. Only the
+  // flat storage types support this.
+  bool fuse_rk2;
+
   void setup() {
     dx = (xmax - xmin) / ncells;
     dx_1 = 1.0 / dx;
@@ -81,7 +95,21 @@ struct parameters_t {
   }
 };
 
-parameters_t parameters;
+// The parameters are set up during startup, so that they are also
+// available on the other processes
+parameters_t make_parameters() {
+  parameters_t parameters;
+  parameters.ncells = vione * 100;
+  parameters.nsteps = adt::maxval(parameters.ncells) * parameters.icfl;
+  parameters.outinfo_every = parameters.nsteps / 10;
+  parameters.outfile_every = -1; // TODO parameters.nsteps / 20;
+  parameters.outfile_name = "wave3d.tsv";
+  parameters.fuse_rk2 = false;
+  parameters.setup();
+  return parameters;
+}
+
+const parameters_t parameters = make_parameters();
 
 // Norm
 
@@ -134,6 +162,10 @@ struct cell_t {
   vreal_t v;
   template <typename Archive> void serialize(Archive &ar) { ar(x, u, rho, v); }
 };
+// Cells contain only numbers, and are sent as their bytes
+namespace cxx {
+template <> struct is_bitwise_serializable<cell_t> : std::true_type {};
+}
 
 std::ostream &operator<<(std::ostream &os, const cell_t &c) {
   return os << "cell_t{x=" << c.x << " u=" << c.u << " rho=" << c.rho
@@ -227,6 +259,11 @@ constexpr std::size_t max_size = 16;
 template <typename T>
 using maxarray_grid = adt::grid<adt::maxarray<adt::dummy, max_size>, T, dim>;
 
+// A single flat grid; its loops are parallelized via the execution
+// policy below
+template <typename T>
+using vector_grid = adt::grid<std::vector<adt::dummy>, T, dim>;
+
 template <typename T>
 using shared_grid =
     adt::nested<std::shared_ptr<adt::dummy>, maxarray_grid<adt::dummy>, T>;
@@ -243,6 +280,11 @@ template <typename T> using future_tree = adt::tree<future_grid<adt::dummy>, T>;
 
 template <typename T> using proxy_tree = adt::tree<proxy_grid<adt::dummy>, T>;
 
+// A grid distributed over all processes; stencils exchange the halos
+// between its blocks in one message per neighbouring process
+template <typename T>
+using dist_grid = funhpc::dist_grid<std::vector<adt::dummy>, T, dim>;
+
 template <typename T>
 using shared_grid_tree =
     adt::nested<adt::tree<shared_grid<adt::dummy>, adt::dummy>,
@@ -258,9 +300,13 @@ using proxy_grid_tree =
     adt::nested<adt::tree<proxy_grid<adt::dummy>, adt::dummy>,
                 proxy_grid<adt::dummy>, T>;
 
-// TOOD: Correct handling of boundaries (?) for adt::nested to make
-// the other storage types work
-template <typename T> using storage_t = maxarray_grid<T>;
+// The single-leaf storage types (maxarray_grid and the *_grid types
+// below) hold at most max_size cells; use them only with a small
+// ncells. The tree-based types and dist_grid spread the cells over
+// all processes.
+template <typename T> using storage_t = vector_grid<T>;
+// template <typename T> using storage_t = maxarray_grid<T>;
+// template <typename T> using storage_t = dist_grid<T>;
 
 // template <typename T> using storage_t = shared_grid<T>;
 // template <typename T> using storage_t = future_grid<T>;
@@ -280,6 +326,30 @@ template <typename T>
 using boundary_t =
     typename fun::fun_traits<boundary_dummy>::template constructor<T>;
 
+// The flat and distributed grids parallelize their loops via an
+// execution policy, and can evaluate lazy expressions. The nested
+// storage types are parallelized via their outer level instead.
+template <typename C> struct is_flat_storage : std::false_type {};
+template <typename S, typename T, std::size_t D>
+struct is_flat_storage<adt::grid<S, T, D>> : std::true_type {};
+template <typename S, typename T, std::size_t D>
+struct is_flat_storage<funhpc::dist_grid<S, T, D>> : std::true_type {};
+
+constexpr auto policy = cxx::execution::par;
+
+// Call f(policy, args...) for the flat storage types, and f(args...)
+// otherwise
+template <typename F, typename... Args, typename C = storage_t<adt::dummy>,
+          std::enable_if_t<is_flat_storage<C>::value> * = nullptr>
+auto storage_call(F &&f, Args &&... args) {
+  return std::forward<F>(f)(policy, std::forward<Args>(args)...);
+}
+template <typename F, typename... Args, typename C = storage_t<adt::dummy>,
+          std::enable_if_t<!is_flat_storage<C>::value> * = nullptr>
+auto storage_call(F &&f, Args &&... args) {
+  return std::forward<F>(f)(std::forward<Args>(args)...);
+}
+
 struct grid_t {
   real_t time;
   storage_t<cell_t> cells;
@@ -295,37 +365,92 @@ std::ostream &operator<<(std::ostream &os, const grid_t &g) {
 
 auto grid_axpy(const grid_t &y, const grid_t &x, real_t alpha) {
   return grid_t{alpha * x.time + y.time,
-                fun::fmap2(cell_axpy, y.cells, x.cells, alpha)};
+                storage_call([](auto &&... args) {
+                  return fun::fmap2(std::forward<decltype(args)>(args)...);
+                }, cell_axpy, y.cells, x.cells, alpha)};
+}
+
+auto cell_axpy_swapped(const cell_t &x, const cell_t &y, real_t alpha) {
+  return cell_axpy(y, x, alpha);
+}
+
+// Reuse the storage of x for the result
+auto grid_axpy(const grid_t &y, grid_t &&x, real_t alpha) {
+  return grid_t{alpha * x.time + y.time,
+                storage_call([](auto &&... args) {
+                  return fun::fmap2(std::forward<decltype(args)>(args)...);
+                }, cell_axpy_swapped, std::move(x.cells), y.cells, alpha)};
+}
+
+// Function objects that are sent to other processes cannot be lambdas
+struct cell_init_at {
+  real_t t;
+  template <typename Archive> void serialize(Archive &ar) { ar(t); }
+  auto operator()(vint_t i) const {
+    vreal_t x = parameters.xmin +
+                parameters.dx *
+                    (fun::fmap([](int_t i) { return real_t(i); }, i) + 0.5);
+    return cell_init(t, x);
+  }
+};
+
+// Proxy-based storage types spread their leaves over all processes,
+// keeping neighbouring leaves together along a Hilbert curve
+template <typename C, typename F,
+          std::enable_if_t<fun::detail::is_placeable<C>::value> * = nullptr>
+auto storage_iotaMapMulti(F &&f, const adt::steprange_t<dim> &inds) {
+  return fun::iotaMapMulti<C>(
+      funhpc::placement<dim>(funhpc::placement_kind::hilbert),
+      std::forward<F>(f), inds);
+}
+template <typename C, typename F,
+          std::enable_if_t<!fun::detail::is_placeable<C>::value> * = nullptr>
+auto storage_iotaMapMulti(F &&f, const adt::steprange_t<dim> &inds) {
+  return storage_call(
+      [](auto &&... args) {
+        return fun::iotaMapMulti<C>(std::forward<decltype(args)>(args)...);
+      },
+      std::forward<F>(f), inds);
 }
 
 auto grid_init(real_t t) {
-  return grid_t{
-      t, fun::iotaMapMulti<storage_t<adt::dummy>>(
-             [t](vint_t i) {
-               vreal_t x =
-                   parameters.xmin +
-                   parameters.dx *
-                       (fun::fmap([](int_t i) { return real_t(i); }, i) + 0.5);
-               return cell_init(t, x);
-             },
-             adt::steprange_t<dim>(parameters.ncells))};
+  return grid_t{t, storage_iotaMapMulti<storage_t<adt::dummy>>(
+                       cell_init_at{t},
+                       adt::steprange_t<dim>(parameters.ncells))};
 }
 
 auto grid_error(const grid_t &g) {
-  return grid_t{g.time, fun::fmap(cell_error, g.cells, g.time)};
+  return grid_t{g.time, storage_call([](auto &&... args) {
+                  return fun::fmap(std::forward<decltype(args)>(args)...);
+                }, cell_error, g.cells, g.time)};
 }
 
-auto grid_norm(const grid_t &g) {
-  return fun::foldMap(cell_norm, norm_t::plus, norm_t::zero(), g.cells);
-}
+struct cell_error_norm {
+  real_t t;
+  template <typename Archive> void serialize(Archive &ar) { ar(t); }
+  auto operator()(const cell_t &c) const {
+    return cell_norm(cell_error(c, t));
+  }
+};
 
-auto grid_energy(const grid_t &g) {
-  return fun::foldMap(cell_energy, std::plus<real_t>(), 0.0, g.cells);
+real_t real_plus(real_t x, real_t y) { return x + y; }
+
+// Calculate the error norm and the energy in a single traversal
+auto grid_norm_energy(const grid_t &g) {
+  return storage_call(
+      [](auto &&... args) {
+        return fun::foldMapTuple(std::forward<decltype(args)>(args)...);
+      },
+      std::make_tuple(cell_error_norm{g.time}, cell_energy),
+      std::make_tuple(fun::associative(norm_t::plus),
+                      fun::associative(real_plus)),
+      std::make_tuple(norm_t::zero(), 0.0), g.cells);
 }
 
-auto grid_boundary(const grid_t &g, int_t i) {
-  // return fun::boundaryMap(cell_boundary_dirichlet, g.cells, i, g.time);
-  return fun::boundaryMap(cell_boundary_reflecting, g.cells, i);
+// The cells may also be a lazy expression (see fun/lazy.hpp)
+template <typename Cells> auto cells_boundary(const Cells &cells, int_t i) {
+  // return fun::boundaryMap(cell_boundary_dirichlet, cells, i, time);
+  return fun::boundaryMap(cell_boundary_reflecting, cells, i);
 }
 
 template <typename F, typename G, typename TS, typename BS,
@@ -338,50 +463,51 @@ auto wrap_fmapStencil(F &&f, G &&g, TS &&xs, BS &&bs,
       std::get<Indices>(std::forward<BS>(bs))..., std::forward<Args>(args)...);
 }
 
-auto grid_rhs(const grid_t &g) {
+template <typename Cells> auto cells_rhs(const Cells &cells) {
   std::array<boundary_t<cell_t>, dim> bms, bps;
   for (std::ptrdiff_t d = 0; d < dim; ++d) {
-    bms[d] = grid_boundary(g, 2 * d + 0);
-    bps[d] = grid_boundary(g, 2 * d + 1);
+    bms[d] = cells_boundary(cells, 2 * d + 0);
+    bps[d] = cells_boundary(cells, 2 * d + 1);
   }
   auto bs = std::tuple_cat(std::move(bms), std::move(bps));
   std::size_t bmask = ~0;
 
-  // return grid_t{1.0,
-  //               wrap_fmapStencil( // CXX_FUNOBJ((cell_rhs_t)cell_rhs),
-  //                   // CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &>),
-  //                   CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &,
-  //                                       const cell_t &, const cell_t &>),
-  //                   CXX_FUNOBJ(cell_get_face), g.cells, std::move(bs),
-  //                   std::make_index_sequence<2 * dim>())};
+  // return wrap_fmapStencil( // CXX_FUNOBJ((cell_rhs_t)cell_rhs),
+  //     // CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &>),
+  //     CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &,
+  //                         const cell_t &, const cell_t &>),
+  //     CXX_FUNOBJ(cell_get_face), cells, std::move(bs),
+  //     std::make_index_sequence<2 * dim>());
   // static_assert(dim == 1, "");
-  // return grid_t{1.0, fun::fmapStencilMulti<dim>(
-  //                        CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t
-  //                        &>),
-  //                        CXX_FUNOBJ(cell_get_face), g.cells, bmask,
-  //                        std::get<0>(bs), std::get<1>(bs))};
+  // return fun::fmapStencilMulti<dim>(
+  //     CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &>),
+  //     CXX_FUNOBJ(cell_get_face), cells, bmask, std::get<0>(bs),
+  //     std::get<1>(bs));
   static_assert(dim == 2, "");
-  return grid_t{1.0,
-                fun::fmapStencilMulti<dim>(
-                    CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &,
-                                        const cell_t &, const cell_t &>),
-                    CXX_FUNOBJ(cell_get_face), g.cells, bmask, std::get<0>(bs),
-                    std::get<1>(bs), std::get<2>(bs), std::get<3>(bs))};
+  return storage_call(
+      [](auto &&... args) {
+        return fun::fmapStencilMulti<dim>(
+            std::forward<decltype(args)>(args)...);
+      },
+      CXX_FUNOBJ(cell_rhs<const cell_t &, const cell_t &, const cell_t &,
+                          const cell_t &>),
+      CXX_FUNOBJ(cell_get_face), cells, bmask, std::get<0>(bs),
+      std::get<1>(bs), std::get<2>(bs), std::get<3>(bs));
 }
 
+auto grid_rhs(const grid_t &g) { return grid_t{1.0, cells_rhs(g.cells)}; }
+
 // State
 
 struct schedule_t {
   int_t iter;
   grid_t state;
-  grid_t error;
-  qthread::shared_future<norm_t> fnorm;
-  qthread::shared_future<real_t> fenergy;
+  qthread::shared_future<std::tuple<norm_t, real_t>> fnorm_energy;
   grid_t rhs;
   schedule_t(int_t iter, const grid_t &state)
-      : iter(iter), state(state), error(grid_error(state)),
-        fnorm(qthread::async(grid_norm, error)),
-        fenergy(qthread::async(grid_energy, state)), rhs(grid_rhs(state)) {}
+      : iter(iter), state(state),
+        fnorm_energy(qthread::async(grid_norm_energy, state)),
+        rhs(grid_rhs(state)) {}
 };
 
 auto euler(const schedule_t &s) {
@@ -390,12 +516,33 @@ auto euler(const schedule_t &s) {
   return grid_axpy(s0, r0, parameters.dt);
 }
 
-auto rk2(const schedule_t &s) {
+auto rk2_stored(const schedule_t &s) {
   const grid_t &s0 = s.state;
   const grid_t &r0 = s.rhs;
   auto s1 = grid_axpy(s0, r0, 0.5 * parameters.dt);
-  auto r1 = grid_rhs(s1);
-  return grid_axpy(s0, r1, parameters.dt);
+  return grid_axpy(s0, grid_rhs(s1), parameters.dt);
+}
+
+// The intermediate state is not stored; the stencil evaluates it on
+// the fly. (The cells are accessed via C so that this is instantiated
+// only for the flat storage types.)
+template <typename C = storage_t<cell_t>,
+          std::enable_if_t<is_flat_storage<C>::value> * = nullptr>
+grid_t rk2_fused(const schedule_t &s) {
+  const grid_t &s0 = s.state;
+  const C &c0 = s0.cells;
+  const C &r0 = s.rhs.cells;
+  auto s1 = fun::fmap2(cell_axpy, fun::lazy(c0), fun::lazy(r0),
+                       0.5 * parameters.dt);
+  return grid_axpy(s0, grid_t{1.0, cells_rhs(s1)}, parameters.dt);
+}
+// Lazy expressions do not support the nested storage types
+template <typename C = storage_t<cell_t>,
+          std::enable_if_t<!is_flat_storage<C>::value> * = nullptr>
+grid_t rk2_fused(const schedule_t &s) { return rk2_stored(s); }
+
+grid_t rk2(const schedule_t &s) {
+  return parameters.fuse_rk2 ? rk2_fused(s) : rk2_stored(s);
 }
 
 // Output
@@ -409,7 +556,8 @@ int info_output(int token, const schedule_t &s) {
        s.iter % parameters.outinfo_every == 0) ||
       s.iter == parameters.nsteps) {
     std::cout << "[" << s.iter << "] " << s.state.time << ": "
-              << s.fnorm.get().norm2() << " " << s.fenergy.get() << "\n"
+              << std::get<0>(s.fnorm_energy.get()).norm2() << " "
+              << std::get<1>(s.fnorm_energy.get()) << "\n"
               << std::flush;
   }
   return token;
@@ -438,7 +586,7 @@ int file_output(int token, const schedule_t &s) {
     fs.open(parameters.outfile_name, mode);
     fs << fun::foldMap2(cell_to_ostreamer{s.state.time},
                         fun::combine_ostreamers(), fun::ostreamer(),
-                        s.state.cells, s.error.cells)
+                        s.state.cells, grid_error(s.state).cells)
        << "\n";
     fs.close();
   }
@@ -468,12 +616,6 @@ public:
 
 int funhpc_main(int argc, char **argv) {
   std::cout << "Wave3d\n";
-  parameters.ncells = vione * 100;
-  parameters.nsteps = adt::maxval(parameters.ncells) * parameters.icfl;
-  parameters.outinfo_every = parameters.nsteps / 10;
-  parameters.outfile_every = -1; // TODO parameters.nsteps / 20;
-  parameters.outfile_name = "wave3d.tsv";
-  parameters.setup();
   qthread::shared_future<int> info_token = qthread::make_ready_future(0);
   qthread::shared_future<int> file_token = qthread::make_ready_future(0);
   auto s = std::make_shared<schedule_t>(0, grid_init(parameters.tmin));
@@ -0,0 +1,173 @@
+#ifndef FUN_BALANCE_HPP
+#define FUN_BALANCE_HPP
+
+#include <adt/nested_decl.hpp>
+#include <fun/nested_decl.hpp>
+#include <fun/proxy.hpp>
+#include <funhpc/proxy.hpp>
+#include <funhpc/rexec.hpp>
+#include <funhpc/rptr.hpp>
+#include <qthread/future.hpp>
+
+#include <cereal/access.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Load balancing for containers whose leaves are proxies, e.g.
+// nested<tree<...>, nested<proxy<...>, ...>, T>. While timing is
+// switched on (see funhpc::set_proxy_timing), the tasks of fmap and
+// fmapStencil on proxies record how long they took (see
+// fun/proxy.hpp); balance collects these costs for all leaves, cuts the
+// sequence of leaves into pieces of equal cost (for trees ordered
+// along a space-filling curve, these are compact regions), and
+// migrates the leaves whose process changes. Call it between steps, on
+// the result of the most expensive operation of a step.
+//
+// Since the container's structure is traversed with fmap and foldMap,
+// include this header after the declarations of the outer container.
+
+namespace fun {
+
+// balance
+
+namespace detail {
+// Cut the leaves, in order, into nprocs pieces of about equal cost. A
+// leaf goes to the process in whose piece its midpoint lies.
+inline std::vector<std::ptrdiff_t>
+balance_partition(const std::vector<double> &costs, std::ptrdiff_t nprocs) {
+  std::ptrdiff_t nleaves = costs.size();
+  double total = std::accumulate(costs.begin(), costs.end(), 0.0);
+  std::vector<std::ptrdiff_t> procs(nleaves);
+  double sum = 0.0;
+  for (std::ptrdiff_t k = 0; k < nleaves; ++k) {
+    double mid =
+        total > 0.0 ? (sum + costs[k] / 2) / total : (k + 0.5) / nleaves;
+    procs[k] = std::min(nprocs - 1, std::ptrdiff_t(mid * nprocs));
+    sum += costs[k];
+  }
+  return procs;
+}
+
+// The largest load of a process relative to the average load
+inline double balance_imbalance(const std::vector<double> &costs,
+                                const std::vector<std::ptrdiff_t> &procs,
+                                std::ptrdiff_t nprocs) {
+  std::vector<double> loads(nprocs, 0.0);
+  for (std::size_t k = 0; k < costs.size(); ++k)
+    loads[procs[k]] += costs[k];
+  double total = std::accumulate(loads.begin(), loads.end(), 0.0);
+  if (total <= 0.0)
+    return 1.0;
+  return *std::max_element(loads.begin(), loads.end()) * nprocs / total;
+}
+
+struct balance_collect : std::tuple<> {
+  template <typename L> auto operator()(const L &leaf) const {
+    std::vector<std::decay_t<decltype(leaf.data)>> leaves;
+    if (bool(leaf.data))
+      leaves.push_back(leaf.data);
+    return leaves;
+  }
+};
+
+struct balance_concat : std::tuple<> {
+  template <typename V> V operator()(V xs, const V &ys) const {
+    xs.insert(xs.end(), ys.begin(), ys.end());
+    return xs;
+  }
+};
+
+// Migrate the leaves that are listed, sorted by their location
+template <typename X> struct balance_move {
+  typedef std::pair<funhpc::rptr<X>, std::ptrdiff_t> move_t;
+  std::vector<move_t> moves;
+
+  template <typename Archive> void serialize(Archive &ar) { ar(moves); }
+
+  template <typename L> L operator()(const L &leaf) const {
+    if (!bool(leaf.data))
+      return leaf;
+    auto ptr = leaf.data.get_rptr();
+    auto it = std::lower_bound(
+        moves.begin(), moves.end(), ptr,
+        [](const move_t &move, const funhpc::rptr<X> &ptr) {
+          return move.first < ptr;
+        });
+    if (it == moves.end() || it->first != ptr)
+      return leaf;
+    L res(leaf);
+    res.data = leaf.data.migrate(it->second);
+    return res;
+  }
+};
+}
+
+// Redistribute the leaves if the most loaded process has more than
+// threshold times the average load. Leaves whose cost is not known
+// count as average leaves.
+template <
+    typename P, typename A, typename T, typename Policy,
+    std::enable_if_t<detail::is_proxy<typename A::pointer_dummy>::value> * =
+        nullptr>
+adt::nested<P, A, T, Policy> balance(const adt::nested<P, A, T, Policy> &xs,
+                                     double threshold = 1.1) {
+  typedef typename adt::nested<P, A, T, Policy>::template array_constructor<T>
+      L;
+  const auto leaves = foldMap(detail::balance_collect(),
+                              detail::balance_concat(),
+                              detail::balance_collect()(L()), xs.data);
+  typedef typename std::decay_t<decltype(leaves)>::value_type::element_type X;
+  std::ptrdiff_t nleaves = leaves.size();
+  std::ptrdiff_t nprocs = funhpc::size();
+  if (nleaves == 0 || nprocs == 1)
+    return xs;
+
+  std::vector<qthread::future<double>> fcosts(nleaves);
+  for (std::ptrdiff_t k = 0; k < nleaves; ++k)
+    fcosts[k] = leaves[k].get_cost_future();
+  std::vector<double> costs(nleaves);
+  std::vector<std::ptrdiff_t> procs(nleaves);
+  double known = 0.0;
+  std::ptrdiff_t nknown = 0;
+  for (std::ptrdiff_t k = 0; k < nleaves; ++k) {
+    costs[k] = fcosts[k].get();
+    procs[k] = leaves[k].get_proc();
+    if (costs[k] >= 0.0) {
+      known += costs[k];
+      ++nknown;
+    }
+  }
+  double average = nknown == 0 ? 1.0 : known / nknown;
+  for (auto &cost : costs)
+    if (cost < 0.0)
+      cost = average;
+
+  double imbalance = detail::balance_imbalance(costs, procs, nprocs);
+  if (imbalance <= threshold)
+    return xs;
+  auto new_procs = detail::balance_partition(costs, nprocs);
+  if (detail::balance_imbalance(costs, new_procs, nprocs) >= imbalance)
+    return xs;
+
+  detail::balance_move<X> move;
+  for (std::ptrdiff_t k = 0; k < nleaves; ++k)
+    if (new_procs[k] != procs[k])
+      move.moves.emplace_back(leaves[k].get_rptr(), new_procs[k]);
+  std::sort(move.moves.begin(), move.moves.end(),
+            [](const auto &x, const auto &y) { return x.first < y.first; });
+  return {fmap(move, xs.data), xs.policy};
+}
+}
+
+#define FUN_BALANCE_HPP_DONE
+#endif // #ifdef FUN_BALANCE_HPP
+#ifndef FUN_BALANCE_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,89 @@
+#include <adt/dummy.hpp>
+#include <adt/maxarray.hpp>
+#include <fun/maxarray.hpp>
+#include <fun/nested_decl.hpp>
+#include <fun/proxy.hpp>
+#include <fun/tree_decl.hpp>
+#include <funhpc/proxy.hpp>
+#include <funhpc/rexec.hpp>
+
+#include <fun/nested_impl.hpp>
+#include <fun/tree_impl.hpp>
+
+#include <fun/balance.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+using namespace fun;
+
+namespace {
+template <typename T>
+using proxy_maxarray = adt::nested<funhpc::proxy<adt::dummy>,
+                                   adt::maxarray<adt::dummy, 16>, T>;
+template <typename T>
+using proxy_maxarray_tree =
+    adt::nested<adt::tree<proxy_maxarray<adt::dummy>, adt::dummy>,
+                proxy_maxarray<adt::dummy>, T>;
+
+int iota(std::ptrdiff_t i) { return i; }
+// Most points are expensive
+int work(int x) {
+  if (x < 150) {
+    auto t0 = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - t0 <
+           std::chrono::microseconds(200))
+      ;
+  }
+  return x;
+}
+int id(int x) { return x; }
+int add(int x, int y) { return x + y; }
+int min(int x, int y) { return std::min(x, y); }
+int max(int x, int y) { return std::max(x, y); }
+// The process of the expensive points, and -1 elsewhere
+int expensive_proc(int x) { return x < 150 ? funhpc::rank() : -1; }
+int expensive_min_proc(int x) {
+  return x < 150 ? funhpc::rank() : funhpc::size();
+}
+}
+
+TEST(fun_balance, partition) {
+  std::vector<double> costs{1, 1, 1, 1, 4};
+  auto procs = detail::balance_partition(costs, 2);
+  EXPECT_EQ((std::vector<std::ptrdiff_t>{0, 0, 0, 0, 1}), procs);
+  EXPECT_EQ(1.0, detail::balance_imbalance(costs, procs, 2));
+  EXPECT_EQ(1.25, detail::balance_imbalance(
+                     costs, std::vector<std::ptrdiff_t>{0, 0, 0, 1, 1}, 2));
+  // Without costs, the leaves are distributed evenly
+  EXPECT_EQ((std::vector<std::ptrdiff_t>{0, 0, 1, 1}),
+            detail::balance_partition(std::vector<double>(4, 0.0), 2));
+}
+
+TEST(fun_balance, balance) {
+  std::ptrdiff_t s = 200;
+  auto xs = iotaMap<proxy_maxarray_tree<int>>(iota, s);
+  funhpc::set_proxy_timing(true);
+  auto ys = fmap(work, xs);
+  // All points live on this process
+  EXPECT_EQ(funhpc::rank(), foldMap(expensive_proc, max, -1, ys));
+
+  // A large threshold leaves the container alone
+  auto zs0 = balance(ys, 1.0e+10);
+  EXPECT_EQ(funhpc::rank(), foldMap(expensive_proc, max, -1, zs0));
+
+  auto zs = balance(ys);
+  EXPECT_EQ(s * (s - 1) / 2, foldMap(id, add, 0, zs));
+  // The expensive points are spread over all processes
+  EXPECT_EQ(0, foldMap(expensive_min_proc, min, funhpc::size(), zs));
+  EXPECT_EQ(funhpc::size() - 1, foldMap(expensive_proc, max, -1, zs));
+  // The costs moved with the leaves, and the container stays balanced
+  auto ws = balance(zs);
+  EXPECT_EQ(funhpc::size() - 1, foldMap(expensive_proc, max, -1, ws));
+  EXPECT_EQ(s * (s - 1) / 2, foldMap(id, add, 0, fmap(work, ws)));
+  funhpc::set_proxy_timing(false);
+}
@@ -0,0 +1,723 @@
+#ifndef FUN_DIST_GRID_HPP
+#define FUN_DIST_GRID_HPP
+
+#include <funhpc/dist_grid.hpp>
+
+#include <adt/dummy.hpp>
+#include <adt/index.hpp>
+#include <cxx/cassert.hpp>
+#include <cxx/execution.hpp>
+#include <cxx/invoke.hpp>
+#include <cxx/serialize.hpp>
+#include <fun/fun_decl.hpp>
+#include <fun/grid_decl.hpp>
+#include <funhpc/async.hpp>
+#include <funhpc/proxy.hpp>
+#include <funhpc/rexec.hpp>
+#include <funhpc/rptr.hpp>
+#include <qthread/future.hpp>
+#include <qthread/mutex.hpp>
+
+#include <cereal/types/array.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A funhpc::dist_grid is distributed over all processes. Each
+// operation sends one message per process, which then works on all of
+// its blocks. A stencil exchanges halos as given by the grid's plan:
+// each process receives all the faces it needs from a neighbouring
+// process in a single message, and evaluates the stencil on each of
+// its blocks as soon as that block's faces have arrived. The faces
+// are received into buffers that persist from one stencil to the next.
+
+namespace fun {
+
+// is_dist_grid
+
+namespace detail {
+template <typename> struct is_dist_grid : std::false_type {};
+template <typename C, typename T, std::size_t D>
+struct is_dist_grid<funhpc::dist_grid<C, T, D>> : std::true_type {};
+}
+
+// traits
+
+template <typename> struct fun_traits;
+template <typename C, typename T, std::size_t D>
+struct fun_traits<funhpc::dist_grid<C, T, D>> {
+  template <typename U>
+  using constructor = funhpc::dist_grid<C, std::decay_t<U>, D>;
+  typedef constructor<adt::dummy> dummy;
+  typedef T value_type;
+
+  static constexpr std::ptrdiff_t rank = D;
+  typedef adt::index_t<rank> index_type;
+
+  typedef funhpc::dist_grid<C, adt::dummy, D - 1> boundary_dummy;
+
+  static constexpr std::size_t min_size() { return 0; }
+  static constexpr std::size_t max_size() { return std::size_t(-1); }
+};
+
+namespace detail {
+// The number of blocks per process; with several blocks, a process
+// can work on some of them while it waits for the faces of others
+constexpr std::ptrdiff_t dist_grid_blocks_per_proc = 4;
+
+// Apply fk to the blocks 0...n-1 of a process; with a parallel policy,
+// the blocks are processed concurrently
+template <typename Policy, typename FK>
+auto dist_grid_map_blocks(const Policy &policy, std::size_t n, const FK &fk) {
+  typedef std::decay_t<decltype(fk(std::size_t()))> R;
+  std::vector<R> rs;
+  rs.reserve(n);
+  if (cxx::is_parallel_execution_policy<Policy>::value) {
+    std::vector<qthread::future<R>> frs;
+    frs.reserve(n);
+    for (std::size_t k = 0; k < n; ++k)
+      frs.push_back(qthread::async(fk, k));
+    for (auto &fr : frs)
+      rs.push_back(fr.get());
+  } else {
+    for (std::size_t k = 0; k < n; ++k)
+      rs.push_back(fk(k));
+  }
+  return rs;
+}
+
+template <typename C, typename T, std::size_t D>
+void dist_grid_assert_same_plan(
+    const funhpc::dist_grid<C, T, D> &xs,
+    const std::shared_ptr<const funhpc::halo_plan<D>> &plan) {
+  cxx_assert(bool(xs.plan) == bool(plan));
+  cxx_assert(!plan || *xs.plan == *plan);
+}
+}
+
+// iotaMapMulti
+
+namespace detail {
+template <typename BC, typename Policy>
+struct dist_grid_iotaMapMulti : std::tuple<> {
+  template <typename F, std::size_t D, typename... Args>
+  auto operator()(const F &f, const std::vector<adt::steprange_t<D>> &indss,
+                  const Args &... args) const {
+    return dist_grid_map_blocks(Policy(), indss.size(), [&](std::size_t k) {
+      return iotaMapMulti<BC>(Policy(), f, indss[k], args...);
+    });
+  }
+};
+}
+
+template <typename C, typename Policy, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_dist_grid<C>::value &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const Policy &policy, F &&f, const adt::steprange_t<D> &inds,
+                Args &&... args) {
+  typedef typename CR::plan_type plan_type;
+  auto nprocs = funhpc::size();
+  auto shape = inds.shape();
+  auto plan = std::make_shared<plan_type>(
+      shape, plan_type::default_block_shape(
+                 shape, detail::dist_grid_blocks_per_proc * nprocs),
+      nprocs);
+  std::vector<funhpc::proxy<typename CR::part_type>> parts(nprocs);
+  for (std::ptrdiff_t p = 0; p < nprocs; ++p) {
+    const auto &ex = plan->exchange(p);
+    if (ex.blocks.empty())
+      continue;
+    std::vector<adt::steprange_t<D>> indss;
+    indss.reserve(ex.blocks.size());
+    for (auto b : ex.blocks) {
+      auto r = plan->block_range(b);
+      indss.emplace_back(inds.imin() + r.imin() * inds.istep(),
+                         inds.imin() + r.imax() * inds.istep(), inds.istep());
+    }
+    parts[p] = funhpc::remote(
+        p, detail::dist_grid_iotaMapMulti<typename C::block_type, Policy>(), f,
+        std::move(indss), args...);
+  }
+  return CR(plan, std::move(parts));
+}
+
+template <typename C, std::size_t D, typename F, typename... Args,
+          std::enable_if_t<detail::is_dist_grid<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
+  return iotaMapMulti<C>(cxx::execution::seq, std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+
+// fmap
+
+namespace detail {
+template <typename Policy> struct dist_grid_fmap : std::tuple<> {
+  template <typename F, typename T, typename... Args>
+  auto operator()(const F &f, const funhpc::proxy<std::vector<T>> &xs,
+                  const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    const auto &xbs = *xs;
+    return dist_grid_map_blocks(Policy(), xbs.size(), [&](std::size_t k) {
+      return fmap(Policy(), f, xbs[k], args...);
+    });
+  }
+};
+}
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap(const Policy &policy, F &&f, const funhpc::dist_grid<C, T, D> &xs,
+        Args &&... args) {
+  cxx_assert(xs.invariant());
+  std::vector<funhpc::proxy<typename CR::part_type>> parts(xs.parts.size());
+  for (std::size_t p = 0; p < parts.size(); ++p)
+    if (bool(xs.parts[p]))
+      parts[p] = funhpc::remote(p, detail::dist_grid_fmap<Policy>(), f,
+                                xs.parts[p], args...);
+  return CR(xs.plan, std::move(parts));
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename... Args,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap(F &&f, const funhpc::dist_grid<C, T, D> &xs, Args &&... args) {
+  return fmap(cxx::execution::seq, std::forward<F>(f), xs,
+              std::forward<Args>(args)...);
+}
+
+namespace detail {
+template <typename Policy> struct dist_grid_fmap2 : std::tuple<> {
+  template <typename F, typename T, typename T2, typename... Args>
+  auto operator()(const F &f, const funhpc::proxy<std::vector<T>> &xs,
+                  const funhpc::proxy<std::vector<T2>> &ys,
+                  const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    cxx_assert(bool(ys) && ys.local());
+    const auto &xbs = *xs;
+    const auto &ybs = *ys;
+    cxx_assert(ybs.size() == xbs.size());
+    return dist_grid_map_blocks(Policy(), xbs.size(), [&](std::size_t k) {
+      return fmap2(Policy(), f, xbs[k], ybs[k], args...);
+    });
+  }
+};
+}
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap2(const Policy &policy, F &&f, const funhpc::dist_grid<C, T, D> &xs,
+         const funhpc::dist_grid<C, T2, D> &ys, Args &&... args) {
+  cxx_assert(xs.invariant());
+  detail::dist_grid_assert_same_plan(ys, xs.plan);
+  std::vector<funhpc::proxy<typename CR::part_type>> parts(xs.parts.size());
+  for (std::size_t p = 0; p < parts.size(); ++p)
+    if (bool(xs.parts[p]))
+      parts[p] = funhpc::remote(p, detail::dist_grid_fmap2<Policy>(), f,
+                                xs.parts[p], ys.parts[p], args...);
+  return CR(xs.plan, std::move(parts));
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename T2,
+          typename... Args, typename CT = funhpc::dist_grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap2(F &&f, const funhpc::dist_grid<C, T, D> &xs,
+         const funhpc::dist_grid<C, T2, D> &ys, Args &&... args) {
+  return fmap2(cxx::execution::seq, std::forward<F>(f), xs, ys,
+               std::forward<Args>(args)...);
+}
+
+// boundary, boundaryMap
+
+// The blocks of a boundary live on the same processes as the adjacent
+// blocks of the grid
+
+namespace detail {
+struct dist_grid_boundary : std::tuple<> {
+  template <typename T>
+  auto operator()(const funhpc::proxy<std::vector<T>> &xs,
+                  const std::vector<std::ptrdiff_t> &positions,
+                  std::ptrdiff_t i) const {
+    cxx_assert(bool(xs) && xs.local());
+    const auto &xbs = *xs;
+    typedef std::decay_t<decltype(boundary(xbs[0], i))> BT;
+    std::vector<BT> bs;
+    bs.reserve(positions.size());
+    for (auto pos : positions)
+      bs.push_back(boundary(xbs[pos], i));
+    return bs;
+  }
+};
+
+struct dist_grid_boundaryMap : std::tuple<> {
+  template <typename F, typename T, typename... Args>
+  auto operator()(const F &f, const funhpc::proxy<std::vector<T>> &xs,
+                  const std::vector<std::ptrdiff_t> &positions,
+                  std::ptrdiff_t i, const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    const auto &xbs = *xs;
+    typedef std::decay_t<decltype(boundaryMap(f, xbs[0], i, args...))> BR;
+    std::vector<BR> bs;
+    bs.reserve(positions.size());
+    for (auto pos : positions)
+      bs.push_back(boundaryMap(f, xbs[pos], i, args...));
+    return bs;
+  }
+};
+
+// The positions of the blocks adjacent to face i of the blocks of the
+// boundary that live on process p
+template <std::size_t D>
+std::vector<std::ptrdiff_t>
+dist_grid_face_positions(const funhpc::halo_plan<D> &plan, std::ptrdiff_t p,
+                         std::ptrdiff_t i) {
+  const auto &fex = plan.face_plan(i)->exchange(p);
+  std::vector<std::ptrdiff_t> positions;
+  positions.reserve(fex.blocks.size());
+  for (auto fb : fex.blocks)
+    positions.push_back(plan.position(plan.block_at_face(fb, i)));
+  return positions;
+}
+}
+
+template <typename C, typename T, std::size_t D,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename BCT = typename fun_traits<BC>::template constructor<T>>
+BCT boundary(const funhpc::dist_grid<C, T, D> &xs, std::ptrdiff_t i) {
+  cxx_assert(xs.invariant() && bool(xs.plan));
+  cxx_assert(i >= 0 && i < std::ptrdiff_t(2 * D));
+  const auto &fplan = xs.plan->face_plan(i);
+  std::vector<funhpc::proxy<typename BCT::part_type>> parts(xs.parts.size());
+  for (std::size_t p = 0; p < parts.size(); ++p)
+    if (!fplan->exchange(p).blocks.empty())
+      parts[p] = funhpc::remote(
+          p, detail::dist_grid_boundary(), xs.parts[p],
+          detail::dist_grid_face_positions(*xs.plan, p, i), i);
+  return BCT(fplan, std::move(parts));
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename... Args,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename R = cxx::invoke_of_t<F, T, std::ptrdiff_t, Args...>,
+          typename BCR = typename fun_traits<BC>::template constructor<R>>
+BCR boundaryMap(F &&f, const funhpc::dist_grid<C, T, D> &xs, std::ptrdiff_t i,
+                Args &&... args) {
+  cxx_assert(xs.invariant() && bool(xs.plan));
+  cxx_assert(i >= 0 && i < std::ptrdiff_t(2 * D));
+  const auto &fplan = xs.plan->face_plan(i);
+  std::vector<funhpc::proxy<typename BCR::part_type>> parts(xs.parts.size());
+  for (std::size_t p = 0; p < parts.size(); ++p)
+    if (!fplan->exchange(p).blocks.empty())
+      parts[p] = funhpc::remote(
+          p, detail::dist_grid_boundaryMap(), f, xs.parts[p],
+          detail::dist_grid_face_positions(*xs.plan, p, i), i, args...);
+  return BCR(fplan, std::move(parts));
+}
+
+// fmapStencilMulti
+
+namespace detail {
+// Receive buffers for the halo exchange, one per neighbouring process.
+// Each process keeps these per list of neighbours
+// (halo_plan::exchange_t::procs), i.e. per plan. A stencil checks out
+// a set of buffers for its step and returns it afterwards, so that the
+// next step receives into the same storage; concurrent stencils use
+// separate sets.
+template <typename B> class dist_grid_halo_buffers {
+public:
+  typedef std::vector<std::vector<B>> buffers_t;
+
+private:
+  typedef std::map<std::vector<std::ptrdiff_t>,
+                   std::vector<std::unique_ptr<buffers_t>>>
+      pool_t;
+  static qthread::mutex &mutex() {
+    static auto *mtx = new qthread::mutex;
+    return *mtx;
+  }
+  static pool_t &pool() {
+    static auto *pl = new pool_t;
+    return *pl;
+  }
+
+public:
+  static std::unique_ptr<buffers_t>
+  checkout(const std::vector<std::ptrdiff_t> &procs) {
+    {
+      qthread::lock_guard<qthread::mutex> g(mutex());
+      auto it = pool().find(procs);
+      if (it != pool().end() && !it->second.empty()) {
+        auto bufs = std::move(it->second.back());
+        it->second.pop_back();
+        return bufs;
+      }
+    }
+    return std::make_unique<buffers_t>(procs.size());
+  }
+  static void checkin(const std::vector<std::ptrdiff_t> &procs,
+                      std::unique_ptr<buffers_t> bufs) {
+    cxx_assert(bufs->size() == procs.size());
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    pool()[procs].push_back(std::move(bufs));
+  }
+};
+
+// The faces that a process sends to a neighbour. They are
+// deserialized directly into the neighbour's receive buffer buf,
+// overwriting the faces of the previous step in place.
+template <typename B> struct dist_grid_face_msg {
+  funhpc::rptr<std::vector<B>> buf;
+  std::vector<B> faces; // empty on the receiving side
+
+  template <typename Archive> void save(Archive &ar) const {
+    ar(buf);
+    cxx::save_container(ar, faces);
+  }
+  template <typename Archive> void load(Archive &ar) {
+    ar(buf);
+    cxx::load_container(ar, *buf.get_ptr());
+  }
+};
+
+// Evaluate the faces (position, face) of the blocks of this process
+// that another process needs; they are sent back in a single message
+template <typename G> struct dist_grid_faces {
+  G g;
+  template <typename Archive> void serialize(Archive &ar) { ar(g); }
+  template <typename T, typename B>
+  dist_grid_face_msg<B>
+  operator()(const funhpc::proxy<std::vector<T>> &xs,
+             const std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>>
+                 &faces,
+             const funhpc::rptr<std::vector<B>> &buf) const {
+    cxx_assert(bool(xs) && xs.local());
+    const auto &xbs = *xs;
+    static_assert(
+        std::is_same<std::decay_t<decltype(boundaryMap(g, xbs[0],
+                                                       std::ptrdiff_t()))>,
+                     B>::value,
+        "");
+    dist_grid_face_msg<B> msg{buf, {}};
+    // Faces for this process go into the buffer right away
+    auto &bs = buf.local() ? *buf.get_ptr() : msg.faces;
+    bs.clear();
+    bs.reserve(faces.size());
+    for (const auto &face : faces)
+      bs.push_back(boundaryMap(g, xbs[face.first], face.second));
+    return msg;
+  }
+};
+
+// Pass the faces to a block's stencil as bm0, bm1, ..., bp0, bp1, ...
+template <std::size_t D, typename Policy, typename F, typename G, typename T,
+          typename B, std::size_t... Is, typename... Args>
+auto dist_grid_block_stencil(const Policy &policy, const F &f, const G &g,
+                             const T &xs, std::size_t bmask,
+                             const std::array<const B *, 2 * D> &bs,
+                             std::index_sequence<Is...>, const Args &... args) {
+  return fmapStencilMulti<D>(policy, f, g, xs, bmask,
+                             *bs[Is < D ? 2 * Is : 2 * (Is - D) + 1]...,
+                             args...);
+}
+
+template <std::size_t D, typename Policy>
+struct dist_grid_fmapStencilMulti : std::tuple<> {
+  template <typename F, typename G, typename T, typename B, typename... Args>
+  auto operator()(const F &f, const G &g,
+                  const typename funhpc::halo_plan<D>::exchange_t &ex,
+                  std::size_t bmask, const funhpc::proxy<std::vector<T>> &xs,
+                  const std::vector<funhpc::proxy<std::vector<T>>> &nxs,
+                  const std::array<funhpc::proxy<std::vector<B>>, 2 * D> &bs,
+                  const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    cxx_assert(nxs.size() == ex.procs.size());
+    // Request the faces from all neighbouring processes at once
+    auto bufs = dist_grid_halo_buffers<B>::checkout(ex.procs);
+    std::vector<qthread::shared_future<dist_grid_face_msg<B>>> nfaces;
+    nfaces.reserve(ex.procs.size());
+    for (std::size_t s = 0; s < ex.procs.size(); ++s)
+      nfaces.push_back(
+          funhpc::async(funhpc::rlaunch::async, ex.procs[s],
+                        dist_grid_faces<G>{g}, nxs[s], ex.faces[s],
+                        funhpc::rptr<std::vector<B>>(&(*bufs)[s]))
+              .share());
+    // The boundary blocks live on this process
+    std::array<const std::vector<B> *, 2 * D> bfaces;
+    for (std::size_t i = 0; i < 2 * D; ++i) {
+      bfaces[i] = nullptr;
+      if (bool(bs[i])) {
+        bs[i].wait();
+        cxx_assert(bs[i].local());
+        bfaces[i] = &*bs[i];
+      }
+    }
+    const auto &xbs = *xs;
+    cxx_assert(xbs.size() == ex.blocks.size());
+    auto rs = dist_grid_map_blocks(Policy(), xbs.size(), [&](std::size_t k) {
+      std::array<const B *, 2 * D> faces;
+      for (std::size_t i = 0; i < 2 * D; ++i) {
+        auto src = ex.sources[k][i];
+        if (src.first >= 0) {
+          nfaces[src.first].wait();
+          faces[i] = &(*bufs)[src.first][src.second];
+        } else {
+          cxx_assert(bfaces[i]);
+          faces[i] = &(*bfaces[i])[src.second];
+        }
+      }
+      // Only the faces at the outer boundary are boundaries
+      return dist_grid_block_stencil<D>(Policy(), f, g, xbs[k],
+                                        bmask & ex.outer[k], faces,
+                                        std::make_index_sequence<2 * D>(),
+                                        args...);
+    });
+    for (const auto &nf : nfaces)
+      nf.wait();
+    dist_grid_halo_buffers<B>::checkin(ex.procs, std::move(bufs));
+    return rs;
+  }
+};
+
+template <typename CR, std::size_t D, typename Policy, typename F, typename G,
+          typename C, typename T, typename BCB, typename... Args>
+CR dist_grid_fmapStencilMulti_impl(const Policy &policy, F &&f, G &&g,
+                                   const funhpc::dist_grid<C, T, D> &xs,
+                                   std::size_t bmask,
+                                   const std::array<const BCB *, 2 * D> &bs,
+                                   Args &&... args) {
+  cxx_assert(xs.invariant() && bool(xs.plan));
+  const auto &plan = *xs.plan;
+  for (std::size_t i = 0; i < 2 * D; ++i)
+    dist_grid_assert_same_plan(*bs[i], plan.face_plan(i));
+  std::vector<funhpc::proxy<typename CR::part_type>> parts(xs.parts.size());
+  for (std::ptrdiff_t p = 0; p < plan.nprocs(); ++p) {
+    const auto &ex = plan.exchange(p);
+    if (ex.blocks.empty())
+      continue;
+    std::vector<funhpc::proxy<typename funhpc::dist_grid<C, T, D>::part_type>>
+        nxs;
+    nxs.reserve(ex.procs.size());
+    for (auto q : ex.procs)
+      nxs.push_back(xs.parts[q]);
+    std::array<funhpc::proxy<typename BCB::part_type>, 2 * D> bps;
+    for (std::size_t i = 0; i < 2 * D; ++i)
+      bps[i] = bs[i]->parts[p];
+    parts[p] = funhpc::remote(p, dist_grid_fmapStencilMulti<D, Policy>(), f, g,
+                              ex, bmask, xs.parts[p], std::move(nxs),
+                              std::move(bps), args...);
+  }
+  return CR(xs.plan, std::move(parts));
+}
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 1 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const funhpc::dist_grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                    Args &&... args) {
+  return detail::dist_grid_fmapStencilMulti_impl<CR>(
+      policy, std::forward<F>(f), std::forward<G>(g), xs, bmask,
+      std::array<const BCB *, 2 * D>{{&bm0, &bp0}},
+      std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 2 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const funhpc::dist_grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                    const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                    Args &&... args) {
+  return detail::dist_grid_fmapStencilMulti_impl<CR>(
+      policy, std::forward<F>(f), std::forward<G>(g), xs, bmask,
+      std::array<const BCB *, 2 * D>{{&bm0, &bp0, &bm1, &bp1}},
+      std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename... Args, std::enable_if_t<D == 1> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(F &&f, G &&g, const funhpc::dist_grid<C, T, D> &xs,
+                    std::size_t bmask, const std::decay_t<BCB> &bm0,
+                    const std::decay_t<BCB> &bp0, Args &&... args) {
+  return fmapStencilMulti<D>(cxx::execution::seq, std::forward<F>(f),
+                             std::forward<G>(g), xs, bmask, bm0, bp0,
+                             std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename... Args, std::enable_if_t<D == 2> * = nullptr,
+          typename CT = funhpc::dist_grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(F &&f, G &&g, const funhpc::dist_grid<C, T, D> &xs,
+                    std::size_t bmask, const std::decay_t<BCB> &bm0,
+                    const std::decay_t<BCB> &bm1, const std::decay_t<BCB> &bp0,
+                    const std::decay_t<BCB> &bp1, Args &&... args) {
+  return fmapStencilMulti<D>(cxx::execution::seq, std::forward<F>(f),
+                             std::forward<G>(g), xs, bmask, bm0, bm1, bp0, bp1,
+                             std::forward<Args>(args)...);
+}
+
+// foldMap
+
+// The blocks are folded separately, so that z needs to be an identity
+// of op
+
+namespace detail {
+template <typename Policy> struct dist_grid_foldMap : std::tuple<> {
+  template <typename F, typename Op, typename Z, typename T, typename... Args>
+  auto operator()(const F &f, const Op &op, const Z &z,
+                  const funhpc::proxy<std::vector<T>> &xs,
+                  const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    const auto &xbs = *xs;
+    auto rs = dist_grid_map_blocks(Policy(), xbs.size(), [&](std::size_t k) {
+      return foldMap(Policy(), f, op, z, xbs[k], args...);
+    });
+    typename decltype(rs)::value_type r(z);
+    for (auto &r1 : rs)
+      r = cxx::invoke(op, std::move(r), std::move(r1));
+    return r;
+  }
+};
+
+template <typename Policy> struct dist_grid_foldMap2 : std::tuple<> {
+  template <typename F, typename Op, typename Z, typename T, typename T2,
+            typename... Args>
+  auto operator()(const F &f, const Op &op, const Z &z,
+                  const funhpc::proxy<std::vector<T>> &xs,
+                  const funhpc::proxy<std::vector<T2>> &ys,
+                  const Args &... args) const {
+    cxx_assert(bool(xs) && xs.local());
+    cxx_assert(bool(ys) && ys.local());
+    const auto &xbs = *xs;
+    const auto &ybs = *ys;
+    cxx_assert(ybs.size() == xbs.size());
+    auto rs = dist_grid_map_blocks(Policy(), xbs.size(), [&](std::size_t k) {
+      return foldMap2(Policy(), f, op, z, xbs[k], ybs[k], args...);
+    });
+    typename decltype(rs)::value_type r(z);
+    for (auto &r1 : rs)
+      r = cxx::invoke(op, std::move(r), std::move(r1));
+    return r;
+  }
+};
+}
+
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, Args...>>
+R foldMap(const Policy &policy, F &&f, Op &&op, Z &&z,
+          const funhpc::dist_grid<C, T, D> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  cxx_assert(xs.invariant());
+  // Fold all parts concurrently
+  std::vector<qthread::future<R>> rs;
+  for (std::size_t p = 0; p < xs.parts.size(); ++p)
+    if (bool(xs.parts[p]))
+      rs.push_back(funhpc::async(funhpc::rlaunch::async, p,
+                                 detail::dist_grid_foldMap<Policy>(), f, op, z,
+                                 xs.parts[p], args...));
+  R r(std::forward<Z>(z));
+  for (auto &r1 : rs)
+    r = cxx::invoke(op, std::move(r), r1.get());
+  return r;
+}
+
+template <typename F, typename Op, typename Z, typename C, typename T,
+          std::size_t D, typename... Args,
+          typename R = cxx::invoke_of_t<F, T, Args...>>
+R foldMap(F &&f, Op &&op, Z &&z, const funhpc::dist_grid<C, T, D> &xs,
+          Args &&... args) {
+  return foldMap(cxx::execution::seq, std::forward<F>(f), std::forward<Op>(op),
+                 std::forward<Z>(z), xs, std::forward<Args>(args)...);
+}
+
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+R foldMap2(const Policy &policy, F &&f, Op &&op, Z &&z,
+           const funhpc::dist_grid<C, T, D> &xs,
+           const funhpc::dist_grid<C, T2, D> &ys, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  cxx_assert(xs.invariant());
+  detail::dist_grid_assert_same_plan(ys, xs.plan);
+  std::vector<qthread::future<R>> rs;
+  for (std::size_t p = 0; p < xs.parts.size(); ++p)
+    if (bool(xs.parts[p]))
+      rs.push_back(funhpc::async(funhpc::rlaunch::async, p,
+                                 detail::dist_grid_foldMap2<Policy>(), f, op, z,
+                                 xs.parts[p], ys.parts[p], args...));
+  R r(std::forward<Z>(z));
+  for (auto &r1 : rs)
+    r = cxx::invoke(op, std::move(r), r1.get());
+  return r;
+}
+
+template <typename F, typename Op, typename Z, typename C, typename T,
+          std::size_t D, typename T2, typename... Args,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+R foldMap2(F &&f, Op &&op, Z &&z, const funhpc::dist_grid<C, T, D> &xs,
+           const funhpc::dist_grid<C, T2, D> &ys, Args &&... args) {
+  return foldMap2(cxx::execution::seq, std::forward<F>(f),
+                  std::forward<Op>(op), std::forward<Z>(z), xs, ys,
+                  std::forward<Args>(args)...);
+}
+}
+
+#define FUN_DIST_GRID_HPP_DONE
+#endif // #ifdef FUN_DIST_GRID_HPP
+#ifndef FUN_DIST_GRID_HPP_DONE
+#error "Cyclic include dependency"
+#endif
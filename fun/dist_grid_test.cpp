@@ -0,0 +1,127 @@
+#include <fun/dist_grid.hpp>
+
+#include <adt/dummy.hpp>
+#include <adt/index.hpp>
+#include <cxx/execution.hpp>
+#include <fun/grid_decl.hpp>
+#include <fun/vector.hpp>
+
+#include <fun/grid_impl.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+using namespace fun;
+
+namespace {
+template <std::size_t D>
+using grid = adt::grid<std::vector<adt::dummy>, adt::dummy, D>;
+template <std::size_t D>
+using dist_grid = funhpc::dist_grid<std::vector<adt::dummy>, adt::dummy, D>;
+
+double init1(const adt::index_t<1> &i) { return i[0]; }
+double init2(const adt::index_t<2> &i) { return i[0] + 10 * i[1]; }
+
+double get_face(double x, std::ptrdiff_t i) { return x; }
+double reflect(double x, std::ptrdiff_t i) { return -x - 1; }
+
+double laplace1(double x, std::size_t bdirs, double bm0, double bp0) {
+  return bm0 - 2 * x + bp0 + 100 * bdirs;
+}
+double laplace2(double x, std::size_t bdirs, double bm0, double bm1,
+                double bp0, double bp1) {
+  return bm0 + bm1 - 4 * x + bp0 + bp1 + 1000 * bdirs;
+}
+
+double one(double x) { return 1; }
+double square(double x) { return x * x; }
+double ident(double x) { return x; }
+double add(double x, double y) { return x + y; }
+}
+
+TEST(fun_dist_grid, iotaMapMulti) {
+  auto xs = iotaMapMulti<dist_grid<1>>(
+      init1, adt::steprange_t<1>(adt::index_t<1>{{20}}));
+  EXPECT_TRUE(xs.invariant());
+  // Each process has several blocks
+  EXPECT_GE(xs.plan->size(), 2 * funhpc::size());
+  EXPECT_EQ(190, foldMap(ident, add, 0.0, xs));
+
+  auto ys = iotaMapMulti<dist_grid<2>>(
+      cxx::execution::par, init2,
+      adt::steprange_t<2>(adt::index_t<2>{{9, 7}}));
+  EXPECT_TRUE(ys.invariant());
+  EXPECT_EQ(9 * 7, foldMap(cxx::execution::par, one, add, 0.0, ys));
+  auto zs = fmap2(add, ys, fmap(square, ys));
+  EXPECT_EQ(foldMap(ident, add, 0.0, ys) + foldMap(square, add, 0.0, ys),
+            foldMap(ident, add, 0.0, zs));
+  EXPECT_EQ(2 * foldMap(ident, add, 0.0, ys),
+            foldMap2(add, add, 0.0, ys, ys));
+}
+
+TEST(fun_dist_grid, fmapStencilMulti) {
+  // Compare to a grid that is not distributed
+  {
+    adt::steprange_t<1> inds(adt::index_t<1>{{20}});
+    auto xs = iotaMapMulti<dist_grid<1>>(init1, inds);
+    auto ys = iotaMapMulti<grid<1>>(init1, inds);
+    auto rs = fmapStencilMulti<1>(laplace1, get_face, xs, ~std::size_t(0),
+                                  boundaryMap(reflect, xs, 0),
+                                  boundaryMap(reflect, xs, 1));
+    auto ss = fmapStencilMulti<1>(laplace1, get_face, ys, ~std::size_t(0),
+                                  boundaryMap(reflect, ys, 0),
+                                  boundaryMap(reflect, ys, 1));
+    EXPECT_EQ(foldMap(ident, add, 0.0, ss), foldMap(ident, add, 0.0, rs));
+    EXPECT_EQ(foldMap(square, add, 0.0, ss), foldMap(square, add, 0.0, rs));
+  }
+  {
+    adt::steprange_t<2> inds(adt::index_t<2>{{9, 7}});
+    auto xs = iotaMapMulti<dist_grid<2>>(init2, inds);
+    auto ys = iotaMapMulti<grid<2>>(init2, inds);
+    auto rs = fmapStencilMulti<2>(
+        cxx::execution::par, laplace2, get_face, xs, ~std::size_t(0),
+        boundaryMap(reflect, xs, 0), boundaryMap(reflect, xs, 2),
+        boundaryMap(reflect, xs, 1), boundaryMap(reflect, xs, 3));
+    auto ss = fmapStencilMulti<2>(
+        laplace2, get_face, ys, ~std::size_t(0), boundaryMap(reflect, ys, 0),
+        boundaryMap(reflect, ys, 2), boundaryMap(reflect, ys, 1),
+        boundaryMap(reflect, ys, 3));
+    EXPECT_EQ(foldMap(ident, add, 0.0, ss), foldMap(ident, add, 0.0, rs));
+    EXPECT_EQ(foldMap(square, add, 0.0, ss), foldMap(square, add, 0.0, rs));
+    // The boundaries of the result
+    auto bs = boundary(rs, 3);
+    EXPECT_EQ(foldMap(ident, add, 0.0, boundary(ss, 3)),
+              foldMap(ident, add, 0.0, bs));
+  }
+}
+
+namespace {
+double axpy(double y, double x, double alpha) { return alpha * x + y; }
+
+template <typename G> G diffuse(const G &xs, int nsteps) {
+  G ys = xs;
+  for (int n = 0; n < nsteps; ++n) {
+    auto rs = fmapStencilMulti<2>(
+        laplace2, get_face, ys, ~std::size_t(0), boundaryMap(reflect, ys, 0),
+        boundaryMap(reflect, ys, 2), boundaryMap(reflect, ys, 1),
+        boundaryMap(reflect, ys, 3));
+    ys = fmap2(axpy, ys, rs, 1.0e-3);
+  }
+  return ys;
+}
+}
+
+TEST(fun_dist_grid, iterate) {
+  // Repeated stencils receive their faces into the same buffers
+  adt::steprange_t<2> inds(adt::index_t<2>{{9, 7}});
+  auto xs = diffuse(iotaMapMulti<dist_grid<2>>(init2, inds), 5);
+  auto ys = diffuse(iotaMapMulti<grid<2>>(init2, inds), 5);
+  // The blocks are summed in a different order
+  auto sum = foldMap(ident, add, 0.0, ys);
+  auto sum_sq = foldMap(square, add, 0.0, ys);
+  EXPECT_NEAR(sum, foldMap(ident, add, 0.0, xs), 1.0e-12 * sum_sq);
+  EXPECT_NEAR(sum_sq, foldMap(square, add, 0.0, xs), 1.0e-12 * sum_sq);
+}
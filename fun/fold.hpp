@@ -0,0 +1,131 @@
+#ifndef FUN_FOLD_HPP
+#define FUN_FOLD_HPP
+
+#include <adt/index.hpp>
+#include <cxx/execution.hpp>
+#include <cxx/invoke.hpp>
+#include <qthread/parallel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace fun {
+
+// is_associative
+
+// Whether op(op(x, y), z) == op(x, op(y, z)). foldMap may then regroup
+// the operations (but it does not reorder the operands, so op need not
+// be commutative). Floating-point addition and multiplication are not
+// associative because of rounding; regrouping them would make results
+// depend on the number of threads. Callers that accept this need to
+// opt in explicitly via associative(op).
+template <typename Op> struct is_associative : std::false_type {};
+template <typename T>
+struct is_associative<std::plus<T>> : std::is_integral<T> {};
+template <typename T>
+struct is_associative<std::multiplies<T>> : std::is_integral<T> {};
+template <typename T>
+struct is_associative<std::logical_and<T>> : std::true_type {};
+template <typename T>
+struct is_associative<std::logical_or<T>> : std::true_type {};
+template <typename T>
+struct is_associative<std::bit_and<T>> : std::true_type {};
+template <typename T> struct is_associative<std::bit_or<T>> : std::true_type {};
+template <typename T>
+struct is_associative<std::bit_xor<T>> : std::true_type {};
+
+// Declare an operation (e.g. a lambda) as associative
+template <typename Op> struct associative_op {
+  Op op;
+  template <typename Archive> void serialize(Archive &ar) { ar(op); }
+  template <typename T, typename U>
+  decltype(auto) operator()(T &&x, U &&y) const {
+    return cxx::invoke(op, std::forward<T>(x), std::forward<U>(y));
+  }
+};
+template <typename Op>
+struct is_associative<associative_op<Op>> : std::true_type {};
+
+template <typename Op> associative_op<std::decay_t<Op>> associative(Op &&op) {
+  return {std::forward<Op>(op)};
+}
+
+namespace detail {
+// Fold g(0), ..., g(s-1) onto r. Associative operations are folded
+// with several accumulators, each covering a consecutive block, so
+// that the operations of different blocks can overlap. z is used only
+// once and need not be an identity of op.
+constexpr std::ptrdiff_t fold_naccs = 4;
+
+template <typename Op, typename R, typename G>
+R fold_range(std::false_type, const Op &op, R r, std::ptrdiff_t s,
+             const G &g) {
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    r = cxx::invoke(op, std::move(r), g(i));
+  return r;
+}
+
+template <typename Op, typename R, typename G>
+R fold_range(std::true_type, const Op &op, R r, std::ptrdiff_t s,
+             const G &g) {
+  if (s < 2 * fold_naccs)
+    return fold_range(std::false_type(), op, std::move(r), s, g);
+  static_assert(fold_naccs == 4, "");
+  const std::ptrdiff_t b = s / fold_naccs;
+  R r0(cxx::invoke(op, std::move(r), g(0)));
+  R r1(g(b)), r2(g(2 * b)), r3(g(3 * b));
+  for (std::ptrdiff_t i = 1; i < b; ++i) {
+    r0 = cxx::invoke(op, std::move(r0), g(i));
+    r1 = cxx::invoke(op, std::move(r1), g(b + i));
+    r2 = cxx::invoke(op, std::move(r2), g(2 * b + i));
+    r3 = cxx::invoke(op, std::move(r3), g(3 * b + i));
+  }
+  r = cxx::invoke(op, cxx::invoke(op, std::move(r0), std::move(r1)),
+                  cxx::invoke(op, std::move(r2), std::move(r3)));
+  for (std::ptrdiff_t i = fold_naccs * b; i < s; ++i)
+    r = cxx::invoke(op, std::move(r), g(i));
+  return r;
+}
+
+template <typename Op, typename R, typename G>
+R fold_range(const Op &op, R r, std::ptrdiff_t s, const G &g) {
+  return fold_range(is_associative<Op>(), op, std::move(r), s, g);
+}
+
+// Fold g(0), ..., g(s-1), starting from z. With a parallel policy and
+// an associative op, the range is split into chunks that are folded by
+// separate threads, and z needs to be an identity of op.
+template <typename Op, typename R, typename G>
+R fold(const cxx::execution::sequenced_policy &, const Op &op, const R &z,
+       std::ptrdiff_t s, const G &g) {
+  return fold_range(op, z, s, g);
+}
+
+template <typename Policy, typename Op, typename R, typename G,
+          std::enable_if_t<cxx::is_parallel_execution_policy<Policy>::value>
+              * = nullptr>
+R fold(const Policy &, const Op &op, const R &z, std::ptrdiff_t s,
+       const G &g) {
+  if (!is_associative<Op>::value)
+    return fold_range(op, z, s, g);
+  return qthread::parallel_reduce_chunks(
+             adt::irange_t(s),
+             [&](const adt::irange_t &chunk) {
+               std::ptrdiff_t imin = chunk.imin();
+               return fold_range(op, z, chunk.shape(),
+                                 [&](std::ptrdiff_t i) { return g(imin + i); });
+             },
+             op, z)
+      .get();
+}
+}
+}
+
+#define FUN_FOLD_HPP_DONE
+#endif // #ifdef FUN_FOLD_HPP
+#ifndef FUN_FOLD_HPP_DONE
+#error "Cyclic include dependency"
+#endif
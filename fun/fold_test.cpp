@@ -0,0 +1,122 @@
+#include <fun/fold.hpp>
+
+#include <fun/grid_decl.hpp>
+#include <fun/maxarray.hpp>
+#include <fun/vector.hpp>
+
+#include <fun/grid_impl.hpp>
+
+#include <cxx/execution.hpp>
+
+#include <gtest/gtest.h>
+#include <qthread.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace fun;
+
+namespace {
+auto cat = [](const std::string &x, const std::string &y) { return x + y; };
+auto str = [](int i) { return std::to_string(i % 10); };
+
+std::string expected_cat(std::ptrdiff_t n) {
+  std::string r;
+  for (std::ptrdiff_t i = 0; i < n; ++i)
+    r += str(i);
+  return r;
+}
+}
+
+TEST(fun_fold, is_associative) {
+  EXPECT_TRUE(is_associative<std::plus<int>>::value);
+  // Floating-point operations need to opt in
+  EXPECT_FALSE(is_associative<std::plus<double>>::value);
+  EXPECT_FALSE(is_associative<std::multiplies<float>>::value);
+  EXPECT_TRUE(
+      is_associative<decltype(associative(std::plus<double>()))>::value);
+  EXPECT_TRUE(is_associative<std::logical_and<bool>>::value);
+  EXPECT_FALSE(is_associative<std::minus<int>>::value);
+  EXPECT_FALSE(is_associative<decltype(cat)>::value);
+  EXPECT_TRUE(is_associative<decltype(associative(cat))>::value);
+  EXPECT_EQ("ab", associative(cat)("a", "b"));
+}
+
+TEST(fun_fold, fold_range) {
+  // The order of the operands is kept, and z need not be an identity
+  for (std::ptrdiff_t n : {0, 1, 7, 8, 9, 100, 1001}) {
+    auto g = [](std::ptrdiff_t i) { return str(i); };
+    EXPECT_EQ("z" + expected_cat(n),
+              detail::fold_range(cat, std::string("z"), n, g));
+    EXPECT_EQ("z" + expected_cat(n),
+              detail::fold_range(associative(cat), std::string("z"), n, g));
+  }
+  auto sub = [](std::ptrdiff_t x, std::ptrdiff_t y) { return x - y; };
+  EXPECT_EQ(-45, detail::fold_range(sub, std::ptrdiff_t(0), 10,
+                                    [](std::ptrdiff_t i) { return i; }));
+}
+
+TEST(fun_fold, vector) {
+  qthread_initialize();
+
+  std::ptrdiff_t n = 100000;
+  std::vector<int> xs(n);
+  for (std::ptrdiff_t i = 0; i < n; ++i)
+    xs[i] = i;
+  auto id = [](int x) { return std::ptrdiff_t(x); };
+  std::ptrdiff_t sum = n * (n - 1) / 2;
+  EXPECT_EQ(sum, foldMap(id, std::plus<std::ptrdiff_t>(), 0, xs));
+  EXPECT_EQ(sum, foldMap(cxx::execution::seq, id, std::plus<std::ptrdiff_t>(),
+                         0, xs));
+  EXPECT_EQ(sum, foldMap(cxx::execution::par, id, std::plus<std::ptrdiff_t>(),
+                         0, xs));
+  auto add = [](int x, int y) { return std::ptrdiff_t(x + y); };
+  EXPECT_EQ(2 * sum, foldMap2(cxx::execution::par, add,
+                              std::plus<std::ptrdiff_t>(), 0, xs, xs));
+
+  std::vector<int> ys(1000);
+  for (std::ptrdiff_t i = 0; i < std::ptrdiff_t(ys.size()); ++i)
+    ys[i] = i;
+  EXPECT_EQ(expected_cat(ys.size()),
+            foldMap(cxx::execution::par, str, associative(cat), std::string(),
+                    ys));
+  // Non-associative operations are folded serially
+  EXPECT_EQ(expected_cat(ys.size()),
+            foldMap(cxx::execution::par, str, cat, std::string(), ys));
+}
+
+TEST(fun_fold, maxarray) {
+  adt::maxarray<int, 20> xs(20);
+  for (std::ptrdiff_t i = 0; i < 20; ++i)
+    xs[i] = i;
+  EXPECT_EQ(expected_cat(20),
+            foldMap(str, associative(cat), std::string(), xs));
+}
+
+TEST(fun_fold, grid) {
+  qthread_initialize();
+
+  typedef adt::grid<std::vector<adt::dummy>, int, 2> grid2;
+  std::ptrdiff_t s = 300;
+  auto xs = iotaMapMulti<grid2>(
+      [s](const adt::index_t<2> &i) { return int(i[0] + s * i[1]); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto id = [](int x) { return std::ptrdiff_t(x); };
+  std::ptrdiff_t n = s * s;
+  std::ptrdiff_t sum = n * (n - 1) / 2;
+  EXPECT_EQ(sum, foldMap(id, std::plus<std::ptrdiff_t>(), 0, xs));
+  EXPECT_EQ(sum, foldMap(cxx::execution::par, id, std::plus<std::ptrdiff_t>(),
+                         0, xs));
+  auto add = [](int x, int y) { return std::ptrdiff_t(x + y); };
+  EXPECT_EQ(2 * sum, foldMap2(cxx::execution::par, add,
+                              std::plus<std::ptrdiff_t>(), 0, xs, xs));
+  EXPECT_EQ(expected_cat(n),
+            foldMap(cxx::execution::par, str, associative(cat), std::string(),
+                    xs));
+
+  // Boundaries have non-unit strides
+  auto bs = boundary(xs, 2);
+  EXPECT_EQ(s * (s - 1) / 2, foldMap(cxx::execution::par, id,
+                                     std::plus<std::ptrdiff_t>(), 0, bs));
+}
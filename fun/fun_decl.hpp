@@ -1,6 +1,9 @@
 #ifndef FUN_FUN_DECL_HPP
 #define FUN_FUN_DECL_HPP
 
+#include <cxx/execution.hpp>
+#include <cxx/invoke.hpp>
+
 #include <cereal/types/tuple.hpp>
 
 #include <functional>
@@ -10,6 +13,7 @@
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace fun {
@@ -33,6 +37,73 @@ template <typename C1, typename C2T,
           typename C1T = typename fun_traits<C1>::template constructor<T>>
 C1T convert(const C2T &xs);
 
+// foldMapTuple
+
+// Evaluate several foldMaps, one per element of fs, ops, and zs, in a
+// single traversal of xs
+template <typename... Fs, typename... Ops, typename... Zs, typename CT,
+          typename... Args,
+          typename T = typename fun::fun_traits<CT>::value_type,
+          typename R = std::tuple<std::decay_t<
+              cxx::invoke_of_t<const Fs &, const T &, const Args &...>>...>>
+R foldMapTuple(const std::tuple<Fs...> &fs, const std::tuple<Ops...> &ops,
+               const std::tuple<Zs...> &zs, const CT &xs,
+               const Args &... args);
+
+template <typename Policy, typename... Fs, typename... Ops, typename... Zs,
+          typename CT, typename... Args,
+          typename T = typename fun::fun_traits<CT>::value_type,
+          typename R = std::tuple<std::decay_t<
+              cxx::invoke_of_t<const Fs &, const T &, const Args &...>>...>>
+R foldMapTuple(const Policy &policy, const std::tuple<Fs...> &fs,
+               const std::tuple<Ops...> &ops, const std::tuple<Zs...> &zs,
+               const CT &xs, const Args &... args);
+
+// fmapFold
+
+// Calculate ys = fmap(f, xs, args...) and foldMap(g, op, z, ys) in a
+// single traversal. Containers implement this via fmapFoldPair, where
+// the mapped function returns a pair of the new element and the value
+// to be folded.
+template <typename F, typename G, typename Op, typename Z, typename CT,
+          typename... Args,
+          typename T = typename fun::fun_traits<CT>::value_type,
+          typename R = std::decay_t<
+              cxx::invoke_of_t<const F &, const T &, const Args &...>>,
+          typename S = std::decay_t<cxx::invoke_of_t<const G &, const R &>>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFold(const F &f, const G &g, Op &&op, Z &&z,
+                          const CT &xs, const Args &... args);
+
+template <typename Policy, typename F, typename G, typename Op, typename Z,
+          typename CT, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename T = typename fun::fun_traits<CT>::value_type,
+          typename R = std::decay_t<
+              cxx::invoke_of_t<const F &, const T &, const Args &...>>,
+          typename S = std::decay_t<cxx::invoke_of_t<const G &, const R &>>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFold(const Policy &policy, const F &f, const G &g,
+                          Op &&op, Z &&z, const CT &xs, const Args &... args);
+
+// placement
+
+// Containers that create their elements on other processes (proxies)
+// accept a placement as first argument of iotaMap and iotaMapMulti
+// (see funhpc/placement.hpp). Containers built from such containers
+// accept it as well, and pass it on. Otherwise, no_placement is
+// passed around instead.
+namespace detail {
+template <typename> struct is_placement : std::false_type {};
+template <typename> struct is_placeable : std::false_type {};
+struct no_placement : std::tuple<> {
+  template <std::size_t D1, typename Range>
+  no_placement pinned(const Range &) const {
+    return *this;
+  }
+};
+}
+
 // An ostreamer is function that outputs something. In particular,
 // there is an efficient way of combining ostreamers -- somthing that
 // is not possible with regular ostreams.
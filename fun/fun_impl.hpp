@@ -3,14 +3,19 @@
 
 #include "fun_decl.hpp"
 
+#include <cxx/invoke.hpp>
+#include <cxx/utility.hpp>
+#include <fun/fold.hpp>
 #include <fun/maybe.hpp>
 
 #include <cereal/types/tuple.hpp>
 
+#include <cstddef>
 #include <functional>
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace fun {
@@ -51,6 +56,102 @@ C1T convert(const C2T &xs) {
   };
   return foldMap(f(), op(), mzero<C1, T>(), xs);
 }
+
+// foldMapTuple
+
+namespace detail {
+template <typename... Fs> struct tuple_fmap {
+  std::tuple<Fs...> fs;
+  template <typename Archive> void serialize(Archive &ar) { ar(fs); }
+  template <std::size_t... Is, typename... Args>
+  auto call(std::index_sequence<Is...>, const Args &... args) const {
+    return std::tuple<std::decay_t<
+        cxx::invoke_of_t<const Fs &, const Args &...>>...>(
+        cxx::invoke(std::get<Is>(fs), args...)...);
+  }
+  template <typename... Args> auto operator()(const Args &... args) const {
+    return call(std::index_sequence_for<Fs...>(), args...);
+  }
+};
+
+template <typename... Ops> struct tuple_op {
+  std::tuple<Ops...> ops;
+  template <typename Archive> void serialize(Archive &ar) { ar(ops); }
+  template <std::size_t... Is, typename... Rs>
+  std::tuple<Rs...> call(std::index_sequence<Is...>, std::tuple<Rs...> &x,
+                         std::tuple<Rs...> &y) const {
+    return std::tuple<Rs...>(cxx::invoke(std::get<Is>(ops),
+                                         std::move(std::get<Is>(x)),
+                                         std::move(std::get<Is>(y)))...);
+  }
+  template <typename... Rs>
+  std::tuple<Rs...> operator()(std::tuple<Rs...> x,
+                               std::tuple<Rs...> y) const {
+    return call(std::index_sequence_for<Rs...>(), x, y);
+  }
+};
+}
+
+// The combined operation is associative if all operations are
+template <typename... Ops>
+struct is_associative<detail::tuple_op<Ops...>>
+    : cxx::all_of_type<is_associative<Ops>::value...> {};
+
+template <typename... Fs, typename... Ops, typename... Zs, typename CT,
+          typename... Args, typename T, typename R>
+R foldMapTuple(const std::tuple<Fs...> &fs, const std::tuple<Ops...> &ops,
+               const std::tuple<Zs...> &zs, const CT &xs,
+               const Args &... args) {
+  static_assert(sizeof...(Fs) == sizeof...(Ops), "");
+  static_assert(sizeof...(Fs) == sizeof...(Zs), "");
+  return foldMap(detail::tuple_fmap<Fs...>{fs}, detail::tuple_op<Ops...>{ops},
+                 R(zs), xs, args...);
+}
+
+template <typename Policy, typename... Fs, typename... Ops, typename... Zs,
+          typename CT, typename... Args, typename T, typename R>
+R foldMapTuple(const Policy &policy, const std::tuple<Fs...> &fs,
+               const std::tuple<Ops...> &ops, const std::tuple<Zs...> &zs,
+               const CT &xs, const Args &... args) {
+  static_assert(sizeof...(Fs) == sizeof...(Ops), "");
+  static_assert(sizeof...(Fs) == sizeof...(Zs), "");
+  return foldMap(policy, detail::tuple_fmap<Fs...>{fs},
+                 detail::tuple_op<Ops...>{ops}, R(zs), xs, args...);
+}
+
+// fmapFold
+
+namespace detail {
+template <typename F, typename G> struct fmapFold_pair {
+  F f;
+  G g;
+  template <typename Archive> void serialize(Archive &ar) { ar(f, g); }
+  template <typename T, typename... Args>
+  auto operator()(const T &x, const Args &... args) const {
+    auto y = cxx::invoke(f, x, args...);
+    auto s = cxx::invoke(g, y);
+    return std::make_pair(std::move(y), std::move(s));
+  }
+};
+}
+
+template <typename F, typename G, typename Op, typename Z, typename CT,
+          typename... Args, typename T, typename R, typename S, typename CR>
+std::pair<CR, S> fmapFold(const F &f, const G &g, Op &&op, Z &&z,
+                          const CT &xs, const Args &... args) {
+  return fmapFoldPair(detail::fmapFold_pair<F, G>{f, g}, std::forward<Op>(op),
+                      std::forward<Z>(z), xs, args...);
+}
+
+template <typename Policy, typename F, typename G, typename Op, typename Z,
+          typename CT, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename T, typename R, typename S, typename CR>
+std::pair<CR, S> fmapFold(const Policy &policy, const F &f, const G &g,
+                          Op &&op, Z &&z, const CT &xs, const Args &... args) {
+  return fmapFoldPair(policy, detail::fmapFold_pair<F, G>{f, g},
+                      std::forward<Op>(op), std::forward<Z>(z), xs, args...);
+}
 }
 
 #define FUN_FUN_IMPL_HPP_DONE
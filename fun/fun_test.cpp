@@ -8,9 +8,15 @@
 
 #include <fun/nested_impl.hpp>
 
+#include <cxx/execution.hpp>
+
 #include <gtest/gtest.h>
+#include <qthread.h>
 
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 using namespace fun;
@@ -39,3 +45,51 @@ TEST(fun_fun, to_string) {
   auto s = to_string(xs);
   EXPECT_EQ("[h,e,l,l,o,]", s);
 }
+
+TEST(fun_fun, foldMapTuple) {
+  qthread_initialize();
+
+  auto xs = iotaMap<std::vector<adt::dummy>>([](int i) { return i; }, 100);
+  // All functions receive the same extra arguments
+  auto fs = std::make_tuple([](int x, int a) { return x; },
+                            [](int x, int a) { return a * x * x; });
+  auto ops = std::make_tuple(
+      std::plus<int>(), [](int x, int y) { return std::max(x, y); });
+  auto zs = std::make_tuple(0, 0);
+  auto rs = foldMapTuple(fs, ops, zs, xs, 2);
+  EXPECT_EQ(99 * 100 / 2, std::get<0>(rs));
+  EXPECT_EQ(2 * 99 * 99, std::get<1>(rs));
+  EXPECT_EQ(rs, foldMapTuple(cxx::execution::par, fs, ops, zs, xs, 2));
+  auto sums = std::make_tuple(std::plus<int>(), std::plus<int>());
+  EXPECT_TRUE((is_associative<
+               detail::tuple_op<std::plus<int>, std::plus<int>>>::value));
+  EXPECT_EQ(std::make_tuple(99 * 100 / 2, 2 * 99 * 100 * 199 / 6),
+            foldMapTuple(cxx::execution::par, fs, sums, zs, xs, 2));
+
+  auto ys = convert<shared_vector<adt::dummy>>(xs);
+  EXPECT_EQ(rs, foldMapTuple(fs, ops, zs, ys, 2));
+}
+
+TEST(fun_fun, fmapFold) {
+  qthread_initialize();
+
+  auto xs = iotaMap<std::vector<adt::dummy>>([](int i) { return i; }, 100);
+  auto sq = [](int x) { return x * x; };
+  auto id = [](int x) { return x; };
+  auto rs = fmapFold(sq, id, std::plus<int>(), 0, xs);
+  EXPECT_EQ(fmap(sq, xs), rs.first);
+  EXPECT_EQ(99 * 100 * 199 / 6, rs.second);
+  EXPECT_EQ(rs, fmapFold(cxx::execution::par, sq, id, std::plus<int>(), 0, xs));
+  auto rs1 = fmapFold([](int x, int a) { return a * x; },
+                      [](int x) { return double(x); }, std::plus<double>(),
+                      0.0, xs, 2);
+  static_assert(std::is_same<decltype(rs1.second), double>::value, "");
+  EXPECT_EQ(99 * 100, rs1.second);
+
+  auto ys = convert<shared_vector<adt::dummy>>(xs);
+  auto rs2 = fmapFold(sq, id, std::plus<int>(), 0, ys);
+  static_assert(
+      std::is_same<decltype(rs2.first), shared_vector<int>>::value, "");
+  EXPECT_EQ(rs.first, convert<std::vector<adt::dummy>>(rs2.first));
+  EXPECT_EQ(rs.second, rs2.second);
+}
@@ -5,10 +5,13 @@
 
 #include <adt/dummy.hpp>
 #include <adt/index.hpp>
+#include <cxx/execution.hpp>
 #include <cxx/invoke.hpp>
 #include <fun/fun_decl.hpp>
 
+#include <array>
 #include <type_traits>
+#include <utility>
 
 namespace fun {
 
@@ -52,6 +55,18 @@ template <typename C, std::size_t D, typename F, typename... Args,
           typename CR = typename fun_traits<C>::template constructor<R>>
 CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args);
 
+// The overloads taking an execution policy (cxx::execution::seq, par,
+// par_unseq) may evaluate the function in parallel
+
+template <typename C, typename Policy, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_grid<C>::value &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const Policy &policy, F &&f, const adt::steprange_t<D> &inds,
+                Args &&... args);
+
 // fmap
 
 template <typename F, typename C, typename T, std::size_t D, typename... Args,
@@ -60,6 +75,32 @@ template <typename F, typename C, typename T, std::size_t D, typename... Args,
           typename CR = typename fun_traits<CT>::template constructor<R>>
 CR fmap(F &&f, const adt::grid<C, T, D> &xs, Args &&... args);
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+        Args &&... args);
+
+// These reuse the storage of xs if the result has the same type
+
+template <typename F, typename C, typename T, std::size_t D, typename... Args,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap(F &&f, adt::grid<C, T, D> &&xs, Args &&... args);
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap(const Policy &policy, F &&f, adt::grid<C, T, D> &&xs,
+        Args &&... args);
+
 template <typename F, typename C, typename T, std::size_t D, typename T2,
           typename... Args, typename CT = adt::grid<C, T, D>,
           typename R = cxx::invoke_of_t<F, T, T2, Args...>,
@@ -67,6 +108,31 @@ template <typename F, typename C, typename T, std::size_t D, typename T2,
 CR fmap2(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
          Args &&... args);
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap2(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+         const adt::grid<C, T2, D> &ys, Args &&... args);
+
+template <typename F, typename C, typename T, std::size_t D, typename T2,
+          typename... Args, typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap2(F &&f, adt::grid<C, T, D> &&xs, const adt::grid<C, T2, D> &ys,
+         Args &&... args);
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap2(const Policy &policy, F &&f, adt::grid<C, T, D> &&xs,
+         const adt::grid<C, T2, D> &ys, Args &&... args);
+
 template <typename F, typename C, typename T, std::size_t D, typename T2,
           typename T3, typename... Args, typename CT = adt::grid<C, T, D>,
           typename R = cxx::invoke_of_t<F, T, T2, T3, Args...>,
@@ -74,6 +140,16 @@ template <typename F, typename C, typename T, std::size_t D, typename T2,
 CR fmap3(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
          const adt::grid<C, T3, D> &zs, Args &&... args);
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename T3, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, T3, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmap3(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+         const adt::grid<C, T2, D> &ys, const adt::grid<C, T3, D> &zs,
+         Args &&... args);
+
 // fmapStencil
 
 template <std::size_t D, typename F, typename G, typename C, typename T,
@@ -109,6 +185,233 @@ CR fmapStencilMulti(F &&f, G &&g, const adt::grid<C, T, D> &xs,
                     const std::decay_t<BCB> &bm1, const std::decay_t<BCB> &bp0,
                     const std::decay_t<BCB> &bp1, Args &&... args);
 
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 0 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 1 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                    Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 2 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, B, B, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                    const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                    Args &&... args);
+
+// fmapStencilMultiWide: As fmapStencilMulti, but for a stencil of
+// radius K. f receives an array of the K nearest neighbours (nearest
+// first) for each face, and the boundaries hold K layers (see
+// boundaryMapWide).
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename C,
+          typename T, typename... Args, std::enable_if_t<D == 1> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args);
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename C,
+          typename T, typename... Args, std::enable_if_t<D == 2> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R =
+              cxx::invoke_of_t<F, T, std::size_t, BK, BK, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args);
+
+template <std::size_t D, std::size_t K, typename Policy, typename F,
+          typename G, typename C, typename T, typename... Args,
+          std::enable_if_t<D == 1 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(const Policy &policy, F &&f, G &&g,
+                        const adt::grid<C, T, D> &xs, std::size_t bmask,
+                        const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args);
+
+template <std::size_t D, std::size_t K, typename Policy, typename F,
+          typename G, typename C, typename T, typename... Args,
+          std::enable_if_t<D == 2 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R =
+              cxx::invoke_of_t<F, T, std::size_t, BK, BK, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(const Policy &policy, F &&f, G &&g,
+                        const adt::grid<C, T, D> &xs, std::size_t bmask,
+                        const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args);
+
+// iterateStencil: Apply a stencil nsteps times, as in
+//   for (n = 0; n < nsteps; ++n)
+//     xs = fmapStencilMulti<D>(f, g, xs, bmask, boundaryMap(h, xs, 0),
+//                              boundaryMap(h, xs, 1), ...);
+// with the boundaries in the order that fmapStencilMulti expects.
+// Several steps are taken at once on cache-sized tiles (temporal
+// blocking), so that the grid is streamed through memory only once
+// for these steps.
+
+template <std::size_t D, typename F, typename G, typename H, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 1 || D == 2> * = nullptr>
+adt::grid<C, T, D> iterateStencil(F &&f, G &&g, H &&h,
+                                  const adt::grid<C, T, D> &xs,
+                                  std::size_t bmask, std::ptrdiff_t nsteps,
+                                  Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename H,
+          typename C, typename T, typename... Args,
+          std::enable_if_t<(D == 1 || D == 2) &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr>
+adt::grid<C, T, D> iterateStencil(const Policy &policy, F &&f, G &&g, H &&h,
+                                  const adt::grid<C, T, D> &xs,
+                                  std::size_t bmask, std::ptrdiff_t nsteps,
+                                  Args &&... args);
+
+// fmapStencilMulti2: As fmapStencilMulti, but f and g receive the
+// corresponding elements of two grids
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 0> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, std::size_t, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     Args &&... args);
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 1> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B =
+              std::decay_t<cxx::invoke_of_t<G, T, T2, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, T2, std::size_t, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                     Args &&... args);
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 2> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B =
+              std::decay_t<cxx::invoke_of_t<G, T, T2, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R =
+              cxx::invoke_of_t<F, T, T2, std::size_t, B, B, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                     const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                     Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 0 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename R = cxx::invoke_of_t<F, T, T2, std::size_t, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 1 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B =
+              std::decay_t<cxx::invoke_of_t<G, T, T2, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R = cxx::invoke_of_t<F, T, T2, std::size_t, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                     Args &&... args);
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 2 &&
+                           cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B =
+              std::decay_t<cxx::invoke_of_t<G, T, T2, std::ptrdiff_t>>,
+          typename BCB = typename fun_traits<BC>::template constructor<B>,
+          typename R =
+              cxx::invoke_of_t<F, T, T2, std::size_t, B, B, B, B, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                     const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                     Args &&... args);
+
 // head, last
 
 template <typename C, typename T, std::size_t D,
@@ -139,6 +442,28 @@ template <typename F, typename C, typename T, std::size_t D, typename... Args,
 BCR boundaryMap(F &&f, const adt::grid<C, T, D> &xs, std::ptrdiff_t i,
                 Args &&... args);
 
+template <typename F, typename C, typename T, std::size_t D, typename T2,
+          typename... Args, std::enable_if_t<D != 0> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename R = cxx::invoke_of_t<F, T, T2, std::ptrdiff_t, Args...>,
+          typename BCR = typename fun_traits<BC>::template constructor<R>>
+BCR boundaryMap2(F &&f, const adt::grid<C, T, D> &xs,
+                 const adt::grid<C, T2, D> &ys, std::ptrdiff_t i,
+                 Args &&... args);
+
+// boundaryMapWide: As boundaryMap, but each element holds the K
+// outermost layers, starting at the boundary and going inwards
+template <std::size_t K, typename F, typename C, typename T, std::size_t D,
+          typename... Args, std::enable_if_t<D != 0> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename R = cxx::invoke_of_t<F, T, std::ptrdiff_t, Args...>,
+          typename BCR =
+              typename fun_traits<BC>::template constructor<std::array<R, K>>>
+BCR boundaryMapWide(F &&f, const adt::grid<C, T, D> &xs, std::ptrdiff_t i,
+                    Args &&... args);
+
 // foldMap
 
 template <typename F, typename Op, typename Z, typename C, typename T,
@@ -146,12 +471,51 @@ template <typename F, typename Op, typename Z, typename C, typename T,
           typename R = cxx::invoke_of_t<F, T, Args...>>
 R foldMap(F &&f, Op &&op, Z &&z, const adt::grid<C, T, D> &xs, Args &&... args);
 
+// With a parallel policy, the fold is parallelized if op is associative
+// (see fun::is_associative); z then needs to be an identity of op
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, Args...>>
+R foldMap(const Policy &policy, F &&f, Op &&op, Z &&z,
+          const adt::grid<C, T, D> &xs, Args &&... args);
+
 template <typename F, typename Op, typename Z, typename C, typename T,
           std::size_t D, typename T2, typename... Args,
           typename R = cxx::invoke_of_t<F, T, T2, Args...>>
 R foldMap2(F &&f, Op &&op, Z &&z, const adt::grid<C, T, D> &xs,
            const adt::grid<C, T2, D> &ys, Args &&... args);
 
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+R foldMap2(const Policy &policy, F &&f, Op &&op, Z &&z,
+           const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
+           Args &&... args);
+
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename C, typename T,
+          std::size_t D, typename... Args, typename CT = adt::grid<C, T, D>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const adt::grid<C, T, D> &xs, Args &&... args);
+
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = adt::grid<C, T, D>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(const Policy &policy, F &&f, Op &&op, Z &&z,
+                              const adt::grid<C, T, D> &xs, Args &&... args);
+
 // dump
 
 template <typename C, typename T, std::size_t D>
@@ -34,6 +34,17 @@ CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
             std::forward<Args>(args)...);
 }
 
+template <typename C, typename Policy, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_grid<C>::value &&
+                           cxx::is_execution_policy<Policy>::value> *,
+          typename R, typename CR>
+CR iotaMapMulti(const Policy &policy, F &&f, const adt::steprange_t<D> &inds,
+                Args &&... args) {
+  return CR(typename CR::iotaMapMulti(), policy, std::forward<F>(f), inds,
+            std::forward<Args>(args)...);
+}
+
 // fmap
 
 template <typename F, typename C, typename T, std::size_t D, typename... Args,
@@ -43,6 +54,33 @@ CR fmap(F &&f, const adt::grid<C, T, D> &xs, Args &&... args) {
             std::forward<Args>(args)...);
 }
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmap(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+        Args &&... args) {
+  return CR(typename CR::fmap(), policy, std::forward<F>(f), xs,
+            std::forward<Args>(args)...);
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename... Args,
+          typename CT, typename R, typename CR>
+CR fmap(F &&f, adt::grid<C, T, D> &&xs, Args &&... args) {
+  return CR(typename CR::fmap(), std::forward<F>(f), std::move(xs),
+            std::forward<Args>(args)...);
+}
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmap(const Policy &policy, F &&f, adt::grid<C, T, D> &&xs,
+        Args &&... args) {
+  return CR(typename CR::fmap(), policy, std::forward<F>(f), std::move(xs),
+            std::forward<Args>(args)...);
+}
+
 template <typename F, typename C, typename T, std::size_t D, typename T2,
           typename... Args, typename CT, typename R, typename CR>
 CR fmap2(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
@@ -51,6 +89,37 @@ CR fmap2(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
             std::forward<Args>(args)...);
 }
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmap2(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+         const adt::grid<C, T2, D> &ys, Args &&... args) {
+  return CR(typename CR::fmap2(), policy, std::forward<F>(f), xs, ys,
+            std::forward<Args>(args)...);
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename T2,
+          typename... Args, typename CT, typename R, typename CR>
+CR fmap2(F &&f, adt::grid<C, T, D> &&xs, const adt::grid<C, T2, D> &ys,
+         Args &&... args) {
+  return fmap2(cxx::execution::seq, std::forward<F>(f), std::move(xs), ys,
+               std::forward<Args>(args)...);
+}
+
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmap2(const Policy &policy, F &&f, adt::grid<C, T, D> &&xs,
+         const adt::grid<C, T2, D> &ys, Args &&... args) {
+  if (__builtin_expect(static_cast<const void *>(&xs) == &ys, false))
+    return fmap2(policy, std::forward<F>(f), static_cast<const CT &>(xs), ys,
+                 std::forward<Args>(args)...);
+  return CR(typename CR::fmap2(), policy, std::forward<F>(f), std::move(xs),
+            ys, std::forward<Args>(args)...);
+}
+
 template <typename F, typename C, typename T, std::size_t D, typename T2,
           typename T3, typename... Args, typename CT, typename R, typename CR>
 CR fmap3(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
@@ -59,6 +128,17 @@ CR fmap3(F &&f, const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
             std::forward<Args>(args)...);
 }
 
+template <typename Policy, typename F, typename C, typename T, std::size_t D,
+          typename T2, typename T3, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmap3(const Policy &policy, F &&f, const adt::grid<C, T, D> &xs,
+         const adt::grid<C, T2, D> &ys, const adt::grid<C, T3, D> &zs,
+         Args &&... args) {
+  return CR(typename CR::fmap3(), policy, std::forward<F>(f), xs, ys, zs,
+            std::forward<Args>(args)...);
+}
+
 // fmapStencil
 
 template <std::size_t D, typename F, typename G, typename C, typename T,
@@ -93,6 +173,215 @@ CR fmapStencilMulti(F &&f, G &&g, const adt::grid<C, T, D> &xs,
             std::forward<Args>(args)...);
 }
 
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 0 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    Args &&... args) {
+  return CR(typename CR::fmapStencilMulti(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, bmask, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 1 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                    Args &&... args) {
+  return CR(typename CR::fmapStencilMulti(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, bmask, bm0, bp0,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename... Args,
+          std::enable_if_t<D == 2 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                    const adt::grid<C, T, D> &xs, std::size_t bmask,
+                    const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                    const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                    Args &&... args) {
+  return CR(typename CR::fmapStencilMulti(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, bmask, bm0, bm1, bp0, bp1,
+            std::forward<Args>(args)...);
+}
+
+// fmapStencilMultiWide
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename C,
+          typename T, typename... Args, std::enable_if_t<D == 1> *,
+          typename CT, typename BC, typename B, typename BK, typename BCB,
+          typename R, typename CR>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args) {
+  return CR(typename CR::template fmapStencilMultiWide<K>(),
+            std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bp0,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename C,
+          typename T, typename... Args, std::enable_if_t<D == 2> *,
+          typename CT, typename BC, typename B, typename BK, typename BCB,
+          typename R, typename CR>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args) {
+  return CR(typename CR::template fmapStencilMultiWide<K>(),
+            std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bm1, bp0,
+            bp1, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, std::size_t K, typename Policy, typename F,
+          typename G, typename C, typename T, typename... Args,
+          std::enable_if_t<D == 1 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BK, typename BCB,
+          typename R, typename CR>
+CR fmapStencilMultiWide(const Policy &policy, F &&f, G &&g,
+                        const adt::grid<C, T, D> &xs, std::size_t bmask,
+                        const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args) {
+  return CR(typename CR::template fmapStencilMultiWide<K>(), policy,
+            std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bp0,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, std::size_t K, typename Policy, typename F,
+          typename G, typename C, typename T, typename... Args,
+          std::enable_if_t<D == 2 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BK, typename BCB,
+          typename R, typename CR>
+CR fmapStencilMultiWide(const Policy &policy, F &&f, G &&g,
+                        const adt::grid<C, T, D> &xs, std::size_t bmask,
+                        const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args) {
+  return CR(typename CR::template fmapStencilMultiWide<K>(), policy,
+            std::forward<F>(f), std::forward<G>(g), xs, bmask, bm0, bm1, bp0,
+            bp1, std::forward<Args>(args)...);
+}
+
+// iterateStencil
+
+template <std::size_t D, typename F, typename G, typename H, typename C,
+          typename T, typename... Args, std::enable_if_t<D == 1 || D == 2> *>
+adt::grid<C, T, D> iterateStencil(F &&f, G &&g, H &&h,
+                                  const adt::grid<C, T, D> &xs,
+                                  std::size_t bmask, std::ptrdiff_t nsteps,
+                                  Args &&... args) {
+  typedef adt::grid<C, T, D> CT;
+  return CT(typename CT::iterateStencil(), std::forward<F>(f),
+            std::forward<G>(g), std::forward<H>(h), xs, bmask, nsteps,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename H,
+          typename C, typename T, typename... Args,
+          std::enable_if_t<(D == 1 || D == 2) &&
+                           cxx::is_execution_policy<Policy>::value> *>
+adt::grid<C, T, D> iterateStencil(const Policy &policy, F &&f, G &&g, H &&h,
+                                  const adt::grid<C, T, D> &xs,
+                                  std::size_t bmask, std::ptrdiff_t nsteps,
+                                  Args &&... args) {
+  typedef adt::grid<C, T, D> CT;
+  return CT(typename CT::iterateStencil(), policy, std::forward<F>(f),
+            std::forward<G>(g), std::forward<H>(h), xs, bmask, nsteps,
+            std::forward<Args>(args)...);
+}
+
+// fmapStencilMulti2
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 0> *,
+          typename CT, typename R, typename CR>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), cxx::execution::seq,
+            std::forward<F>(f), std::forward<G>(g), xs, ys, bmask,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 1> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), cxx::execution::seq,
+            std::forward<F>(f), std::forward<G>(g), xs, ys, bmask, bm0, bp0,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename C, typename T,
+          typename T2, typename... Args, std::enable_if_t<D == 2> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti2(F &&f, G &&g, const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                     const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), cxx::execution::seq,
+            std::forward<F>(f), std::forward<G>(g), xs, ys, bmask, bm0, bm1,
+            bp0, bp1, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 0 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename R, typename CR>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, ys, bmask, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 1 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bp0,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, ys, bmask, bm0, bp0,
+            std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename C,
+          typename T, typename T2, typename... Args,
+          std::enable_if_t<D == 2 && cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename BC, typename B, typename BCB, typename R,
+          typename CR>
+CR fmapStencilMulti2(const Policy &policy, F &&f, G &&g,
+                     const adt::grid<C, T, D> &xs,
+                     const adt::grid<C, T2, D> &ys, std::size_t bmask,
+                     const std::decay_t<BCB> &bm0, const std::decay_t<BCB> &bm1,
+                     const std::decay_t<BCB> &bp0, const std::decay_t<BCB> &bp1,
+                     Args &&... args) {
+  return CR(typename CR::fmapStencilMulti2(), policy, std::forward<F>(f),
+            std::forward<G>(g), xs, ys, bmask, bm0, bm1, bp0, bp1,
+            std::forward<Args>(args)...);
+}
+
 // head, last
 
 template <typename C, typename T, std::size_t D, std::enable_if_t<D == 1> *>
@@ -120,8 +409,27 @@ template <typename F, typename C, typename T, std::size_t D, typename... Args,
           typename BCR>
 BCR boundaryMap(F &&f, const adt::grid<C, T, D> &xs, std::ptrdiff_t i,
                 Args &&... args) {
-  return fmap(std::forward<F>(f), boundary(xs, i), i,
-              std::forward<Args>(args)...);
+  return BCR(typename BCR::boundaryMap(), std::forward<F>(f), xs, i, i,
+             std::forward<Args>(args)...);
+}
+
+template <typename F, typename C, typename T, std::size_t D, typename T2,
+          typename... Args, std::enable_if_t<D != 0> *, typename CT,
+          typename BC, typename R, typename BCR>
+BCR boundaryMap2(F &&f, const adt::grid<C, T, D> &xs,
+                 const adt::grid<C, T2, D> &ys, std::ptrdiff_t i,
+                 Args &&... args) {
+  return BCR(typename BCR::boundaryMap2(), std::forward<F>(f), xs, ys, i, i,
+             std::forward<Args>(args)...);
+}
+
+template <std::size_t K, typename F, typename C, typename T, std::size_t D,
+          typename... Args, std::enable_if_t<D != 0> *, typename CT,
+          typename BC, typename R, typename BCR>
+BCR boundaryMapWide(F &&f, const adt::grid<C, T, D> &xs, std::ptrdiff_t i,
+                    Args &&... args) {
+  return BCR(typename BCR::template boundaryMapWide<K>(), std::forward<F>(f),
+             xs, i, i, std::forward<Args>(args)...);
 }
 
 // foldMap
@@ -134,6 +442,16 @@ R foldMap(F &&f, Op &&op, Z &&z, const adt::grid<C, T, D> &xs,
                     std::forward<Z>(z), std::forward<Args>(args)...);
 }
 
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename R>
+R foldMap(const Policy &policy, F &&f, Op &&op, Z &&z,
+          const adt::grid<C, T, D> &xs, Args &&... args) {
+  return xs.foldMap(policy, std::forward<F>(f), std::forward<Op>(op),
+                    std::forward<Z>(z), std::forward<Args>(args)...);
+}
+
 template <typename F, typename Op, typename Z, typename C, typename T,
           std::size_t D, typename T2, typename... Args, typename R>
 R foldMap2(F &&f, Op &&op, Z &&z, const adt::grid<C, T, D> &xs,
@@ -142,6 +460,42 @@ R foldMap2(F &&f, Op &&op, Z &&z, const adt::grid<C, T, D> &xs,
                      std::forward<Z>(z), ys, std::forward<Args>(args)...);
 }
 
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename T2, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename R>
+R foldMap2(const Policy &policy, F &&f, Op &&op, Z &&z,
+           const adt::grid<C, T, D> &xs, const adt::grid<C, T2, D> &ys,
+           Args &&... args) {
+  return xs.foldMap2(policy, std::forward<F>(f), std::forward<Op>(op),
+                     std::forward<Z>(z), ys, std::forward<Args>(args)...);
+}
+
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename C, typename T,
+          std::size_t D, typename... Args, typename CT, typename RS,
+          typename R, typename S, typename CR>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const adt::grid<C, T, D> &xs, Args &&... args) {
+  return fmapFoldPair(cxx::execution::seq, std::forward<F>(f),
+                      std::forward<Op>(op), std::forward<Z>(z), xs,
+                      std::forward<Args>(args)...);
+}
+
+template <typename Policy, typename F, typename Op, typename Z, typename C,
+          typename T, std::size_t D, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> *,
+          typename CT, typename RS, typename R, typename S, typename CR>
+std::pair<CR, S> fmapFoldPair(const Policy &policy, F &&f, Op &&op, Z &&z,
+                              const adt::grid<C, T, D> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  S r(std::forward<Z>(z));
+  CR rs(typename CR::fmapFold(), policy, std::forward<F>(f), op, r, xs,
+        std::forward<Args>(args)...);
+  return {std::move(rs), std::move(r)};
+}
+
 // dump
 
 template <typename C, typename T, std::size_t D>
@@ -2,15 +2,26 @@
 
 #include <fun/array.hpp>
 #include <fun/idtype.hpp>
+#include <fun/maxarray.hpp>
 #include <fun/nested_decl.hpp>
 #include <fun/shared_ptr.hpp>
 #include <fun/vector.hpp>
 
 #include <fun/grid_impl.hpp>
 
+#include <cxx/memory.hpp>
+
 #include <fun/nested_impl.hpp>
 
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
 #include <gtest/gtest.h>
+#include <qthread.h>
+
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
 
 using namespace fun;
 
@@ -23,6 +34,11 @@ template <typename T> using grid0 = adt::grid<std::vector<adt::dummy>, T, 0>;
 template <typename T> using grid1 = adt::grid<std::vector<adt::dummy>, T, 1>;
 template <typename T> using grid2 = adt::grid<std::vector<adt::dummy>, T, 2>;
 template <typename T> using grid3 = adt::grid<std::vector<adt::dummy>, T, 3>;
+template <typename T>
+using aligned_grid2 = adt::grid<
+    std::vector<adt::dummy,
+                cxx::aligned_allocator<adt::dummy, cxx::cache_line_size>>,
+    T, 2>;
 }
 
 TEST(fun_grid, iotaMap) {
@@ -67,6 +83,75 @@ TEST(fun_grid, fmap) {
   EXPECT_EQ(55, zs.last());
 }
 
+TEST(fun_grid, fmap_inplace) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMapMulti<grid3<adt::dummy>>(
+      [](const typename grid3<int>::index_type &x) { return int(adt::sum(x)); },
+      adt::steprange_t<3>(adt::index_t<3>{{s, s, s}}));
+  auto add = [](auto x, auto y) { return x + y; };
+  auto ys = xs;
+
+  const int *p = &xs.head();
+  auto rs = fmap(add, std::move(xs), 1);
+  EXPECT_EQ(p, &rs.head());
+  EXPECT_EQ(28, rs.last());
+  auto rs2 = fmap2(cxx::execution::par, add, std::move(rs), ys);
+  EXPECT_EQ(p, &rs2.head());
+  EXPECT_EQ(55, rs2.last());
+
+  auto rs3 = fmap2(add, std::move(ys), ys);
+  EXPECT_EQ(54, rs3.last());
+
+  auto rs4 = fmap([](auto x) { return double(x); }, std::move(rs2));
+  static_assert(std::is_same<decltype(rs4), grid3<double>>::value, "");
+  EXPECT_EQ(55.0, rs4.last());
+}
+
+TEST(fun_grid, parallel) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 40;
+  adt::steprange_t<3> range(adt::index_t<3>{{s, s, s}});
+  auto f = [](const auto &x) { return int(adt::sum(x)); };
+  auto xs = iotaMapMulti<grid3<adt::dummy>>(f, range);
+  auto xs1 = iotaMapMulti<grid3<adt::dummy>>(cxx::execution::seq, f, range);
+  auto xs2 = iotaMapMulti<grid3<adt::dummy>>(cxx::execution::par, f, range);
+  auto xs3 =
+      iotaMapMulti<grid3<adt::dummy>>(cxx::execution::par_unseq, f, range);
+  auto eq = [](auto x, auto y) { return x == y; };
+  auto all = [](bool x, bool y) { return x && y; };
+  EXPECT_TRUE(foldMap2(eq, all, true, xs, xs1));
+  EXPECT_TRUE(foldMap2(eq, all, true, xs, xs2));
+  EXPECT_TRUE(foldMap2(eq, all, true, xs, xs3));
+
+  auto add = [](auto x, auto y) { return x + y; };
+  auto ys = fmap(cxx::execution::par, add, xs, 1);
+  EXPECT_TRUE(foldMap2(eq, all, true, fmap(add, xs, 1), ys));
+  auto zs = fmap2(cxx::execution::par, add, xs, ys);
+  EXPECT_TRUE(foldMap2(eq, all, true, fmap2(add, xs, ys), zs));
+  auto add3 = [](auto x, auto y, auto z) { return x + y + z; };
+  auto ws = fmap3(cxx::execution::par, add3, xs, ys, zs);
+  EXPECT_TRUE(foldMap2(eq, all, true, fmap3(add3, xs, ys, zs), ws));
+
+  auto xs2d = iotaMapMulti<grid2<adt::dummy>>(
+      cxx::execution::par, [](const auto &x) { return int(adt::sum(x * x)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s * s, s}}));
+  auto bms = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &x) { return int(-1); },
+      adt::steprange_t<1>(adt::index_t<1>{{s * s}}));
+  auto bps = fmap([](auto x) { return x + 1; }, bms);
+  auto lap = [](auto x, auto bdirs, int bm0, int bm1, int bp0, int bp1) {
+    return (bm0 - 2 * x + bp0) + (bm1 - 2 * x + bp1);
+  };
+  auto get = [](auto x, auto i) { return x; };
+  auto rs = fmapStencilMulti<2>(lap, get, xs2d, ~0, bms, bms, bps, bps);
+  auto rs1 = fmapStencilMulti<2>(cxx::execution::par, lap, get, xs2d, ~0, bms,
+                                 bms, bps, bps);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs, rs1));
+}
+
 TEST(fun_grid, boundary) {
   std::ptrdiff_t s = 10;
 
@@ -179,6 +264,185 @@ TEST(fun_grid, fmapStencil) {
   EXPECT_EQ(400, sum2);
 }
 
+TEST(fun_grid, fmapStencilWide) {
+  std::ptrdiff_t s = 10;
+  auto id = [](auto x) { return x; };
+  auto add = [](auto x, auto y) { return x + y; };
+  auto get = [](auto x, auto i) { return x; };
+  // Fourth order second derivative, times 12
+  auto lap = [](int x, std::size_t bdirs, const std::array<int, 2> &bm,
+                const std::array<int, 2> &bp) {
+    return -bm[1] + 16 * bm[0] - 30 * x + 16 * bp[0] - bp[1];
+  };
+
+  auto xs1 = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &x) { return int(adt::sum(x * x)); },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto bl1 = boundaryMapWide<2>(get, xs1, 1);
+  EXPECT_EQ(1, msize(bl1));
+  EXPECT_EQ((std::array<int, 2>{{(s - 1) * (s - 1), (s - 2) * (s - 2)}}),
+            mextract(bl1));
+  // Continue x^2 into the boundaries
+  auto bms1 = iotaMapMulti<grid0<adt::dummy>>(
+      [](const auto &x) { return std::array<int, 2>{{1, 4}}; },
+      adt::steprange_t<0>(adt::index_t<0>{{}}));
+  auto bps1 = iotaMapMulti<grid0<adt::dummy>>(
+      [s](const auto &x) {
+        return std::array<int, 2>{{int(s * s), int((s + 1) * (s + 1))}};
+      },
+      adt::steprange_t<0>(adt::index_t<0>{{}}));
+  auto ys1 = fmapStencilMultiWide<1, 2>(lap, get, xs1, ~0, bms1, bps1);
+  EXPECT_EQ(24 * s, foldMap(id, add, 0, ys1));
+  auto bdirs1 = fmapStencilMultiWide<1, 2>(
+      [](int x, std::size_t bdirs, const std::array<int, 2> &bm,
+         const std::array<int, 2> &bp) { return int(bdirs); },
+      get, xs1, ~0, bms1, bps1);
+  // The two outermost points on each side reach into the boundaries
+  EXPECT_EQ(0b01, head(bdirs1));
+  EXPECT_EQ(0b10, last(bdirs1));
+  EXPECT_EQ(2 * 0b01 + 2 * 0b10, foldMap(id, add, 0, bdirs1));
+
+  auto xs2 = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &x) { return int(adt::sum(x * x)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto bms2 = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &x) {
+        int j2 = adt::sum(x * x);
+        return std::array<int, 2>{{1 + j2, 4 + j2}};
+      },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto bps2 = iotaMapMulti<grid1<adt::dummy>>(
+      [s](const auto &x) {
+        int j2 = adt::sum(x * x);
+        return std::array<int, 2>{
+            {int(s * s) + j2, int((s + 1) * (s + 1)) + j2}};
+      },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto lap2 = [](int x, std::size_t bdirs, const std::array<int, 2> &bm0,
+                 const std::array<int, 2> &bm1, const std::array<int, 2> &bp0,
+                 const std::array<int, 2> &bp1) {
+    return (-bm0[1] + 16 * bm0[0] - 30 * x + 16 * bp0[0] - bp0[1]) +
+           (-bm1[1] + 16 * bm1[0] - 30 * x + 16 * bp1[0] - bp1[1]);
+  };
+  auto ys2 =
+      fmapStencilMultiWide<2, 2>(lap2, get, xs2, ~0, bms2, bms2, bps2, bps2);
+  EXPECT_EQ(48 * s * s, foldMap(id, add, 0, ys2));
+  auto eq = [](auto x, auto y) { return x == y; };
+  auto all = [](bool x, bool y) { return x && y; };
+  auto ys2p = fmapStencilMultiWide<2, 2>(cxx::execution::par, lap2, get, xs2,
+                                         ~0, bms2, bms2, bps2, bps2);
+  EXPECT_TRUE(foldMap2(eq, all, true, ys2, ys2p));
+
+  // Boundary layers are taken from the container itself, passing
+  // through a nested container
+  typedef adt::nested<std::shared_ptr<adt::dummy>, grid1<adt::dummy>, int>
+      nested_grid1;
+  auto nxs1 = iotaMapMulti<nested_grid1>(
+      [](const auto &x) { return int(adt::sum(x * x)); },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto nys1 = fmapStencilMultiWide<1, 2>(
+      lap, get, nxs1, ~0, boundaryMapWide<2>(get, nxs1, 0),
+      boundaryMapWide<2>(get, nxs1, 1));
+  auto zs1 = fmapStencilMultiWide<1, 2>(lap, get, xs1, ~0,
+                                        boundaryMapWide<2>(get, xs1, 0),
+                                        boundaryMapWide<2>(get, xs1, 1));
+  EXPECT_EQ(foldMap(id, add, 0, zs1), foldMap(id, add, 0, nys1));
+  EXPECT_EQ(head(zs1), head(nys1));
+  EXPECT_EQ(last(zs1), last(nys1));
+
+  // With several blocks, the boundary layers of each block come from
+  // its neighbours. A stencil of radius 2 with weights 1 2 3 2 1 is
+  // two steps of the stencil with weights 1 1 1, if the grid is
+  // continued antisymmetrically into the boundaries.
+  typedef adt::nested<grid1<adt::dummy>,
+                      adt::grid<adt::maxarray<adt::dummy, 8>, adt::dummy, 1>,
+                      int>
+      blocked_grid1;
+  auto neg = [](int x, std::ptrdiff_t i) { return -x; };
+  auto sum3 = [](int x, std::size_t bdirs, int bm, int bp) {
+    return bm + x + bp;
+  };
+  auto sum5 = [](int x, std::size_t bdirs, const std::array<int, 2> &bm,
+                 const std::array<int, 2> &bp) {
+    return bm[1] + 2 * bm[0] + 3 * x + 2 * bp[0] + bp[1];
+  };
+  auto bxs1 = iotaMapMulti<blocked_grid1>(
+      [](const auto &x) { return int(adt::sum(x * x)); },
+      adt::steprange_t<1>(adt::index_t<1>{{50}}));
+  EXPECT_EQ(7, msize(bxs1.data));
+  auto bys1 = fmapStencilMultiWide<1, 2>(sum5, get, bxs1, ~0,
+                                         boundaryMapWide<2>(neg, bxs1, 0),
+                                         boundaryMapWide<2>(neg, bxs1, 1));
+  auto bzs1 = bxs1;
+  for (int n = 0; n < 2; ++n)
+    bzs1 = fmapStencilMulti<1>(sum3, get, bzs1, ~0, boundaryMap(neg, bzs1, 0),
+                               boundaryMap(neg, bzs1, 1));
+  EXPECT_TRUE(foldMap2(eq, all, true, bzs1, bys1));
+}
+
+TEST(fun_grid, iterateStencil) {
+  typedef std::uint32_t U;
+  auto get = [](U x, std::ptrdiff_t i) { return x; };
+  auto refl = [](U x, std::ptrdiff_t i) { return x + U(i); };
+  auto eq = [](auto x, auto y) { return x == y; };
+  auto all = [](bool x, bool y) { return x && y; };
+  std::ptrdiff_t nsteps = 10;
+
+  // Large enough for several tiles
+  auto f1 = [](U x, std::size_t bdirs, U bm0, U bp0) {
+    return 3 * bm0 + 5 * x + 7 * bp0 + U(bdirs);
+  };
+  auto xs1 = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &x) { return U(x[0]); },
+      adt::steprange_t<1>(adt::index_t<1>{{100000}}));
+  auto ys1 = xs1;
+  for (std::ptrdiff_t n = 0; n < nsteps; ++n)
+    ys1 = fmapStencilMulti<1>(f1, get, ys1, ~0, boundaryMap(refl, ys1, 0),
+                              boundaryMap(refl, ys1, 1));
+  auto zs1 = iterateStencil<1>(f1, get, refl, xs1, ~0, nsteps);
+  EXPECT_TRUE(foldMap2(eq, all, true, ys1, zs1));
+  auto zs1p =
+      iterateStencil<1>(cxx::execution::par, f1, get, refl, xs1, ~0, nsteps);
+  EXPECT_TRUE(foldMap2(eq, all, true, ys1, zs1p));
+  EXPECT_TRUE(foldMap2(eq, all, true, xs1,
+                       iterateStencil<1>(f1, get, refl, xs1, ~0, 0)));
+
+  auto f2 = [](U x, std::size_t bdirs, U bm0, U bm1, U bp0, U bp1, U c) {
+    return 3 * bm0 + 5 * bm1 + 7 * x + 11 * bp0 + 13 * bp1 + U(bdirs) + c;
+  };
+  auto xs2 = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &x) { return U(x[0] + 1000 * x[1]); },
+      adt::steprange_t<2>(adt::index_t<2>{{400, 300}}));
+  auto ys2 = xs2;
+  for (std::ptrdiff_t n = 0; n < nsteps; ++n)
+    ys2 = fmapStencilMulti<2>(f2, get, ys2, 0b0111, boundaryMap(refl, ys2, 0),
+                              boundaryMap(refl, ys2, 2),
+                              boundaryMap(refl, ys2, 1),
+                              boundaryMap(refl, ys2, 3), U(1));
+  auto zs2 = iterateStencil<2>(cxx::execution::par, f2, get, refl, xs2,
+                               0b0111, nsteps, U(1));
+  EXPECT_TRUE(foldMap2(eq, all, true, ys2, zs2));
+
+  // Nested containers take the steps one by one
+  typedef adt::nested<std::shared_ptr<adt::dummy>, grid1<adt::dummy>, U>
+      nested_grid1;
+  auto nxs1 = iotaMapMulti<nested_grid1>(
+      [](const auto &x) { return U(x[0]); },
+      adt::steprange_t<1>(adt::index_t<1>{{1000}}));
+  auto nzs1 = iterateStencil<1>(f1, get, refl, nxs1, ~0, nsteps);
+  auto ws1 = iterateStencil<1>(
+      f1, get, refl,
+      iotaMapMulti<grid1<adt::dummy>>(
+          [](const auto &x) { return U(x[0]); },
+          adt::steprange_t<1>(adt::index_t<1>{{1000}})),
+      ~0, nsteps);
+  auto add = [](U x, U y) { return x + y; };
+  auto id = [](U x) { return x; };
+  EXPECT_EQ(foldMap(id, add, U(0), ws1), foldMap(id, add, U(0), nzs1));
+  EXPECT_EQ(head(ws1), head(nzs1));
+  EXPECT_EQ(last(ws1), last(nzs1));
+}
+
 TEST(fun_grid, foldMap) {
   std::ptrdiff_t s = 10;
   auto xs = iotaMapMulti<grid3<adt::dummy>>(
@@ -190,6 +454,139 @@ TEST(fun_grid, foldMap) {
   EXPECT_EQ(13500, r);
 }
 
+TEST(fun_grid, fmapFold) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 40;
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &x) { return int(adt::sum(x)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto sq = [](auto x) { return x * x; };
+  auto id = [](auto x) { return x; };
+  auto add = [](auto x, auto y) { return x + y; };
+  auto eq = [](auto x, auto y) { return x == y; };
+  auto all = [](bool x, bool y) { return x && y; };
+  auto ys = fmap(sq, xs);
+  auto sum = foldMap(id, add, 0, ys);
+  auto rs = fmapFold(sq, id, add, 0, xs);
+  EXPECT_TRUE(foldMap2(eq, all, true, ys, rs.first));
+  EXPECT_EQ(sum, rs.second);
+  auto rs1 = fmapFold(cxx::execution::par, sq, id, std::plus<int>(), 0, xs);
+  EXPECT_TRUE(foldMap2(eq, all, true, ys, rs1.first));
+  EXPECT_EQ(sum, rs1.second);
+
+  // Boundaries have non-unit strides
+  auto bs = boundary(xs, 3);
+  auto rs2 = fmapFold(sq, id, add, 0, bs);
+  EXPECT_TRUE(foldMap2(eq, all, true, fmap(sq, bs), rs2.first));
+  EXPECT_EQ(foldMap(sq, add, 0, bs), rs2.second);
+}
+
+TEST(fun_grid, aligned) {
+  qthread_initialize();
+
+  // Odd sizes, so that rows are padded
+  adt::steprange_t<2> range(adt::index_t<2>{{13, 7}});
+  auto f = [](const auto &x) { return int(adt::sum(x * x)); };
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(f, range);
+  auto axs = iotaMapMulti<aligned_grid2<adt::dummy>>(f, range);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(&axs.head()) % 64);
+  EXPECT_EQ(xs.last(), axs.last());
+
+  auto id = [](auto x) { return x; };
+  auto sq = [](auto x) { return x * x; };
+  auto add = [](auto x, auto y) { return x + y; };
+  auto sum = [&](const auto &ys) { return foldMap(id, add, 0, ys); };
+  EXPECT_EQ(sum(xs), sum(axs));
+  EXPECT_EQ(sum(fmap2(add, xs, fmap(sq, xs))),
+            sum(fmap2(add, axs, fmap(sq, axs))));
+  EXPECT_EQ(sum(fmap(cxx::execution::par, sq, xs)),
+            sum(fmap(cxx::execution::par, sq, axs)));
+  EXPECT_EQ(foldMap(sq, add, 0, xs),
+            foldMap(cxx::execution::par, sq, std::plus<int>(), 0, axs));
+  EXPECT_EQ(sum(fmapFold(sq, id, add, 0, xs).first),
+            fmapFold(sq, id, add, 0, axs).second);
+
+  for (std::ptrdiff_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(sum(boundary(xs, i)), sum(boundary(axs, i)));
+    EXPECT_EQ(sum(boundaryMap([](auto x, auto i) { return -x; }, xs, i)),
+              sum(boundaryMap([](auto x, auto i) { return -x; }, axs, i)));
+  }
+
+  auto lap = [](auto x, auto bdirs, int bm0, int bm1, int bp0, int bp1) {
+    return (bm0 - 2 * x + bp0) + (bm1 - 2 * x + bp1);
+  };
+  auto get = [](auto x, auto i) { return x; };
+  auto bd = [](auto x, auto i) { return x + 1; };
+  auto rs = fmapStencilMulti<2>(
+      lap, get, xs, ~0, boundaryMap(bd, xs, 0), boundaryMap(bd, xs, 2),
+      boundaryMap(bd, xs, 1), boundaryMap(bd, xs, 3));
+  auto ars = fmapStencilMulti<2>(
+      cxx::execution::par, lap, get, axs, ~0, boundaryMap(bd, axs, 0),
+      boundaryMap(bd, axs, 2), boundaryMap(bd, axs, 1),
+      boundaryMap(bd, axs, 3));
+  EXPECT_EQ(sum(rs), sum(ars));
+  EXPECT_EQ(sum(fmap(sq, rs)), sum(fmap(sq, ars)));
+}
+
+namespace {
+template <typename T> std::string serialize(const T &x) {
+  std::stringstream buf;
+  { (cereal::BinaryOutputArchive(buf))(x); }
+  return buf.str();
+}
+
+template <typename T> T deserialize(const std::string &str) {
+  std::stringstream buf(str);
+  T x;
+  { (cereal::BinaryInputArchive(buf))(x); }
+  return x;
+}
+}
+
+TEST(fun_grid, serialize) {
+  std::ptrdiff_t s = 10;
+  auto f = [](const auto &x) { return int(adt::sum(x * x)); };
+  auto eq = [](auto x, auto y) { return x == y; };
+  auto all = [](bool x, bool y) { return x && y; };
+  auto xs = iotaMapMulti<grid3<adt::dummy>>(
+      f, adt::steprange_t<3>(adt::index_t<3>{{s, s, s}}));
+  auto ys = deserialize<grid3<int>>(serialize(xs));
+  EXPECT_TRUE(foldMap2(eq, all, true, xs, ys));
+
+  // Loading into a grid of the same size reuses its storage
+  auto zs = iotaMapMulti<grid3<adt::dummy>>(
+      [](const auto &x) { return 0; },
+      adt::steprange_t<3>(adt::index_t<3>{{s, s, s}}));
+  const int *zptr = &zs.head();
+  {
+    std::stringstream buf(serialize(xs));
+    (cereal::BinaryInputArchive(buf))(zs);
+  }
+  EXPECT_EQ(zptr, &zs.head());
+  EXPECT_TRUE(foldMap2(eq, all, true, xs, zs));
+
+  // Boundaries send only their own points
+  for (std::ptrdiff_t i = 0; i < 6; ++i) {
+    auto bs = boundary(xs, i);
+    auto str = serialize(bs);
+    EXPECT_LT(str.size(), s * s * sizeof(int) + 100);
+    auto cs = deserialize<grid2<int>>(str);
+    EXPECT_EQ(s * s, cs.size());
+    EXPECT_TRUE(foldMap2(eq, all, true, bs, cs));
+  }
+
+  // Padded grids are sent without their padding
+  adt::steprange_t<2> range(adt::index_t<2>{{13, 7}});
+  auto axs = iotaMapMulti<aligned_grid2<adt::dummy>>(f, range);
+  auto str = serialize(axs);
+  EXPECT_EQ(serialize(iotaMapMulti<grid2<adt::dummy>>(f, range)), str);
+  auto ays = deserialize<aligned_grid2<int>>(str);
+  EXPECT_TRUE(foldMap2(eq, all, true, axs, ays));
+
+  EXPECT_TRUE(deserialize<grid2<int>>(serialize(grid2<int>())).empty());
+}
+
 TEST(fun_grid, monad) {
   auto xs = munit<grid3<adt::dummy>>(1);
   auto xss = munit<grid3<adt::dummy>>(xs);
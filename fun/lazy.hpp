@@ -0,0 +1,485 @@
+#ifndef FUN_LAZY_HPP
+#define FUN_LAZY_HPP
+
+#include <fun/grid_decl.hpp>
+
+#include <cxx/execution.hpp>
+#include <cxx/invoke.hpp>
+#include <cxx/utility.hpp>
+
+#include <cereal/types/tuple.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fun {
+
+// Lazy fmap
+//
+// A lazy_fmap is an fmap that has not been evaluated yet: its elements
+// are obtained by applying f to the corresponding elements of its leaf
+// containers xss. fmap, fmap2, and fmap3 on lazy_fmap values only
+// compose functions; the composed function is evaluated in a single
+// traversal of the leaves when the result is consumed by materialize,
+// foldMap, boundaryMap, or fmapStencilMulti.
+//
+//   auto s1 = fmap2(axpy, lazy(s0), lazy(r0), dt / 2); // no traversal
+//   auto r1 = fmapStencilMulti<2>(rhs, face, s1, ...); // one traversal
+//
+// Leaves passed as lvalues are held by reference and need to outlive
+// the expression; rvalues are moved into the expression. All leaves
+// need to have the same container type and shape.
+//
+// Include this header after the declarations of the container types
+// it is used with.
+
+template <typename F, typename... CTs> struct lazy_fmap {
+  static_assert(sizeof...(CTs) > 0, "");
+  static constexpr std::size_t nleaves = sizeof...(CTs);
+  F f;
+  std::tuple<CTs...> xss;
+};
+
+// These function objects live in namespace fun (and not in
+// fun::detail) so that calls to fmap etc. with these objects as
+// arguments find the fun overloads for all container types.
+
+struct lazy_id : std::tuple<> {
+  template <typename T> const T &operator()(const T &x) const { return x; }
+};
+
+// Zip elements into tuples, so that more leaves than fmap3 accepts can
+// be passed to f (see materialize)
+struct lazy_tuple : std::tuple<> {
+  template <typename T, typename T2>
+  std::tuple<T, T2> operator()(const T &x, const T2 &y) const {
+    return std::tuple<T, T2>(x, y);
+  }
+};
+struct lazy_cons : std::tuple<> {
+  template <typename T, typename... Ts>
+  std::tuple<T, Ts...> operator()(const T &x,
+                                  const std::tuple<Ts...> &ys) const {
+    return std::tuple_cat(std::tuple<T>(x), ys);
+  }
+};
+template <typename F> struct lazy_unzip {
+  F f;
+
+  template <typename Archive> void serialize(Archive &ar) { ar(f); }
+
+  template <typename T, typename T2, typename TT, std::size_t... Is>
+  auto call(const T &x, const T2 &y, const TT &zs,
+            std::index_sequence<Is...>) const {
+    return cxx::invoke(f, x, y, std::get<Is>(zs)...);
+  }
+  template <typename T, typename T2, typename... Ts>
+  auto operator()(const T &x, const T2 &y, const std::tuple<Ts...> &zs) const {
+    return call(x, y, zs, std::index_sequence_for<Ts...>());
+  }
+};
+
+namespace detail {
+template <std::size_t... Ns> constexpr std::size_t lazy_offset(std::size_t k) {
+  const std::size_t ns[] = {Ns..., 0};
+  std::size_t offset = 0;
+  for (std::size_t j = 0; j < k; ++j)
+    offset += ns[j];
+  return offset;
+}
+template <std::size_t... Ns> constexpr std::size_t lazy_count(std::size_t k) {
+  const std::size_t ns[] = {Ns..., 0};
+  return ns[k];
+}
+}
+
+// Apply f to the results of the functions es, where es[k] consumes the
+// next Ns[k] arguments. The remaining arguments and the bound arguments
+// args are passed on to f.
+template <typename F, typename Es, typename Ns, typename Args>
+struct lazy_compose;
+template <typename F, typename... Es, std::size_t... Ns, typename... Args>
+struct lazy_compose<F, std::tuple<Es...>, std::index_sequence<Ns...>,
+                    std::tuple<Args...>> {
+  static constexpr std::size_t nleaves =
+      detail::lazy_offset<Ns...>(sizeof...(Ns));
+
+  F f;
+  std::tuple<Es...> es;
+  std::tuple<Args...> args;
+
+  template <typename Archive> void serialize(Archive &ar) { ar(f, es, args); }
+
+  template <std::size_t K, typename XT, std::size_t... Is>
+  decltype(auto) call_e(const XT &xt, std::index_sequence<Is...>) const {
+    return cxx::invoke(std::get<K>(es), std::get<Is>(xt)...);
+  }
+
+  template <typename XT, std::size_t... Ks, std::size_t... Rs,
+            std::size_t... As>
+  auto call(const XT &xt, std::index_sequence<Ks...>,
+            std::index_sequence<Rs...>, std::index_sequence<As...>) const {
+    return cxx::invoke(
+        f,
+        call_e<Ks>(xt, cxx::affine_map<detail::lazy_offset<Ns...>(Ks), 1>(
+                           std::make_index_sequence<detail::lazy_count<Ns...>(
+                               Ks)>()))...,
+        std::get<nleaves + Rs>(xt)..., std::get<As>(args)...);
+  }
+
+  template <typename... Xs> auto operator()(Xs &&... xs) const {
+    static_assert(sizeof...(Xs) >= nleaves, "");
+    return call(std::forward_as_tuple(xs...), std::index_sequence_for<Es...>(),
+                std::make_index_sequence<sizeof...(Xs) - nleaves>(),
+                std::index_sequence_for<Args...>());
+  }
+};
+
+namespace detail {
+template <typename> struct is_lazy_fmap : std::false_type {};
+template <typename F, typename... CTs>
+struct is_lazy_fmap<lazy_fmap<F, CTs...>> : std::true_type {};
+
+template <typename... Es>
+using enable_if_lazy_fmap_t = std::enable_if_t<
+    cxx::all_of_type<is_lazy_fmap<std::decay_t<Es>>::value...>::value>;
+
+template <typename CT>
+using lazy_leaf_t =
+    std::conditional_t<std::is_lvalue_reference<CT>::value,
+                       const std::decay_t<CT> &, std::decay_t<CT>>;
+
+template <typename... CTs>
+using lazy_all_grids = cxx::all_of_type<is_grid<std::decay_t<CTs>>::value...>;
+
+// The function f applied to the elements of the expressions es
+template <typename F, typename Args, typename... Es>
+auto lazy_then(F &&f, Args &&args, Es &&... es) {
+  return lazy_compose<std::decay_t<F>,
+                      std::tuple<decltype(std::decay_t<Es>::f)...>,
+                      std::index_sequence<std::decay_t<Es>::nleaves...>,
+                      std::decay_t<Args>>{
+      std::forward<F>(f), std::make_tuple(std::forward<Es>(es).f...),
+      std::forward<Args>(args)};
+}
+
+template <typename F, typename... CTs>
+lazy_fmap<std::decay_t<F>, CTs...> make_lazy_fmap(F &&f,
+                                                  std::tuple<CTs...> &&xss) {
+  return {std::forward<F>(f), std::move(xss)};
+}
+}
+
+// lazy
+
+template <typename CT, typename L = detail::lazy_leaf_t<CT>>
+lazy_fmap<lazy_id, L> lazy(CT &&xs) {
+  return {lazy_id(), std::tuple<L>(std::forward<CT>(xs))};
+}
+
+// fmap
+
+template <typename F, typename E, typename... Args,
+          detail::enable_if_lazy_fmap_t<E> * = nullptr>
+auto fmap(F &&f, E &&e, Args &&... args) {
+  auto xss = std::forward<E>(e).xss;
+  return detail::make_lazy_fmap(
+      detail::lazy_then(std::forward<F>(f),
+                        std::make_tuple(std::forward<Args>(args)...),
+                        std::forward<E>(e)),
+      std::move(xss));
+}
+
+template <typename F, typename E, typename E2, typename... Args,
+          detail::enable_if_lazy_fmap_t<E, E2> * = nullptr>
+auto fmap2(F &&f, E &&e, E2 &&e2, Args &&... args) {
+  auto xss = std::tuple_cat(std::forward<E>(e).xss, std::forward<E2>(e2).xss);
+  return detail::make_lazy_fmap(
+      detail::lazy_then(std::forward<F>(f),
+                        std::make_tuple(std::forward<Args>(args)...),
+                        std::forward<E>(e), std::forward<E2>(e2)),
+      std::move(xss));
+}
+
+template <typename F, typename E, typename E2, typename E3, typename... Args,
+          detail::enable_if_lazy_fmap_t<E, E2, E3> * = nullptr>
+auto fmap3(F &&f, E &&e, E2 &&e2, E3 &&e3, Args &&... args) {
+  auto xss = std::tuple_cat(std::forward<E>(e).xss, std::forward<E2>(e2).xss,
+                            std::forward<E3>(e3).xss);
+  return detail::make_lazy_fmap(
+      detail::lazy_then(std::forward<F>(f),
+                        std::make_tuple(std::forward<Args>(args)...),
+                        std::forward<E>(e), std::forward<E2>(e2),
+                        std::forward<E3>(e3)),
+      std::move(xss));
+}
+
+// materialize
+//
+// Expressions with up to three leaves are evaluated in a single
+// traversal. Containers provide at most fmap3, so for more leaves, the
+// third and following leaves are first zipped into a container of
+// tuples; this costs one additional traversal per additional leaf.
+
+namespace detail {
+template <typename CT, typename CT2>
+auto lazy_zip(const CT &xs, const CT2 &ys) {
+  return fmap2(lazy_tuple(), xs, ys);
+}
+template <typename CT, typename CT2, typename CT3, typename... CTs,
+          std::enable_if_t<!cxx::is_execution_policy<CT>::value> * = nullptr>
+auto lazy_zip(const CT &xs, const CT2 &ys, const CT3 &zs,
+              const CTs &... wss) {
+  return fmap2(lazy_cons(), xs, lazy_zip(ys, zs, wss...));
+}
+
+template <typename Policy, typename CT, typename CT2,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto lazy_zip(const Policy &policy, const CT &xs, const CT2 &ys) {
+  return fmap2(policy, lazy_tuple(), xs, ys);
+}
+template <typename Policy, typename CT, typename CT2, typename CT3,
+          typename... CTs,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto lazy_zip(const Policy &policy, const CT &xs, const CT2 &ys,
+              const CT3 &zs, const CTs &... wss) {
+  return fmap2(policy, lazy_cons(), xs, lazy_zip(policy, ys, zs, wss...));
+}
+
+template <typename F, typename... CTs, std::size_t... Is>
+auto lazy_materialize(const lazy_fmap<F, CTs...> &e,
+                      std::index_sequence<Is...>) {
+  return fmap3(lazy_unzip<F>{e.f}, std::get<0>(e.xss), std::get<1>(e.xss),
+               lazy_zip(std::get<2 + Is>(e.xss)...));
+}
+template <typename Policy, typename F, typename... CTs, std::size_t... Is>
+auto lazy_materialize(const Policy &policy, const lazy_fmap<F, CTs...> &e,
+                      std::index_sequence<Is...>) {
+  return fmap3(policy, lazy_unzip<F>{e.f}, std::get<0>(e.xss),
+               std::get<1>(e.xss),
+               lazy_zip(policy, std::get<2 + Is>(e.xss)...));
+}
+}
+
+template <typename F, typename CT> auto materialize(const lazy_fmap<F, CT> &e) {
+  return fmap(e.f, std::get<0>(e.xss));
+}
+
+template <typename F, typename CT, typename CT2>
+auto materialize(const lazy_fmap<F, CT, CT2> &e) {
+  return fmap2(e.f, std::get<0>(e.xss), std::get<1>(e.xss));
+}
+
+template <typename F, typename CT, typename CT2, typename CT3>
+auto materialize(const lazy_fmap<F, CT, CT2, CT3> &e) {
+  return fmap3(e.f, std::get<0>(e.xss), std::get<1>(e.xss),
+               std::get<2>(e.xss));
+}
+
+template <typename F, typename CT, typename CT2, typename CT3, typename CT4,
+          typename... CTs>
+auto materialize(const lazy_fmap<F, CT, CT2, CT3, CT4, CTs...> &e) {
+  return detail::lazy_materialize(
+      e, std::make_index_sequence<2 + sizeof...(CTs)>());
+}
+
+template <typename Policy, typename F, typename CT,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto materialize(const Policy &policy, const lazy_fmap<F, CT> &e) {
+  return fmap(policy, e.f, std::get<0>(e.xss));
+}
+
+template <typename Policy, typename F, typename CT, typename CT2,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto materialize(const Policy &policy, const lazy_fmap<F, CT, CT2> &e) {
+  return fmap2(policy, e.f, std::get<0>(e.xss), std::get<1>(e.xss));
+}
+
+template <typename Policy, typename F, typename CT, typename CT2, typename CT3,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto materialize(const Policy &policy, const lazy_fmap<F, CT, CT2, CT3> &e) {
+  return fmap3(policy, e.f, std::get<0>(e.xss), std::get<1>(e.xss),
+               std::get<2>(e.xss));
+}
+
+template <typename Policy, typename F, typename CT, typename CT2, typename CT3,
+          typename CT4, typename... CTs,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr>
+auto materialize(const Policy &policy,
+                 const lazy_fmap<F, CT, CT2, CT3, CT4, CTs...> &e) {
+  return detail::lazy_materialize(
+      policy, e, std::make_index_sequence<2 + sizeof...(CTs)>());
+}
+
+// foldMap
+
+template <typename F, typename Op, typename Z, typename G, typename CT,
+          typename... Args>
+auto foldMap(F &&f, Op &&op, Z &&z, const lazy_fmap<G, CT> &e,
+             Args &&... args) {
+  return foldMap(detail::lazy_then(std::forward<F>(f),
+                                   std::make_tuple(std::forward<Args>(args)...),
+                                   e),
+                 std::forward<Op>(op), std::forward<Z>(z), std::get<0>(e.xss));
+}
+
+template <typename F, typename Op, typename Z, typename G, typename CT,
+          typename CT2, typename... Args>
+auto foldMap(F &&f, Op &&op, Z &&z, const lazy_fmap<G, CT, CT2> &e,
+             Args &&... args) {
+  return foldMap2(
+      detail::lazy_then(std::forward<F>(f),
+                        std::make_tuple(std::forward<Args>(args)...), e),
+      std::forward<Op>(op), std::forward<Z>(z), std::get<0>(e.xss),
+      std::get<1>(e.xss));
+}
+
+template <typename F, typename Op, typename Z, typename G, typename CT,
+          typename CT2, typename CT3, typename... CTs, typename... Args>
+auto foldMap(F &&f, Op &&op, Z &&z, const lazy_fmap<G, CT, CT2, CT3, CTs...> &e,
+             Args &&... args) {
+  return foldMap(std::forward<F>(f), std::forward<Op>(op), std::forward<Z>(z),
+                 materialize(e), std::forward<Args>(args)...);
+}
+
+// boundaryMap
+
+namespace detail {
+template <typename F, typename G, typename CT, typename CT2,
+          std::size_t... Is, typename... Args>
+auto lazy_boundaryMap(std::true_type, F &&f, const lazy_fmap<G, CT, CT2> &e,
+                      std::ptrdiff_t i, std::index_sequence<Is...>,
+                      Args &&... args) {
+  return boundaryMap2(lazy_then(std::forward<F>(f), std::tuple<>(), e),
+                      std::get<0>(e.xss), std::get<1>(e.xss), i,
+                      std::forward<Args>(args)...);
+}
+
+template <typename F, typename G, typename... CTs, std::size_t... Is,
+          typename... Args>
+auto lazy_boundaryMap(std::false_type, F &&f, const lazy_fmap<G, CTs...> &e,
+                      std::ptrdiff_t i, std::index_sequence<Is...>,
+                      Args &&... args) {
+  // Evaluate the expression on the boundaries of the leaves
+  auto be = make_lazy_fmap(G(e.f), std::make_tuple(boundary(
+                                       std::get<Is>(e.xss), i)...));
+  return materialize(fmap(std::forward<F>(f), std::move(be), i,
+                          std::forward<Args>(args)...));
+}
+}
+
+template <typename F, typename G, typename CT, typename... Args>
+auto boundaryMap(F &&f, const lazy_fmap<G, CT> &e, std::ptrdiff_t i,
+                 Args &&... args) {
+  return boundaryMap(detail::lazy_then(std::forward<F>(f), std::tuple<>(), e),
+                     std::get<0>(e.xss), i, std::forward<Args>(args)...);
+}
+
+template <typename F, typename G, typename CT, typename CT2, typename... CTs,
+          typename... Args>
+auto boundaryMap(F &&f, const lazy_fmap<G, CT, CT2, CTs...> &e,
+                 std::ptrdiff_t i, Args &&... args) {
+  constexpr bool fused =
+      sizeof...(CTs) == 0 && detail::lazy_all_grids<CT, CT2>::value;
+  return detail::lazy_boundaryMap(
+      std::integral_constant<bool, fused>(), std::forward<F>(f), e, i,
+      std::make_index_sequence<2 + sizeof...(CTs)>(),
+      std::forward<Args>(args)...);
+}
+
+// fmapStencilMulti
+//
+// The expression is evaluated at each point and at each of its
+// neighbours; this is cheap compared to storing and re-reading an
+// intermediate result. Expressions with more leaves than a stencil
+// supports (two for grids, one for other containers) are materialized
+// first (see materialize).
+
+namespace detail {
+template <std::size_t D, typename Policy, typename F, typename G, typename H,
+          typename CT, typename... Args>
+auto lazy_fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                           const lazy_fmap<H, CT> &e, std::size_t bmask,
+                           Args &&... args) {
+  return fmapStencilMulti<D>(
+      policy, lazy_then(std::forward<F>(f), std::tuple<>(), e),
+      lazy_then(std::forward<G>(g), std::tuple<>(), e), std::get<0>(e.xss),
+      bmask, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename H, typename CT,
+          typename... Args>
+auto lazy_fmapStencilMulti(const cxx::execution::sequenced_policy &, F &&f,
+                           G &&g, const lazy_fmap<H, CT> &e, std::size_t bmask,
+                           Args &&... args) {
+  return fmapStencilMulti<D>(lazy_then(std::forward<F>(f), std::tuple<>(), e),
+                             lazy_then(std::forward<G>(g), std::tuple<>(), e),
+                             std::get<0>(e.xss), bmask,
+                             std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename H,
+          typename CT, typename CT2, typename... Args,
+          std::enable_if_t<lazy_all_grids<CT, CT2>::value> * = nullptr>
+auto lazy_fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                           const lazy_fmap<H, CT, CT2> &e, std::size_t bmask,
+                           Args &&... args) {
+  return fmapStencilMulti2<D>(
+      policy, lazy_then(std::forward<F>(f), std::tuple<>(), e),
+      lazy_then(std::forward<G>(g), std::tuple<>(), e), std::get<0>(e.xss),
+      std::get<1>(e.xss), bmask, std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename H,
+          typename CT, typename CT2, typename... CTs, typename... Args,
+          std::enable_if_t<!(sizeof...(CTs) == 0 &&
+                             lazy_all_grids<CT, CT2>::value)> * = nullptr>
+auto lazy_fmapStencilMulti(const Policy &policy, F &&f, G &&g,
+                           const lazy_fmap<H, CT, CT2, CTs...> &e,
+                           std::size_t bmask, Args &&... args) {
+  return fmapStencilMulti<D>(std::forward<F>(f), std::forward<G>(g),
+                             materialize(policy, e), bmask,
+                             std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename G, typename H, typename CT,
+          typename CT2, typename... CTs, typename... Args,
+          std::enable_if_t<!(sizeof...(CTs) == 0 &&
+                             lazy_all_grids<CT, CT2>::value)> * = nullptr>
+auto lazy_fmapStencilMulti(const cxx::execution::sequenced_policy &, F &&f,
+                           G &&g, const lazy_fmap<H, CT, CT2, CTs...> &e,
+                           std::size_t bmask, Args &&... args) {
+  return fmapStencilMulti<D>(std::forward<F>(f), std::forward<G>(g),
+                             materialize(e), bmask,
+                             std::forward<Args>(args)...);
+}
+}
+
+template <std::size_t D, typename F, typename G, typename E, typename... Args,
+          detail::enable_if_lazy_fmap_t<E> * = nullptr>
+auto fmapStencilMulti(F &&f, G &&g, const E &e, std::size_t bmask,
+                      Args &&... args) {
+  return detail::lazy_fmapStencilMulti<D>(
+      cxx::execution::seq, std::forward<F>(f), std::forward<G>(g), e, bmask,
+      std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename Policy, typename F, typename G, typename E,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          detail::enable_if_lazy_fmap_t<E> * = nullptr>
+auto fmapStencilMulti(const Policy &policy, F &&f, G &&g, const E &e,
+                      std::size_t bmask, Args &&... args) {
+  return detail::lazy_fmapStencilMulti<D>(policy, std::forward<F>(f),
+                                          std::forward<G>(g), e, bmask,
+                                          std::forward<Args>(args)...);
+}
+}
+
+#define FUN_LAZY_HPP_DONE
+#endif // #ifdef FUN_LAZY_HPP
+#ifndef FUN_LAZY_HPP_DONE
+#error "Cyclic include dependency"
+#endif
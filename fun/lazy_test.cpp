@@ -0,0 +1,204 @@
+#include <fun/grid_decl.hpp>
+#include <fun/nested_decl.hpp>
+#include <fun/shared_ptr.hpp>
+#include <fun/vector.hpp>
+
+#include <fun/lazy.hpp>
+
+#include <fun/grid_impl.hpp>
+#include <fun/nested_impl.hpp>
+
+#include <cxx/execution.hpp>
+
+#include <gtest/gtest.h>
+#include <qthread.h>
+
+#include <type_traits>
+
+using namespace fun;
+
+namespace {
+template <typename T> using grid1 = adt::grid<std::vector<adt::dummy>, T, 1>;
+template <typename T> using grid2 = adt::grid<std::vector<adt::dummy>, T, 2>;
+template <typename T>
+using nested1 = adt::nested<std::shared_ptr<adt::dummy>,
+                            adt::grid<std::vector<adt::dummy>, adt::dummy, 1>,
+                            T>;
+
+auto add = [](auto x, auto y) { return x + y; };
+auto axpy = [](auto y, auto x, auto a) { return a * x + y; };
+auto eq = [](auto x, auto y) { return x == y; };
+auto all = [](bool x, bool y) { return x && y; };
+}
+
+TEST(fun_lazy, fmap) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &i) { return double(adt::sum(i)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto ys = fmap([](auto x) { return x * x; }, xs);
+
+  auto es = fmap([](auto x) { return x + 1; },
+                 fmap2(axpy, lazy(xs), lazy(ys), 2.0));
+  auto rs = materialize(es);
+  static_assert(std::is_same<decltype(rs), grid2<double>>::value, "");
+  auto rs0 = fmap([](auto x) { return x + 1; }, fmap2(axpy, xs, ys, 2.0));
+  EXPECT_TRUE(foldMap2(eq, all, true, rs, rs0));
+  auto rs1 = materialize(cxx::execution::par, es);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs1, rs0));
+
+  // rvalue leaves are owned by the expression
+  auto es2 = fmap3([](auto x, auto y, auto z) { return x + y + z; },
+                   lazy(fmap([](auto x) { return 2 * x; }, xs)), lazy(ys),
+                   fmap([](auto y) { return -y; }, lazy(ys)));
+  auto rs2 = materialize(es2);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs2, fmap2(add, xs, xs)));
+
+  // more leaves than fmap3 accepts
+  auto es4 = fmap2(add, fmap2(add, lazy(xs), lazy(ys)),
+                   fmap2(add, lazy(xs), lazy(ys)));
+  static_assert(decltype(es4)::nleaves == 4, "");
+  auto rs4 = materialize(es4);
+  static_assert(std::is_same<decltype(rs4), grid2<double>>::value, "");
+  auto rs40 = fmap([](auto x) { return 2 * x; }, fmap2(add, xs, ys));
+  EXPECT_TRUE(foldMap2(eq, all, true, rs4, rs40));
+  auto es5 = fmap3([](auto x, auto y, auto z) { return x + y - z; }, es4,
+                   lazy(xs), fmap2(add, lazy(xs), lazy(xs)));
+  static_assert(decltype(es5)::nleaves == 7, "");
+  auto rs5 = materialize(cxx::execution::par, es5);
+  auto rs50 = fmap2([](auto x, auto y) { return x - y; }, rs40, xs);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs5, rs50));
+  EXPECT_TRUE(foldMap2(eq, all, true, materialize(es5), rs5));
+}
+
+TEST(fun_lazy, foldMap) {
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &i) { return int(i[0]); },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto sum1 = foldMap([](auto x) { return x; }, add, 0,
+                      fmap([](auto x) { return 2 * x; }, lazy(xs)));
+  EXPECT_EQ(90, sum1);
+  auto sum2 =
+      foldMap([](auto x, auto a) { return a * x; }, add, 0,
+              fmap2(add, lazy(xs), fmap([](auto x) { return 1; }, lazy(xs))),
+              2);
+  EXPECT_EQ(110, sum2);
+  auto sum3 = foldMap([](auto x) { return x; }, add, 0,
+                      fmap3([](auto x, auto y, auto z) { return x + y + z; },
+                            lazy(xs), lazy(xs), lazy(xs)));
+  EXPECT_EQ(135, sum3);
+  auto sum4 = foldMap([](auto x) { return x; }, add, 0,
+                      fmap2(add, fmap2(add, lazy(xs), lazy(xs)),
+                            fmap2(add, lazy(xs), lazy(xs))));
+  EXPECT_EQ(180, sum4);
+}
+
+TEST(fun_lazy, boundaryMap) {
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &i) { return int(adt::sum(i * i)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto ys = fmap([](auto x) { return x + 1; }, xs);
+  auto es = fmap2(add, lazy(xs), lazy(ys));
+  auto zs = materialize(es);
+  for (std::ptrdiff_t f = 0; f < 4; ++f) {
+    auto bs = boundaryMap([](auto x, auto f) { return x + f; }, es, f);
+    auto bs0 = boundaryMap([](auto x, auto f) { return x + f; }, zs, f);
+    EXPECT_TRUE(foldMap2(eq, all, true, bs, bs0));
+    auto cs = boundaryMap([](auto x, auto f) { return x + f; }, lazy(xs), f);
+    auto cs0 = boundaryMap([](auto x, auto f) { return x + f; }, xs, f);
+    EXPECT_TRUE(foldMap2(eq, all, true, cs, cs0));
+  }
+  auto es4 = fmap2(add, es, es);
+  auto zs4 = materialize(es4);
+  for (std::ptrdiff_t f = 0; f < 4; ++f) {
+    auto bs = boundaryMap([](auto x, auto f) { return x + f; }, es4, f);
+    auto bs0 = boundaryMap([](auto x, auto f) { return x + f; }, zs4, f);
+    EXPECT_TRUE(foldMap2(eq, all, true, bs, bs0));
+  }
+}
+
+TEST(fun_lazy, fmapStencil) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(
+      [](const auto &i) { return int(adt::sum(i * i)); },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  auto ys = fmap([](auto x) { return 3 * x; }, xs);
+  auto lap = [](auto x, auto bdirs, auto bm0, auto bm1, auto bp0, auto bp1) {
+    return (bm0 - 2 * x + bp0) + (bm1 - 2 * x + bp1);
+  };
+  auto get = [](auto x, auto i) { return x; };
+  auto bm = iotaMapMulti<grid1<adt::dummy>>(
+      [](const auto &i) { return int(i[0]); },
+      adt::steprange_t<1>(adt::index_t<1>{{s}}));
+  auto bp = fmap([](auto x) { return x + 1; }, bm);
+
+  // one leaf
+  auto es1 = fmap([](auto x) { return x + 1; }, lazy(xs));
+  auto rs1 = fmapStencilMulti<2>(lap, get, es1, ~0, bm, bm, bp, bp);
+  auto rs10 =
+      fmapStencilMulti<2>(lap, get, materialize(es1), ~0, bm, bm, bp, bp);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs1, rs10));
+
+  // two leaves
+  auto es2 = fmap2(axpy, lazy(xs), lazy(ys), 2);
+  auto rs2 = fmapStencilMulti<2>(cxx::execution::par, lap, get, es2, ~0, bm,
+                                 bm, bp, bp);
+  auto rs20 =
+      fmapStencilMulti<2>(lap, get, materialize(es2), ~0, bm, bm, bp, bp);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs2, rs20));
+
+  // three leaves
+  auto es3 = fmap3([](auto x, auto y, auto z) { return x + y - z; }, lazy(xs),
+                   lazy(ys), lazy(xs));
+  auto rs3 = fmapStencilMulti<2>(lap, get, es3, ~0, bm, bm, bp, bp);
+  auto rs30 = fmapStencilMulti<2>(lap, get, ys, ~0, bm, bm, bp, bp);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs3, rs30));
+
+  // four leaves
+  auto es4 = fmap2([](auto x, auto y) { return x - y; }, es3, es1);
+  auto rs4 = fmapStencilMulti<2>(cxx::execution::par, lap, get, es4, ~0, bm,
+                                 bm, bp, bp);
+  auto rs40 =
+      fmapStencilMulti<2>(lap, get, materialize(es4), ~0, bm, bm, bp, bp);
+  EXPECT_TRUE(foldMap2(eq, all, true, rs4, rs40));
+}
+
+TEST(fun_lazy, nested) {
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMap<nested1<adt::dummy>>([](int x) { return x * x; }, s);
+  auto ys = fmap([](auto x) { return x + 1; }, xs);
+
+  auto es1 = fmap([](auto x) { return 2 * x; }, lazy(xs));
+  auto es2 = fmap2(add, lazy(xs), lazy(ys));
+  auto zs1 = materialize(es1);
+  auto zs2 = materialize(es2);
+  static_assert(std::is_same<decltype(zs2), nested1<int>>::value, "");
+  EXPECT_EQ(foldMap([](auto x) { return x; }, add, 0, zs2),
+            foldMap([](auto x) { return x; }, add, 0, es2));
+
+  auto b0 = boundaryMap([](auto x, auto f) { return x; }, es2, 0);
+  auto b1 = boundaryMap([](auto x, auto f) { return x; }, es2, 1);
+  EXPECT_EQ(1, mextract(b0));
+  EXPECT_EQ(2 * (s - 1) * (s - 1) + 1, mextract(b1));
+
+  auto lap = [](auto x, auto bdirs, auto bm, auto bp) {
+    return bm - 2 * x + bp;
+  };
+  auto get = [](auto x, auto i) { return x; };
+  auto bm = boundaryMap([](auto x, auto f) { return x; }, xs, 0);
+  auto bp = boundaryMap([](auto x, auto f) { return x; }, xs, 1);
+  auto rs1 = fmapStencilMulti<1>(lap, get, es1, ~0, bm, bp);
+  auto rs10 = fmapStencilMulti<1>(lap, get, zs1, ~0, bm, bp);
+  EXPECT_EQ(foldMap([](auto x) { return x; }, add, 0, rs10),
+            foldMap([](auto x) { return x; }, add, 0, rs1));
+  auto rs2 = fmapStencilMulti<1>(lap, get, es2, ~0, bm, bp);
+  auto rs20 = fmapStencilMulti<1>(lap, get, zs2, ~0, bm, bp);
+  EXPECT_EQ(foldMap([](auto x) { return x; }, add, 0, rs20),
+            foldMap([](auto x) { return x; }, add, 0, rs2));
+}
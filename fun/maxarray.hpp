@@ -6,6 +6,7 @@
 #include <adt/dummy.hpp>
 #include <adt/index.hpp>
 #include <cxx/cassert.hpp>
+#include <fun/fold.hpp>
 #include <fun/fun_decl.hpp>
 #include <fun/idtype.hpp>
 
@@ -279,35 +280,20 @@ template <typename F, typename Op, typename Z, typename T, std::size_t N,
 R foldMap(F &&f, Op &&op, Z &&z, const adt::maxarray<T, N> &xs,
           Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
-  std::ptrdiff_t s = xs.size();
-  R r(std::forward<Z>(z));
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], args...));
-  return r;
+  return detail::fold_range(op, R(std::forward<Z>(z)), xs.size(),
+                            [&](std::ptrdiff_t i) {
+                              return cxx::invoke(f, xs[i], args...);
+                            });
 }
 
 template <typename F, typename Op, typename Z, typename T, std::size_t N,
           typename... Args, typename R = cxx::invoke_of_t<F &&, T, Args &&...>>
 R foldMap(F &&f, Op &&op, Z &&z, adt::maxarray<T, N> &&xs, Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
-  std::ptrdiff_t s = xs.size();
-  R r(std::forward<Z>(z));
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r),
-                    cxx::invoke(f, std::move(xs[i]), args...));
-  return r;
+  return detail::fold_range(op, R(std::forward<Z>(z)), xs.size(),
+                            [&](std::ptrdiff_t i) {
+                              return cxx::invoke(f, std::move(xs[i]), args...);
+                            });
 }
 
 template <typename F, typename Op, typename Z, typename T, std::size_t N,
@@ -316,18 +302,33 @@ template <typename F, typename Op, typename Z, typename T, std::size_t N,
 R foldMap2(F &&f, Op &&op, Z &&z, const adt::maxarray<T, N> &xs,
            const adt::maxarray<T2, N2> &ys, Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  cxx_assert(ys.size() == xs.size());
+  return detail::fold_range(op, R(std::forward<Z>(z)), xs.size(),
+                            [&](std::ptrdiff_t i) {
+                              return cxx::invoke(f, xs[i], ys[i], args...);
+                            });
+}
+
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename T, std::size_t N,
+          typename... Args, typename C = adt::maxarray<T, N>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const adt::maxarray<T, N> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
   std::ptrdiff_t s = xs.size();
-  cxx_assert(std::ptrdiff_t(ys.size()) == s);
-  R r(std::forward<Z>(z));
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], ys[i], args...));
-  return r;
+  CR rs(s);
+  S r = detail::fold_range(op, S(std::forward<Z>(z)), s,
+                           [&](std::ptrdiff_t i) {
+                             auto y = cxx::invoke(f, xs[i], args...);
+                             rs[i] = std::move(y.first);
+                             return std::move(y.second);
+                           });
+  return {std::move(rs), std::move(r)};
 }
 
 // dump
@@ -351,8 +352,8 @@ template <typename C, typename T,
           typename CR = typename fun_traits<C>::template constructor<R>>
 constexpr CR munit(T &&x) {
   static_assert(fun_traits<CR>::max_size() > 0, "");
-  CR rs(1);
-  rs[0] = std::forward<T>(x);
+  CR rs;
+  rs.push_back(std::forward<T>(x));
   return rs;
 }
 
@@ -362,12 +363,9 @@ template <typename T, std::size_t N, std::size_t N2,
           typename CT = adt::maxarray<T, N>>
 CT mjoin(const adt::maxarray<adt::maxarray<T, N>, N2> &xss) {
   CT rs;
-  std::size_t s = 0;
-  for (const auto &xs : xss) {
-    std::copy(xs.begin(), xs.end(), rs.end());
-    s += xs.size();
-  }
-  rs.resize(s);
+  for (const auto &xs : xss)
+    for (const auto &x : xs)
+      rs.push_back(x);
   return rs;
 }
 
@@ -375,12 +373,9 @@ template <typename T, std::size_t N, std::size_t N2,
           typename CT = adt::maxarray<T, N>>
 CT mjoin(adt::maxarray<adt::maxarray<T, N>, N2> &&xss) {
   CT rs;
-  std::size_t s = 0;
-  for (const auto &xs : xss) {
-    std::move(xs.begin(), xs.end(), rs.end());
-    s += xs.size();
-  }
-  rs.resize(s);
+  for (auto &xs : xss)
+    for (auto &x : xs)
+      rs.push_back(std::move(x));
   return rs;
 }
 
@@ -443,10 +438,9 @@ template <typename T, std::size_t N, typename... Ts, std::size_t... Ns,
           typename CT = adt::maxarray<T, N>>
 CT mplus(const adt::maxarray<T, N> &xs, const adt::maxarray<Ts, Ns> &... xss) {
   CT rs;
-  for (auto pxs : std::initializer_list<const CT *>{&xs, &xss...}) {
-    std::copy(pxs->begin(), pxs->end(), rs.end());
-    rs.resize(rs.size() + pxs->size());
-  }
+  for (auto pxs : std::initializer_list<const CT *>{&xs, &xss...})
+    for (const auto &x : *pxs)
+      rs.push_back(x);
   return rs;
 }
 
@@ -454,10 +448,9 @@ template <typename T, std::size_t N, typename... Ts, std::size_t... Ns,
           typename CT = adt::maxarray<T, N>>
 CT mplus(adt::maxarray<T, N> &&xs, adt::maxarray<Ts, Ns> &&... xss) {
   CT rs;
-  for (auto pxs : std::initializer_list<const CT *>{&xs, &xss...}) {
-    std::move(pxs->begin(), pxs->end(), rs.end());
-    rs.resize(rs.size() + pxs->size());
-  }
+  for (auto pxs : std::initializer_list<CT *>{&xs, &xss...})
+    for (auto &x : *pxs)
+      rs.push_back(std::move(x));
   return rs;
 }
 
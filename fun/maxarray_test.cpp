@@ -105,6 +105,18 @@ TEST(fun_maxarray, foldMap) {
   EXPECT_EQ((s - 1) * s * (2 * s - 1) / 6, sum_sq);
 }
 
+TEST(fun_maxarray, fmapFold) {
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMap<adt_maxarray<adt::dummy>>([](auto x) { return int(x); }, s);
+  auto rs = fmapFold([](auto x) { return x * x; }, [](auto x) { return x; },
+                     [](auto x, auto y) { return x + y; }, 0, xs);
+  static_assert(std::is_same<decltype(rs.first), adt_maxarray<int>>::value,
+                "");
+  EXPECT_EQ(s, rs.first.size());
+  EXPECT_EQ((s - 1) * (s - 1), last(rs.first));
+  EXPECT_EQ((s - 1) * s * (2 * s - 1) / 6, rs.second);
+}
+
 TEST(fun_maxarray, monad) {
   auto x1 = munit<adt_maxarray<adt::dummy>>(1);
   static_assert(std::is_same<decltype(x1), adt_maxarray<int>>::value, "");
@@ -8,6 +8,7 @@
 #include <cxx/invoke.hpp>
 #include <fun/fun_decl.hpp>
 
+#include <array>
 #include <cstddef>
 #include <type_traits>
 #include <utility>
@@ -53,6 +54,13 @@ struct fun_traits<adt::nested<P, A, T, Policy>> {
   }
 };
 
+namespace detail {
+template <typename P, typename A, typename T, typename Policy>
+struct is_placeable<adt::nested<P, A, T, Policy>>
+    : std::integral_constant<bool, is_placeable<P>::value ||
+                                       is_placeable<A>::value> {};
+}
+
 // iotaMap
 
 template <typename C, typename F, typename... Args,
@@ -91,6 +99,55 @@ CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
                          std::forward<Args>(args)...);
 }
 
+// iotaMap, iotaMapMulti with a placement, which is passed on to the
+// inner and outer containers
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_nested<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<std::decay_t<F>, std::ptrdiff_t,
+                                        std::decay_t<Args>...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(const typename CR::policy_type &policy, const Placement &placement,
+           F &&f, const adt::irange_t &inds, Args &&... args);
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_nested<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<std::decay_t<F>, std::ptrdiff_t,
+                                        std::decay_t<Args>...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(const Placement &placement, F &&f, const adt::irange_t &inds,
+           Args &&... args) {
+  return iotaMap<C>(typename CR::policy_type(), placement, std::forward<F>(f),
+                    inds, std::forward<Args>(args)...);
+}
+
+template <
+    typename C, typename Placement, std::size_t D, typename F,
+    typename... Args,
+    std::enable_if_t<detail::is_nested<C>::value &&
+                     detail::is_placement<Placement>::value> * = nullptr,
+    typename R = cxx::invoke_of_t<F &&, const adt::index_t<D> &, Args &&...>,
+    typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const typename CR::policy_type &policy,
+                const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args);
+
+template <
+    typename C, typename Placement, std::size_t D, typename F,
+    typename... Args,
+    std::enable_if_t<detail::is_nested<C>::value &&
+                     detail::is_placement<Placement>::value> * = nullptr,
+    typename R = cxx::invoke_of_t<F &&, const adt::index_t<D> &, Args &&...>,
+    typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  return iotaMapMulti<C>(typename CR::policy_type(), placement,
+                         std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+
 // fmap
 
 template <typename F, typename P, typename A, typename T, typename Policy,
@@ -99,6 +156,12 @@ template <typename F, typename P, typename A, typename T, typename Policy,
           typename CR = typename fun_traits<C>::template constructor<R>>
 CR fmap(F &&f, const adt::nested<P, A, T, Policy> &xss, Args &&... args);
 
+template <typename F, typename P, typename A, typename T, typename Policy,
+          typename... Args, typename C = adt::nested<P, A, T, Policy>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR fmap(F &&f, adt::nested<P, A, T, Policy> &&xss, Args &&... args);
+
 template <typename F, typename P, typename A, typename T, typename Policy,
           typename T2, typename Policy2, typename... Args,
           typename C = adt::nested<P, A, T, Policy>,
@@ -107,6 +170,14 @@ template <typename F, typename P, typename A, typename T, typename Policy,
 CR fmap2(F &&f, const adt::nested<P, A, T, Policy> &xss,
          const adt::nested<P, A, T2, Policy2> &yss, Args &&... args);
 
+template <typename F, typename P, typename A, typename T, typename Policy,
+          typename T2, typename Policy2, typename... Args,
+          typename C = adt::nested<P, A, T, Policy>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR fmap2(F &&f, adt::nested<P, A, T, Policy> &&xss,
+         const adt::nested<P, A, T2, Policy2> &yss, Args &&... args);
+
 template <typename F, typename P, typename A, typename T, typename Policy,
           typename T2, typename Policy2, typename T3, typename Policy3,
           typename... Args, typename C = adt::nested<P, A, T, Policy>,
@@ -163,13 +234,62 @@ CR fmapStencilMulti(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
                     const std::decay_t<BCB> &bm1, const std::decay_t<BCB> &bp0,
                     const std::decay_t<BCB> &bp1, Args &&... args);
 
+template <std::size_t D, std::size_t K, typename F, typename G, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 1> * = nullptr,
+          typename CT = adt::nested<P, A, T, Policy>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R = cxx::invoke_of_t<F, T, std::size_t, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args);
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 2> * = nullptr,
+          typename CT = adt::nested<P, A, T, Policy>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename B = std::decay_t<cxx::invoke_of_t<G, T, std::ptrdiff_t>>,
+          typename BK = std::array<B, K>,
+          typename BCB = typename fun_traits<BC>::template constructor<BK>,
+          typename R =
+              cxx::invoke_of_t<F, T, std::size_t, BK, BK, BK, BK, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args);
+
+// iterateStencil: Leaves are usually small enough to be cache-sized
+// tiles already. Blocking several steps across leaves would need the
+// diagonal neighbours of each leaf, so the steps are taken one by one.
+
+template <std::size_t D, typename F, typename G, typename H, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 1> * = nullptr>
+adt::nested<P, A, T, Policy>
+iterateStencil(F &&f, G &&g, H &&h, const adt::nested<P, A, T, Policy> &xss,
+               std::size_t bmask, std::ptrdiff_t nsteps, Args &&... args);
+
+template <std::size_t D, typename F, typename G, typename H, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 2> * = nullptr>
+adt::nested<P, A, T, Policy>
+iterateStencil(F &&f, G &&g, H &&h, const adt::nested<P, A, T, Policy> &xss,
+               std::size_t bmask, std::ptrdiff_t nsteps, Args &&... args);
+
 // head, last
 
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) head(const adt::nested<P, A, T, Policy> &xss);
+T head(const adt::nested<P, A, T, Policy> &xss);
 
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) last(const adt::nested<P, A, T, Policy> &xss);
+T last(const adt::nested<P, A, T, Policy> &xss);
 
 // boundary
 
@@ -189,6 +309,16 @@ template <typename F, typename P, typename A, typename T, typename Policy,
 BCR boundaryMap(F &&f, const adt::nested<P, A, T, Policy> &xs, std::ptrdiff_t i,
                 Args &&... args);
 
+template <std::size_t K, typename F, typename P, typename A, typename T,
+          typename Policy, typename... Args,
+          typename CT = adt::nested<P, A, T, Policy>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename R = cxx::invoke_of_t<F, T, std::ptrdiff_t, Args...>,
+          typename BCR =
+              typename fun_traits<BC>::template constructor<std::array<R, K>>>
+BCR boundaryMapWide(F &&f, const adt::nested<P, A, T, Policy> &xs,
+                    std::ptrdiff_t i, Args &&... args);
+
 // indexing
 
 template <typename P, typename A, typename T, typename Policy>
@@ -212,6 +342,19 @@ template <typename F, typename Op, typename Z, typename P, typename A,
 R foldMap2(F &&f, Op &&op, Z &&z, const adt::nested<P, A, T, Policy> &xss,
            const adt::nested<P, A, T2, Policy2> &yss, Args &&... args);
 
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename P, typename A,
+          typename T, typename Policy, typename... Args,
+          typename C = adt::nested<P, A, T, Policy>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const adt::nested<P, A, T, Policy> &xss,
+                              Args &&... args);
+
 // dump
 
 template <typename P, typename A, typename T, typename Policy>
@@ -247,7 +390,7 @@ CR mbind(F &&f, const adt::nested<P, A, T, Policy> &xss, Args &&... args);
 // mextract
 
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) mextract(const adt::nested<P, A, T, Policy> &xss);
+T mextract(const adt::nested<P, A, T, Policy> &xss);
 
 // mfoldMap
 
@@ -346,6 +346,104 @@ CR iotaMapMulti(const typename CR::policy_type &policy, F &&f,
             policy};
 }
 
+// iotaMap, iotaMapMulti with a placement
+
+namespace detail {
+// Pass the placement on to containers that accept one
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<is_placeable<C>::value> * = nullptr>
+auto nested_place_iotaMap(const Placement &placement, F &&f,
+                          const adt::irange_t &inds, Args &&... args) {
+  return iotaMap<C>(placement, std::forward<F>(f), inds,
+                    std::forward<Args>(args)...);
+}
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<!is_placeable<C>::value> * = nullptr>
+auto nested_place_iotaMap(const Placement &placement, F &&f,
+                          const adt::irange_t &inds, Args &&... args) {
+  return iotaMap<C>(std::forward<F>(f), inds, std::forward<Args>(args)...);
+}
+
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<is_placeable<C>::value> * = nullptr>
+auto nested_place_iotaMapMulti(const Placement &placement, F &&f,
+                               const adt::steprange_t<D> &inds,
+                               Args &&... args) {
+  return iotaMapMulti<C>(placement, std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<!is_placeable<C>::value> * = nullptr>
+auto nested_place_iotaMapMulti(const Placement &placement, F &&f,
+                               const adt::steprange_t<D> &inds,
+                               Args &&... args) {
+  return iotaMapMulti<C>(std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+
+template <typename CR> struct nested_iotaMap_placed : std::tuple<> {
+  template <typename Placement, typename F, typename... Args>
+  auto operator()(std::ptrdiff_t i, const adt::irange_t &inds,
+                  const adt::irange_t &oinds, const Placement &placement,
+                  F &&f, Args &&... args) const {
+    typedef typename CR::pointer_dummy P;
+    typedef typename CR::array_dummy A;
+    auto iinds = nested_calc_inner_inds<P, A>(inds, oinds, i);
+    return nested_place_iotaMap<A>(placement, std::forward<F>(f), iinds,
+                                   std::forward<Args>(args)...);
+  }
+};
+
+template <typename CR> struct nested_iotaMapMulti_placed : std::tuple<> {
+  template <std::size_t D, typename Placement, typename F, typename... Args>
+  auto operator()(const adt::index_t<D> &i, const adt::steprange_t<D> &inds,
+                  const adt::steprange_t<D> &oinds, const Placement &placement,
+                  F &&f, Args &&... args) const {
+    typedef typename CR::pointer_dummy P;
+    typedef typename CR::array_dummy A;
+    auto iinds = nested_calc_inner_range<P, A>(inds, oinds, i);
+    return nested_place_iotaMapMulti<A>(placement, std::forward<F>(f), iinds,
+                                        std::forward<Args>(args)...);
+  }
+};
+}
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_nested<C>::value &&
+                           detail::is_placement<Placement>::value> *,
+          typename R, typename CR>
+CR iotaMap(const typename CR::policy_type &policy, const Placement &placement,
+           F &&f, const adt::irange_t &inds, Args &&... args) {
+  typedef typename C::pointer_dummy P;
+  typedef typename C::array_dummy A;
+  auto oinds = detail::nested_calc_outer_inds<P, A>(inds);
+  auto pl = placement.bind(inds);
+  return CR{detail::nested_place_iotaMap<P>(
+                pl, detail::nested_iotaMap_placed<CR>(), oinds, inds, oinds,
+                pl, std::forward<F>(f), std::forward<Args>(args)...),
+            policy};
+}
+
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_nested<C>::value &&
+                           detail::is_placement<Placement>::value> *,
+          typename R, typename CR>
+CR iotaMapMulti(const typename CR::policy_type &policy,
+                const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  typedef typename C::pointer_dummy P;
+  typedef typename C::array_dummy A;
+  auto oinds = detail::nested_calc_outer_range<P, A>(inds);
+  auto pl = placement.bind(inds);
+  return CR{detail::nested_place_iotaMapMulti<P>(
+                pl, detail::nested_iotaMapMulti_placed<CR>(), oinds, inds,
+                oinds, pl, std::forward<F>(f), std::forward<Args>(args)...),
+            policy};
+}
+
 // fmap
 
 namespace detail {
@@ -366,6 +464,16 @@ CR fmap(F &&f, const adt::nested<P, A, T, Policy> &xss, Args &&... args) {
             typename CR::policy_type(xss.get_policy())};
 }
 
+// The storage of xss is reused if it is not shared
+template <typename F, typename P, typename A, typename T, typename Policy,
+          typename... Args, typename C, typename R, typename CR>
+CR fmap(F &&f, adt::nested<P, A, T, Policy> &&xss, Args &&... args) {
+  typename CR::policy_type policy(xss.get_policy());
+  return CR{fmap(detail::nested_fmap(), std::move(xss.data),
+                 std::forward<F>(f), std::forward<Args>(args)...),
+            policy};
+}
+
 namespace detail {
 struct nested_fmap2 : std::tuple<> {
   template <typename AT, typename AT2, typename F, typename... Args>
@@ -386,6 +494,17 @@ CR fmap2(F &&f, const adt::nested<P, A, T, Policy> &xss,
             typename CR::policy_type(xss.get_policy())};
 }
 
+template <typename F, typename P, typename A, typename T, typename Policy,
+          typename T2, typename Policy2, typename... Args, typename C,
+          typename R, typename CR>
+CR fmap2(F &&f, adt::nested<P, A, T, Policy> &&xss,
+         const adt::nested<P, A, T2, Policy2> &yss, Args &&... args) {
+  typename CR::policy_type policy(xss.get_policy());
+  return CR{fmap2(detail::nested_fmap2(), std::move(xss.data), yss.data,
+                  std::forward<F>(f), std::forward<Args>(args)...),
+            policy};
+}
+
 namespace detail {
 struct nested_fmap3 : std::tuple<> {
   template <typename AT, typename AT2, typename AT3, typename F,
@@ -425,10 +544,10 @@ struct nested_fmapStencil_f : std::tuple<> {
 template <typename G> struct nested_fmapStencil_g {
   G g;
   template <typename Archive> void serialize(Archive &ar) { ar(g); }
+  // Only the boundary value is calculated where xs lives, and only
+  // this value is transferred
   template <typename AT> auto operator()(AT &&xs, std::ptrdiff_t i) const {
-    // TODO: This is slow; call boundaryMap instead
-    return i == 0 ? cxx::invoke(g, head(std::forward<AT>(xs)), i)
-                  : cxx::invoke(g, last(std::forward<AT>(xs)), i);
+    return mextract(boundaryMap(g, std::forward<AT>(xs), i));
   }
 };
 }
@@ -552,6 +671,118 @@ CR fmapStencilMulti(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
             typename CR::policy_type(xss.get_policy())};
 }
 
+// fmapStencilMultiWide
+
+// The outer container passes the neighbouring blocks' boundaries, of
+// which nested_fmapStencilMultiWide_g takes K layers, on to the
+// inner stencils
+
+namespace detail {
+template <std::size_t, std::size_t> struct nested_fmapStencilMultiWide_f;
+template <std::size_t K, typename G> struct nested_fmapStencilMultiWide_g {
+  G g;
+  template <typename Archive> void serialize(Archive &ar) { ar(g); }
+  template <typename AT> auto operator()(AT &&xs, std::ptrdiff_t i) const {
+    return boundaryMapWide<K>(g, std::forward<AT>(xs), i);
+  }
+};
+}
+
+namespace detail {
+template <std::size_t K>
+struct nested_fmapStencilMultiWide_f<1, K> : std::tuple<> {
+  template <typename AT, typename BM0, typename BP0, typename F, typename G,
+            typename... Args>
+  auto operator()(AT &&xs, std::size_t bmask, BM0 &&bm0, BP0 &&bp0, F &&f,
+                  G &&g, Args &&... args) const {
+    return fmapStencilMultiWide<1, K>(
+        std::forward<F>(f), std::forward<G>(g), std::forward<AT>(xs), bmask,
+        std::forward<BM0>(bm0), std::forward<BP0>(bp0),
+        std::forward<Args>(args)...);
+  }
+};
+}
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 1> *, typename CT, typename BC, typename B,
+          typename BK, typename BCB, typename R, typename CR>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bp0, Args &&... args) {
+  return CR{
+      fmapStencilMulti<D>(
+          detail::nested_fmapStencilMultiWide_f<D, K>(),
+          detail::nested_fmapStencilMultiWide_g<K, std::decay_t<G>>{g},
+          xss.data, bmask, bm0.data, bp0.data, std::forward<F>(f), g,
+          std::forward<Args>(args)...),
+      typename CR::policy_type(xss.get_policy())};
+}
+
+namespace detail {
+template <std::size_t K>
+struct nested_fmapStencilMultiWide_f<2, K> : std::tuple<> {
+  template <typename AT, typename BM0, typename BM1, typename BP0, typename BP1,
+            typename F, typename G, typename... Args>
+  auto operator()(AT &&xs, std::size_t bmask, BM0 &&bm0, BM1 &&bm1, BP0 &&bp0,
+                  BP1 &&bp1, F &&f, G &&g, Args &&... args) const {
+    return fmapStencilMultiWide<2, K>(
+        std::forward<F>(f), std::forward<G>(g), std::forward<AT>(xs), bmask,
+        std::forward<BM0>(bm0), std::forward<BM1>(bm1), std::forward<BP0>(bp0),
+        std::forward<BP1>(bp1), std::forward<Args>(args)...);
+  }
+};
+}
+
+template <std::size_t D, std::size_t K, typename F, typename G, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 2> *, typename CT, typename BC, typename B,
+          typename BK, typename BCB, typename R, typename CR>
+CR fmapStencilMultiWide(F &&f, G &&g, const adt::nested<P, A, T, Policy> &xss,
+                        std::size_t bmask, const std::decay_t<BCB> &bm0,
+                        const std::decay_t<BCB> &bm1,
+                        const std::decay_t<BCB> &bp0,
+                        const std::decay_t<BCB> &bp1, Args &&... args) {
+  return CR{
+      fmapStencilMulti<D>(
+          detail::nested_fmapStencilMultiWide_f<D, K>(),
+          detail::nested_fmapStencilMultiWide_g<K, std::decay_t<G>>{g},
+          xss.data, bmask, bm0.data, bm1.data, bp0.data, bp1.data,
+          std::forward<F>(f), g, std::forward<Args>(args)...),
+      typename CR::policy_type(xss.get_policy())};
+}
+
+// iterateStencil
+
+template <std::size_t D, typename F, typename G, typename H, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 1> *>
+adt::nested<P, A, T, Policy>
+iterateStencil(F &&f, G &&g, H &&h, const adt::nested<P, A, T, Policy> &xss,
+               std::size_t bmask, std::ptrdiff_t nsteps, Args &&... args) {
+  cxx_assert(nsteps >= 0);
+  auto yss = xss;
+  for (std::ptrdiff_t n = 0; n < nsteps; ++n)
+    yss = fmapStencilMulti<D>(f, g, yss, bmask, boundaryMap(h, yss, 0),
+                              boundaryMap(h, yss, 1), args...);
+  return yss;
+}
+
+template <std::size_t D, typename F, typename G, typename H, typename P,
+          typename A, typename T, typename Policy, typename... Args,
+          std::enable_if_t<D == 2> *>
+adt::nested<P, A, T, Policy>
+iterateStencil(F &&f, G &&g, H &&h, const adt::nested<P, A, T, Policy> &xss,
+               std::size_t bmask, std::ptrdiff_t nsteps, Args &&... args) {
+  cxx_assert(nsteps >= 0);
+  auto yss = xss;
+  for (std::ptrdiff_t n = 0; n < nsteps; ++n)
+    yss = fmapStencilMulti<D>(f, g, yss, bmask, boundaryMap(h, yss, 0),
+                              boundaryMap(h, yss, 2), boundaryMap(h, yss, 1),
+                              boundaryMap(h, yss, 3), args...);
+  return yss;
+}
+
 // head, last
 
 namespace detail {
@@ -572,15 +803,20 @@ struct nested_last : std::tuple<> {
 // head or mextract on the proxy would copy the whole data structure
 // to the local process, which would be prohibitively expensive.
 
-// Note: Why not use boundaryMap instead of (head|last)(fmap)?
+// Note: boundaryMap would also avoid the copy, but it evaluates the
+// whole boundary face, which is more than a single element if A has
+// rank > 1.
+
+// Note: fmap returns a temporary, so we cannot return a reference into
+// it
 
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) head(const adt::nested<P, A, T, Policy> &xss) {
+T head(const adt::nested<P, A, T, Policy> &xss) {
   return head(fmap(detail::nested_head(), xss.data));
 }
 
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) last(const adt::nested<P, A, T, Policy> &xss) {
+T last(const adt::nested<P, A, T, Policy> &xss) {
   return last(fmap(detail::nested_last(), xss.data));
 }
 
@@ -597,20 +833,51 @@ struct nested_boundary {
 template <typename P, typename A, typename T, typename Policy, typename CT,
           typename BC, typename BCT>
 BCT boundary(const adt::nested<P, A, T, Policy> &xs, std::ptrdiff_t i) {
-  // TODO: use boundaryMap instead
-  return BCT{fmap(detail::nested_boundary(), boundary(xs.data, i), i),
+  return BCT{boundaryMap(detail::nested_boundary(), xs.data, i),
              typename BCT::policy_type(xs.get_policy())};
 }
 
-// boudaryMap
+// boundaryMap
+
+namespace detail {
+struct nested_boundaryMap : std::tuple<> {
+  template <typename AT, typename F, typename... Args>
+  auto operator()(AT &&xs, std::ptrdiff_t i, F &&f, Args &&... args) const {
+    return boundaryMap(std::forward<F>(f), std::forward<AT>(xs), i,
+                       std::forward<Args>(args)...);
+  }
+};
+}
 
 template <typename F, typename P, typename A, typename T, typename Policy,
           typename... Args, typename CT, typename BC, typename R, typename BCR>
 BCR boundaryMap(F &&f, const adt::nested<P, A, T, Policy> &xs, std::ptrdiff_t i,
                 Args &&... args) {
-  // TODO: use boundaryMap instead
-  return fmap(std::forward<F>(f), boundary(xs, i), i,
-              std::forward<Args>(args)...);
+  // Map over the boundary where the data live, without copying the
+  // boundary first
+  return BCR{boundaryMap(detail::nested_boundaryMap(), xs.data, i,
+                         std::forward<F>(f), std::forward<Args>(args)...),
+             typename BCR::policy_type(xs.get_policy())};
+}
+
+namespace detail {
+template <std::size_t K> struct nested_boundaryMapWide : std::tuple<> {
+  template <typename AT, typename F, typename... Args>
+  auto operator()(AT &&xs, std::ptrdiff_t i, F &&f, Args &&... args) const {
+    return boundaryMapWide<K>(std::forward<F>(f), std::forward<AT>(xs), i,
+                              std::forward<Args>(args)...);
+  }
+};
+}
+
+template <std::size_t K, typename F, typename P, typename A, typename T,
+          typename Policy, typename... Args, typename CT, typename BC,
+          typename R, typename BCR>
+BCR boundaryMapWide(F &&f, const adt::nested<P, A, T, Policy> &xs,
+                    std::ptrdiff_t i, Args &&... args) {
+  return BCR{boundaryMap(detail::nested_boundaryMapWide<K>(), xs.data, i,
+                         std::forward<F>(f), std::forward<Args>(args)...),
+             typename BCR::policy_type(xs.get_policy())};
 }
 
 // indexing
@@ -694,6 +961,32 @@ R foldMap2(F &&f, Op &&op, Z &&z, const adt::nested<P, A, T, Policy> &xss,
                   std::forward<F>(f), op, z, std::forward<Args>(args)...);
 }
 
+// fmapFoldPair
+
+namespace detail {
+struct nested_fmapFoldPair : std::tuple<> {
+  template <typename AT, typename F, typename Op, typename Z, typename... Args>
+  auto operator()(const AT &xs, F &&f, Op &&op, Z &&z, Args &&... args) const {
+    return fmapFoldPair(std::forward<F>(f), std::forward<Op>(op),
+                        std::forward<Z>(z), xs, std::forward<Args>(args)...);
+  }
+};
+}
+
+template <typename F, typename Op, typename Z, typename P, typename A,
+          typename T, typename Policy, typename... Args, typename C,
+          typename RS, typename R, typename S, typename CR>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const adt::nested<P, A, T, Policy> &xss,
+                              Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  auto rss = fmapFoldPair(detail::nested_fmapFoldPair(), op, z, xss.data,
+                          std::forward<F>(f), op, z,
+                          std::forward<Args>(args)...);
+  return {CR{std::move(rss.first), typename CR::policy_type(xss.get_policy())},
+          std::move(rss.second)};
+}
+
 // dump
 
 template <typename P, typename A, typename T, typename Policy>
@@ -762,8 +1055,10 @@ CR mbind(F &&f, const adt::nested<P, A, T, Policy> &xss, Args &&... args) {
 
 // mextract
 
+// Note: mextract(xss.data) may return a temporary (e.g. for proxies),
+// so we cannot return a reference into it
 template <typename P, typename A, typename T, typename Policy>
-decltype(auto) mextract(const adt::nested<P, A, T, Policy> &xss) {
+T mextract(const adt::nested<P, A, T, Policy> &xss) {
   return mextract(mextract(xss.data));
 }
 
@@ -87,6 +87,23 @@ TEST(fun_nested, fmap) {
   EXPECT_EQ(11.0, zs.data->at(5));
 }
 
+TEST(fun_nested, fmap_inplace) {
+  auto xs = iotaMap<nested1<adt::dummy>>([](auto x) { return double(x); }, 10);
+  const double *p = xs.data->data();
+  auto ys = fmap([](auto x) { return x + 1.0; }, std::move(xs));
+  EXPECT_EQ(p, ys.data->data());
+  EXPECT_EQ(6.0, ys.data->at(5));
+
+  auto ys2 = ys;
+  auto zs = fmap2([](auto x, auto y) { return x + y; }, std::move(ys2), ys);
+  EXPECT_NE(p, zs.data->data());
+  EXPECT_EQ(6.0, ys.data->at(5));
+  EXPECT_EQ(12.0, zs.data->at(5));
+
+  auto zs2 = fmap2([](auto x, auto y) { return x - y; }, std::move(zs), ys);
+  EXPECT_EQ(6.0, zs2.data->at(5));
+}
+
 TEST(fun_nested, fmap2) {
   auto xs = iotaMap<nested2<adt::dummy>>([](auto x) { return double(x); }, 10);
   auto ys = fmap([](auto x) { return x + 1.0; }, xs);
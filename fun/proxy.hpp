@@ -1,6 +1,7 @@
 #ifndef FUN_PROXY_HPP
 #define FUN_PROXY_HPP
 
+#include <funhpc/placement.hpp>
 #include <funhpc/proxy.hpp>
 
 #include <adt/dummy.hpp>
@@ -10,6 +11,7 @@
 #include <fun/fun_decl.hpp>
 
 #include <cereal/types/tuple.hpp>
+#include <cereal/types/utility.hpp>
 
 #include <algorithm>
 #include <initializer_list>
@@ -27,6 +29,14 @@ template <typename> struct is_proxy : std::false_type {};
 template <typename T> struct is_proxy<funhpc::proxy<T>> : std::true_type {};
 }
 
+// placement
+
+namespace detail {
+template <std::size_t D>
+struct is_placement<funhpc::placement<D>> : std::true_type {};
+template <typename T> struct is_placeable<funhpc::proxy<T>> : std::true_type {};
+}
+
 // traits
 
 template <typename> struct fun_traits;
@@ -56,7 +66,7 @@ CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args) {
   cxx_assert(s <= 1);
   if (__builtin_expect(!s, false))
     return CR();
-  // TODO: use funhpc::remote
+  // Without a placement, the element lives on this process
   return funhpc::local(std::forward<F>(f), inds[0],
                        std::forward<Args>(args)...);
 }
@@ -73,19 +83,71 @@ CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
   cxx_assert(inds.size() <= 1);
   if (__builtin_expect(!s, false))
     return CR();
-  // TODO: use funhpc::remote
+  // Without a placement, the element lives on this process
   return funhpc::local(std::forward<F>(f), inds.imin(),
                        std::forward<Args>(args)...);
 }
 
+// iotaMap, iotaMapMulti with a placement
+
+// The element is created on the process chosen by the placement; f
+// and args need to be serializable
+
+template <typename C, typename F, typename... Args,
+          std::enable_if_t<detail::is_proxy<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(const funhpc::placement<1> &placement, F &&f,
+           const adt::irange_t &inds, Args &&... args) {
+  std::size_t s = inds.size();
+  cxx_assert(s <= 1);
+  if (__builtin_expect(!s, false))
+    return CR();
+  return funhpc::remote(placement.bind(inds).owner(inds), std::forward<F>(f),
+                        inds[0], std::forward<Args>(args)...);
+}
+
+template <
+    typename C, std::size_t D, typename F, typename... Args,
+    std::enable_if_t<detail::is_proxy<C>::value> * = nullptr,
+    typename R = std::decay_t<cxx::invoke_of_t<F, adt::index_t<D>, Args...>>,
+    typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const funhpc::placement<D> &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  std::size_t s = inds.size();
+  cxx_assert(inds.size() <= 1);
+  if (__builtin_expect(!s, false))
+    return CR();
+  return funhpc::remote(placement.bind(inds).owner(inds), std::forward<F>(f),
+                        inds.imin(), std::forward<Args>(args)...);
+}
+
 // fmap
 
+// When timing is switched on (see funhpc::set_proxy_timing), the tasks
+// of fmap and fmapStencil record their run time, which fun::balance
+// uses to weigh the leaves (see fun/balance.hpp). Only the call to f
+// is timed, not waiting for the arguments or for neighbouring
+// boundaries.
+
 namespace detail {
-struct proxy_fmap : std::tuple<> {
+template <bool Timed, typename F, typename... Args,
+          std::enable_if_t<!Timed> * = nullptr>
+auto proxy_invoke(F &&f, Args &&... args) {
+  return cxx::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+}
+template <bool Timed, typename F, typename... Args,
+          std::enable_if_t<Timed> * = nullptr>
+auto proxy_invoke(F &&f, Args &&... args) {
+  return funhpc::invoke_timed(std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template <bool Timed> struct proxy_fmap : std::tuple<> {
   template <typename F, typename T, typename... Args>
   auto operator()(F &&f, const funhpc::proxy<T> &xs, Args &&... args) const {
     cxx_assert(bool(xs) && xs.proc_ready() && xs.local());
-    return cxx::invoke(std::forward<F>(f), *xs, std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs,
+                               std::forward<Args>(args)...);
   }
 };
 }
@@ -97,20 +159,24 @@ template <typename F, typename T, typename... Args,
 CR fmap(F &&f, const funhpc::proxy<T> &xs, Args &&... args) {
   bool s = bool(xs);
   cxx_assert(s);
-  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap(),
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmap<true>(), std::forward<F>(f),
+                                xs, std::forward<Args>(args)...);
+  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap<false>(),
                         std::forward<F>(f), xs, std::forward<Args>(args)...);
 }
 
 namespace detail {
-struct proxy_fmap2 : std::tuple<> {
+template <bool Timed> struct proxy_fmap2 : std::tuple<> {
   template <typename F, typename T, typename T2, typename... Args>
   auto operator()(F &&f, const funhpc::proxy<T> &xs,
                   const funhpc::proxy<T2> &ys, Args &&... args) const {
     cxx_assert(bool(xs) && xs.proc_ready() && xs.local());
     cxx_assert(bool(ys));
     auto ysl = ys.make_local();
-    return cxx::invoke(std::forward<F>(f), *xs, *ysl,
-                       std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, *ysl,
+                               std::forward<Args>(args)...);
   }
 };
 }
@@ -124,13 +190,17 @@ CR fmap2(F &&f, const funhpc::proxy<T> &xs, const funhpc::proxy<T2> &ys,
   bool s = bool(xs);
   cxx_assert(bool(ys) == s);
   cxx_assert(s);
-  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap2(),
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmap2<true>(), std::forward<F>(f),
+                                xs, ys, std::forward<Args>(args)...);
+  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap2<false>(),
                         std::forward<F>(f), xs, ys,
                         std::forward<Args>(args)...);
 }
 
 namespace detail {
-struct proxy_fmap3 : std::tuple<> {
+template <bool Timed> struct proxy_fmap3 : std::tuple<> {
   template <typename F, typename T, typename T2, typename T3, typename... Args>
   auto operator()(F &&f, const funhpc::proxy<T> &xs,
                   const funhpc::proxy<T2> &ys, const funhpc::proxy<T3> &zs,
@@ -140,8 +210,8 @@ struct proxy_fmap3 : std::tuple<> {
     cxx_assert(bool(zs));
     auto ysl = ys.make_local();
     auto zsl = zs.make_local();
-    return cxx::invoke(std::forward<F>(f), *xs, *ysl, *zsl,
-                       std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, *ysl, *zsl,
+                               std::forward<Args>(args)...);
   }
 };
 }
@@ -156,13 +226,17 @@ CR fmap3(F &&f, const funhpc::proxy<T> &xs, const funhpc::proxy<T2> &ys,
   cxx_assert(bool(ys) == s);
   cxx_assert(bool(zs) == s);
   cxx_assert(s);
-  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap3(),
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmap3<true>(), std::forward<F>(f),
+                                xs, ys, zs, std::forward<Args>(args)...);
+  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap3<false>(),
                         std::forward<F>(f), xs, ys, zs,
                         std::forward<Args>(args)...);
 }
 
 namespace detail {
-struct proxy_fmap5 : std::tuple<> {
+template <bool Timed> struct proxy_fmap5 : std::tuple<> {
   template <typename F, typename T, typename T2, typename T3, typename T4,
             typename T5, typename... Args>
   auto operator()(F &&f, const funhpc::proxy<T> &xs,
@@ -178,8 +252,8 @@ struct proxy_fmap5 : std::tuple<> {
     auto zsl = zs.make_local();
     auto asl = as.make_local();
     auto bsl = bs.make_local();
-    return cxx::invoke(std::forward<F>(f), *xs, *ysl, *zsl, *asl, *bsl,
-                       std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, *ysl, *zsl, *asl,
+                               *bsl, std::forward<Args>(args)...);
   }
 };
 }
@@ -201,7 +275,12 @@ CR fmap5(F &&f, const funhpc::proxy<T> &xs, const funhpc::proxy<T2> &ys,
   cxx_assert(bool(as) == s);
   cxx_assert(bool(bs) == s);
   cxx_assert(s);
-  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap5(),
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmap5<true>(), std::forward<F>(f),
+                                xs, ys, zs, as, bs,
+                                std::forward<Args>(args)...);
+  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmap5<false>(),
                         std::forward<F>(f), xs, ys, zs, as, bs,
                         std::forward<Args>(args)...);
 }
@@ -209,13 +288,14 @@ CR fmap5(F &&f, const funhpc::proxy<T> &xs, const funhpc::proxy<T2> &ys,
 // fmapStencil
 
 namespace detail {
-struct proxy_fmapStencil : std::tuple<> {
+template <bool Timed> struct proxy_fmapStencil : std::tuple<> {
   template <typename F, typename T, typename BM, typename BP, typename... Args>
   auto operator()(F &&f, const funhpc::proxy<T> &xs, std::size_t bmask, BM &&bm,
                   BP &&bp, Args &&... args) const {
     cxx_assert(bool(xs) && xs.proc_ready() && xs.local());
-    return cxx::invoke(std::forward<F>(f), *xs, bmask, std::forward<BM>(bm),
-                       std::forward<BP>(bp), std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, bmask,
+                               std::forward<BM>(bm), std::forward<BP>(bp),
+                               std::forward<Args>(args)...);
   }
 };
 }
@@ -231,19 +311,26 @@ CR fmapStencil(F &&f, G &&g, const funhpc::proxy<T> &xs, std::size_t bmask,
   static_assert(std::is_same<std::decay_t<BP>, B>::value, "");
   bool s = bool(xs);
   cxx_assert(s);
-  return funhpc::remote(xs.get_proc_future(), detail::proxy_fmapStencil(),
-                        std::forward<F>(f), xs, bmask, std::forward<BM>(bm),
-                        std::forward<BP>(bp), std::forward<Args>(args)...);
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(
+        xs.get_proc_future(), detail::proxy_fmapStencil<true>(),
+        std::forward<F>(f), xs, bmask, std::forward<BM>(bm),
+        std::forward<BP>(bp), std::forward<Args>(args)...);
+  return funhpc::remote(
+      xs.get_proc_future(), detail::proxy_fmapStencil<false>(),
+      std::forward<F>(f), xs, bmask, std::forward<BM>(bm), std::forward<BP>(bp),
+      std::forward<Args>(args)...);
 }
 
 // fmapStencilMulti
 
 namespace detail {
-template <std::size_t D> struct proxy_fmapStencilMulti;
+template <std::size_t D, bool Timed> struct proxy_fmapStencilMulti;
 }
 
 namespace detail {
-template <> struct proxy_fmapStencilMulti<1> : std::tuple<> {
+template <bool Timed>
+struct proxy_fmapStencilMulti<1, Timed> : std::tuple<> {
   template <typename T, typename BM0, typename BP0, typename F,
             typename... Args>
   auto operator()(const funhpc::proxy<T> &xs, std::size_t bmask,
@@ -254,8 +341,8 @@ template <> struct proxy_fmapStencilMulti<1> : std::tuple<> {
     cxx_assert(bool(bp0));
     auto bm0l = bm0.make_local();
     auto bp0l = bp0.make_local();
-    return cxx::invoke(std::forward<F>(f), *xs, bmask, *bm0l, *bp0l,
-                       std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, bmask, *bm0l, *bp0l,
+                               std::forward<Args>(args)...);
   }
 };
 }
@@ -272,13 +359,20 @@ CR fmapStencilMulti(F &&f, G &&g, const funhpc::proxy<T> &xs, std::size_t bmask,
                     Args &&... args) {
   bool s = bool(xs);
   cxx_assert(s);
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmapStencilMulti<D, true>(), xs,
+                                bmask, bm0, bp0, std::forward<F>(f),
+                                std::forward<Args>(args)...);
   return funhpc::remote(xs.get_proc_future(),
-                        detail::proxy_fmapStencilMulti<D>(), xs, bmask, bm0,
-                        bp0, std::forward<F>(f), std::forward<Args>(args)...);
+                        detail::proxy_fmapStencilMulti<D, false>(), xs, bmask,
+                        bm0, bp0, std::forward<F>(f),
+                        std::forward<Args>(args)...);
 }
 
 namespace detail {
-template <> struct proxy_fmapStencilMulti<2> : std::tuple<> {
+template <bool Timed>
+struct proxy_fmapStencilMulti<2, Timed> : std::tuple<> {
   template <typename T, typename BM0, typename BM1, typename BP0, typename BP1,
             typename F, typename... Args>
   auto operator()(const funhpc::proxy<T> &xs, std::size_t bmask,
@@ -294,8 +388,8 @@ template <> struct proxy_fmapStencilMulti<2> : std::tuple<> {
     auto bm1l = bm1.make_local();
     auto bp0l = bp0.make_local();
     auto bp1l = bp1.make_local();
-    return cxx::invoke(std::forward<F>(f), *xs, bmask, *bm0l, *bm1l, *bp0l,
-                       *bp1l, std::forward<Args>(args)...);
+    return proxy_invoke<Timed>(std::forward<F>(f), *xs, bmask, *bm0l, *bm1l,
+                               *bp0l, *bp1l, std::forward<Args>(args)...);
   }
 };
 }
@@ -313,9 +407,15 @@ CR fmapStencilMulti(F &&f, G &&g, const funhpc::proxy<T> &xs, std::size_t bmask,
                     Args &&... args) {
   bool s = bool(xs);
   cxx_assert(s);
-  return funhpc::remote(
-      xs.get_proc_future(), detail::proxy_fmapStencilMulti<D>(), xs, bmask, bm0,
-      bm1, bp0, bp1, std::forward<F>(f), std::forward<Args>(args)...);
+  if (funhpc::proxy_timing())
+    return funhpc::remote_timed(xs.get_proc_future(),
+                                detail::proxy_fmapStencilMulti<D, true>(), xs,
+                                bmask, bm0, bm1, bp0, bp1, std::forward<F>(f),
+                                std::forward<Args>(args)...);
+  return funhpc::remote(xs.get_proc_future(),
+                        detail::proxy_fmapStencilMulti<D, false>(), xs, bmask,
+                        bm0, bm1, bp0, bp1, std::forward<F>(f),
+                        std::forward<Args>(args)...);
 }
 
 // head, last
@@ -403,6 +503,40 @@ R foldMap2(F &&f, Op &&op, Z &&z, const funhpc::proxy<T> &xs,
       .get();
 }
 
+// fmapFoldPair
+
+namespace detail {
+struct proxy_fmapFoldPair : std::tuple<> {
+  template <typename F, typename T, typename... Args>
+  auto operator()(F &&f, const funhpc::proxy<T> &xs, Args &&... args) const {
+    cxx_assert(bool(xs) && xs.proc_ready() && xs.local());
+    auto ys = cxx::invoke(std::forward<F>(f), *xs, std::forward<Args>(args)...);
+    typedef std::decay_t<decltype(ys.first)> R;
+    return std::make_pair(funhpc::make_local_proxy<R>(std::move(ys.first)),
+                          std::move(ys.second));
+  }
+};
+}
+
+// The new element stays on the process of xs; only the value to be
+// folded is sent back, in the same round trip
+template <typename F, typename Op, typename Z, typename T, typename... Args,
+          typename C = funhpc::proxy<T>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const funhpc::proxy<T> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  bool s = bool(xs);
+  cxx_assert(s);
+  return funhpc::async(funhpc::rlaunch::sync, xs.get_proc_future(),
+                       detail::proxy_fmapFoldPair(), std::forward<F>(f), xs,
+                       std::forward<Args>(args)...)
+      .get();
+}
+
 // dump
 
 namespace detail {
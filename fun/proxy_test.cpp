@@ -1,8 +1,21 @@
 #include <fun/proxy.hpp>
 
+#include <adt/index.hpp>
+#include <fun/maxarray.hpp>
+#include <fun/nested_decl.hpp>
+#include <fun/tree_decl.hpp>
+#include <funhpc/placement.hpp>
+#include <funhpc/rexec.hpp>
+
+#include <fun/nested_impl.hpp>
+#include <fun/tree_impl.hpp>
+
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
+#include <utility>
 
 using namespace fun;
 
@@ -89,6 +102,20 @@ TEST(fun_proxy, foldMap) {
   EXPECT_EQ((s - 1) * s * (2 * s - 1) / 6, sum_sq);
 }
 
+namespace {
+auto add1_sq(int x) { return std::make_pair(x + 1, sq(x)); }
+}
+
+TEST(fun_proxy, fmapFoldPair) {
+  std::ptrdiff_t s = 1;
+  auto xs = iotaMap<funhpc::proxy<adt::dummy>>(id, s);
+  auto rs = fmapFoldPair(add1_sq, add, 0, xs);
+  static_assert(
+      std::is_same<decltype(rs.first), funhpc::proxy<int>>::value, "");
+  EXPECT_EQ(1, *rs.first.make_local());
+  EXPECT_EQ(0, rs.second);
+}
+
 namespace {
 auto mkproxy_add(int x, int y) {
   return munit<funhpc::proxy<adt::dummy>>(x + y);
@@ -120,3 +147,53 @@ TEST(fun_proxy, monad) {
   auto r1 = mfoldMap(id, add, 0, x1);
   EXPECT_EQ(r, mextract(r1));
 }
+
+namespace {
+template <typename T>
+using proxy_maxarray = adt::nested<funhpc::proxy<adt::dummy>,
+                                   adt::maxarray<adt::dummy, 16>, T>;
+template <typename T>
+using proxy_maxarray_tree =
+    adt::nested<adt::tree<proxy_maxarray<adt::dummy>, adt::dummy>,
+                proxy_maxarray<adt::dummy>, T>;
+
+int iota(std::ptrdiff_t i) { return i; }
+int iota2(const adt::index_t<2> &i) { return i[0] + 10 * i[1]; }
+int proc(int x) { return funhpc::rank(); }
+int min(int x, int y) { return std::min(x, y); }
+int max(int x, int y) { return std::max(x, y); }
+
+int stencil(int x, std::size_t bmask, int bm, int bp) { return bp - bm; }
+int get_face(int x, std::ptrdiff_t i) { return x; }
+}
+
+TEST(fun_proxy, fmapStencil) {
+  std::ptrdiff_t s = 200;
+  auto xs = iotaMap<proxy_maxarray_tree<adt::dummy>>(iota, s);
+  EXPECT_EQ(0, head(xs));
+  EXPECT_EQ(s - 1, last(xs));
+  // The boundaries between leaves are transferred correctly
+  auto ys = fmapStencil(stencil, get_face, xs, 0b11, -1, int(s));
+  EXPECT_EQ(2, foldMap(id, min, s, ys));
+  EXPECT_EQ(2, foldMap(id, max, -1, ys));
+}
+
+TEST(fun_proxy, placement) {
+  std::ptrdiff_t s = 200;
+  auto xs = iotaMap<proxy_maxarray_tree<adt::dummy>>(
+      funhpc::placement<1>(funhpc::placement_kind::block), iota, s);
+  EXPECT_EQ(s * (s - 1) / 2, foldMap(id, add, 0, xs));
+  // The leaves are spread over all processes, in order
+  auto ps = fmap(proc, xs);
+  EXPECT_EQ(0, foldMap(id, min, funhpc::size(), ps));
+  EXPECT_EQ(funhpc::size() - 1, foldMap(id, max, -1, ps));
+  EXPECT_EQ(0, head(ps));
+  EXPECT_EQ(funhpc::size() - 1, last(ps));
+
+  auto ys = iotaMapMulti<adt::tree<proxy_maxarray<adt::dummy>, adt::dummy>>(
+      funhpc::placement<2>(funhpc::placement_kind::hilbert), iota2,
+      adt::steprange_t<2>(adt::index_t<2>{{10, 10}}));
+  EXPECT_EQ(100 * (45 + 450) / 10, foldMap(id, add, 0, ys));
+  auto qs = fmap(proc, ys);
+  EXPECT_EQ(funhpc::size() - 1, foldMap(id, max, -1, qs));
+}
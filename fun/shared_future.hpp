@@ -269,6 +269,28 @@ R foldMap2(F &&f, Op &&op, Z &&z, const qthread::shared_future<T> &xs,
                      std::forward<Args>(args)...);
 }
 
+// fmapFoldPair
+
+// This waits for xs, as foldMap does
+template <typename F, typename Op, typename Z, typename T, typename... Args,
+          typename C = qthread::shared_future<T>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const qthread::shared_future<T> &xs,
+                              Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  bool s = xs.valid();
+  if (!s)
+    return {CR(), S(std::forward<Z>(z))};
+  auto ys =
+      cxx::invoke(std::forward<F>(f), xs.get(), std::forward<Args>(args)...);
+  return {qthread::make_ready_future(std::move(ys.first)).share(),
+          std::move(ys.second)};
+}
+
 // dump
 
 template <typename T> ostreamer dump(const qthread::shared_future<T> &xs) {
@@ -88,6 +88,22 @@ CR fmap(F &&f, const std::shared_ptr<T> &xs, Args &&... args) {
       cxx::invoke(std::forward<F>(f), *xs, std::forward<Args>(args)...));
 }
 
+// If xs is the only reference to its value and the result has the
+// same type, update the value in place
+template <typename F, typename T, typename... Args,
+          typename C = std::shared_ptr<T>,
+          typename R = std::decay_t<cxx::invoke_of_t<F, T, Args...>>,
+          typename CR = typename fun_traits<C>::template constructor<R>,
+          std::enable_if_t<std::is_same<CR, C>::value> * = nullptr>
+CR fmap(F &&f, std::shared_ptr<T> &&xs, Args &&... args) {
+  if (xs.use_count() != 1)
+    return fmap(std::forward<F>(f), static_cast<const C &>(xs),
+                std::forward<Args>(args)...);
+  *xs = cxx::invoke(std::forward<F>(f), std::move(*xs),
+                    std::forward<Args>(args)...);
+  return std::move(xs);
+}
+
 template <typename F, typename T, typename T2, typename... Args,
           typename C = std::shared_ptr<T>,
           typename R = std::decay_t<cxx::invoke_of_t<F, T, T2, Args...>>,
@@ -102,6 +118,22 @@ CR fmap2(F &&f, const std::shared_ptr<T> &xs, const std::shared_ptr<T2> &ys,
       cxx::invoke(std::forward<F>(f), *xs, *ys, std::forward<Args>(args)...));
 }
 
+template <typename F, typename T, typename T2, typename... Args,
+          typename C = std::shared_ptr<T>,
+          typename R = std::decay_t<cxx::invoke_of_t<F, T, T2, Args...>>,
+          typename CR = typename fun_traits<C>::template constructor<R>,
+          std::enable_if_t<std::is_same<CR, C>::value> * = nullptr>
+CR fmap2(F &&f, std::shared_ptr<T> &&xs, const std::shared_ptr<T2> &ys,
+         Args &&... args) {
+  if (xs.use_count() != 1 || static_cast<const void *>(xs.get()) == ys.get())
+    return fmap2(std::forward<F>(f), static_cast<const C &>(xs), ys,
+                 std::forward<Args>(args)...);
+  cxx_assert(bool(ys));
+  *xs = cxx::invoke(std::forward<F>(f), std::move(*xs), *ys,
+                    std::forward<Args>(args)...);
+  return std::move(xs);
+}
+
 template <typename F, typename T, typename T2, typename T3, typename... Args,
           typename C = std::shared_ptr<T>,
           typename R = std::decay_t<cxx::invoke_of_t<F, T, T2, T3, Args...>>,
@@ -243,6 +275,24 @@ R foldMap2(F &&f, Op &&op, Z &&z, const std::shared_ptr<T> &xs,
   return cxx::invoke(std::forward<F>(f), *xs, *ys, std::forward<Args>(args)...);
 }
 
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename T, typename... Args,
+          typename C = std::shared_ptr<T>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const std::shared_ptr<T> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  bool s = bool(xs);
+  if (__builtin_expect(!s, false))
+    return {CR(), S(std::forward<Z>(z))};
+  auto ys = cxx::invoke(std::forward<F>(f), *xs, std::forward<Args>(args)...);
+  return {std::make_shared<R>(std::move(ys.first)), std::move(ys.second)};
+}
+
 // dump
 
 template <typename T> ostreamer dump(const std::shared_ptr<T> &xs) {
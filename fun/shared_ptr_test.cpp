@@ -53,6 +53,24 @@ TEST(fun_shared_ptr, fmap) {
   EXPECT_EQ(0, accum);
 }
 
+TEST(fun_shared_ptr, fmap_inplace) {
+  auto xs = std::make_shared<int>(1);
+  const int *p = xs.get();
+  auto rs = fmap([](int i) { return i + 1; }, std::move(xs));
+  EXPECT_EQ(p, rs.get());
+  EXPECT_EQ(2, *rs);
+
+  // shared values are not modified
+  auto ys = rs;
+  auto rs2 = fmap2([](int i, int j) { return i + j; }, std::move(ys), rs);
+  EXPECT_NE(p, rs2.get());
+  EXPECT_EQ(2, *rs);
+  EXPECT_EQ(4, *rs2);
+
+  auto rs3 = fmap2([](int i, int j) { return i * j; }, std::move(rs2), rs);
+  EXPECT_EQ(8, *rs3);
+}
+
 TEST(fun_shared_ptr, foldMap) {
   std::ptrdiff_t s = 1;
   auto xs =
@@ -0,0 +1,298 @@
+#ifndef FUN_SOA_VECTOR_HPP
+#define FUN_SOA_VECTOR_HPP
+
+#include <adt/soa_vector.hpp>
+
+#include <adt/dummy.hpp>
+#include <adt/index.hpp>
+#include <cxx/cassert.hpp>
+#include <cxx/invoke.hpp>
+#include <fun/fun_decl.hpp>
+#include <fun/idtype.hpp>
+
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace fun {
+
+// is_soa_vector
+
+namespace detail {
+template <typename> struct is_soa_vector : std::false_type {};
+template <typename T>
+struct is_soa_vector<adt::soa_vector<T>> : std::true_type {};
+}
+
+// traits
+
+template <typename> struct fun_traits;
+template <typename T> struct fun_traits<adt::soa_vector<T>> {
+  template <typename U> using constructor = adt::soa_vector<std::decay_t<U>>;
+  typedef constructor<adt::dummy> dummy;
+  typedef T value_type;
+
+  static constexpr std::ptrdiff_t rank = 1;
+  typedef adt::index_t<rank> index_type;
+
+  typedef adt::idtype<adt::dummy> boundary_dummy;
+
+  static constexpr std::size_t min_size() { return 0; }
+  static constexpr std::size_t max_size() {
+    return std::numeric_limits<std::size_t>::max();
+  }
+};
+
+// iotaMap
+
+template <typename C, typename F, typename... Args,
+          std::enable_if_t<detail::is_soa_vector<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args) {
+  std::ptrdiff_t s = inds.shape();
+  CR rs(s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    rs[i] = cxx::invoke(f, inds[i], args...);
+  return rs;
+}
+
+template <typename C, std::size_t D, typename F, typename... Args,
+          std::enable_if_t<detail::is_soa_vector<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
+  static_assert(D == 1, "");
+  adt::irange_t inds1(inds.imin()[0], inds.imax()[0], inds.istep()[0]);
+  std::ptrdiff_t s = inds1.shape();
+  CR rs(s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    rs[i] = cxx::invoke(f, adt::set<adt::index_t<1>>(inds1[i]), args...);
+  return rs;
+}
+
+// fmap
+
+template <typename F, typename T, typename... Args,
+          typename C = adt::soa_vector<T>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR fmap(F &&f, const adt::soa_vector<T> &xs, Args &&... args) {
+  std::ptrdiff_t s = xs.size();
+  CR rs(s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    rs[i] = cxx::invoke(f, xs[i], args...);
+  return rs;
+}
+
+template <typename F, typename T, typename T2, typename... Args,
+          typename C = adt::soa_vector<T>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR fmap2(F &&f, const adt::soa_vector<T> &xs, const adt::soa_vector<T2> &ys,
+         Args &&... args) {
+  std::ptrdiff_t s = xs.size();
+  cxx_assert(std::ptrdiff_t(ys.size()) == s);
+  CR rs(s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    rs[i] = cxx::invoke(f, xs[i], ys[i], args...);
+  return rs;
+}
+
+template <typename F, typename T, typename T2, typename T3, typename... Args,
+          typename C = adt::soa_vector<T>,
+          typename R = cxx::invoke_of_t<F, T, T2, T3, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR fmap3(F &&f, const adt::soa_vector<T> &xs, const adt::soa_vector<T2> &ys,
+         const adt::soa_vector<T3> &zs, Args &&... args) {
+  std::ptrdiff_t s = xs.size();
+  cxx_assert(std::ptrdiff_t(ys.size()) == s);
+  cxx_assert(std::ptrdiff_t(zs.size()) == s);
+  CR rs(s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    rs[i] = cxx::invoke(f, xs[i], ys[i], zs[i], args...);
+  return rs;
+}
+
+// head, last
+
+template <typename T> T head(const adt::soa_vector<T> &xs) {
+  cxx_assert(!xs.empty());
+  return xs[0];
+}
+
+template <typename T> T last(const adt::soa_vector<T> &xs) {
+  cxx_assert(!xs.empty());
+  return xs[xs.size() - 1];
+}
+
+// boundary
+
+template <typename T, typename CT = adt::soa_vector<T>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename BCT = typename fun_traits<BC>::template constructor<T>>
+BCT boundary(const adt::soa_vector<T> &xs, std::ptrdiff_t i) {
+  cxx_assert(i >= 0 && i < 2);
+  return munit<BC>(i == 0 ? head(xs) : last(xs));
+}
+
+// boundaryMap
+
+template <typename F, typename T, typename... Args,
+          typename CT = adt::soa_vector<T>,
+          typename BC = typename fun_traits<CT>::boundary_dummy,
+          typename R = cxx::invoke_of_t<F, T, std::ptrdiff_t, Args...>,
+          typename BCR = typename fun_traits<BC>::template constructor<R>>
+BCR boundaryMap(F &&f, const adt::soa_vector<T> &xs, std::ptrdiff_t i,
+                Args &&... args) {
+  return fmap(std::forward<F>(f), boundary(xs, i), i,
+              std::forward<Args>(args)...);
+}
+
+// indexing
+
+template <typename T>
+T getIndex(const adt::soa_vector<T> &xs, std::ptrdiff_t i) {
+  cxx_assert(i >= 0 && i < std::ptrdiff_t(xs.size()));
+  return xs[i];
+}
+
+template <typename> class accumulator;
+template <typename T> class accumulator<adt::soa_vector<T>> {
+  adt::soa_vector<T> data;
+
+public:
+  accumulator(std::ptrdiff_t n) : data(n) {}
+  typename adt::soa_vector<T>::reference operator[](std::ptrdiff_t i) {
+    return data[i];
+  }
+  decltype(auto) finalize() { return std::move(data); }
+};
+
+// foldMap
+
+template <typename F, typename Op, typename Z, typename T, typename... Args,
+          typename R = cxx::invoke_of_t<F, T, Args...>>
+R foldMap(F &&f, Op &&op, Z &&z, const adt::soa_vector<T> &xs,
+          Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  std::ptrdiff_t s = xs.size();
+  R r(std::forward<Z>(z));
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], args...));
+  return r;
+}
+
+template <typename F, typename Op, typename Z, typename T, typename T2,
+          typename... Args, typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+R foldMap2(F &&f, Op &&op, Z &&z, const adt::soa_vector<T> &xs,
+           const adt::soa_vector<T2> &ys, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  std::ptrdiff_t s = xs.size();
+  cxx_assert(std::ptrdiff_t(ys.size()) == s);
+  R r(std::forward<Z>(z));
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], ys[i], args...));
+  return r;
+}
+
+// dump
+
+template <typename T> ostreamer dump(const adt::soa_vector<T> &xs) {
+  std::ptrdiff_t s = xs.size();
+  std::ostringstream os;
+  os << "soa_vector{";
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    os << xs[i] << ",";
+  os << "}";
+  return ostreamer(os.str());
+}
+
+// munit
+
+template <typename C, typename T,
+          std::enable_if_t<detail::is_soa_vector<C>::value> * = nullptr,
+          typename R = std::decay_t<T>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR munit(T &&x) {
+  CR rs(1);
+  rs[0] = std::forward<T>(x);
+  return rs;
+}
+
+// mextract
+
+template <typename T> T mextract(const adt::soa_vector<T> &xs) {
+  cxx_assert(!xs.empty());
+  return xs[0];
+}
+
+// mfoldMap
+
+template <typename F, typename Op, typename Z, typename T, typename... Args,
+          typename C = adt::soa_vector<T>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR mfoldMap(F &&f, Op &&op, Z &&z, const adt::soa_vector<T> &xs,
+            Args &&... args) {
+  return munit<CR>(foldMap(std::forward<F>(f), std::forward<Op>(op),
+                           std::forward<Z>(z), xs,
+                           std::forward<Args>(args)...));
+}
+
+// mzero
+
+template <typename C, typename R,
+          std::enable_if_t<detail::is_soa_vector<C>::value> * = nullptr,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR mzero() {
+  return CR();
+}
+
+// mplus
+
+template <typename T, typename... Ts, typename CT = adt::soa_vector<T>>
+CT mplus(const adt::soa_vector<T> &xs, const adt::soa_vector<Ts> &... xss) {
+  CT rs;
+  for (auto pxs : std::initializer_list<const CT *>{&xs, &xss...})
+    for (std::size_t i = 0; i < pxs->size(); ++i)
+      rs.push_back((*pxs)[i]);
+  return rs;
+}
+
+// msome
+
+template <typename C, typename T, typename... Ts,
+          std::enable_if_t<detail::is_soa_vector<C>::value> * = nullptr,
+          typename R = std::decay_t<T>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR msome(T &&x, Ts &&... ys) {
+  return CR{std::forward<T>(x), std::forward<Ts>(ys)...};
+}
+
+// mempty
+
+template <typename T> bool mempty(const adt::soa_vector<T> &xs) {
+  return xs.empty();
+}
+
+// msize
+
+template <typename T> std::size_t msize(const adt::soa_vector<T> &xs) {
+  return xs.size();
+}
+}
+
+#define FUN_SOA_VECTOR_HPP_DONE
+#endif // #ifdef FUN_SOA_VECTOR_HPP
+#ifndef FUN_SOA_VECTOR_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,122 @@
+#include <adt/soa_vector.hpp>
+#include <fun/soa_vector.hpp>
+
+#include <fun/fun_decl.hpp>
+#include <fun/grid_decl.hpp>
+#include <fun/idtype.hpp>
+
+#include <fun/fun_impl.hpp>
+#include <fun/grid_impl.hpp>
+
+#include <gtest/gtest.h>
+#include <qthread.h>
+
+#include <tuple>
+
+using namespace fun;
+
+namespace {
+struct cell_t {
+  double u, rho;
+};
+
+template <typename T> using grid2 = adt::grid<adt::soa_vector<adt::dummy>, T, 2>;
+}
+
+namespace adt {
+template <> struct soa_traits<cell_t> {
+  static constexpr auto fields() {
+    return std::make_tuple(&cell_t::u, &cell_t::rho);
+  }
+};
+}
+
+TEST(fun_soa_vector, iotaMap) {
+  std::ptrdiff_t s = 10;
+  auto rs = iotaMap<adt::soa_vector<adt::dummy>>(
+      [](int x) { return cell_t{double(x), -double(x)}; }, s);
+  static_assert(std::is_same<decltype(rs), adt::soa_vector<cell_t>>::value,
+                "");
+  EXPECT_EQ(s, rs.size());
+  for (std::ptrdiff_t i = 0; i < s; ++i) {
+    EXPECT_EQ(i, getIndex(rs, i).u);
+    EXPECT_EQ(-i, getIndex(rs, i).rho);
+  }
+  EXPECT_EQ(s, rs.field<0>().size());
+  EXPECT_EQ(s - 1, rs.field<0>().back());
+}
+
+TEST(fun_soa_vector, dump) {
+  std::ptrdiff_t s = 5;
+  auto rs = iotaMap<adt::soa_vector<adt::dummy>>([](int x) { return x; }, s);
+  std::string str(dump(rs));
+  EXPECT_EQ("soa_vector{0,1,2,3,4,}", str);
+}
+
+TEST(fun_soa_vector, fmap) {
+  std::ptrdiff_t s = 10;
+  auto xs = iotaMap<adt::soa_vector<adt::dummy>>(
+      [](int x) { return cell_t{double(x), 1.0}; }, s);
+  auto ys = fmap([](const cell_t &c, double a) { return cell_t{a * c.u, c.rho}; },
+                 xs, 2.0);
+  EXPECT_EQ(s, ys.size());
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    EXPECT_EQ(2.0 * i, getIndex(ys, i).u);
+
+  auto us = fmap2([](const cell_t &x, const cell_t &y) { return x.u + y.u; },
+                  xs, ys);
+  static_assert(std::is_same<decltype(us), adt::soa_vector<double>>::value,
+                "");
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    EXPECT_EQ(3.0 * i, us[i]);
+
+  auto sum = foldMap([](const cell_t &c) { return c.u; },
+                     [](double x, double y) { return x + y; }, 0.0, xs);
+  EXPECT_EQ((s - 1) * s / 2, sum);
+
+  EXPECT_EQ(0.0, head(xs).u);
+  EXPECT_EQ(s - 1, last(xs).u);
+  EXPECT_EQ(s - 1, mextract(boundary(xs, 1)).u);
+}
+
+TEST(fun_soa_vector, monad) {
+  auto x1 = munit<adt::soa_vector<adt::dummy>>(1);
+  static_assert(std::is_same<decltype(x1), adt::soa_vector<int>>::value, "");
+  EXPECT_EQ(1, x1.size());
+  EXPECT_EQ(1, mextract(x1));
+
+  auto x3 = msome<adt::soa_vector<adt::dummy>>(1, 2, 3);
+  EXPECT_EQ(3, msize(x3));
+  auto x4 = mplus(x1, x3);
+  EXPECT_EQ(4, msize(x4));
+  EXPECT_EQ(3, x4[3]);
+
+  auto x0 = mzero<adt::soa_vector<adt::dummy>, int>();
+  EXPECT_TRUE(mempty(x0));
+}
+
+TEST(fun_soa_vector, grid) {
+  qthread_initialize();
+
+  std::ptrdiff_t s = 50;
+  auto xs = iotaMapMulti<grid2<adt::dummy>>(
+      [](const adt::index_t<2> &i) {
+        return cell_t{double(i[0]), double(i[1])};
+      },
+      adt::steprange_t<2>(adt::index_t<2>{{s, s}}));
+  static_assert(std::is_same<decltype(xs), grid2<cell_t>>::value, "");
+  auto axpy = [](const cell_t &y, const cell_t &x, double a) {
+    return cell_t{a * x.u + y.u, a * x.rho + y.rho};
+  };
+  auto ys = fmap2(axpy, xs, xs, 1.0);
+  auto zs = fmap2(cxx::execution::par, axpy, xs, xs, 1.0);
+  auto sum = [](const cell_t &c) { return c.u + c.rho; };
+  auto plus = [](double x, double y) { return x + y; };
+  EXPECT_EQ(2.0 * s * s * (s - 1), foldMap(sum, plus, 0.0, ys));
+  EXPECT_EQ(2.0 * s * s * (s - 1), foldMap(sum, plus, 0.0, zs));
+  EXPECT_EQ(2.0 * (s - 1), ys.last().u);
+
+  auto bs = boundaryMap([](const cell_t &c, std::ptrdiff_t) { return c.u; },
+                        xs, 1);
+  EXPECT_EQ(s * (s - 1), foldMap([](double x) { return x; }, plus, 0.0, bs));
+}
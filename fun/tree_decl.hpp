@@ -4,10 +4,12 @@
 #include <adt/tree_decl.hpp>
 
 #include <adt/dummy.hpp>
+#include <cxx/cassert.hpp>
 #include <cxx/invoke.hpp>
 #include <fun/fun_decl.hpp>
 
 #include <type_traits>
+#include <utility>
 
 namespace fun {
 
@@ -38,19 +40,114 @@ template <typename A, typename T> struct fun_traits<adt::tree<A, T>> {
   static constexpr std::size_t max_size() { return -1; }
 };
 
+namespace detail {
+template <typename A, typename T>
+struct is_placeable<adt::tree<A, T>> : is_placeable<A> {};
+}
+
+// tree_policy
+
+// The order of the children of a branch. This only applies if the
+// branches are one-dimensional arrays (e.g. vectors) while the index
+// space is multi-dimensional; multi-dimensional arrays (e.g. grids)
+// keep their own layout.
+enum class tree_order { lexicographic, morton, hilbert };
+
+// How iotaMap and iotaMapMulti build trees
+struct tree_policy {
+  // Maximum number of children of a branch. In D dimensions, each
+  // direction is split into max_size^(1/D) (rounded, at least 2) parts.
+  std::ptrdiff_t max_size;
+  tree_order order;
+
+  tree_policy() : tree_policy(16) {}
+  explicit tree_policy(std::ptrdiff_t max_size,
+                       tree_order order = tree_order::lexicographic)
+      : max_size(max_size), order(order) {
+    cxx_assert(max_size >= 2);
+  }
+
+  template <typename Archive> void serialize(Archive &ar) {
+    ar(max_size, order);
+  }
+};
+
 // iotaMap
 
 template <typename C, typename F, typename... Args,
           std::enable_if_t<detail::is_tree<C>::value> * = nullptr,
           typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
           typename CR = typename fun_traits<C>::template constructor<R>>
-CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args);
+CR iotaMap(const tree_policy &policy, F &&f, const adt::irange_t &inds,
+           Args &&... args);
+
+template <typename C, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args) {
+  return iotaMap<C>(tree_policy(), std::forward<F>(f), inds,
+                    std::forward<Args>(args)...);
+}
 
 template <typename C, std::size_t D, typename F, typename... Args,
           std::enable_if_t<detail::is_tree<C>::value> * = nullptr,
           typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
           typename CR = typename fun_traits<C>::template constructor<R>>
-CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args);
+CR iotaMapMulti(const tree_policy &policy, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args);
+
+template <typename C, std::size_t D, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
+  return iotaMapMulti<C>(tree_policy(), std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+
+// iotaMap, iotaMapMulti with a placement, which is passed on to the
+// arrays of the branches
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(const tree_policy &policy, const Placement &placement, F &&f,
+           const adt::irange_t &inds, Args &&... args);
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMap(const Placement &placement, F &&f, const adt::irange_t &inds,
+           Args &&... args) {
+  return iotaMap<C>(tree_policy(), placement, std::forward<F>(f), inds,
+                    std::forward<Args>(args)...);
+}
+
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const tree_policy &policy, const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args);
+
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR iotaMapMulti(const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  return iotaMapMulti<C>(tree_policy(), placement, std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
 
 // fmap
 
@@ -144,6 +241,17 @@ template <typename F, typename Op, typename Z, typename A, typename T,
 R foldMap2(F &&f, Op &&op, Z &&z, const adt::tree<A, T> &xs,
            const adt::tree<A, T2> &ys, Args &&... args);
 
+// fmapFoldPair
+
+template <typename F, typename Op, typename Z, typename A, typename T,
+          typename... Args, typename CT = adt::tree<A, T>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z, const adt::tree<A, T> &xs,
+                              Args &&... args);
+
 // dump
 
 template <typename A, typename T> ostreamer dump(const adt::tree<A, T> &xs);
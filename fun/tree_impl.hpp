@@ -11,42 +11,109 @@
 
 #include <adt/tree_impl.hpp>
 
+#include <cereal/types/vector.hpp>
+
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <initializer_list>
 #include <iterator>
 #include <sstream>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace fun {
 
 // iotaMap
 
 namespace detail {
-constexpr std::ptrdiff_t max_tree_size = 16;
+// The number of parts into which each direction of a branch is split
 template <std::size_t D>
-const std::ptrdiff_t
-    max_tree_linear_size = std::rint(std::pow(double(max_tree_size), 1.0 / D));
+std::ptrdiff_t tree_linear_size(const tree_policy &policy) {
+  return std::max(std::ptrdiff_t(2),
+                  std::ptrdiff_t(std::rint(
+                      std::pow(double(policy.max_size), 1.0 / double(D)))));
 }
 
-namespace detail {
+// The extent of the children of a branch with the given shape: in
+// each direction, the smallest power of the linear size that yields at
+// most linear size children. Directions are scaled independently, so
+// that short directions are not split into single-element children.
+template <std::size_t D>
+adt::index_t<D> tree_scale(const tree_policy &policy,
+                           const adt::index_t<D> &shape) {
+  std::ptrdiff_t b = tree_linear_size<D>(policy);
+  adt::index_t<D> scale;
+  for (std::size_t d = 0; d < D; ++d) {
+    scale[d] = 1;
+    while (shape[d] > scale[d] * b)
+      scale[d] *= b;
+  }
+  return scale;
+}
+
+// Pass the placement on to arrays that accept one
+template <typename A, typename Placement, typename F, typename... Args,
+          std::enable_if_t<is_placement<Placement>::value &&
+                           is_placeable<A>::value> * = nullptr>
+auto tree_place_iotaMap(const Placement &placement, F &&f,
+                        const adt::irange_t &inds, Args &&... args) {
+  return iotaMap<A>(placement, std::forward<F>(f), inds,
+                    std::forward<Args>(args)...);
+}
+template <typename A, typename Placement, typename F, typename... Args,
+          std::enable_if_t<!(is_placement<Placement>::value &&
+                             is_placeable<A>::value)> * = nullptr>
+auto tree_place_iotaMap(const Placement &placement, F &&f,
+                        const adt::irange_t &inds, Args &&... args) {
+  return iotaMap<A>(std::forward<F>(f), inds, std::forward<Args>(args)...);
+}
+
+template <typename A, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<is_placement<Placement>::value &&
+                           is_placeable<A>::value> * = nullptr>
+auto tree_place_iotaMapMulti(const Placement &placement, F &&f,
+                             const adt::steprange_t<D> &inds,
+                             Args &&... args) {
+  return iotaMapMulti<A>(placement, std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+template <typename A, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<!(is_placement<Placement>::value &&
+                             is_placeable<A>::value)> * = nullptr>
+auto tree_place_iotaMapMulti(const Placement &placement, F &&f,
+                             const adt::steprange_t<D> &inds,
+                             Args &&... args) {
+  return iotaMapMulti<A>(std::forward<F>(f), inds,
+                         std::forward<Args>(args)...);
+}
+
+template <typename C, typename Placement, typename F, typename... Args,
+          typename R = cxx::invoke_of_t<F, std::ptrdiff_t, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR tree_iotaMap_impl(const tree_policy &policy, const Placement &placement,
+                     F &&f, const adt::irange_t &inds, Args &&... args);
+
 template <typename C> struct tree_iotaMap : std::tuple<> {
-  template <typename F, typename... Args>
+  template <typename Placement, typename F, typename... Args>
   auto operator()(std::ptrdiff_t i, const adt::irange_t &inds,
-                  std::ptrdiff_t scale, F &&f, Args &&... args) const {
+                  std::ptrdiff_t scale, const tree_policy &policy,
+                  const Placement &placement, F &&f, Args &&... args) const {
     adt::irange_t sub_inds(i, std::min(i + inds.istep() * scale, inds.imax()),
                            inds.istep());
-    return iotaMap<C>(std::forward<F>(f), sub_inds,
-                      std::forward<Args>(args)...);
+    return tree_iotaMap_impl<C>(policy, placement, std::forward<F>(f),
+                                sub_inds, std::forward<Args>(args)...);
   }
 };
-}
 
-template <typename C, typename F, typename... Args,
-          std::enable_if_t<detail::is_tree<C>::value> *, typename R,
-          typename CR>
-CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args) {
+template <typename C, typename Placement, typename F, typename... Args,
+          typename R, typename CR>
+CR tree_iotaMap_impl(const tree_policy &policy, const Placement &placement,
+                     F &&f, const adt::irange_t &inds, Args &&... args) {
   typedef typename CR::array_dummy A;
   // Empty tree: special case
   if (inds.empty())
@@ -57,120 +124,199 @@ CR iotaMap(F &&f, const adt::irange_t &inds, Args &&... args) {
         cxx::invoke(std::forward<F>(f), inds[0], std::forward<Args>(args)...));
   // Branch
   // Calculate optimal branch size, so that all sub-branches will be full
-  std::ptrdiff_t scale = 1;
-  while (inds.shape() > scale * detail::max_tree_size)
-    scale *= detail::max_tree_size;
-  cxx_assert(scale < inds.shape() &&
-             scale * detail::max_tree_size >= inds.shape());
+  std::ptrdiff_t scale =
+      tree_scale(policy, adt::index_t<1>{{inds.shape()}})[0];
   adt::irange_t branch_inds(inds.imin(), inds.imax(), inds.istep() * scale);
-  return CR{CR::either_t::make_right(
-      iotaMap<A>(detail::tree_iotaMap<C>(), branch_inds, inds, scale,
-                 std::forward<F>(f), std::forward<Args>(args)...))};
+  return CR{CR::either_t::make_right(tree_place_iotaMap<A>(
+      placement, tree_iotaMap<C>(), branch_inds, inds, scale, policy,
+      placement, std::forward<F>(f), std::forward<Args>(args)...))};
 }
-
-#if 0
-namespace detail {
-template <typename C> struct tree_iotaMapMulti : std::tuple<> {
-  template <std::size_t D, typename F, typename... Args>
-  auto operator()(const adt::index_t<D> &i, const adt::steprange_t<D> &inds,
-                  std::ptrdiff_t scale, F &&f, Args &&... args) const {
-    adt::steprange_t<D> sub_inds(i, adt::min(i + inds.istep() * scale, inds.imax()),
-                             inds.istep());
-    return iotaMapMulti<C>(std::forward<F>(f), sub_inds,
-                           std::forward<Args>(args)...);
-  }
-};
 }
 
-template <typename C, std::size_t D, typename F, typename... Args,
+template <typename C, typename F, typename... Args,
           std::enable_if_t<detail::is_tree<C>::value> *, typename R,
           typename CR>
-CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
-  typedef typename CR::array_dummy A;
-  // Empty tree: special case
-  if (inds.empty())
-    return mzero<C, R>();
-  // Leaf
-  if (inds.size() == 1)
-    return munit<C>(cxx::invoke(std::forward<F>(f), inds.imin(),
-                                std::forward<Args>(args)...));
-  // Branch
-  // Calculate optimal branch size, so that all sub-branches will be full
-  // TODO: Consider different scales in different directions
-  std::ptrdiff_t scale = 1;
-  while (
-      adt::any(adt::gt(inds.shape(), scale * detail::max_tree_linear_size<D>)))
-    scale *= detail::max_tree_linear_size<D>;
-  cxx_assert(
-      adt::any(adt::lt(scale, inds.shape()) &&
-               adt::ge(scale * detail::max_tree_linear_size<D>, inds.shape())));
-  adt::steprange_t<D> branch_inds(inds.imin(), inds.imax(), inds.istep() * scale);
-  return CR{CR::either_t::make_right(
-      iotaMapMulti<A>(detail::tree_iotaMapMulti<C>(), branch_inds, inds, scale,
-                      std::forward<F>(f), std::forward<Args>(args)...))};
+CR iotaMap(const tree_policy &policy, F &&f, const adt::irange_t &inds,
+           Args &&... args) {
+  return detail::tree_iotaMap_impl<C>(policy, detail::no_placement(),
+                                      std::forward<F>(f), inds,
+                                      std::forward<Args>(args)...);
+}
+
+template <typename C, typename Placement, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> *,
+          typename R, typename CR>
+CR iotaMap(const tree_policy &policy, const Placement &placement, F &&f,
+           const adt::irange_t &inds, Args &&... args) {
+  return detail::tree_iotaMap_impl<C>(policy, placement.bind(inds),
+                                      std::forward<F>(f), inds,
+                                      std::forward<Args>(args)...);
 }
-#endif
 
 namespace detail {
-template <typename C> struct tree_iotaMapMulti_leaf : std::tuple<> {
-  template <std::size_t D, typename F, typename... Args,
-            typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
-            typename CR = typename fun_traits<C>::template constructor<R>>
-  auto operator()(const adt::index_t<D> &i, F &&f, Args &&... args) const {
-    return CR{CR::either_t::make_left(
-        cxx::invoke(std::forward<F>(f), i, std::forward<Args>(args)...))};
+// The positions of the children of a branch covering inds, where the
+// children have the extent scale, ordered along a curve
+template <std::size_t D>
+std::vector<adt::index_t<D>>
+tree_child_positions(const adt::steprange_t<D> &inds,
+                     const adt::index_t<D> &scale, tree_order order) {
+  adt::steprange_t<D> branch_inds(inds.imin(), inds.imax(),
+                                  inds.istep() * scale);
+  adt::index_t<D> shape = branch_inds.shape();
+  int bits = 0;
+  while (adt::any(adt::gt(shape, std::ptrdiff_t(1) << bits)))
+    ++bits;
+  std::vector<std::pair<std::uint64_t, adt::index_t<D>>> children;
+  children.reserve(branch_inds.size());
+  adt::steprange_t<D>(shape).loop([&](const adt::index_t<D> &i) {
+    std::uint64_t key = order == tree_order::morton
+                            ? adt::morton_key(i, bits)
+                            : order == tree_order::hilbert
+                                  ? adt::hilbert_key(i, bits)
+                                  : children.size();
+    children.emplace_back(key, branch_inds.imin() + i * branch_inds.istep());
+  });
+  std::sort(children.begin(), children.end(),
+            [](const auto &x, const auto &y) { return x.first < y.first; });
+  std::vector<adt::index_t<D>> positions(children.size());
+  for (std::size_t n = 0; n < children.size(); ++n)
+    positions[n] = children[n].second;
+  return positions;
+}
+
+template <typename C> struct tree_iotaMapMulti_branch;
+
+template <typename C> struct tree_iotaMapMulti_curve : std::tuple<> {
+  template <std::size_t D, typename... Args>
+  auto operator()(std::ptrdiff_t n,
+                  const std::vector<adt::index_t<D>> &positions,
+                  Args &&... args) const {
+    return tree_iotaMapMulti_branch<C>()(positions[n],
+                                         std::forward<Args>(args)...);
   }
 };
 
+// The child at position i of a branch covering all_inds, where the
+// children have the extent scale
 template <typename C> struct tree_iotaMapMulti_branch : std::tuple<> {
-  template <std::size_t D, typename F, typename... Args,
+  template <std::size_t D, typename Placement, typename F, typename... Args,
             typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
             typename CR = typename fun_traits<C>::template constructor<R>>
   auto operator()(const adt::index_t<D> &i, const adt::steprange_t<D> &all_inds,
-                  std::ptrdiff_t scale, F &&f, Args &&... args) const {
-    typedef typename CR::array_dummy A;
+                  const adt::index_t<D> &scale, const tree_policy &policy,
+                  const Placement &placement, F &&f, Args &&... args) const {
+    // Leaf
+    if (adt::all(adt::eq(scale, 1)))
+      return CR{CR::either_t::make_left(
+          cxx::invoke(std::forward<F>(f), i, std::forward<Args>(args)...))};
+    // Branch
     adt::steprange_t<D> inds(
         i, adt::min(i + all_inds.istep() * scale, all_inds.imax()),
         all_inds.istep());
-    cxx_assert(scale % detail::max_tree_linear_size<D> == 0);
-    scale /= detail::max_tree_linear_size<D>;
-    if (scale == 1)
-      return CR{CR::either_t::make_right(
-          iotaMapMulti<A>(tree_iotaMapMulti_leaf<C>(), inds, std::forward<F>(f),
-                          std::forward<Args>(args)...))};
+    std::ptrdiff_t b = tree_linear_size<D>(policy);
+    adt::index_t<D> sub_scale;
+    for (std::size_t d = 0; d < D; ++d)
+      sub_scale[d] = scale[d] == 1 ? 1 : scale[d] / b;
+    return make_branch<CR>(inds, sub_scale, policy, placement,
+                           std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  // Create a branch covering inds, with children of extent scale
+  template <typename CR, std::size_t D, typename Placement, typename F,
+            typename... Args>
+  static CR make_branch(const adt::steprange_t<D> &inds,
+                        const adt::index_t<D> &scale,
+                        const tree_policy &policy, const Placement &placement,
+                        F &&f, Args &&... args) {
+    typedef typename CR::array_dummy A;
+    constexpr std::ptrdiff_t rank = fun_traits<A>::rank;
+    static_assert(rank == D || rank == 1,
+                  "The branches need to be either one-dimensional or have "
+                  "the dimension of the index space");
+    return make_branch<CR>(std::integral_constant<bool, rank == D>(), inds,
+                           scale, policy, placement, std::forward<F>(f),
+                           std::forward<Args>(args)...);
+  }
+
+  // The branches have the same dimension as the index space
+  template <typename CR, std::size_t D, typename Placement, typename F,
+            typename... Args>
+  static CR make_branch(std::true_type, const adt::steprange_t<D> &inds,
+                        const adt::index_t<D> &scale,
+                        const tree_policy &policy, const Placement &placement,
+                        F &&f, Args &&... args) {
+    typedef typename CR::array_dummy A;
     adt::steprange_t<D> branch_inds(inds.imin(), inds.imax(),
                                     inds.istep() * scale);
-    return CR{CR::either_t::make_right(
-        iotaMapMulti<A>(tree_iotaMapMulti_branch<C>(), branch_inds, inds, scale,
-                        std::forward<F>(f), std::forward<Args>(args)...))};
+    return CR{CR::either_t::make_right(tree_place_iotaMapMulti<A>(
+        placement, tree_iotaMapMulti_branch(), branch_inds, inds, scale,
+        policy, placement, std::forward<F>(f), std::forward<Args>(args)...))};
+  }
+
+  // The branches are one-dimensional; order the children along a curve.
+  // Such a branch is placed where its first child would be placed.
+  template <typename CR, std::size_t D, typename Placement, typename F,
+            typename... Args>
+  static CR make_branch(std::false_type, const adt::steprange_t<D> &inds,
+                        const adt::index_t<D> &scale,
+                        const tree_policy &policy, const Placement &placement,
+                        F &&f, Args &&... args) {
+    typedef typename CR::array_dummy A;
+    auto positions = tree_child_positions(inds, scale, policy.order);
+    auto pinned = placement.template pinned<1>(adt::steprange_t<D>(
+        positions.empty() ? inds.imin() : positions[0], inds.imax(),
+        inds.istep() * scale));
+    return CR{CR::either_t::make_right(tree_place_iotaMap<A>(
+        pinned, tree_iotaMapMulti_curve<C>(), adt::irange_t(positions.size()),
+        positions, inds, scale, policy, placement, std::forward<F>(f),
+        std::forward<Args>(args)...))};
   }
 };
-}
 
-template <typename C, std::size_t D, typename F, typename... Args,
-          std::enable_if_t<detail::is_tree<C>::value> *, typename R,
-          typename CR>
-CR iotaMapMulti(F &&f, const adt::steprange_t<D> &inds, Args &&... args) {
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          typename R = cxx::invoke_of_t<F, adt::index_t<D>, Args...>,
+          typename CR = typename fun_traits<C>::template constructor<R>>
+CR tree_iotaMapMulti_impl(const tree_policy &policy,
+                          const Placement &placement, F &&f,
+                          const adt::steprange_t<D> &inds, Args &&... args) {
   // Empty tree: special case
   if (inds.empty())
     return mzero<C, R>();
   // Leaf
   if (inds.size() == 1)
-    return detail::tree_iotaMapMulti_leaf<C>()(inds.imin(), std::forward<F>(f),
-                                               std::forward<Args>(args)...);
+    return CR{CR::either_t::make_left(cxx::invoke(
+        std::forward<F>(f), inds.imin(), std::forward<Args>(args)...))};
+  // Branch
   // Calculate optimal branch size, so that all sub-branches will be full
-  // TODO: Consider different scales in different directions
-  std::ptrdiff_t scale = 1;
-  while (
-      adt::any(adt::gt(inds.shape(), scale * detail::max_tree_linear_size<D>)))
-    scale *= detail::max_tree_linear_size<D>;
-  cxx_assert(
-      adt::any(adt::lt(scale, inds.shape()) &&
-               adt::ge(scale * detail::max_tree_linear_size<D>, inds.shape())));
-  return detail::tree_iotaMapMulti_branch<C>()(
-      inds.imin(), inds, scale * detail::max_tree_linear_size<D>,
+  return tree_iotaMapMulti_branch<C>::template make_branch<CR>(
+      inds, tree_scale(policy, inds.shape()), policy, placement,
       std::forward<F>(f), std::forward<Args>(args)...);
 }
+}
+
+template <typename C, std::size_t D, typename F, typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value> *, typename R,
+          typename CR>
+CR iotaMapMulti(const tree_policy &policy, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  return detail::tree_iotaMapMulti_impl<C>(policy, detail::no_placement(),
+                                           std::forward<F>(f), inds,
+                                           std::forward<Args>(args)...);
+}
+
+template <typename C, typename Placement, std::size_t D, typename F,
+          typename... Args,
+          std::enable_if_t<detail::is_tree<C>::value &&
+                           detail::is_placement<Placement>::value> *,
+          typename R, typename CR>
+CR iotaMapMulti(const tree_policy &policy, const Placement &placement, F &&f,
+                const adt::steprange_t<D> &inds, Args &&... args) {
+  return detail::tree_iotaMapMulti_impl<C>(policy, placement.bind(inds),
+                                           std::forward<F>(f), inds,
+                                           std::forward<Args>(args)...);
+}
 
 // fmap
 
@@ -251,16 +397,54 @@ CR fmap3(F &&f, const adt::tree<A, T> &xs, const adt::tree<A, T2> &ys,
 
 // head, last
 
+namespace detail {
+struct tree_head : std::tuple<> {
+  template <typename A, typename T>
+  T operator()(const adt::tree<A, T> &xs, std::ptrdiff_t i) const {
+    return head(xs);
+  }
+};
+struct tree_last : std::tuple<> {
+  template <typename A, typename T>
+  T operator()(const adt::tree<A, T> &xs, std::ptrdiff_t i) const {
+    return last(xs);
+  }
+};
+
+// If the subtrees are one-dimensional, the first (last) subtree is
+// their lower (upper) boundary, and boundaryMap extracts the element
+// there without copying the subtree. Otherwise, this boundary is a
+// whole face, and we copy the first (last) subtree instead.
+template <typename A, typename T>
+T tree_head_impl(std::true_type, const adt::tree<A, T> &xs) {
+  return head(boundaryMap(tree_head(), xs.subtrees.get_right(), 0));
+}
+template <typename A, typename T>
+T tree_head_impl(std::false_type, const adt::tree<A, T> &xs) {
+  return head(head(xs.subtrees.get_right()));
+}
+template <typename A, typename T>
+T tree_last_impl(std::true_type, const adt::tree<A, T> &xs) {
+  return last(boundaryMap(tree_last(), xs.subtrees.get_right(), 1));
+}
+template <typename A, typename T>
+T tree_last_impl(std::false_type, const adt::tree<A, T> &xs) {
+  return last(last(xs.subtrees.get_right()));
+}
+}
+
 template <typename A, typename T> T head(const adt::tree<A, T> &xs) {
-  // TODO: head(head(...)) copies subtrees; call boundaryMap instead
-  // TODO: This is slow; call boundaryMap instead
-  return xs.subtrees.left() ? xs.subtrees.get_left()
-                            : head(head(xs.subtrees.get_right()));
+  if (xs.subtrees.left())
+    return xs.subtrees.get_left();
+  return detail::tree_head_impl(
+      std::integral_constant<bool, fun_traits<A>::rank == 1>(), xs);
 }
 
 template <typename A, typename T> T last(const adt::tree<A, T> &xs) {
-  return xs.subtrees.left() ? xs.subtrees.get_left()
-                            : last(last(xs.subtrees.get_right()));
+  if (xs.subtrees.left())
+    return xs.subtrees.get_left();
+  return detail::tree_last_impl(
+      std::integral_constant<bool, fun_traits<A>::rank == 1>(), xs);
 }
 
 // boundary
@@ -279,9 +463,8 @@ BCT boundary(const adt::tree<A, T> &xs, std::ptrdiff_t i) {
   bool s = xs.subtrees.right();
   if (!s)
     return munit<BC>(xs.subtrees.get_left());
-  // TODO: use boundaryMap instead to avoid copying subtrees
   return BCT{BCT::either_t::make_right(
-      fmap(detail::tree_boundary(), boundary(xs.subtrees.get_right(), i), i))};
+      boundaryMap(detail::tree_boundary(), xs.subtrees.get_right(), i))};
 }
 
 // boundaryMap
@@ -327,8 +510,7 @@ template <typename G> struct tree_fmapStencil_g {
   template <typename Archive> void serialize(Archive &ar) { ar(g); }
   template <typename A, typename T>
   auto operator()(const adt::tree<A, T> &xs, std::ptrdiff_t i) const {
-    // TODO: This is slow; call boundaryMap instead
-    return i == 0 ? cxx::invoke(g, head(xs), i) : cxx::invoke(g, last(xs), i);
+    return mextract(boundaryMap(g, xs, i));
   }
 };
 }
@@ -506,6 +688,40 @@ R foldMap2(F &&f, Op &&op, Z &&z, const adt::tree<A, T> &xs,
                   std::forward<Args>(args)...);
 }
 
+// fmapFoldPair
+
+namespace detail {
+struct tree_fmapFoldPair : std::tuple<> {
+  template <typename A, typename T, typename F, typename Op, typename Z,
+            typename... Args>
+  auto operator()(const adt::tree<A, T> &xs, F &&f, Op &&op, Z &&z,
+                  Args &&... args) const {
+    return fmapFoldPair(std::forward<F>(f), std::forward<Op>(op),
+                        std::forward<Z>(z), xs, std::forward<Args>(args)...);
+  }
+};
+}
+
+template <typename F, typename Op, typename Z, typename A, typename T,
+          typename... Args, typename CT, typename RS, typename R, typename S,
+          typename CR>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z, const adt::tree<A, T> &xs,
+                              Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
+  bool s = xs.subtrees.right();
+  if (!s) {
+    auto ys = cxx::invoke(std::forward<F>(f), xs.subtrees.get_left(),
+                          std::forward<Args>(args)...);
+    return {CR{CR::either_t::make_left(std::move(ys.first))},
+            std::move(ys.second)};
+  }
+  auto yss = fmapFoldPair(detail::tree_fmapFoldPair(), op, z,
+                          xs.subtrees.get_right(), std::forward<F>(f), op, z,
+                          std::forward<Args>(args)...);
+  return {CR{CR::either_t::make_right(std::move(yss.first))},
+          std::move(yss.second)};
+}
+
 // dump
 
 namespace detail {
@@ -1,17 +1,22 @@
 #include <fun/nested_decl.hpp>
 
+#include <fun/grid_decl.hpp>
 #include <fun/idtype.hpp>
 #include <fun/shared_future.hpp>
 #include <fun/shared_ptr.hpp>
 #include <fun/tree_decl.hpp>
 #include <fun/vector.hpp>
 
+#include <fun/grid_impl.hpp>
 #include <fun/nested_impl.hpp>
 
 #include <fun/tree_impl.hpp>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace fun;
 
 namespace {
@@ -27,7 +32,12 @@ template <typename T>
 using future_tree = adt::tree<future_vector<adt::dummy>, T>;
 }
 
-// TODO: Test trees of grids
+template <typename T>
+using shared_grid =
+    adt::nested<std::shared_ptr<adt::dummy>,
+                adt::grid<std::vector<adt::dummy>, adt::dummy, 2>, T>;
+template <typename T>
+using shared_grid_tree = adt::tree<shared_grid<adt::dummy>, T>;
 
 TEST(fun_tree, iotaMap) {
   for (std::ptrdiff_t s = 0; s < 110; ++s) {
@@ -68,6 +78,24 @@ TEST(fun_tree, fmap) {
   EXPECT_EQ(19, last(zs));
 }
 
+TEST(fun_tree, fmapFold) {
+  std::ptrdiff_t s = 100;
+  auto xs = iotaMap<shared_tree<adt::dummy>>([](auto x) { return int(x); }, s);
+  auto sq = [](auto x) { return x * x; };
+  auto id = [](auto x) { return x; };
+  auto add = [](auto x, auto y) { return x + y; };
+  auto rs = fmapFold(sq, id, add, 0, xs);
+  static_assert(std::is_same<decltype(rs.first), shared_tree<int>>::value, "");
+  EXPECT_EQ(s, msize(rs.first));
+  EXPECT_EQ((s - 1) * (s - 1), last(rs.first));
+  EXPECT_EQ((s - 1) * s * (2 * s - 1) / 6, rs.second);
+
+  auto x2s = iotaMap<future_tree<adt::dummy>>([](auto x) { return int(x); }, s);
+  auto r2s = fmapFold(sq, id, add, 0, x2s);
+  EXPECT_EQ(foldMap(id, add, 0, rs.first), foldMap(id, add, 0, r2s.first));
+  EXPECT_EQ(rs.second, r2s.second);
+}
+
 TEST(fun_tree, boundary) {
   std::ptrdiff_t s = 10;
 
@@ -90,7 +118,42 @@ TEST(fun_tree, boundary) {
   // TODO: test other tree types
 }
 
-// TODO: test boundaryMap
+TEST(fun_tree, boundaryMap) {
+  std::ptrdiff_t s = 100;
+  auto xs = iotaMap<shared_tree<adt::dummy>>([](int x) { return x * x; }, s);
+  auto f = [](int x, std::ptrdiff_t i, int y) { return x + 2 * int(i) + y; };
+  auto bm = boundaryMap(f, xs, 0, 1000);
+  auto bp = boundaryMap(f, xs, 1, 1000);
+  EXPECT_EQ(1, msize(bm));
+  EXPECT_EQ(1000, mextract(bm));
+  EXPECT_EQ((s - 1) * (s - 1) + 2 + 1000, mextract(bp));
+  EXPECT_EQ(0, head(xs));
+  EXPECT_EQ((s - 1) * (s - 1), last(xs));
+
+  // The boundaries of a two-dimensional tree are one-dimensional
+  adt::index_t<2> n{{9, 7}};
+  auto ys = iotaMapMulti<shared_grid_tree<adt::dummy>>(
+      tree_policy(4), [](adt::index_t<2> x) { return int(10 * x[0] + x[1]); },
+      adt::steprange_t<2>(n));
+  auto id = [](int x) { return x; };
+  auto add = [](int x, int y) { return x + y; };
+  for (std::ptrdiff_t i = 0; i < 4; ++i) {
+    std::ptrdiff_t dir = i / 2, face = i % 2;
+    auto bys = boundaryMap([](int x, std::ptrdiff_t, int y) { return x + y; },
+                           ys, i, 1);
+    auto cys = boundary(ys, i);
+    EXPECT_EQ(n[1 - dir], msize(bys));
+    EXPECT_EQ(msize(cys) + foldMap(id, add, 0, cys), foldMap(id, add, 0, bys));
+    int sum = 0;
+    for (std::ptrdiff_t j = 0; j < n[1 - dir]; ++j) {
+      adt::index_t<2> x;
+      x[dir] = face ? n[dir] - 1 : 0;
+      x[1 - dir] = j;
+      sum += 10 * x[0] + x[1] + 1;
+    }
+    EXPECT_EQ(sum, foldMap(id, add, 0, bys));
+  }
+}
 
 TEST(fun_tree, fmapStencil) {
   std::ptrdiff_t s = 10;
@@ -147,3 +210,62 @@ TEST(fun_tree, monad) {
   EXPECT_FALSE(mempty(ps));
   EXPECT_FALSE(mempty(ss));
 }
+
+namespace {
+// The indices of a tree, in the order of its elements
+template <typename C> std::vector<adt::index_t<2>> indices_of(const C &xs) {
+  typedef std::vector<adt::index_t<2>> indices;
+  return foldMap([](const auto &i) { return indices{i}; },
+                 [](indices is, const indices &js) {
+                   is.insert(is.end(), js.begin(), js.end());
+                   return is;
+                 },
+                 indices(), xs);
+}
+}
+
+TEST(fun_tree, iotaMapMulti) {
+  auto id = [](const adt::index_t<2> &i) { return i; };
+  const adt::index_t<2> shape{{8, 8}};
+  const adt::steprange_t<2> inds(shape);
+  typedef shared_tree<adt::dummy> C;
+
+  // With two children per direction, the elements follow a Morton curve
+  auto ms = iotaMapMulti<C>(tree_policy(4, fun::tree_order::morton), id, inds);
+  auto is = indices_of(ms);
+  EXPECT_EQ(64, is.size());
+  for (std::size_t n = 0; n < is.size(); ++n)
+    EXPECT_EQ(n, adt::morton_key(is[n], 3));
+
+  for (auto order : {fun::tree_order::lexicographic, fun::tree_order::morton,
+                     fun::tree_order::hilbert}) {
+    for (std::ptrdiff_t max_size : {2, 4, 9, 16}) {
+      auto xs = iotaMapMulti<C>(tree_policy(max_size, order), id, inds);
+      auto is = indices_of(xs);
+      EXPECT_EQ(adt::prod(shape), is.size());
+      std::sort(is.begin(), is.end());
+      EXPECT_EQ(is.end(), std::unique(is.begin(), is.end()));
+      EXPECT_EQ(adt::index_t<2>(), is.front());
+      EXPECT_EQ(shape - 1, is.back());
+    }
+  }
+
+  // Short directions are not split further than necessary
+  auto ys = iotaMapMulti<C>(id, adt::steprange_t<2>(adt::index_t<2>{{64, 2}}));
+  EXPECT_EQ(128, msize(ys));
+  EXPECT_EQ(8, msize(ys.subtrees.get_right()));
+
+  // Trees of grids keep the layout of the grids
+  typedef shared_grid_tree<adt::dummy> G;
+  for (const auto &shape : {adt::index_t<2>{{8, 8}}, adt::index_t<2>{{7, 10}},
+                            adt::index_t<2>{{100, 3}}}) {
+    auto zs = iotaMapMulti<G>(id, adt::steprange_t<2>(shape));
+    auto is = indices_of(zs);
+    EXPECT_EQ(adt::prod(shape), is.size());
+    std::sort(is.begin(), is.end());
+    EXPECT_EQ(is.end(), std::unique(is.begin(), is.end()));
+    EXPECT_EQ(shape - 1, is.back());
+  }
+  auto zs = iotaMapMulti<G>(id, adt::steprange_t<2>(adt::index_t<2>{{64, 2}}));
+  EXPECT_EQ(8, msize(zs.subtrees.get_right()));
+}
@@ -4,7 +4,10 @@
 #include <adt/dummy.hpp>
 #include <adt/index.hpp>
 #include <cxx/cassert.hpp>
+#include <cxx/execution.hpp>
 #include <cxx/invoke.hpp>
+#include <cxx/memory.hpp>
+#include <fun/fold.hpp>
 #include <fun/fun_decl.hpp>
 #include <fun/idtype.hpp>
 
@@ -105,7 +108,8 @@ CR fmap(F &&f, const std::vector<T, Allocator> &xs, Args &&... args) {
 template <typename F, typename T, typename Allocator, typename... Args,
           typename CT = std::vector<T, Allocator>,
           typename R = cxx::invoke_of_t<F, T, Args...>,
-          typename CR = typename fun_traits<CT>::template constructor<R>>
+          typename CR = typename fun_traits<CT>::template constructor<R>,
+          std::enable_if_t<!std::is_same<CR, CT>::value> * = nullptr>
 CR fmap(F &&f, std::vector<T, Allocator> &&xs, Args &&... args) {
   std::ptrdiff_t s = xs.size();
   CR rs(s);
@@ -115,6 +119,20 @@ CR fmap(F &&f, std::vector<T, Allocator> &&xs, Args &&... args) {
   return rs;
 }
 
+// If the result has the same type, reuse the storage of xs
+template <typename F, typename T, typename Allocator, typename... Args,
+          typename CT = std::vector<T, Allocator>,
+          typename R = cxx::invoke_of_t<F, T, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>,
+          std::enable_if_t<std::is_same<CR, CT>::value> * = nullptr>
+CR fmap(F &&f, std::vector<T, Allocator> &&xs, Args &&... args) {
+  std::ptrdiff_t s = xs.size();
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    xs[i] = cxx::invoke(f, std::move(xs[i]), args...);
+  return std::move(xs);
+}
+
 template <typename F, typename T, typename Allocator, typename T2,
           typename Allocator2, typename... Args,
           typename CT = std::vector<T, Allocator>,
@@ -131,6 +149,25 @@ CR fmap2(F &&f, const std::vector<T, Allocator> &xs,
   return rs;
 }
 
+template <typename F, typename T, typename Allocator, typename T2,
+          typename Allocator2, typename... Args,
+          typename CT = std::vector<T, Allocator>,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>,
+          typename CR = typename fun_traits<CT>::template constructor<R>,
+          std::enable_if_t<std::is_same<CR, CT>::value> * = nullptr>
+CR fmap2(F &&f, std::vector<T, Allocator> &&xs,
+         const std::vector<T2, Allocator2> &ys, Args &&... args) {
+  if (__builtin_expect(static_cast<const void *>(&xs) == &ys, false))
+    return fmap2(std::forward<F>(f), static_cast<const CT &>(xs), ys,
+                 std::forward<Args>(args)...);
+  std::ptrdiff_t s = xs.size();
+  cxx_assert(std::ptrdiff_t(ys.size()) == s);
+#pragma omp simd
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    xs[i] = cxx::invoke(f, std::move(xs[i]), ys[i], args...);
+  return std::move(xs);
+}
+
 template <typename F, typename T, typename Allocator, typename T2,
           typename Allocator2, typename T3, typename Allocator3,
           typename... Args, typename CT = std::vector<T, Allocator>,
@@ -282,11 +319,19 @@ class accumulator<std::vector<T, Allocator>> {
   std::vector<T, Allocator> data;
 
 public:
+  // The alignment of the storage, in bytes
+  static constexpr std::size_t alignment =
+      cxx::allocator_alignment<Allocator>::value;
+
   accumulator(std::ptrdiff_t n) : data(n) {}
+  // Take over the storage of xs, keeping its elements
+  explicit accumulator(std::vector<T, Allocator> &&xs) : data(std::move(xs)) {}
   T &restrict operator[](std::ptrdiff_t i) { return data[i]; }
   decltype(auto) finalize() { return std::move(data); }
   ~accumulator() { cxx_assert(data.empty()); }
 };
+template <typename T, typename Allocator>
+constexpr std::size_t accumulator<std::vector<T, Allocator>>::alignment;
 
 // foldMap
 
@@ -295,17 +340,9 @@ template <typename F, typename Op, typename Z, typename T, typename Allocator,
 R foldMap(F &&f, Op &&op, Z &&z, const std::vector<T, Allocator> &xs,
           Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
-  std::ptrdiff_t s = xs.size();
-  R r(z);
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], args...));
-  return r;
+  return detail::fold_range(op, R(z), xs.size(), [&](std::ptrdiff_t i) {
+    return cxx::invoke(f, xs[i], args...);
+  });
 }
 
 template <typename F, typename Op, typename Z, typename T, typename Allocator,
@@ -313,18 +350,21 @@ template <typename F, typename Op, typename Z, typename T, typename Allocator,
 R foldMap(F &&f, Op &&op, Z &&z, std::vector<T, Allocator> &&xs,
           Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
-  std::ptrdiff_t s = xs.size();
-  R r(z);
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r),
-                    cxx::invoke(f, std::move(xs[i]), args...));
-  return r;
+  return detail::fold_range(op, R(z), xs.size(), [&](std::ptrdiff_t i) {
+    return cxx::invoke(f, std::move(xs[i]), args...);
+  });
+}
+
+template <typename Policy, typename F, typename Op, typename Z, typename T,
+          typename Allocator, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, Args...>>
+R foldMap(const Policy &policy, F &&f, Op &&op, Z &&z,
+          const std::vector<T, Allocator> &xs, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  return detail::fold(policy, op, R(z), xs.size(), [&](std::ptrdiff_t i) {
+    return cxx::invoke(f, xs[i], args...);
+  });
 }
 
 template <typename F, typename Op, typename Z, typename T, typename Allocator,
@@ -333,18 +373,65 @@ template <typename F, typename Op, typename Z, typename T, typename Allocator,
 R foldMap2(F &&f, Op &&op, Z &&z, const std::vector<T, Allocator> &xs,
            const std::vector<T2, Allocator2> &ys, Args &&... args) {
   static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  cxx_assert(ys.size() == xs.size());
+  return detail::fold_range(op, R(z), xs.size(), [&](std::ptrdiff_t i) {
+    return cxx::invoke(f, xs[i], ys[i], args...);
+  });
+}
+
+template <typename Policy, typename F, typename Op, typename Z, typename T,
+          typename Allocator, typename T2, typename Allocator2,
+          typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename R = cxx::invoke_of_t<F, T, T2, Args...>>
+R foldMap2(const Policy &policy, F &&f, Op &&op, Z &&z,
+           const std::vector<T, Allocator> &xs,
+           const std::vector<T2, Allocator2> &ys, Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, R, R>, R>::value, "");
+  cxx_assert(ys.size() == xs.size());
+  return detail::fold(policy, op, R(z), xs.size(), [&](std::ptrdiff_t i) {
+    return cxx::invoke(f, xs[i], ys[i], args...);
+  });
+}
+
+// fmapFoldPair
+
+// f returns a pair; the first elements form the resulting container,
+// and the second elements are folded
+template <typename Policy, typename F, typename Op, typename Z, typename T,
+          typename Allocator, typename... Args,
+          std::enable_if_t<cxx::is_execution_policy<Policy>::value> * = nullptr,
+          typename CT = std::vector<T, Allocator>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(const Policy &policy, F &&f, Op &&op, Z &&z,
+                              const std::vector<T, Allocator> &xs,
+                              Args &&... args) {
+  static_assert(std::is_same<cxx::invoke_of_t<Op, S, S>, S>::value, "");
   std::ptrdiff_t s = xs.size();
-  cxx_assert(std::ptrdiff_t(ys.size()) == s);
-  R r(z);
-#if 0
-#pragma omp declare reduction(red : R : (                                      \
-    omp_out = cxx::invoke(op, std::move(omp_out),                              \
-                                        omp_in))) initializer(omp_priv(z))
-#pragma omp simd reduction(red : r)
-#endif
-  for (std::ptrdiff_t i = 0; i < s; ++i)
-    r = cxx::invoke(op, std::move(r), cxx::invoke(f, xs[i], ys[i], args...));
-  return r;
+  CR rs(s);
+  S r = detail::fold(policy, op, S(z), s, [&](std::ptrdiff_t i) {
+    auto y = cxx::invoke(f, xs[i], args...);
+    rs[i] = std::move(y.first);
+    return std::move(y.second);
+  });
+  return {std::move(rs), std::move(r)};
+}
+
+template <typename F, typename Op, typename Z, typename T, typename Allocator,
+          typename... Args, typename CT = std::vector<T, Allocator>,
+          typename RS = cxx::invoke_of_t<F, T, Args...>,
+          typename R = std::decay_t<typename RS::first_type>,
+          typename S = std::decay_t<typename RS::second_type>,
+          typename CR = typename fun_traits<CT>::template constructor<R>>
+std::pair<CR, S> fmapFoldPair(F &&f, Op &&op, Z &&z,
+                              const std::vector<T, Allocator> &xs,
+                              Args &&... args) {
+  return fmapFoldPair(cxx::execution::seq, std::forward<F>(f),
+                      std::forward<Op>(op), std::forward<Z>(z), xs,
+                      std::forward<Args>(args)...);
 }
 
 // dump
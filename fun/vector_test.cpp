@@ -61,6 +61,30 @@ TEST(fun_vector, fmap) {
   EXPECT_EQ((s - 1) * s / 2, accum);
 }
 
+TEST(fun_vector, fmap_inplace) {
+  std::ptrdiff_t s = 10;
+  std::vector<int> xs(s);
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    xs[i] = i;
+  auto ys = xs;
+
+  const int *p = xs.data();
+  auto rs = fmap([](int i) { return i + 1; }, std::move(xs));
+  EXPECT_EQ(p, rs.data());
+  auto rs2 = fmap2([](int i, int j) { return i + j; }, std::move(rs), ys);
+  EXPECT_EQ(p, rs2.data());
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    EXPECT_EQ(2 * i + 1, rs2[i]);
+
+  auto rs3 = fmap2([](int i, int j) { return i + j; }, std::move(ys), ys);
+  for (std::ptrdiff_t i = 0; i < s; ++i)
+    EXPECT_EQ(2 * i, rs3[i]);
+
+  auto rs4 = fmap([](int i) { return double(i); }, std::move(rs2));
+  static_assert(std::is_same<decltype(rs4), std::vector<double>>::value, "");
+  EXPECT_EQ(s, rs4.size());
+}
+
 TEST(fun_vector, fmapStencil) {
   std::ptrdiff_t s = 10;
   auto xs = iotaMap<std::vector<adt::dummy>>([](int x) { return x * x; }, s);
@@ -5,6 +5,7 @@
 #include <cxx/invoke.hpp>
 #include <funhpc/rexec.hpp>
 #include <funhpc/rptr.hpp>
+#include <funhpc/steal.hpp>
 #include <qthread/future.hpp>
 
 #include <cereal/types/tuple.hpp>
@@ -21,6 +22,9 @@ enum class rlaunch : unsigned {
   deferred = static_cast<unsigned>(qthread::launch::deferred),
   sync = static_cast<unsigned>(qthread::launch::sync),
   detached = static_cast<unsigned>(qthread::launch::detached),
+  // Run on any process; dest only chooses where the task is queued
+  // (see funhpc/steal.hpp)
+  any = 16,
 };
 
 inline constexpr rlaunch operator~(rlaunch a) {
@@ -55,12 +59,14 @@ namespace detail {
     return rlaunch::sync;
   if ((policy | rlaunch::detached) == rlaunch::detached)
     return rlaunch::detached;
+  if ((policy | rlaunch::any) == rlaunch::any)
+    return rlaunch::any;
   return rlaunch::async;
 }
 
 // Convert policy to a local policy
 constexpr qthread::launch local_policy(rlaunch policy) {
-  return static_cast<qthread::launch>(policy);
+  return static_cast<qthread::launch>(policy & ~rlaunch::any);
 }
 }
 
@@ -103,6 +109,17 @@ template <typename F, typename... Args,
               cxx::invoke_of_t<std::decay_t<F>, std::decay_t<Args>...>>>
 qthread::future<R> async(rlaunch policy, std::ptrdiff_t dest, F &&f,
                          Args &&... args) {
+  if (detail::decode_policy(policy) == rlaunch::any) {
+    auto pres = new qthread::promise<R>;
+    auto fres = pres->get_future();
+    task_t::register_type<detail::continued<R>, rptr<qthread::promise<R>>,
+                          std::decay_t<F>, std::decay_t<Args>...>();
+    steal::enqueue(dest,
+                   task_t(detail::continued<R>(),
+                          rptr<qthread::promise<R>>(pres), std::forward<F>(f),
+                          std::forward<Args>(args)...));
+    return fres;
+  }
   if (dest == rank())
     return qthread::async(detail::local_policy(policy), std::forward<F>(f),
                           std::forward<Args>(args)...);
@@ -131,6 +148,8 @@ qthread::future<R> async(rlaunch policy, std::ptrdiff_t dest, F &&f,
     rexec(dest, std::forward<F>(f), std::forward<Args>(args)...);
     return qthread::future<R>();
   }
+  case rlaunch::any:
+    break;
   }
   __builtin_unreachable();
 }
@@ -145,11 +164,12 @@ qthread::future<R> async(rlaunch policy,
   if (fdest.ready())
     return async(policy, fdest.get(), std::forward<F>(f),
                  std::forward<Args>(args)...);
+  bool any = detail::decode_policy(policy) == rlaunch::any;
   return qthread::async(
-      detail::local_policy(policy),
-      [fdest = std::move(fdest)](auto &&f, auto &&... args) mutable {
-        return async(rlaunch::sync, fdest.get(), std::move(f),
-                     std::move(args)...)
+      any ? qthread::launch::async : detail::local_policy(policy),
+      [ fdest = std::move(fdest), any ](auto &&f, auto &&... args) mutable {
+        return async(any ? rlaunch::any : rlaunch::sync, fdest.get(),
+                     std::move(f), std::move(args)...)
             .get();
       },
       std::forward<F>(f), std::forward<Args>(args)...);
@@ -3,6 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <numeric>
+#include <vector>
+
 using namespace funhpc;
 using namespace qthread;
 
@@ -105,3 +109,31 @@ TEST(funhpc_async, detached) {
   EXPECT_FALSE(ires.valid());
   qthread::this_thread::sleep_for(std::chrono::milliseconds(200));
 }
+
+namespace {
+int busy_rank() {
+  auto t0 = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(2))
+    ;
+  return rank();
+}
+}
+
+TEST(funhpc_async, any) {
+  auto fres = async(rlaunch::any, 1 % size(), add, 1, 2);
+  EXPECT_EQ(3, fres.get());
+
+  // Queue many tasks on this process; idle processes steal some of them
+  std::vector<future<int>> fs;
+  for (int n = 0; n < 200; ++n)
+    fs.push_back(async(rlaunch::any, rank(), busy_rank));
+  std::vector<int> counts(size(), 0);
+  for (auto &f : fs) {
+    int p = f.get();
+    ASSERT_TRUE(p >= 0 && p < size());
+    ++counts[p];
+  }
+  EXPECT_EQ(200, std::accumulate(counts.begin(), counts.end(), 0));
+  if (size() > 1)
+    EXPECT_LT(counts[rank()], 200);
+}
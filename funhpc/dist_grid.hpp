@@ -0,0 +1,53 @@
+#ifndef FUNHPC_DIST_GRID_HPP
+#define FUNHPC_DIST_GRID_HPP
+
+#include <adt/grid_decl.hpp>
+#include <cxx/cassert.hpp>
+#include <funhpc/halo.hpp>
+#include <funhpc/proxy.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace funhpc {
+
+// A grid that is distributed over all processes. It consists of
+// blocks (adt::grid), placed as given by the plan. Each process holds
+// its blocks in a single part, so that an operation on the grid sends
+// one message per process, and a stencil one message per neighbouring
+// process (see fun/dist_grid.hpp).
+template <typename C, typename T, std::size_t D> struct dist_grid {
+  typedef adt::grid<C, T, D> block_type;
+  typedef std::vector<block_type> part_type; // ordered by position
+  typedef halo_plan<D> plan_type;
+
+  std::shared_ptr<const plan_type> plan;
+  std::vector<proxy<part_type>> parts; // by process; empty if no blocks
+
+  dist_grid() = default;
+  dist_grid(const std::shared_ptr<const plan_type> &plan,
+            std::vector<proxy<part_type>> parts)
+      : plan(plan), parts(std::move(parts)) {
+    cxx_assert(invariant());
+  }
+
+  bool invariant() const noexcept {
+    if (!plan)
+      return parts.empty();
+    if (std::ptrdiff_t(parts.size()) != plan->nprocs())
+      return false;
+    for (std::ptrdiff_t p = 0; p < plan->nprocs(); ++p)
+      if (bool(parts[p]) == plan->exchange(p).blocks.empty())
+        return false;
+    return true;
+  }
+};
+}
+
+#define FUNHPC_DIST_GRID_HPP_DONE
+#endif // #ifdef FUNHPC_DIST_GRID_HPP
+#ifndef FUNHPC_DIST_GRID_HPP_DONE
+#error "Cyclic include dependency"
+#endif
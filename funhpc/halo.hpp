@@ -0,0 +1,279 @@
+#ifndef FUNHPC_HALO_HPP
+#define FUNHPC_HALO_HPP
+
+#include <adt/index.hpp>
+#include <cxx/cassert.hpp>
+
+#include <cereal/types/array.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace funhpc {
+
+// The decomposition of a distributed grid into blocks, and the halo
+// exchange between these blocks. Block b lives on process owner(b),
+// where it is at position(b) in the process's part of the grid.
+// A stencil on a block needs, for each face i = 2*d+f, the opposite
+// face of the neighbouring block, or the boundary at the outer
+// boundary. The neighbour graph, and the faces that each process
+// receives from each other process, are computed once here and are
+// shared by all grids with the same decomposition.
+template <std::size_t D> class halo_plan {
+public:
+  typedef adt::index_t<D> index_type;
+  typedef halo_plan<D == 0 ? 0 : D - 1> face_plan_type;
+
+  // Where a block finds one of its faces: at position n in the
+  // message from the neighbouring process in slot s (s, n), or at
+  // position n in the process's part of the boundary grid (-1, n)
+  typedef std::pair<std::ptrdiff_t, std::ptrdiff_t> source_t;
+
+  // The halo exchange of one process
+  struct exchange_t {
+    std::vector<std::ptrdiff_t> blocks; // blocks owned by the process
+    std::vector<std::size_t> outer;     // bits of their outer faces
+    std::vector<std::array<source_t, 2 * D>> sources;
+    // One slot per neighbouring process (including the process
+    // itself), with the faces (position, face) it sends
+    std::vector<std::ptrdiff_t> procs;
+    std::vector<std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>>> faces;
+
+    template <typename Archive> void serialize(Archive &ar) {
+      ar(blocks, outer, sources, procs, faces);
+    }
+  };
+
+private:
+  index_type m_shape, m_block_shape, m_nblocks;
+  std::ptrdiff_t m_nprocs;
+  std::vector<std::ptrdiff_t> m_owners, m_positions;
+  std::vector<exchange_t> m_exchanges;
+  std::array<std::shared_ptr<const face_plan_type>, 2 * D> m_face_plans;
+
+public:
+  // Split the grid into blocks of about equal size, at least nblocks
+  // of them (if the grid is large enough)
+  static index_type default_block_shape(const index_type &shape,
+                                        std::ptrdiff_t nblocks) {
+    index_type counts = adt::set<index_type>(1);
+    while (adt::prod(counts) < nblocks) {
+      // Split the direction with the largest blocks
+      std::ptrdiff_t dmax = -1, smax = 1;
+      for (std::size_t d = 0; d < D; ++d) {
+        std::ptrdiff_t s = (shape[d] + counts[d] - 1) / counts[d];
+        if (s > smax || (s == smax && dmax >= 0)) {
+          dmax = d;
+          smax = s;
+        }
+      }
+      if (dmax < 0)
+        break;
+      counts[dmax] = std::min(2 * counts[dmax], shape[dmax]);
+    }
+    index_type block_shape;
+    for (std::size_t d = 0; d < D; ++d)
+      block_shape[d] = std::max(std::ptrdiff_t(1),
+                                (shape[d] + counts[d] - 1) / counts[d]);
+    return block_shape;
+  }
+
+  // Distribute the blocks in contiguous chunks over the processes
+  halo_plan(const index_type &shape, const index_type &block_shape,
+            std::ptrdiff_t nprocs)
+      : halo_plan(shape, block_shape, nprocs, {}) {}
+
+  // Use the given owners of the blocks
+  halo_plan(const index_type &shape, const index_type &block_shape,
+            std::ptrdiff_t nprocs, std::vector<std::ptrdiff_t> owners)
+      : m_shape(shape), m_block_shape(block_shape), m_nprocs(nprocs),
+        m_owners(std::move(owners)) {
+    cxx_assert(m_nprocs > 0);
+    for (std::size_t d = 0; d < D; ++d) {
+      cxx_assert(m_shape[d] >= 0 && m_block_shape[d] > 0);
+      m_nblocks[d] = (m_shape[d] + m_block_shape[d] - 1) / m_block_shape[d];
+    }
+    std::ptrdiff_t nb = size();
+    if (m_owners.empty()) {
+      m_owners.resize(nb);
+      for (std::ptrdiff_t b = 0; b < nb; ++b)
+        m_owners[b] = b * m_nprocs / nb;
+    }
+    cxx_assert(std::ptrdiff_t(m_owners.size()) == nb);
+    m_positions.resize(nb);
+    std::vector<std::ptrdiff_t> counts(m_nprocs, 0);
+    for (std::ptrdiff_t b = 0; b < nb; ++b) {
+      cxx_assert(m_owners[b] >= 0 && m_owners[b] < m_nprocs);
+      m_positions[b] = counts[m_owners[b]]++;
+    }
+    for (std::size_t i = 0; i < 2 * D; ++i)
+      m_face_plans[i] = make_face_plan(i);
+    setup_exchanges();
+  }
+
+  bool invariant() const noexcept {
+    return std::ptrdiff_t(m_owners.size()) == size() &&
+           std::ptrdiff_t(m_exchanges.size()) == m_nprocs;
+  }
+
+  const index_type &shape() const { return m_shape; }
+  const index_type &block_shape() const { return m_block_shape; }
+  const index_type &nblocks() const { return m_nblocks; }
+  std::ptrdiff_t nprocs() const { return m_nprocs; }
+  // Number of blocks
+  std::ptrdiff_t size() const { return adt::prod(m_nblocks); }
+
+  std::ptrdiff_t owner(std::ptrdiff_t b) const {
+    cxx_assert(b >= 0 && b < size());
+    return m_owners[b];
+  }
+  std::ptrdiff_t position(std::ptrdiff_t b) const {
+    cxx_assert(b >= 0 && b < size());
+    return m_positions[b];
+  }
+  const exchange_t &exchange(std::ptrdiff_t p) const {
+    cxx_assert(p >= 0 && p < m_nprocs);
+    return m_exchanges[p];
+  }
+  const std::shared_ptr<const face_plan_type> &face_plan(std::size_t i) const {
+    cxx_assert(i < 2 * D);
+    return m_face_plans[i];
+  }
+
+  // Blocks are numbered with direction 0 varying fastest
+  index_type block_index(std::ptrdiff_t b) const {
+    cxx_assert(b >= 0 && b < size());
+    index_type bi;
+    for (std::size_t d = 0; d < D; ++d) {
+      bi[d] = b % m_nblocks[d];
+      b /= m_nblocks[d];
+    }
+    return bi;
+  }
+  std::ptrdiff_t block_linear(const index_type &bi) const {
+    std::ptrdiff_t b = 0;
+    for (std::ptrdiff_t d = std::ptrdiff_t(D) - 1; d >= 0; --d) {
+      cxx_assert(bi[d] >= 0 && bi[d] < m_nblocks[d]);
+      b = b * m_nblocks[d] + bi[d];
+    }
+    return b;
+  }
+  // The points of block b
+  adt::range_t<D> block_range(std::ptrdiff_t b) const {
+    auto imin = block_index(b) * m_block_shape;
+    return adt::range_t<D>(imin, adt::min(imin + m_block_shape, m_shape));
+  }
+
+  // The neighbour of block b across face i, or -1 at the outer boundary
+  std::ptrdiff_t neighbour(std::ptrdiff_t b, std::size_t i) const {
+    cxx_assert(i < 2 * D);
+    std::size_t f = i % 2, d = i / 2;
+    auto bi = block_index(b);
+    bi[d] += f ? +1 : -1;
+    if (bi[d] < 0 || bi[d] >= m_nblocks[d])
+      return -1;
+    return block_linear(bi);
+  }
+  // The block of the boundary grid at face i that is adjacent to block
+  // b, and vice versa
+  std::ptrdiff_t face_block(std::ptrdiff_t b, std::size_t i) const {
+    return face_plan(i)->block_linear(face_index(block_index(b), i));
+  }
+  std::ptrdiff_t block_at_face(std::ptrdiff_t fb, std::size_t i) const {
+    return block_linear(face_block_index(face_plan(i)->block_index(fb), i));
+  }
+
+  // Grids with equal plans have their blocks in the same places
+  bool operator==(const halo_plan &other) const {
+    return this == &other ||
+           (m_shape == other.m_shape && m_block_shape == other.m_block_shape &&
+            m_owners == other.m_owners);
+  }
+  bool operator!=(const halo_plan &other) const { return !(*this == other); }
+
+private:
+  void setup_exchanges() {
+    m_exchanges.clear();
+    m_exchanges.resize(m_nprocs);
+    for (std::ptrdiff_t b = 0; b < size(); ++b) {
+      auto &ex = m_exchanges[owner(b)];
+      ex.blocks.push_back(b);
+      std::size_t outer = 0;
+      std::array<source_t, 2 * D> sources;
+      for (std::size_t i = 0; i < 2 * D; ++i) {
+        auto n = neighbour(b, i);
+        if (n < 0) {
+          outer |= std::size_t(1) << i;
+          sources[i] =
+              source_t(-1, face_plan(i)->position(face_block(b, i)));
+          continue;
+        }
+        auto q = owner(n);
+        auto pos = std::find(ex.procs.begin(), ex.procs.end(), q);
+        std::ptrdiff_t s = pos - ex.procs.begin();
+        if (pos == ex.procs.end()) {
+          ex.procs.push_back(q);
+          ex.faces.emplace_back();
+        }
+        // The neighbour sends its opposite face
+        sources[i] = source_t(s, ex.faces[s].size());
+        ex.faces[s].emplace_back(position(n), i ^ 1);
+      }
+      ex.outer.push_back(outer);
+      ex.sources.push_back(sources);
+    }
+  }
+
+  // Remove direction d = i/2 from an index, or insert the index of the
+  // outermost block in that direction
+  static typename face_plan_type::index_type face_index(const index_type &bi,
+                                                        std::size_t i) {
+    cxx_assert(i < 2 * D);
+    std::size_t d = i / 2;
+    typename face_plan_type::index_type fi;
+    for (std::size_t e = 0; e + 1 < D; ++e)
+      fi[e] = bi[e < d ? e : e + 1];
+    return fi;
+  }
+  index_type
+  face_block_index(const typename face_plan_type::index_type &fi,
+                   std::size_t i) const {
+    cxx_assert(i < 2 * D);
+    std::size_t f = i % 2, d = i / 2;
+    index_type bi;
+    for (std::size_t e = 0; e < D; ++e)
+      bi[e] = e < d ? fi[e] : e > d ? fi[e - 1] : f ? m_nblocks[d] - 1 : 0;
+    return bi;
+  }
+
+  std::shared_ptr<const face_plan_type> make_face_plan(std::size_t i) const {
+    // The blocks of a face live with the adjacent blocks
+    auto fnblocks = face_index(m_nblocks, i);
+    std::vector<std::ptrdiff_t> fowners(adt::prod(fnblocks));
+    for (std::ptrdiff_t fb = 0; fb < std::ptrdiff_t(fowners.size()); ++fb) {
+      typename face_plan_type::index_type fi;
+      std::ptrdiff_t b = fb;
+      for (std::size_t e = 0; e + 1 < D; ++e) {
+        fi[e] = b % fnblocks[e];
+        b /= fnblocks[e];
+      }
+      fowners[fb] = owner(block_linear(face_block_index(fi, i)));
+    }
+    return std::make_shared<face_plan_type>(
+        face_index(m_shape, i), face_index(m_block_shape, i), m_nprocs,
+        std::move(fowners));
+  }
+};
+}
+
+#define FUNHPC_HALO_HPP_DONE
+#endif // #ifdef FUNHPC_HALO_HPP
+#ifndef FUNHPC_HALO_HPP_DONE
+#error "Cyclic include dependency"
+#endif
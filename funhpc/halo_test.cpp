@@ -0,0 +1,87 @@
+#include <funhpc/halo.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <set>
+#include <utility>
+
+using namespace funhpc;
+
+TEST(funhpc_halo, default_block_shape) {
+  auto bs = halo_plan<2>::default_block_shape({{9, 7}}, 8);
+  EXPECT_EQ(3, bs[0]);
+  EXPECT_EQ(4, bs[1]);
+  // Blocks contain at least one point
+  auto bs1 = halo_plan<1>::default_block_shape({{3}}, 8);
+  EXPECT_EQ(1, bs1[0]);
+}
+
+TEST(funhpc_halo, neighbours) {
+  halo_plan<2> plan({{9, 7}}, {{3, 3}}, 2);
+  EXPECT_TRUE(plan.invariant());
+  EXPECT_EQ(3, plan.nblocks()[0]);
+  EXPECT_EQ(3, plan.nblocks()[1]);
+  EXPECT_EQ(9, plan.size());
+  for (std::ptrdiff_t b = 0; b < plan.size(); ++b) {
+    EXPECT_EQ(b, plan.block_linear(plan.block_index(b)));
+    for (std::size_t i = 0; i < 4; ++i) {
+      auto n = plan.neighbour(b, i);
+      if (n >= 0)
+        EXPECT_EQ(b, plan.neighbour(n, i ^ 1));
+      else
+        EXPECT_EQ(b, plan.block_at_face(plan.face_block(b, i), i));
+    }
+  }
+  // The last blocks are smaller
+  auto r = plan.block_range(8);
+  EXPECT_EQ(6, r.imin()[0]);
+  EXPECT_EQ(9, r.imax()[0]);
+  EXPECT_EQ(6, r.imin()[1]);
+  EXPECT_EQ(7, r.imax()[1]);
+  // The faces live with their adjacent blocks
+  for (std::size_t i = 0; i < 4; ++i) {
+    const auto &fplan = *plan.face_plan(i);
+    EXPECT_EQ(3, fplan.size());
+    for (std::ptrdiff_t fb = 0; fb < fplan.size(); ++fb)
+      EXPECT_EQ(plan.owner(plan.block_at_face(fb, i)), fplan.owner(fb));
+  }
+}
+
+TEST(funhpc_halo, exchange) {
+  halo_plan<2> plan({{9, 7}}, {{3, 3}}, 2);
+  std::size_t nblocks = 0, nfaces = 0;
+  for (std::ptrdiff_t p = 0; p < plan.nprocs(); ++p) {
+    const auto &ex = plan.exchange(p);
+    nblocks += ex.blocks.size();
+    // One message per neighbouring process
+    std::set<std::ptrdiff_t> procs(ex.procs.begin(), ex.procs.end());
+    EXPECT_EQ(ex.procs.size(), procs.size());
+    EXPECT_EQ(ex.procs.size(), ex.faces.size());
+    for (std::size_t k = 0; k < ex.blocks.size(); ++k) {
+      auto b = ex.blocks[k];
+      EXPECT_EQ(p, plan.owner(b));
+      EXPECT_EQ(std::ptrdiff_t(k), plan.position(b));
+      for (std::size_t i = 0; i < 4; ++i) {
+        auto src = ex.sources[k][i];
+        auto n = plan.neighbour(b, i);
+        EXPECT_EQ(n < 0, bool(ex.outer[k] & (std::size_t(1) << i)));
+        if (n < 0) {
+          EXPECT_EQ(-1, src.first);
+          EXPECT_EQ(plan.face_plan(i)->position(plan.face_block(b, i)),
+                    src.second);
+          continue;
+        }
+        ++nfaces;
+        ASSERT_GE(src.first, 0);
+        EXPECT_EQ(plan.owner(n), ex.procs[src.first]);
+        auto face = ex.faces[src.first][src.second];
+        EXPECT_EQ(plan.position(n), face.first);
+        EXPECT_EQ(std::ptrdiff_t(i ^ 1), face.second);
+      }
+    }
+  }
+  EXPECT_EQ(9, nblocks);
+  // Each interior face is sent once in each direction
+  EXPECT_EQ(2 * (2 * 3 + 3 * 2), nfaces);
+}
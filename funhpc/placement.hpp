@@ -0,0 +1,213 @@
+#ifndef FUNHPC_PLACEMENT_HPP
+#define FUNHPC_PLACEMENT_HPP
+
+#include <adt/index.hpp>
+#include <cxx/cassert.hpp>
+#include <cxx/serialize.hpp>
+#include <funhpc/rexec.hpp>
+
+#include <cereal/access.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace funhpc {
+
+// How distributed containers place their leaves on processes
+enum class placement_kind {
+  local,   // on the calling process
+  block,   // contiguous chunks of points in index order
+  cyclic,  // leaves in turn, in index order
+  morton,  // contiguous chunks of points along a Morton curve
+  hilbert, // contiguous chunks of points along a Hilbert curve
+  user,    // as chosen by a function
+  fixed    // on a given process
+};
+
+// A placement maps each leaf of a container to a process. Proxy-based
+// containers accept a placement as first argument of iotaMap and
+// iotaMapMulti (see fun/proxy.hpp), and nested containers and trees
+// pass it on to their leaves. The placement is bound to the index
+// range of the outermost iotaMap call; a leaf is described by its
+// first point and by the distance to the next leaf.
+template <std::size_t D> class placement {
+public:
+  typedef adt::index_t<D> index_type;
+  typedef adt::steprange_t<D> range_type;
+  typedef std::ptrdiff_t owner_function(const range_type &leaf,
+                                        const range_type &inds);
+
+private:
+  placement_kind m_kind;
+  owner_function *m_func;
+  std::ptrdiff_t m_proc;
+  bool m_bound;
+  range_type m_inds;
+
+  friend class cereal::access;
+  template <typename Archive> void serialize(Archive &ar) {
+    ar(m_kind, m_func, m_proc, m_bound, m_inds);
+  }
+
+public:
+  placement(placement_kind kind = placement_kind::local)
+      : m_kind(kind), m_func(nullptr), m_proc(-1), m_bound(false) {
+    cxx_assert(kind != placement_kind::user && kind != placement_kind::fixed);
+  }
+  placement(owner_function *func)
+      : m_kind(placement_kind::user), m_func(func), m_proc(-1),
+        m_bound(false) {
+    cxx_assert(func);
+  }
+  static placement on(std::ptrdiff_t proc) {
+    placement pl;
+    pl.m_kind = placement_kind::fixed;
+    pl.m_proc = proc;
+    return pl;
+  }
+
+  placement_kind kind() const { return m_kind; }
+  bool bound() const { return m_bound; }
+  const range_type &inds() const { return m_inds; }
+
+  // Bind the placement to the index range of a container, unless it
+  // is already bound to an enclosing one
+  placement bind(const range_type &inds) const {
+    if (m_bound)
+      return *this;
+    placement pl(*this);
+    pl.m_bound = true;
+    pl.m_inds = inds;
+    return pl;
+  }
+  template <bool cond = D == 1, std::enable_if_t<cond> * = nullptr>
+  placement bind(const adt::irange_t &inds) const {
+    return bind(make_range(inds));
+  }
+
+  template <bool cond = D == 1, std::enable_if_t<cond> * = nullptr>
+  std::ptrdiff_t owner(const adt::irange_t &leaf) const {
+    return owner(make_range(leaf));
+  }
+
+  // A placement for a container of dimension D1 that lives where the
+  // given leaf would live, e.g. for the branches of a tree that are
+  // numbered along a curve
+  template <std::size_t D1> placement<D1> pinned(const range_type &leaf) const {
+    return placement<D1>::on(owner(leaf));
+  }
+  std::ptrdiff_t owner(const range_type &leaf) const {
+    cxx_assert(m_bound);
+    std::ptrdiff_t nprocs = size();
+    std::ptrdiff_t npoints = m_inds.size();
+    if (npoints == 0)
+      return rank();
+    const index_type i = point(leaf.imin());
+    const index_type shape = m_inds.shape();
+    std::ptrdiff_t p;
+    switch (m_kind) {
+    case placement_kind::local:
+      p = rank();
+      break;
+    case placement_kind::block:
+      p = linear(i, shape) * nprocs / npoints;
+      break;
+    case placement_kind::cyclic: {
+      // Number the leaves
+      index_type nleaves, ileaf;
+      for (std::size_t d = 0; d < D; ++d) {
+        std::ptrdiff_t step = std::max(std::ptrdiff_t(1),
+                                       leaf.istep()[d] / m_inds.istep()[d]);
+        nleaves[d] = (shape[d] + step - 1) / step;
+        ileaf[d] = i[d] / step;
+      }
+      p = linear(ileaf, nleaves) % nprocs;
+      break;
+    }
+    case placement_kind::morton:
+      p = curve_count(i, shape, adt::morton_key<D>) * nprocs / npoints;
+      break;
+    case placement_kind::hilbert:
+      p = curve_count(i, shape, adt::hilbert_key<D>) * nprocs / npoints;
+      break;
+    case placement_kind::user:
+      p = m_func(leaf, m_inds);
+      break;
+    case placement_kind::fixed:
+      p = m_proc;
+      break;
+    default:
+      cxx_assert(false);
+      p = rank();
+    }
+    cxx_assert(p >= 0 && p < nprocs);
+    return p;
+  }
+
+private:
+  static range_type make_range(const adt::irange_t &inds) {
+    return range_type(index_type{{inds.imin()}}, index_type{{inds.imax()}},
+                      index_type{{inds.istep()}});
+  }
+
+  // The position of a point in the bound index range
+  index_type point(const index_type &ipos) const {
+    index_type i;
+    for (std::size_t d = 0; d < D; ++d) {
+      i[d] = (ipos[d] - m_inds.imin()[d]) / m_inds.istep()[d];
+      cxx_assert(i[d] >= 0 && i[d] < m_inds.shape()[d]);
+    }
+    return i;
+  }
+
+  // Direction 0 varies fastest
+  static std::ptrdiff_t linear(const index_type &i, const index_type &shape) {
+    std::ptrdiff_t lin = 0;
+    for (std::ptrdiff_t d = std::ptrdiff_t(D) - 1; d >= 0; --d)
+      lin = lin * shape[d] + i[d];
+    return lin;
+  }
+
+  // The number of points of [0, shape) that come before point i along
+  // a curve. The curve visits the subcubes of each cube one after the
+  // other; at each level, we add the points of the subcubes that the
+  // curve visits before the one containing i.
+  template <typename Key>
+  static std::ptrdiff_t curve_count(const index_type &i,
+                                    const index_type &shape, Key key) {
+    int bits = 0;
+    while (adt::any(adt::gt(shape, std::ptrdiff_t(1) << bits)))
+      ++bits;
+    const std::uint64_t ikey = key(i, bits);
+    std::ptrdiff_t count = 0;
+    for (int level = bits - 1; level >= 0; --level) {
+      std::ptrdiff_t side = std::ptrdiff_t(1) << level;
+      int shift = D * level;
+      index_type parent;
+      for (std::size_t d = 0; d < D; ++d)
+        parent[d] = i[d] & ~(2 * side - 1);
+      for (std::size_t c = 0; c < (std::size_t(1) << D); ++c) {
+        index_type corner;
+        for (std::size_t d = 0; d < D; ++d)
+          corner[d] = parent[d] + ((c >> d) & 1) * side;
+        if (adt::any(adt::ge(corner, shape)) ||
+            (key(corner, bits) >> shift) >= (ikey >> shift))
+          continue;
+        std::ptrdiff_t npoints = 1;
+        for (std::size_t d = 0; d < D; ++d)
+          npoints *= std::min(side, shape[d] - corner[d]);
+        count += npoints;
+      }
+    }
+    return count;
+  }
+};
+}
+
+#define FUNHPC_PLACEMENT_HPP_DONE
+#endif // #ifdef FUNHPC_PLACEMENT_HPP
+#ifndef FUNHPC_PLACEMENT_HPP_DONE
+#error "Cyclic include dependency"
+#endif
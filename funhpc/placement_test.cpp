@@ -0,0 +1,90 @@
+#include <funhpc/placement.hpp>
+
+#include <adt/index.hpp>
+#include <funhpc/rexec.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace funhpc;
+
+namespace {
+// Check that the points are placed in contiguous, balanced chunks
+// along the given order
+void check_chunks(const placement<2> &pl,
+                  const std::vector<adt::index_t<2>> &order) {
+  std::ptrdiff_t npoints = order.size();
+  std::vector<std::ptrdiff_t> counts(size(), 0);
+  std::ptrdiff_t last = 0;
+  for (const auto &i : order) {
+    auto p = pl.owner(adt::steprange_t<2>(i, i + 1));
+    EXPECT_GE(p, last);
+    last = p;
+    ++counts[p];
+  }
+  std::vector<std::ptrdiff_t> expected(size(), 0);
+  for (std::ptrdiff_t k = 0; k < npoints; ++k)
+    ++expected[k * size() / npoints];
+  EXPECT_EQ(expected, counts);
+}
+
+template <typename Key>
+std::vector<adt::index_t<2>> curve_order(const adt::index_t<2> &shape,
+                                         int bits, Key key) {
+  std::vector<std::pair<std::uint64_t, adt::index_t<2>>> points;
+  adt::steprange_t<2>(shape).loop([&](const adt::index_t<2> &i) {
+    points.emplace_back(key(i, bits), i);
+  });
+  std::sort(points.begin(), points.end(),
+            [](const auto &x, const auto &y) { return x.first < y.first; });
+  std::vector<adt::index_t<2>> order;
+  for (const auto &p : points)
+    order.push_back(p.second);
+  return order;
+}
+
+std::ptrdiff_t last_proc(const adt::steprange_t<1> &leaf,
+                         const adt::steprange_t<1> &inds) {
+  return size() - 1;
+}
+}
+
+TEST(funhpc_placement, block) {
+  adt::index_t<2> shape{{5, 3}};
+  auto pl = placement<2>(placement_kind::block).bind(shape);
+  EXPECT_TRUE(pl.bound());
+  std::vector<adt::index_t<2>> order;
+  adt::steprange_t<2>(shape).loop(
+      [&](const adt::index_t<2> &i) { order.push_back(i); });
+  check_chunks(pl, order);
+  // The placement is bound to the outermost range only
+  EXPECT_EQ(shape, pl.bind(adt::index_t<2>{{2, 2}}).inds().imax());
+}
+
+TEST(funhpc_placement, curves) {
+  adt::index_t<2> shape{{5, 3}};
+  check_chunks(placement<2>(placement_kind::morton).bind(shape),
+               curve_order(shape, 3, adt::morton_key<2>));
+  check_chunks(placement<2>(placement_kind::hilbert).bind(shape),
+               curve_order(shape, 3, adt::hilbert_key<2>));
+}
+
+TEST(funhpc_placement, cyclic) {
+  // Leaves of 4 points
+  auto pl = placement<1>(placement_kind::cyclic).bind(adt::irange_t(0, 20));
+  for (std::ptrdiff_t i = 0; i < 20; i += 4)
+    EXPECT_EQ(i / 4 % size(), pl.owner(adt::irange_t(i, i + 4, 4)));
+}
+
+TEST(funhpc_placement, user) {
+  auto pl = placement<1>(last_proc).bind(adt::irange_t(0, 10));
+  EXPECT_EQ(placement_kind::user, pl.kind());
+  EXPECT_EQ(size() - 1, pl.owner(adt::irange_t(3, 4)));
+  EXPECT_EQ(rank(), placement<1>().bind(adt::irange_t(0, 10))
+                        .owner(adt::irange_t(3, 4)));
+}
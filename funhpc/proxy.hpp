@@ -2,19 +2,32 @@
 #define FUNHPC_PROXY_HPP
 
 #include <cxx/cassert.hpp>
+#include <cxx/cstdlib.hpp>
 #include <cxx/invoke.hpp>
 #include <funhpc/async.hpp>
 #include <funhpc/rexec.hpp>
 #include <funhpc/serialize_shared_future.hpp>
 #include <funhpc/shared_rptr.hpp>
 #include <qthread/future.hpp>
+#include <qthread/mutex.hpp>
 
 #include <cereal/access.hpp>
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/memory.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <sstream>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace funhpc {
 
@@ -33,6 +46,233 @@ proxy<T> make_proxy_with_proc(std::ptrdiff_t proc,
                               qthread::future<proxy<T>> &&fptr);
 }
 
+namespace detail {
+// Where the objects on this process that were migrated went. An entry
+// is dropped once its object has been freed. The table itself is never
+// destructed, since releasing its entries requires communication.
+template <typename T> class proxy_forwarding {
+  typedef std::map<std::weak_ptr<T>, shared_rptr<T>,
+                   std::owner_less<std::weak_ptr<T>>>
+      table_t;
+  static qthread::mutex &mutex() {
+    static auto *mtx = new qthread::mutex;
+    return *mtx;
+  }
+  static table_t &table() {
+    static auto *tbl = new table_t;
+    return *tbl;
+  }
+
+public:
+  static shared_rptr<T> lookup(const std::shared_ptr<T> &from) {
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    auto it = table().find(from);
+    if (it == table().end())
+      return shared_rptr<T>();
+    return it->second;
+  }
+  // Record a migration, unless one was recorded already; return the
+  // recorded destination
+  static shared_rptr<T> insert(const std::shared_ptr<T> &from,
+                               const shared_rptr<T> &to) {
+    std::vector<shared_rptr<T>> expired;
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    for (auto it = table().begin(); it != table().end();) {
+      if (it->first.expired()) {
+        expired.push_back(std::move(it->second));
+        it = table().erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return table().emplace(from, to).first->second;
+  }
+  // Point an existing entry at a new destination, e.g. at the end of a
+  // chain of migrations, so that later lookups take a single hop
+  static void update(const std::shared_ptr<T> &from, const shared_rptr<T> &to) {
+    shared_rptr<T> old;
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    auto it = table().find(from);
+    if (it != table().end() && it->second != to) {
+      old = std::move(it->second);
+      it->second = to;
+    }
+  }
+};
+
+// How long it took to compute the objects on this process that were
+// created by remote_timed. An entry is dropped once its object has
+// been freed.
+class proxy_costs {
+  typedef std::map<std::weak_ptr<void>, double,
+                   std::owner_less<std::weak_ptr<void>>>
+      table_t;
+  static qthread::mutex &mutex() {
+    static auto *mtx = new qthread::mutex;
+    return *mtx;
+  }
+  static table_t &table() {
+    static auto *tbl = new table_t;
+    return *tbl;
+  }
+  // Look for freed objects when the table has grown to this size
+  static std::size_t &purge_size() {
+    static std::size_t sz = 1024;
+    return sz;
+  }
+
+public:
+  static void record(const std::shared_ptr<void> &obj, double cost) {
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    auto &tbl = table();
+    if (tbl.size() >= purge_size()) {
+      for (auto it = tbl.begin(); it != tbl.end();) {
+        if (it->first.expired())
+          it = tbl.erase(it);
+        else
+          ++it;
+      }
+      purge_size() = std::max(std::size_t(1024), 2 * tbl.size());
+    }
+    tbl[obj] = cost;
+  }
+  // A negative cost means that the cost is not known
+  static double lookup(const std::shared_ptr<void> &obj) {
+    qthread::lock_guard<qthread::mutex> g(mutex());
+    auto it = table().find(obj);
+    if (it == table().end())
+      return -1;
+    return it->second;
+  }
+};
+}
+
+namespace detail {
+// Local copies of remote objects, shared by all proxies on this process
+// (see proxy::cache). Since proxied objects are immutable, copies never
+// become stale. An entry keeps its remote object alive, so that the
+// object's address is not reused while the entry exists. Once the
+// copies take up more than FUNHPC_PROXY_CACHE_BYTES bytes (default 64
+// MByte, as serialized), the least recently used ones are dropped.
+//
+// The caches for all types share one mutex and one list of entries.
+class proxy_cache_lru {
+public:
+  struct item_t {
+    std::size_t bytes;
+    bool fetched;
+    // Remove the entry from its cache, returning what is to be freed
+    std::function<std::shared_ptr<void>()> erase;
+  };
+  typedef std::list<item_t> list_t;
+
+  static qthread::mutex &mutex() {
+    static auto *mtx = new qthread::mutex;
+    return *mtx;
+  }
+  // Most recently used entries first
+  static list_t &list() {
+    static auto *lst = new list_t;
+    return *lst;
+  }
+  static std::size_t &bytes() {
+    static std::size_t sz = 0;
+    return sz;
+  }
+  static std::size_t max_bytes() {
+    static std::size_t sz = cxx::envtol("FUNHPC_PROXY_CACHE_BYTES", "67108864");
+    return sz;
+  }
+
+  // Call these with the mutex held
+  static void touch(list_t::iterator it) {
+    list().splice(list().begin(), list(), it);
+  }
+  // Entries that are still being fetched stay. Free the returned
+  // objects after releasing the mutex.
+  static std::vector<std::shared_ptr<void>> evict() {
+    std::vector<std::shared_ptr<void>> garbage;
+    auto &lst = list();
+    for (auto it = lst.end(); bytes() > max_bytes() && it != lst.begin();) {
+      --it;
+      if (!it->fetched)
+        continue;
+      bytes() -= it->bytes;
+      garbage.push_back(it->erase());
+      it = lst.erase(it);
+    }
+    return garbage;
+  }
+};
+
+template <typename T> class proxy_cache {
+  struct entry_t {
+    shared_rptr<T> owner;
+    qthread::shared_future<std::shared_ptr<T>> fobj;
+  };
+  typedef std::map<rptr<T>, std::pair<std::shared_ptr<entry_t>,
+                                      proxy_cache_lru::list_t::iterator>>
+      table_t;
+  static table_t &table() {
+    static auto *tbl = new table_t;
+    return *tbl;
+  }
+
+  // Serialize the object on its owner, so that we learn its size
+  static std::string fetch_local(const shared_rptr<T> &owner) {
+    std::ostringstream buf;
+    { (cereal::BinaryOutputArchive(buf))(owner.get_shared_ptr()); }
+    return std::move(buf).str();
+  }
+  static std::shared_ptr<T> fetched(const rptr<T> &key,
+                                    const std::string &str) {
+    std::shared_ptr<T> ptr;
+    {
+      std::istringstream buf(str);
+      (cereal::BinaryInputArchive(buf))(ptr);
+    }
+    std::vector<std::shared_ptr<void>> garbage;
+    {
+      qthread::lock_guard<qthread::mutex> g(proxy_cache_lru::mutex());
+      auto &item = *table().at(key).second;
+      item.bytes = str.size();
+      item.fetched = true;
+      proxy_cache_lru::bytes() += item.bytes;
+      garbage = proxy_cache_lru::evict();
+    }
+    return ptr;
+  }
+
+public:
+  static qthread::shared_future<std::shared_ptr<T>>
+  lookup(const shared_rptr<T> &owner) {
+    cxx_assert(bool(owner) && !owner.local());
+    auto key = owner.get_rptr();
+    qthread::lock_guard<qthread::mutex> g(proxy_cache_lru::mutex());
+    auto it = table().find(key);
+    if (it != table().end()) {
+      proxy_cache_lru::touch(it->second.second);
+      return it->second.first->fobj;
+    }
+    auto fstr = async(rlaunch::async, owner.get_proc(), fetch_local, owner);
+    auto fobj = qthread::async([ key, fstr = std::move(fstr) ]() mutable {
+                  return fetched(key, fstr.get());
+                }).share();
+    auto &lst = proxy_cache_lru::list();
+    lst.push_front({0, false, [key]() -> std::shared_ptr<void> {
+                      auto it = table().find(key);
+                      auto entry = std::move(it->second.first);
+                      table().erase(it);
+                      return entry;
+                    }});
+    table().emplace(key, std::make_pair(std::make_shared<entry_t>(
+                                            entry_t{owner, fobj}),
+                                        lst.begin()));
+    return fobj;
+  }
+};
+}
+
 template <typename T> class proxy {
   template <typename U> friend class proxy;
 
@@ -328,6 +568,14 @@ public:
     cxx_assert(bool(*this));
     return get_proc() == rank();
   }
+  rptr<T> get_rptr() const {
+    cxx_assert(bool(*this));
+    return robj.get().get_rptr();
+  }
+
+  // How long it took to compute the object, or a negative number if
+  // this is not known (see remote_timed)
+  qthread::future<double> get_cost_future() const;
 
   bool ready() const noexcept {
     cxx_assert(bool(*this));
@@ -364,10 +612,37 @@ public:
     return proxy<typename U::element_type>(*this);
   }
 
-  // TODO: Split this into local_copy() and cache()
+  // A proxy for a local copy of the object. The copy is fetched anew
+  // every time.
   // TODO: Add optional policy argument (e.g. deferred)
+  proxy local_copy() const;
+  // A proxy for a local, read-only copy of the object, shared with all
+  // other cached copies on this process (see detail::proxy_cache). A
+  // local object is returned as is.
+  proxy cache() const;
+  // Same as cache()
   proxy make_local() const;
 
+  // Move the object to process dest, and return a proxy for its new
+  // location. The old process keeps the object while references to it
+  // remain, so that tasks already using it are not disturbed, and
+  // remembers where it went, so that later migrations and resolve()
+  // find the new location. T must be serializable.
+  proxy migrate(std::ptrdiff_t dest) const;
+
+  // A proxy for the current location of the object, following
+  // migrations. The processes along the way then forward directly to
+  // that location, so that later lookups take a single hop.
+  proxy resolve() const;
+
+private:
+  static double get_cost_local(const proxy &self);
+  static void set_cost_local(const proxy &self, double cost);
+  static proxy migrate_local(const proxy &self, std::ptrdiff_t dest);
+  static proxy resolve_local(const proxy &self);
+
+public:
+
   bool operator==(const proxy &other) const {
     auto nt = bool(*this), no = bool(other);
     if (nt != no)
@@ -453,6 +728,103 @@ proxy<R> remote(qthread::future<std::ptrdiff_t> &&fdest, F &&f,
       std::forward<F>(f), std::forward<Args>(args)...));
 }
 
+// remote_timed ////////////////////////////////////////////////////////////////
+
+// Like local and remote, but also record how long f took, so that load
+// balancers can weigh the result (see get_cost_future). f returns a
+// timed<R>, i.e. its result together with its run time, so that it can
+// leave out the time spent waiting for its arguments (see
+// invoke_timed). Recording a cost takes a process-wide lock; the
+// containers in fun/proxy.hpp therefore only time their tasks when
+// this is switched on (see set_proxy_timing).
+
+template <typename R> struct timed {
+  typedef R value_type;
+  R value;
+  double cost; // in seconds
+};
+
+template <typename F, typename... Args,
+          typename R = std::decay_t<cxx::invoke_of_t<F &&, Args &&...>>>
+timed<R> invoke_timed(F &&f, Args &&... args) {
+  auto t0 = std::chrono::steady_clock::now();
+  R res = cxx::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+  return timed<R>{std::move(res), dt.count()};
+}
+
+template <typename F, typename... Args,
+          typename TR = std::decay_t<
+              cxx::invoke_of_t<std::decay_t<F>, std::decay_t<Args>...>>,
+          typename R = typename TR::value_type>
+proxy<R> local_timed(F &&f, Args &&... args) {
+  return proxy<R>(qthread::async(
+      [](auto &&f, auto &&... args) {
+        auto res = cxx::invoke(std::move(f), std::move(args)...);
+        auto ptr = std::make_shared<R>(std::move(res.value));
+        detail::proxy_costs::record(ptr, res.cost);
+        return shared_rptr<R>(std::move(ptr));
+      },
+      std::forward<F>(f), std::forward<Args>(args)...));
+}
+
+template <typename F, typename... Args,
+          typename TR = std::decay_t<
+              cxx::invoke_of_t<std::decay_t<F>, std::decay_t<Args>...>>,
+          typename R = typename TR::value_type>
+proxy<R> remote_timed(std::ptrdiff_t dest, F &&f, Args &&... args) {
+  auto local1 = (proxy<R>(&)(std::decay_t<F> &&, std::decay_t<Args> && ...))
+      local_timed<std::decay_t<F>, std::decay_t<Args>...>;
+  return detail::make_proxy_with_proc(
+      dest, async(rlaunch::async | rlaunch::deferred, dest, local1,
+                  std::forward<F>(f), std::forward<Args>(args)...));
+}
+
+template <typename F, typename... Args,
+          typename TR = std::decay_t<
+              cxx::invoke_of_t<std::decay_t<F>, std::decay_t<Args>...>>,
+          typename R = typename TR::value_type>
+proxy<R> remote_timed(qthread::future<std::ptrdiff_t> &&fdest, F &&f,
+                      Args &&... args) {
+  cxx_assert(fdest.valid());
+  if (fdest.ready())
+    return remote_timed(fdest.get(), std::forward<F>(f),
+                        std::forward<Args>(args)...);
+  return proxy<R>(qthread::async(
+      [fdest = std::move(fdest)](auto &&f, auto &&... args) mutable {
+        return remote_timed(fdest.get(), std::move(f), std::move(args)...);
+      },
+      std::forward<F>(f), std::forward<Args>(args)...));
+}
+
+// Whether fmap and fmapStencil on proxies time their tasks; off by
+// default. Each process has its own setting.
+
+namespace detail {
+inline std::atomic<bool> &proxy_timing_flag() {
+  static std::atomic<bool> flag(false);
+  return flag;
+}
+inline void set_proxy_timing_local(bool enable) {
+  proxy_timing_flag().store(enable, std::memory_order_relaxed);
+}
+}
+
+inline bool proxy_timing() {
+  return detail::proxy_timing_flag().load(std::memory_order_relaxed);
+}
+
+// Switch timing on or off on all processes
+inline void set_proxy_timing(bool enable) {
+  std::vector<qthread::future<void>> fs;
+  fs.reserve(size());
+  for (std::ptrdiff_t p = 0; p < size(); ++p)
+    fs.push_back(async(rlaunch::async, p, detail::set_proxy_timing_local,
+                       enable));
+  for (auto &f : fs)
+    f.wait();
+}
+
 // make_local_shared_ptr ///////////////////////////////////////////////////////
 
 namespace detail {
@@ -482,10 +854,102 @@ make_local_shared_ptr(const proxy<T> &rptr) {
   });
 }
 
-template <typename T> proxy<T> proxy<T>::make_local() const {
+template <typename T> proxy<T> proxy<T>::local_copy() const {
   cxx_assert(bool(*this));
   return proxy(make_local_shared_ptr(*this));
 }
+
+// cache ///////////////////////////////////////////////////////////////////////
+
+template <typename T> proxy<T> proxy<T>::cache() const {
+  cxx_assert(bool(*this));
+  if (!ready())
+    return proxy(qthread::async([self = *this]() {
+      self.wait();
+      return self.cache();
+    }));
+  if (local())
+    return *this;
+  return proxy(detail::proxy_cache<T>::lookup(robj.get()));
+}
+
+template <typename T> proxy<T> proxy<T>::make_local() const {
+  return cache();
+}
+
+// get_cost_future /////////////////////////////////////////////////////////////
+
+template <typename T>
+qthread::future<double> proxy<T>::get_cost_future() const {
+  cxx_assert(bool(*this));
+  return async(rlaunch::async, get_proc_future(), get_cost_local, *this);
+}
+
+template <typename T> double proxy<T>::get_cost_local(const proxy &self) {
+  cxx_assert(self.local());
+  return detail::proxy_costs::lookup(self.get_shared_ptr());
+}
+
+template <typename T>
+void proxy<T>::set_cost_local(const proxy &self, double cost) {
+  cxx_assert(self.local());
+  detail::proxy_costs::record(self.get_shared_ptr(), cost);
+}
+
+// migrate /////////////////////////////////////////////////////////////////////
+
+template <typename T> proxy<T> proxy<T>::migrate(std::ptrdiff_t dest) const {
+  cxx_assert(bool(*this));
+  cxx_assert(dest >= 0 && dest < size());
+  return detail::make_proxy_with_proc(
+      dest, async(rlaunch::async | rlaunch::deferred, get_proc_future(),
+                  migrate_local, *this, dest));
+}
+
+template <typename T>
+proxy<T> proxy<T>::migrate_local(const proxy &self, std::ptrdiff_t dest) {
+  cxx_assert(self.local());
+  const auto &ptr = self.get_shared_ptr();
+  auto fwd = detail::proxy_forwarding<T>::lookup(ptr);
+  if (bool(fwd)) {
+    auto res = proxy(std::move(fwd)).migrate(dest);
+    detail::proxy_forwarding<T>::update(ptr, res.robj.get());
+    return res;
+  }
+  if (dest == rank())
+    return self;
+  auto obj = make_remote_proxy<T>(dest, *ptr);
+  // The cost moves with the object
+  double cost = detail::proxy_costs::lookup(ptr);
+  if (cost >= 0)
+    async(rlaunch::sync, dest, set_cost_local, obj, cost).wait();
+  obj.wait();
+  // Another migration may have been recorded in the mean time
+  auto res = proxy(detail::proxy_forwarding<T>::insert(ptr, obj.robj.get()))
+                 .migrate(dest);
+  detail::proxy_forwarding<T>::update(ptr, res.robj.get());
+  return res;
+}
+
+template <typename T> proxy<T> proxy<T>::resolve() const {
+  cxx_assert(bool(*this));
+  return proxy(async(rlaunch::async | rlaunch::deferred, get_proc_future(),
+                     resolve_local, *this));
+}
+
+template <typename T> proxy<T> proxy<T>::resolve_local(const proxy &self) {
+  cxx_assert(self.local());
+  const auto &ptr = self.get_shared_ptr();
+  auto fwd = detail::proxy_forwarding<T>::lookup(ptr);
+  if (bool(fwd)) {
+    // Compress the path, so that the next lookup goes directly to the
+    // final location
+    auto res = proxy(std::move(fwd)).resolve();
+    detail::proxy_forwarding<T>::update(ptr, res.robj.get());
+    return res;
+  }
+  return self;
+}
 }
 
 #define FUNHPC_PROXY_HPP_DONE
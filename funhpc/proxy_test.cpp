@@ -140,3 +140,74 @@ TEST(funhpc_proxy, nested) {
   auto i = async(rlaunch::sync, 1 % size(), getvalue, all_p1).get();
   EXPECT_EQ(5, i);
 }
+
+namespace {
+int getproc(const proxy<s0> &p) { return p.get_proc(); }
+}
+
+TEST(funhpc_proxy, migrate) {
+  auto p = 1 % size();
+  auto q = (p + 1) % size();
+  auto pi = make_local_proxy<s0>(s0{42});
+  auto pm = pi.migrate(p);
+  EXPECT_EQ(p, pm.get_proc());
+  EXPECT_EQ(42, pm.make_local()->i);
+  // The old location keeps working
+  EXPECT_TRUE(pi.local());
+  EXPECT_EQ(42, pi->i);
+  // The old location forwards to the new one
+  EXPECT_EQ(p, pi.resolve().get_proc());
+  EXPECT_EQ(p, async(rlaunch::sync, q, getproc, pi.resolve()).get());
+  EXPECT_EQ(p, pi.migrate(p).get_proc());
+  // Migrations can be chained
+  auto pm2 = pi.migrate(q);
+  EXPECT_EQ(q, pm2.get_proc());
+  EXPECT_EQ(42, pm2.make_local()->i);
+  EXPECT_EQ(q, pi.resolve().get_proc());
+  EXPECT_EQ(q, pm.resolve().get_proc());
+  // The old location forwards directly to the end of the chain
+  if (p != rank())
+    EXPECT_EQ(pm2.get_rptr(),
+              detail::proxy_forwarding<s0>::lookup(pi.get_shared_ptr())
+                  .get_rptr());
+
+  // resolve() compresses chains of migrations made elsewhere
+  auto pa = make_local_proxy<s0>(s0{1});
+  auto pb = pa.migrate(p);
+  auto pc = pb.migrate(q);
+  // Migrations complete asynchronously; wait until the chain exists
+  pc.wait();
+  EXPECT_EQ(q, pa.resolve().get_proc());
+  if (p != rank())
+    EXPECT_EQ(pc.get_rptr(),
+              detail::proxy_forwarding<s0>::lookup(pa.get_shared_ptr())
+                  .get_rptr());
+}
+
+TEST(funhpc_proxy, cache) {
+  auto p = 1 % size();
+  auto pi = make_remote_proxy<int>(p, 1);
+  auto pc1 = pi.cache();
+  auto pc2 = pi.cache();
+  auto pl = pi.local_copy();
+  EXPECT_TRUE(pc1.local());
+  EXPECT_TRUE(pc2.local());
+  EXPECT_TRUE(pl.local());
+  EXPECT_EQ(1, *pc1);
+  EXPECT_EQ(1, *pc2);
+  EXPECT_EQ(1, *pl);
+  // Cached copies are shared
+  EXPECT_EQ(&*pc1, &*pc2);
+  EXPECT_EQ(&*pc1, &*pi.make_local());
+  if (p == rank())
+    EXPECT_EQ(&*pi, &*pc1);
+  else
+    EXPECT_NE(&*pc1, &*pl);
+  // Many objects can be cached at the same time
+  std::vector<proxy<int>> pis(100);
+  for (int n = 0; n < int(pis.size()); ++n)
+    pis[n] = make_remote_proxy<int>(p, n);
+  for (int iter = 0; iter < 2; ++iter)
+    for (int n = 0; n < int(pis.size()); ++n)
+      EXPECT_EQ(n, *pis[n].cache());
+}
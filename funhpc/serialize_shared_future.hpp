@@ -1,22 +1,162 @@
 #ifndef SERIALIZE_SHARED_FUTURE_HPP
 #define SERIALIZE_SHARED_FUTURE_HPP
 
-#include <funhpc/async.hpp>
+#include <cxx/cassert.hpp>
+#include <funhpc/rexec.hpp>
 #include <funhpc/rptr.hpp>
 #include <qthread/future.hpp>
+#include <qthread/mutex.hpp>
+#include <qthread/thread.hpp>
 
 #include <cereal/access.hpp>
 #include <cereal/types/memory.hpp>
 
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
 namespace qthread {
 
 namespace detail {
-template <typename T>
-T shared_future_get(const funhpc::rptr<shared_future<T>> &pf) {
-  T val = pf->get();
-  delete pf.get_ptr();
-  return val;
-}
+// A shared_future that is not ready is exported once per process, no
+// matter how often it is serialized. A process that loads it
+// subscribes once; when the future becomes ready, its value is sent
+// to all subscribed processes, and each process shares it among all
+// its copies. The export is kept until all serialized copies have
+// been loaded.
+
+template <typename T> struct shared_future_export {
+  shared_future<T> f;
+  // Number of serialized and loaded copies
+  std::ptrdiff_t nsaved, nloaded;
+  // Processes waiting for the value
+  std::vector<std::ptrdiff_t> subscribers;
+  bool ready;
+};
+
+template <typename T> struct shared_future_registry {
+  typedef shared_future_export<T> export_t;
+  typedef funhpc::rptr<export_t> id_t;
+  struct import_t {
+    promise<T> p;
+    shared_future<T> f;
+    std::ptrdiff_t nloaded;
+  };
+
+  static mutex &get_mutex() {
+    static auto *mtx = new mutex;
+    return *mtx;
+  }
+  // Exported futures, by shared state
+  static std::map<const void *, export_t *> &get_exports() {
+    static auto *exports = new std::map<const void *, export_t *>;
+    return *exports;
+  }
+  // Imported futures whose value has not yet arrived
+  static std::map<id_t, import_t> &get_imports() {
+    static auto *imports = new std::map<id_t, import_t>;
+    return *imports;
+  }
+
+  // Call with the mutex held
+  static void maybe_drop(export_t *ex) {
+    if (!ex->ready || ex->nloaded < ex->nsaved)
+      return;
+    get_exports().erase(ex->f.get_state_id());
+    delete ex;
+  }
+
+  static id_t export_future(const shared_future<T> &f) {
+    lock_guard<mutex> g(get_mutex());
+    auto &ex = get_exports()[f.get_state_id()];
+    if (!ex) {
+      ex = new export_t{f, 0, 0, {}, false};
+      thread(push, id_t(ex)).detach();
+    }
+    ++ex->nsaved;
+    return id_t(ex);
+  }
+
+  static void push(const id_t &id) {
+    export_t *ex = id.get_ptr();
+    ex->f.wait();
+    shared_future<T> f;
+    std::vector<std::ptrdiff_t> subscribers;
+    {
+      lock_guard<mutex> g(get_mutex());
+      ex->ready = true;
+      f = ex->f;
+      subscribers = std::move(ex->subscribers);
+      maybe_drop(ex);
+    }
+    for (auto proc : subscribers)
+      funhpc::rexec(proc, deliver, id, f.get());
+  }
+
+  static void subscribe(const id_t &id, std::ptrdiff_t proc) {
+    export_t *ex = id.get_ptr();
+    shared_future<T> f;
+    {
+      lock_guard<mutex> g(get_mutex());
+      if (!ex->ready) {
+        ex->subscribers.push_back(proc);
+        return;
+      }
+      f = ex->f;
+    }
+    funhpc::rexec(proc, deliver, id, f.get());
+  }
+
+  static void deliver(const id_t &id, T val) {
+    import_t imp;
+    {
+      lock_guard<mutex> g(get_mutex());
+      auto it = get_imports().find(id);
+      cxx_assert(it != get_imports().end());
+      imp = std::move(it->second);
+      get_imports().erase(it);
+    }
+    imp.p.set_value(std::move(val));
+    funhpc::rexec(id.get_proc(), release, id, imp.nloaded);
+  }
+
+  static void release(const id_t &id, std::ptrdiff_t nloaded) {
+    lock_guard<mutex> g(get_mutex());
+    export_t *ex = id.get_ptr();
+    ex->nloaded += nloaded;
+    maybe_drop(ex);
+  }
+
+  static shared_future<T> import_future(const id_t &id) {
+    shared_future<T> f;
+    bool first = false;
+    {
+      lock_guard<mutex> g(get_mutex());
+      if (id.get_proc() == funhpc::rank()) {
+        export_t *ex = id.get_ptr();
+        f = ex->f;
+        ++ex->nloaded;
+        maybe_drop(ex);
+        return f;
+      }
+      auto &imports = get_imports();
+      auto it = imports.find(id);
+      if (it == imports.end()) {
+        import_t imp;
+        imp.f = imp.p.get_future().share();
+        imp.nloaded = 0;
+        it = imports.emplace(id, std::move(imp)).first;
+        first = true;
+      }
+      ++it->second.nloaded;
+      f = it->second.f;
+    }
+    if (first)
+      funhpc::rexec(id.get_proc(), subscribe, id, funhpc::rank());
+    return f;
+  }
+};
 }
 
 template <typename Archive, typename T>
@@ -29,8 +169,7 @@ void save(Archive &ar, const shared_future<T> &f) {
     if (r) {
       ar(f.get());
     } else {
-      funhpc::rptr<shared_future<T>> pf(new shared_future<T>(f));
-      ar(pf);
+      ar(detail::shared_future_registry<T>::export_future(f));
     }
   }
 }
@@ -47,10 +186,9 @@ void load(Archive &ar, shared_future<T> &f) {
       ar(val);
       f = make_ready_future(std::move(val));
     } else {
-      funhpc::rptr<shared_future<T>> pf;
-      ar(pf);
-      f = funhpc::async(funhpc::rlaunch::async, pf.get_proc(),
-                        detail::shared_future_get<T>, pf);
+      typename detail::shared_future_registry<T>::id_t id;
+      ar(id);
+      f = detail::shared_future_registry<T>::import_future(id);
     }
   }
 }
@@ -0,0 +1,43 @@
+#include <funhpc/async.hpp>
+#include <funhpc/serialize_shared_future.hpp>
+#include <qthread/future.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace funhpc;
+using namespace qthread;
+
+namespace {
+int get(const shared_future<int> &f) { return f.get(); }
+std::uintptr_t state_id(const shared_future<int> &f) {
+  return std::uintptr_t(f.get_state_id());
+}
+}
+
+TEST(funhpc_serialize_shared_future, ready) {
+  auto f = make_ready_future(1).share();
+  auto fres = async(rlaunch::async, 1 % size(), get, f);
+  EXPECT_EQ(1, fres.get());
+}
+
+TEST(funhpc_serialize_shared_future, fanout) {
+  promise<int> p;
+  auto f = p.get_future().share();
+  std::ptrdiff_t dest = 1 % size();
+  // All copies on the destination share one future
+  auto fid1 = async(rlaunch::async, dest, state_id, f);
+  auto fid2 = async(rlaunch::async, dest, state_id, f);
+  EXPECT_EQ(fid1.get(), fid2.get());
+  std::vector<qthread::future<int>> fress;
+  for (int i = 0; i < 100; ++i)
+    fress.push_back(async(rlaunch::async, dest, get, f));
+  p.set_value(42);
+  for (auto &fres : fress)
+    EXPECT_EQ(42, fres.get());
+  // Copies sent after the value arrived
+  EXPECT_EQ(42, async(rlaunch::async, dest, get, f).get());
+}
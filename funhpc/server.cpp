@@ -4,6 +4,7 @@
 #include <funhpc/hwloc.hpp>
 #include <funhpc/rexec.hpp>
 #include <funhpc/server.hpp>
+#include <funhpc/steal.hpp>
 #include <qthread/future.hpp>
 #include <qthread/mutex.hpp>
 #include <qthread/thread.hpp>
@@ -150,6 +151,17 @@ void set_rank_size() {
   // Label nodes by their lowest (global) rank
   int node_group;
   MPI_Allreduce(&rank, &node_group, 1, MPI_INT, MPI_MIN, mpi_node_comm);
+
+  // Work stealing prefers victims on the same node
+  std::vector<int> all_node_groups(size);
+  MPI_Allgather(&node_group, 1, MPI_INT, all_node_groups.data(), 1, MPI_INT,
+                mpi_comm);
+  std::vector<std::ptrdiff_t> node_procs;
+  for (int p = 0; p < size; ++p)
+    if (all_node_groups[p] == node_group)
+      node_procs.push_back(p);
+  steal::initialize(std::move(node_procs));
+
   std::vector<int> node_groups;
   if (rank == mpi_root)
     node_groups.resize(size);
@@ -384,6 +396,24 @@ bool terminate_check(bool ready_to_terminate) {
   return flag;
 }
 
+// After terminating, each process waits for the replies to its steal
+// requests, and then enters a second barrier, so that no steal
+// requests or replies are lost when the event loop ends
+bool draining = false;
+MPI_Request drain_req;
+
+bool drain_check(bool ready_to_drain) {
+  if (!draining) {
+    if (!ready_to_drain)
+      return false;
+    draining = true;
+    MPI_Ibarrier(mpi_comm, &drain_req);
+  }
+  int flag;
+  MPI_Test(&drain_req, &flag, MPI_STATUS_IGNORE);
+  return flag;
+}
+
 void initialize(int &argc, char **&argv) {
   int flag;
   MPI_Initialized(&flag);
@@ -475,10 +505,20 @@ int eventloop(mainfunc_t *user_main, int argc, char **argv) {
     send_tasks();
     recv_tasks();
     comm_unlock();
+    steal::poll();
     if (terminate_check(!fres.valid() || fres.ready()))
       break;
     qthread::this_thread::yield();
   }
+  for (;;) {
+    comm_lock();
+    send_tasks();
+    recv_tasks();
+    comm_unlock();
+    if (drain_check(!steal::stop()))
+      break;
+    qthread::this_thread::yield();
+  }
   cancel_sends();
 
   send_queue_mutex.reset();
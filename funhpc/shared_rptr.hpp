@@ -189,6 +189,10 @@ public:
     cxx_assert(bool(*this));
     return mgr->get_proc();
   }
+  rptr<T> get_rptr() const {
+    cxx_assert(bool(*this));
+    return mgr->get_rptr();
+  }
 
   const std::shared_ptr<T> &get_shared_ptr() const {
     static const std::shared_ptr<T> null;
@@ -0,0 +1,206 @@
+#include <funhpc/steal.hpp>
+
+#include <funhpc/rexec.hpp>
+#include <qthread/mutex.hpp>
+#include <qthread/thread.hpp>
+
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace funhpc {
+namespace steal {
+
+namespace {
+// The pool of this process. We run tasks from the back; thieves take
+// them from the front.
+std::deque<task_t> pool;
+qthread::mutex &pool_mutex() {
+  static auto *mtx = new qthread::mutex;
+  return *mtx;
+}
+
+// Whether stealing is enabled, i.e. whether any process has queued a
+// stealable task, and this process has not given up stealing since
+std::atomic<bool> active(false);
+// Whether the server has stopped stealing before terminating
+std::atomic<bool> stopped(false);
+// Whether a steal request is outstanding
+std::atomic<bool> stealing(false);
+
+// Victims: first the processes on this node, then all others
+std::vector<std::ptrdiff_t> node_victims;
+std::size_t next_victim = 0;
+std::ptrdiff_t next_remote_victim = 0;
+// Number of consecutive failed steal requests
+std::atomic<std::ptrdiff_t> failures(0);
+// After this many consecutive failed steal requests, this process
+// stops stealing. It is woken up again by the processes that turned
+// it away once they have tasks (see thieves), or by a new stealable
+// task being queued.
+const std::ptrdiff_t max_failures = 20;
+// The processes that this process turned away since it last had tasks
+// (protected by the pool's mutex)
+std::vector<std::ptrdiff_t> thieves;
+
+// Wait after failed steal requests before stealing again
+typedef std::chrono::steady_clock steal_clock;
+steal_clock::time_point next_steal;
+const std::chrono::microseconds min_backoff(100);
+const std::chrono::microseconds max_backoff(10000);
+
+void activate() {
+  failures = 0;
+  active = true;
+}
+
+// Runners that have been started but have not yet taken a task. There
+// are only a few of them at a time, so that the scheduler's queue does
+// not fill up with runners, and so that thieves find the tasks that
+// have not been started. A runner starts its successor before running
+// its task, since the task may block.
+std::size_t pending = 0;
+
+void run_one();
+
+// Call with the pool's mutex held
+void start_runners() {
+  std::size_t max_pending = qthread::thread::hardware_concurrency();
+  while (pending < std::min(max_pending, pool.size())) {
+    ++pending;
+    qthread::thread(run_one).detach();
+  }
+}
+
+void run_one() {
+  task_t t;
+  {
+    qthread::lock_guard<qthread::mutex> g(pool_mutex());
+    --pending;
+    if (pool.empty())
+      // The tasks have been run or stolen
+      return;
+    t = std::move(pool.back());
+    pool.pop_back();
+    start_runners();
+  }
+  t();
+}
+
+void push(std::vector<task_t> &&ts) {
+  activate();
+  std::vector<std::ptrdiff_t> waiting;
+  {
+    qthread::lock_guard<qthread::mutex> g(pool_mutex());
+    for (auto &t : ts)
+      pool.push_back(std::move(t));
+    start_runners();
+    std::swap(waiting, thieves);
+  }
+  for (auto p : waiting)
+    rexec(p, activate);
+}
+
+void push1(task_t &&t) {
+  std::vector<task_t> ts;
+  ts.push_back(std::move(t));
+  push(std::move(ts));
+}
+
+void steal_reply(std::vector<task_t> ts) {
+  if (ts.empty()) {
+    if (++failures >= max_failures)
+      active = false;
+  } else {
+    failures = 0;
+    push(std::move(ts));
+  }
+  stealing = false;
+}
+
+void steal_request(std::ptrdiff_t thief) {
+  std::vector<task_t> ts;
+  {
+    qthread::lock_guard<qthread::mutex> g(pool_mutex());
+    std::size_t n = pool.size() / 2;
+    for (std::size_t i = 0; i < n; ++i) {
+      ts.push_back(std::move(pool.front()));
+      pool.pop_front();
+    }
+    if (n == 0 &&
+        std::find(thieves.begin(), thieves.end(), thief) == thieves.end())
+      thieves.push_back(thief);
+  }
+  rexec(thief, steal_reply, std::move(ts));
+}
+
+std::ptrdiff_t choose_victim() {
+  // After a round of failures on this node, try another node
+  std::ptrdiff_t nvictims = node_victims.size();
+  if (nvictims == 0 ||
+      (nvictims < size() - 1 && failures % (nvictims + 1) == nvictims)) {
+    for (;;) {
+      std::ptrdiff_t p = next_remote_victim;
+      next_remote_victim = (next_remote_victim + 1) % size();
+      if (p != rank())
+        return p;
+    }
+  }
+  std::ptrdiff_t p = node_victims[next_victim];
+  next_victim = (next_victim + 1) % node_victims.size();
+  return p;
+}
+}
+
+void initialize(std::vector<std::ptrdiff_t> node_procs) {
+  node_victims.clear();
+  for (auto p : node_procs)
+    if (p != rank())
+      node_victims.push_back(p);
+  next_victim = rank() % std::max(std::size_t(1), node_victims.size());
+  next_remote_victim = (rank() + 1) % size();
+  next_steal = steal_clock::now();
+}
+
+void enqueue(std::ptrdiff_t dest, task_t &&t) {
+  if (!active.exchange(true))
+    for (std::ptrdiff_t p = 0; p < size(); ++p)
+      if (p != rank())
+        rexec(p, activate);
+  if (dest == rank())
+    return push1(std::move(t));
+  rexec(dest, push1, std::move(t));
+}
+
+bool poll() {
+  if (size() == 1 || !active || stealing || stopped)
+    return false;
+  {
+    qthread::lock_guard<qthread::mutex> g(pool_mutex());
+    if (!pool.empty())
+      return false;
+  }
+  auto now = steal_clock::now();
+  if (now < next_steal)
+    return false;
+  int nfailures = std::min(std::ptrdiff_t(failures), std::ptrdiff_t(10));
+  next_steal = now + std::min(max_backoff,
+                              std::chrono::microseconds(min_backoff *
+                                                        (1 << nfailures)));
+  stealing = true;
+  rexec(choose_victim(), steal_request, rank());
+  return true;
+}
+
+bool stop() {
+  stopped = true;
+  return stealing;
+}
+}
+}
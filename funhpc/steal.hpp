@@ -0,0 +1,42 @@
+#ifndef FUNHPC_STEAL_HPP
+#define FUNHPC_STEAL_HPP
+
+#include <funhpc/rexec.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace funhpc {
+namespace steal {
+
+// Tasks launched with rlaunch::any are queued in a stealable pool on
+// their destination process. Each process runs the tasks in its own
+// pool, newest first. A process whose pool is empty steals the oldest
+// half of another process's pool, asking processes on the same node
+// first. Processes start stealing once the first stealable task has
+// been queued anywhere, and stop after a run of failed attempts until
+// tasks appear again.
+
+// The processes on the same node as this one, called once by the
+// server before the event loop starts
+void initialize(std::vector<std::ptrdiff_t> node_procs);
+
+// Queue a task in the pool of process dest
+void enqueue(std::ptrdiff_t dest, task_t &&t);
+
+// Called regularly by the event loop: steal tasks if this process is
+// idle. Returns whether a steal request was sent.
+bool poll();
+
+// Called regularly by the event loop once all processes are
+// terminating: send no more steal requests. Returns whether a steal
+// request sent earlier is still waiting for its reply.
+bool stop();
+}
+}
+
+#define FUNHPC_STEAL_HPP_DONE
+#endif // #ifdef FUNHPC_STEAL_HPP
+#ifndef FUNHPC_STEAL_HPP_DONE
+#error "Cyclic include dependency"
+#endif
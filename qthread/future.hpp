@@ -9,6 +9,7 @@
 #include <qthread/qthread.hpp>
 
 #include <atomic>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <tuple>
@@ -36,16 +37,21 @@ template <typename T> class shared_state {
                      std::conditional_t<std::is_reference<T>::value,
                                         std::remove_reference_t<T> *, T>>
       value;
+  // set instead of value if the producer failed
+  std::exception_ptr exception;
 
   template <typename U = T,
             std::enable_if_t<!std::is_void<U>::value> * = nullptr>
   void run_trigger() {
-    set_value(trigger());
+    auto &&r = trigger();
+    trigger = {};
+    set_value(std::forward<T>(r));
   }
   template <typename U = T,
             std::enable_if_t<std::is_void<U>::value> * = nullptr>
   void run_trigger() {
     trigger();
+    trigger = {};
     set_value();
   }
 
@@ -85,10 +91,8 @@ public:
   bool ready() const noexcept { return is_ready.status(); }
 
   void wait() {
-    if (bool(has_trigger) && has_trigger.exchange(false)) {
+    if (bool(has_trigger) && has_trigger.exchange(false))
       run_trigger();
-      trigger = {};
-    }
     is_ready.readFF();
   }
 
@@ -124,12 +128,24 @@ public:
   }
 
   void set_exception() { throw("not implemented"); }
+  void set_exception(std::exception_ptr exception_) {
+    cxx_assert(!ready());
+    exception = std::move(exception_);
+    is_ready.fill();
+  }
+
+  // Wait, then rethrow the stored exception (if any)
+  void check() {
+    wait();
+    if (exception)
+      std::rethrow_exception(exception);
+  }
 
   template <typename U = T,
             std::enable_if_t<std::is_same<U, T>::value &&
                              !std::is_void<T>::value> * = nullptr>
   const U &get() const {
-    wait();
+    check();
     return value;
   }
   template <
@@ -137,14 +153,14 @@ public:
       std::enable_if_t<std::is_same<U, T>::value && !std::is_void<T>::value &&
                        !std::is_reference<T>::value> * = nullptr>
   U &get() {
-    wait();
+    check();
     return value;
   }
   template <typename U = T,
             std::enable_if_t<std::is_same<U, T>::value &&
                              std::is_reference<T>::value> * = nullptr>
   U get() {
-    wait();
+    check();
     return *value;
   }
   template <
@@ -152,7 +168,7 @@ public:
       std::enable_if_t<std::is_same<U, T>::value && !std::is_void<T>::value &&
                        !std::is_reference<T>::value> * = nullptr>
   U move() {
-    wait();
+    check();
     return std::move(value);
     // Note: The value is now not available any more
   }
@@ -244,7 +260,7 @@ public:
             std::enable_if_t<std::is_void<U>::value> * = nullptr>
   void get() {
     cxx_assert(valid());
-    shared_state->wait();
+    shared_state->check();
     shared_state.reset();
   }
 
@@ -357,7 +373,7 @@ public:
             std::enable_if_t<std::is_void<U>::value> * = nullptr>
   void get() const {
     cxx_assert(valid());
-    shared_state->wait();
+    shared_state->check();
   }
 
   bool valid() const noexcept { return bool(shared_state); }
@@ -372,6 +388,10 @@ public:
     shared_state->wait();
   }
 
+  // Identifies the shared state; copies of a shared_future have the
+  // same id
+  const void *get_state_id() const noexcept { return shared_state.get(); }
+
   template <typename F, typename R = std::decay_t<
                             cxx::invoke_of_t<std::decay_t<F>, shared_future>>>
   future<R> then(launch policy, F &&cont) const;
@@ -466,6 +486,12 @@ public:
     else
       shared_state = std::make_shared<detail::shared_state<T>>(std::tuple<>());
   }
+
+  void set_exception(std::exception_ptr exception) {
+    if (!shared_state)
+      shared_state = std::make_shared<detail::shared_state<T>>();
+    shared_state->set_exception(std::move(exception));
+  }
 };
 template <typename T> void swap(promise<T> &lhs, promise<T> &rhs) noexcept {
   lhs.swap(rhs);
@@ -544,18 +570,24 @@ template <typename R> class async_thread {
 
   future<R> result;
 
+  // The task (and everything it captured) is destroyed before the
+  // result becomes ready, so that a caller that waited for the result
+  // may assume that the task's arguments have been released
   struct thread_args_t {
     cxx::task<R> task;
     promise<R> result;
     template <typename U = R,
               std::enable_if_t<!std::is_void<U>::value> * = nullptr>
     void run() {
-      result.set_value(task());
+      auto &&r = task();
+      task = {};
+      result.set_value(std::forward<R>(r));
     }
     template <typename U = R,
               std::enable_if_t<std::is_void<U>::value> * = nullptr>
     void run() {
       task();
+      task = {};
       result.set_value();
     }
   };
@@ -4,6 +4,12 @@
 #include <gtest/gtest.h>
 #include <qthread.h>
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
 using namespace qthread;
 
 namespace {
@@ -222,6 +228,21 @@ TEST(qthread_future, promise) {
   test_promise<int (&)(int)>(fi);
 }
 
+TEST(qthread_future, promise_exception) {
+  promise<int> p1;
+  auto f1 = p1.get_future();
+  EXPECT_FALSE(f1.ready());
+  p1.set_exception(std::make_exception_ptr(std::runtime_error("p1")));
+  EXPECT_TRUE(f1.ready());
+  EXPECT_THROW(f1.get(), std::runtime_error);
+
+  promise<void> p2;
+  p2.set_exception(std::make_exception_ptr(std::runtime_error("p2")));
+  auto f2 = p2.get_future().share();
+  EXPECT_THROW(f2.get(), std::runtime_error);
+  EXPECT_THROW(f2.get(), std::runtime_error);
+}
+
 namespace {
 template <typename R, typename... Args, typename F>
 void test_packaged_task(F &&f, Args... args) {
@@ -305,6 +326,39 @@ TEST(qthread_future, async) {
   EXPECT_FALSE(fe.valid());
 }
 
+namespace {
+// Records its destruction only after a delay
+struct slow_release {
+  std::shared_ptr<std::atomic<bool>> released;
+  slow_release(const std::shared_ptr<std::atomic<bool>> &released)
+      : released(released) {}
+  slow_release(const slow_release &) = default;
+  slow_release(slow_release &&) = default;
+  ~slow_release() {
+    if (!released)
+      return;
+    this_thread::sleep_for(std::chrono::milliseconds(100));
+    *released = true;
+  }
+  int operator()() const { return 1; }
+};
+}
+
+TEST(qthread_future, async_release) {
+  // The task is released before the result becomes ready
+  for (auto policy : {launch::async, launch::deferred}) {
+    auto released = std::make_shared<std::atomic<bool>>(false);
+    auto f = async(policy, slow_release(released));
+    EXPECT_EQ(1, f.get());
+    EXPECT_TRUE(bool(*released));
+  }
+  auto released = std::make_shared<std::atomic<bool>>(false);
+  auto f = make_ready_future(0).then(
+      [r = slow_release(released)](future<int> f) { return f.get() + r(); });
+  EXPECT_EQ(1, f.get());
+  EXPECT_TRUE(bool(*released));
+}
+
 namespace {
 int recurse(int count) {
   if (count <= 1)
@@ -0,0 +1,448 @@
+#ifndef QTHREAD_PARALLEL_HPP
+#define QTHREAD_PARALLEL_HPP
+
+#include <adt/index.hpp>
+#include <cxx/apply.hpp>
+#include <cxx/cassert.hpp>
+#include <cxx/cstdlib.hpp>
+#include <cxx/invoke.hpp>
+#include <qthread/future.hpp>
+#include <qthread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace qthread {
+
+// grain_size //////////////////////////////////////////////////////////////////
+
+// Choose the number of iterations per task adaptively. The grain size
+// is at least n / (overload_factor * threads), i.e. a loop is split
+// into at most overload_factor chunks per thread. The execution time
+// of each chunk is measured, and the grain size is increased further
+// so that a chunk runs for at least about target_time(); for cheap
+// loop bodies this yields fewer chunks. Before the first measurement
+// only the former bound is used, which gives overload_factor chunks
+// per thread (if the loop has enough iterations). An optional upper
+// bound limits the chunk size, e.g. to fit the data of a chunk into a
+// cache; it takes precedence over both criteria.
+class grain_size {
+  double target;
+  std::ptrdiff_t maximum;
+  std::atomic<double> time_per_iter; // seconds; <= 0 if unknown
+
+public:
+  static constexpr double default_target_time = 1.0e-4;
+  static constexpr std::ptrdiff_t overload_factor = 4;
+
+  explicit grain_size(
+      double target = default_target_time,
+      std::ptrdiff_t maximum = std::numeric_limits<std::ptrdiff_t>::max())
+      : target(target), maximum(maximum), time_per_iter(0.0) {
+    cxx_assert(target > 0);
+    cxx_assert(maximum > 0);
+  }
+  grain_size(const grain_size &) = delete;
+  grain_size(grain_size &&) = delete;
+  grain_size &operator=(const grain_size &) = delete;
+  grain_size &operator=(grain_size &&) = delete;
+
+  double target_time() const noexcept { return target; }
+  std::ptrdiff_t max_grain() const noexcept { return maximum; }
+  double measured_time_per_iter() const noexcept { return time_per_iter; }
+  void reset() noexcept { time_per_iter = 0.0; }
+
+  // Record the execution time of a chunk. Concurrent updates may
+  // overwrite each other; this is harmless since this is only an
+  // estimate.
+  void record(std::ptrdiff_t niters, double seconds) noexcept {
+    if (niters <= 0)
+      return;
+    double t = seconds / niters;
+    double old = time_per_iter.load(std::memory_order_relaxed);
+    time_per_iter.store(old <= 0.0 ? t : 0.75 * old + 0.25 * t,
+                        std::memory_order_relaxed);
+  }
+
+  // Number of iterations per chunk for a loop with n iterations
+  std::ptrdiff_t get(std::ptrdiff_t n) const {
+    if (n <= 0)
+      return 1;
+    std::ptrdiff_t nthreads = thread::hardware_concurrency();
+    std::ptrdiff_t balanced =
+        cxx::div_ceil(n, overload_factor * std::max(std::ptrdiff_t(1),
+                                                    nthreads))
+            .quot;
+    double t = time_per_iter.load(std::memory_order_relaxed);
+    std::ptrdiff_t grain = balanced;
+    if (t > 0.0)
+      grain = std::max(grain, std::ptrdiff_t(std::min(double(n), target / t)));
+    return std::max(std::ptrdiff_t(1), std::min(maximum, grain));
+  }
+};
+
+namespace detail {
+// Each loop kernel type has its own grain size estimate
+template <typename F> grain_size &default_grain_size() {
+  static grain_size grain;
+  return grain;
+}
+
+inline double parallel_gettime() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}
+
+// Splitting ranges ////////////////////////////////////////////////////////////
+
+// Split a range recursively into halves until each part has at most
+// grain iterations. The parts are appended in order.
+inline void split_range(const adt::irange_t &range, std::ptrdiff_t grain,
+                        std::vector<adt::irange_t> &parts) {
+  cxx_assert(grain > 0);
+  std::ptrdiff_t s = range.shape();
+  if (s <= grain) {
+    if (s > 0)
+      parts.push_back(range);
+    return;
+  }
+  std::ptrdiff_t mid = s / 2;
+  split_range(adt::irange_t(range.imin(), range[mid], range.istep()), grain,
+              parts);
+  split_range(adt::irange_t(range[mid], range.imax(), range.istep()), grain,
+              parts);
+}
+
+// Multi-dimensional ranges are bisected in the dimension with the
+// largest extent. On ties, the slowest-varying (highest) dimension is
+// split, which keeps chunks contiguous in memory for as long as
+// possible.
+template <std::size_t D>
+void split_range(const adt::steprange_t<D> &range, std::ptrdiff_t grain,
+                 std::vector<adt::steprange_t<D>> &parts) {
+  cxx_assert(grain > 0);
+  auto shape = range.shape();
+  std::ptrdiff_t s = adt::prod(shape);
+  if (s <= grain) {
+    if (s > 0)
+      parts.push_back(range);
+    return;
+  }
+  std::ptrdiff_t dir = 0;
+  for (std::ptrdiff_t d = 1; d < std::ptrdiff_t(D); ++d)
+    if (shape[d] >= shape[dir])
+      dir = d;
+  cxx_assert(shape[dir] > 1);
+  auto imid = range.imax();
+  imid[dir] = range.imin()[dir] + shape[dir] / 2 * range.istep()[dir];
+  auto jmin = range.imin();
+  jmin[dir] = imid[dir];
+  split_range(adt::steprange_t<D>(range.imin(), imid, range.istep()), grain,
+              parts);
+  split_range(adt::steprange_t<D>(jmin, range.imax(), range.istep()), grain,
+              parts);
+}
+
+namespace detail {
+template <typename R> struct parallel_chunk_loop;
+template <> struct parallel_chunk_loop<adt::irange_t> {
+  template <typename F, typename... Args>
+  static void run(const adt::irange_t &range, F &&f, Args &&... args) {
+    std::ptrdiff_t s = range.shape();
+    for (std::ptrdiff_t i = 0; i < s; ++i)
+      cxx::invoke(f, range[i], args...);
+  }
+};
+template <std::size_t D> struct parallel_chunk_loop<adt::steprange_t<D>> {
+  template <typename F, typename... Args>
+  static void run(const adt::steprange_t<D> &range, F &&f, Args &&... args) {
+    range.loop(std::forward<F>(f), std::forward<Args>(args)...);
+  }
+};
+
+// Turn a function acting on points into one acting on chunks
+template <typename F> struct parallel_point_loop {
+  F f;
+  template <typename Range, typename... Args>
+  void operator()(const Range &range, const Args &... args) {
+    parallel_chunk_loop<Range>::run(range, f, args...);
+  }
+};
+
+// State shared by all chunks of a parallel_for
+template <typename Range, typename F, typename... Args> struct parallel_for_t {
+  grain_size &grain;
+  std::vector<Range> parts;
+  std::vector<promise<void>> dones;
+  F f;
+  std::tuple<Args...> args;
+
+  template <typename F1, typename... Args1>
+  parallel_for_t(grain_size &grain, std::vector<Range> &&parts, F1 &&f,
+                 Args1 &&... args)
+      : grain(grain), parts(std::move(parts)), dones(this->parts.size()),
+        f(std::forward<F1>(f)), args(std::forward<Args1>(args)...) {}
+
+  // An exception thrown by f is passed on to the chunk's future, so
+  // that waiting for the chunk does not block forever
+  void run_chunk(std::ptrdiff_t c) {
+    const Range &range = parts[c];
+    auto t0 = parallel_gettime();
+    try {
+      cxx::apply([&](const auto &... args) { cxx::invoke(f, range, args...); },
+                 args);
+    } catch (...) {
+      dones[c].set_exception(std::current_exception());
+      return;
+    }
+    auto t1 = parallel_gettime();
+    grain.record(range.size(), t1 - t0);
+    dones[c].set_value();
+  }
+
+  // Spawn the chunks [lo, hi) as a binary tree of threads
+  static void spawn(std::shared_ptr<parallel_for_t> self, std::ptrdiff_t lo,
+                    std::ptrdiff_t hi) {
+    while (hi - lo > 1) {
+      std::ptrdiff_t mid = lo + (hi - lo) / 2;
+      thread(spawn, self, mid, hi).detach();
+      hi = mid;
+    }
+    if (hi > lo)
+      self->run_chunk(lo);
+  }
+};
+
+// Turn a function acting on points into one folding chunks
+template <typename R, typename F, typename Op, typename Z>
+struct parallel_point_reduce {
+  F f;
+  Op op;
+  Z z;
+  template <typename Range, typename... Args>
+  R operator()(const Range &range, const Args &... args) const {
+    R r(z);
+    parallel_chunk_loop<Range>::run(range, [&](const auto &i) {
+      r = cxx::invoke(op, std::move(r), cxx::invoke(f, i, args...));
+    });
+    return r;
+  }
+};
+
+// State shared by all chunks of a parallel_reduce
+template <typename Range, typename R, typename F, typename Op,
+          typename... Args>
+struct parallel_reduce_t {
+  grain_size &grain;
+  std::vector<Range> parts;
+  F f;
+  Op op;
+  std::tuple<Args...> args;
+
+  template <typename F1, typename Op1, typename... Args1>
+  parallel_reduce_t(grain_size &grain, std::vector<Range> &&parts, F1 &&f,
+                    Op1 &&op, Args1 &&... args)
+      : grain(grain), parts(std::move(parts)), f(std::forward<F1>(f)),
+        op(std::forward<Op1>(op)), args(std::forward<Args1>(args)...) {}
+
+  R run_chunk(std::ptrdiff_t c) const {
+    const Range &range = parts[c];
+    auto t0 = parallel_gettime();
+    R r = cxx::apply(
+        [&](const auto &... args) { return cxx::invoke(f, range, args...); },
+        args);
+    auto t1 = parallel_gettime();
+    grain.record(range.size(), t1 - t0);
+    return r;
+  }
+
+  // Reduce the chunks [lo, hi) as a binary tree, combining results in
+  // order; op needs to be associative, but not commutative
+  static R reduce(std::shared_ptr<const parallel_reduce_t> self,
+                  std::ptrdiff_t lo, std::ptrdiff_t hi) {
+    cxx_assert(hi > lo);
+    if (hi - lo == 1)
+      return self->run_chunk(lo);
+    std::ptrdiff_t mid = lo + (hi - lo) / 2;
+    auto fright = async(launch::async, reduce, self, mid, hi);
+    R left = reduce(self, lo, mid);
+    return cxx::invoke(self->op, std::move(left), fright.get());
+  }
+};
+}
+
+// parallel_for ////////////////////////////////////////////////////////////////
+
+// Call f(chunk, args...) for every chunk of range. The range is split
+// recursively into chunks (subranges), and each chunk is executed by
+// its own thread. The returned futures correspond to the chunks in
+// index order, so that e.g. the first and last chunk (containing the
+// boundaries) can be awaited early. The arguments are copied.
+
+template <typename Range, typename F, typename... Args>
+std::vector<future<void>> parallel_for_chunks(grain_size &grain,
+                                              const Range &range, F &&f,
+                                              Args &&... args) {
+  typedef detail::parallel_for_t<Range, std::decay_t<F>, std::decay_t<Args>...>
+      state_t;
+  std::vector<Range> parts;
+  split_range(range, grain.get(range.size()), parts);
+  auto state = std::make_shared<state_t>(grain, std::move(parts),
+                                         std::forward<F>(f),
+                                         std::forward<Args>(args)...);
+  std::vector<future<void>> fs;
+  fs.reserve(state->dones.size());
+  for (auto &done : state->dones)
+    fs.push_back(done.get_future());
+  std::ptrdiff_t nparts = state->parts.size();
+  if (nparts > 0)
+    thread(state_t::spawn, std::move(state), 0, nparts).detach();
+  return fs;
+}
+
+template <typename F, typename... Args>
+std::vector<future<void>> parallel_for_chunks(const adt::irange_t &range,
+                                              F &&f, Args &&... args) {
+  return parallel_for_chunks(detail::default_grain_size<std::decay_t<F>>(),
+                             range, std::forward<F>(f),
+                             std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename... Args>
+std::vector<future<void>> parallel_for_chunks(const adt::steprange_t<D> &range,
+                                              F &&f, Args &&... args) {
+  return parallel_for_chunks(detail::default_grain_size<std::decay_t<F>>(),
+                             range, std::forward<F>(f),
+                             std::forward<Args>(args)...);
+}
+
+// Call f(i, args...) for every index i in range, as for
+// parallel_for_chunks.
+
+template <typename Range, typename F, typename... Args>
+std::vector<future<void>> parallel_for(grain_size &grain, const Range &range,
+                                       F &&f, Args &&... args) {
+  return parallel_for_chunks(
+      grain, range, detail::parallel_point_loop<std::decay_t<F>>{
+                        std::forward<F>(f)},
+      std::forward<Args>(args)...);
+}
+
+template <typename F, typename... Args>
+std::vector<future<void>> parallel_for(const adt::irange_t &range, F &&f,
+                                       Args &&... args) {
+  return parallel_for(detail::default_grain_size<std::decay_t<F>>(), range,
+                      std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename... Args>
+std::vector<future<void>> parallel_for(const adt::steprange_t<D> &range, F &&f,
+                                       Args &&... args) {
+  return parallel_for(detail::default_grain_size<std::decay_t<F>>(), range,
+                      std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+// parallel_reduce /////////////////////////////////////////////////////////////
+
+// Evaluate op(...op(f(c0, args...), f(c1, args...))...) for all chunks
+// c of range, where f folds a chunk (a subrange) into a single value.
+// The chunk results are combined in a tree in index order; op needs
+// to be associative. The result for an empty range is z. The
+// arguments are copied.
+
+template <typename Range, typename F, typename Op, typename Z, typename... Args,
+          typename R = std::decay_t<cxx::invoke_of_t<
+              std::decay_t<F>, Range, std::decay_t<Args>...>>>
+future<R> parallel_reduce_chunks(grain_size &grain, const Range &range, F &&f,
+                                 Op &&op, Z &&z, Args &&... args) {
+  static_assert(
+      std::is_same<std::decay_t<cxx::invoke_of_t<std::decay_t<Op>, R, R>>,
+                   R>::value,
+      "");
+  typedef detail::parallel_reduce_t<Range, R, std::decay_t<F>,
+                                    std::decay_t<Op>, std::decay_t<Args>...>
+      state_t;
+  std::vector<Range> parts;
+  split_range(range, grain.get(range.size()), parts);
+  if (parts.empty())
+    return make_ready_future(R(std::forward<Z>(z)));
+  std::ptrdiff_t nparts = parts.size();
+  std::shared_ptr<const state_t> state =
+      std::make_shared<state_t>(grain, std::move(parts), std::forward<F>(f),
+                                std::forward<Op>(op),
+                                std::forward<Args>(args)...);
+  return async(launch::async, state_t::reduce, std::move(state), 0, nparts);
+}
+
+template <typename F, typename Op, typename Z, typename... Args>
+auto parallel_reduce_chunks(const adt::irange_t &range, F &&f, Op &&op, Z &&z,
+                            Args &&... args) {
+  return parallel_reduce_chunks(detail::default_grain_size<std::decay_t<F>>(),
+                                range, std::forward<F>(f), std::forward<Op>(op),
+                                std::forward<Z>(z),
+                                std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename Op, typename Z, typename... Args>
+auto parallel_reduce_chunks(const adt::steprange_t<D> &range, F &&f, Op &&op,
+                            Z &&z, Args &&... args) {
+  return parallel_reduce_chunks(detail::default_grain_size<std::decay_t<F>>(),
+                                range, std::forward<F>(f), std::forward<Op>(op),
+                                std::forward<Z>(z),
+                                std::forward<Args>(args)...);
+}
+
+// Evaluate op(...op(op(z, f(i0, args...)), f(i1, args...))...) for all
+// indices i in range. Chunks are folded serially, and the chunk
+// results are combined in a tree in index order. op needs to be
+// associative, and z needs to be its identity. The arguments are
+// copied.
+
+template <typename Range, typename F, typename Op, typename Z, typename... Args,
+          typename R = std::decay_t<cxx::invoke_of_t<
+              std::decay_t<F>, decltype(std::declval<Range>().imin()),
+              std::decay_t<Args>...>>>
+future<R> parallel_reduce(grain_size &grain, const Range &range, F &&f,
+                          Op &&op, Z &&z, Args &&... args) {
+  typedef detail::parallel_point_reduce<R, std::decay_t<F>, std::decay_t<Op>,
+                                        std::decay_t<Z>>
+      chunk_t;
+  return parallel_reduce_chunks(grain, range,
+                                chunk_t{std::forward<F>(f), op, z},
+                                std::forward<Op>(op), std::forward<Z>(z),
+                                std::forward<Args>(args)...);
+}
+
+template <typename F, typename Op, typename Z, typename... Args>
+auto parallel_reduce(const adt::irange_t &range, F &&f, Op &&op, Z &&z,
+                     Args &&... args) {
+  return parallel_reduce(detail::default_grain_size<std::decay_t<F>>(), range,
+                         std::forward<F>(f), std::forward<Op>(op),
+                         std::forward<Z>(z), std::forward<Args>(args)...);
+}
+
+template <std::size_t D, typename F, typename Op, typename Z, typename... Args>
+auto parallel_reduce(const adt::steprange_t<D> &range, F &&f, Op &&op, Z &&z,
+                     Args &&... args) {
+  return parallel_reduce(detail::default_grain_size<std::decay_t<F>>(), range,
+                         std::forward<F>(f), std::forward<Op>(op),
+                         std::forward<Z>(z), std::forward<Args>(args)...);
+}
+}
+
+#define QTHREAD_PARALLEL_HPP_DONE
+#endif // #ifndef QTHREAD_PARALLEL_HPP
+#ifndef QTHREAD_PARALLEL_HPP_DONE
+#error "Cyclic include dependency"
+#endif
@@ -0,0 +1,179 @@
+#include <qthread/parallel.hpp>
+
+#include <adt/index.hpp>
+
+#include <gtest/gtest.h>
+#include <qthread.h>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace qthread;
+
+TEST(qthread_parallel, grain_size) {
+  qthread_initialize();
+
+  grain_size grain(1.0e-3);
+  EXPECT_EQ(0.0, grain.measured_time_per_iter());
+  EXPECT_GE(grain.get(1000), 1);
+  EXPECT_LE(grain.get(1000), 1000);
+  grain.record(1000, 1.0e-3);
+  EXPECT_GT(grain.measured_time_per_iter(), 0.0);
+  // about 1000 iterations are needed to reach the target time
+  EXPECT_GE(grain.get(1000000), 1000);
+  EXPECT_LE(grain.get(10), 10);
+  grain.reset();
+  EXPECT_EQ(0.0, grain.measured_time_per_iter());
+
+  grain_size capped(1.0e-3, 10);
+  EXPECT_EQ(10, capped.max_grain());
+  capped.record(1000, 1.0e-3);
+  EXPECT_LE(capped.get(1000000), 10);
+}
+
+TEST(qthread_parallel, split_range) {
+  std::vector<adt::irange_t> parts;
+  split_range(adt::irange_t(3, 100, 2), 5, parts);
+  std::ptrdiff_t next = 3, count = 0;
+  for (const auto &part : parts) {
+    EXPECT_LE(part.shape(), 5);
+    EXPECT_EQ(next, part.imin());
+    EXPECT_EQ(2, part.istep());
+    next = part[part.shape()];
+    count += part.shape();
+  }
+  EXPECT_EQ(adt::irange_t(3, 100, 2).shape(), count);
+
+  std::vector<adt::steprange_t<2>> parts2;
+  adt::steprange_t<2> range2(adt::index_t<2>{{0, 0}}, adt::index_t<2>{{7, 9}});
+  split_range(range2, 4, parts2);
+  std::size_t count2 = 0;
+  for (const auto &part : parts2) {
+    EXPECT_LE(part.size(), 4);
+    count2 += part.size();
+  }
+  EXPECT_EQ(range2.size(), count2);
+}
+
+TEST(qthread_parallel, parallel_for) {
+  qthread_initialize();
+
+  std::ptrdiff_t n = 1000;
+  std::vector<int> xs(n, 0);
+  auto fs = parallel_for(adt::irange_t(n),
+                         [&xs](std::ptrdiff_t i, int a) { xs[i] += a; }, 1);
+  EXPECT_FALSE(fs.empty());
+  // The boundary chunks can be awaited separately
+  fs.front().wait();
+  EXPECT_EQ(1, xs.front());
+  fs.back().wait();
+  EXPECT_EQ(1, xs.back());
+  for (auto &f : fs)
+    f.wait();
+  for (std::ptrdiff_t i = 0; i < n; ++i)
+    EXPECT_EQ(1, xs[i]);
+
+  auto fs0 = parallel_for(adt::irange_t(5, 5), [](std::ptrdiff_t) {});
+  EXPECT_TRUE(fs0.empty());
+
+  grain_size grain;
+  std::atomic<std::ptrdiff_t> sum2(0);
+  adt::steprange_t<2> range2(adt::index_t<2>{{1, 2}}, adt::index_t<2>{{10, 30}},
+                             adt::index_t<2>{{1, 3}});
+  auto fs2 = parallel_for(grain, range2, [&sum2](const adt::index_t<2> &i) {
+    sum2 += i[0] * 100 + i[1];
+  });
+  for (auto &f : fs2)
+    f.wait();
+  std::ptrdiff_t expected2 = 0;
+  range2.loop(
+      [&expected2](const adt::index_t<2> &i) { expected2 += i[0] * 100 + i[1]; });
+  EXPECT_EQ(expected2, sum2);
+  EXPECT_GT(grain.measured_time_per_iter(), 0.0);
+
+  // An exception is passed on to the future of its chunk, and the
+  // other chunks still finish
+  std::atomic<std::ptrdiff_t> count3(0);
+  auto fs3 = parallel_for(adt::irange_t(n), [&count3](std::ptrdiff_t i) {
+    if (i == 0)
+      throw std::runtime_error("parallel_for");
+    ++count3;
+  });
+  EXPECT_THROW(fs3.front().get(), std::runtime_error);
+  for (std::size_t c = 1; c < fs3.size(); ++c)
+    fs3[c].get();
+  EXPECT_LT(count3, n);
+  if (fs3.size() > 1)
+    EXPECT_GT(count3, 0);
+}
+
+TEST(qthread_parallel, parallel_reduce) {
+  qthread_initialize();
+
+  std::ptrdiff_t n = 10000;
+  auto fsum = parallel_reduce(adt::irange_t(n),
+                              [](std::ptrdiff_t i, std::ptrdiff_t a) {
+                                return a * i;
+                              },
+                              [](std::ptrdiff_t x, std::ptrdiff_t y) {
+                                return x + y;
+                              },
+                              std::ptrdiff_t(0), std::ptrdiff_t(2));
+  EXPECT_EQ(n * (n - 1), fsum.get());
+
+  // The reduction operator need not be commutative
+  auto fcat = parallel_reduce(adt::irange_t(100),
+                              [](std::ptrdiff_t i) {
+                                return std::vector<std::ptrdiff_t>(1, i);
+                              },
+                              [](std::vector<std::ptrdiff_t> xs,
+                                 const std::vector<std::ptrdiff_t> &ys) {
+                                xs.insert(xs.end(), ys.begin(), ys.end());
+                                return xs;
+                              },
+                              std::vector<std::ptrdiff_t>());
+  auto cat = fcat.get();
+  EXPECT_EQ(100, cat.size());
+  for (std::ptrdiff_t i = 0; i < std::ptrdiff_t(cat.size()); ++i)
+    EXPECT_EQ(i, cat[i]);
+
+  auto fempty = parallel_reduce(adt::irange_t(0),
+                                [](std::ptrdiff_t i) { return i; },
+                                [](std::ptrdiff_t x, std::ptrdiff_t y) {
+                                  return x + y;
+                                },
+                                std::ptrdiff_t(42));
+  EXPECT_EQ(42, fempty.get());
+
+  adt::steprange_t<3> range3(adt::index_t<3>{{4, 5, 6}});
+  auto fcount = parallel_reduce(range3, [](const adt::index_t<3> &) { return 1; },
+                                [](int x, int y) { return x + y; }, 0);
+  EXPECT_EQ(4 * 5 * 6, fcount.get());
+}
+
+TEST(qthread_parallel, parallel_reduce_chunks) {
+  qthread_initialize();
+
+  std::ptrdiff_t n = 10000;
+  std::atomic<std::ptrdiff_t> nchunks(0);
+  auto fsum = parallel_reduce_chunks(
+      adt::irange_t(n),
+      [&nchunks](const adt::irange_t &chunk) {
+        ++nchunks;
+        std::ptrdiff_t r = 0;
+        for (std::ptrdiff_t i = chunk.imin(); i < chunk.imax(); ++i)
+          r += i;
+        return r;
+      },
+      [](std::ptrdiff_t x, std::ptrdiff_t y) { return x + y; },
+      std::ptrdiff_t(0));
+  EXPECT_EQ(n * (n - 1) / 2, fsum.get());
+  EXPECT_GE(nchunks, 1);
+
+  auto fempty = parallel_reduce_chunks(
+      adt::irange_t(0), [](const adt::irange_t &chunk) { return 1; },
+      [](int x, int y) { return x + y; }, 42);
+  EXPECT_EQ(42, fempty.get());
+}